@@ -54,6 +54,13 @@ ET_NODISCARD Error XNNExecutor::initialize(
   externals_.resize(input_ids_.size() + output_ids_.size());
   packed_data_names_ = std::move(packed_data_names);
 
+  input_shapes_.reserve(input_ids_.size() * (XNN_MAX_TENSOR_DIMS + 1));
+  reshaped_input_shapes_.reserve(input_shapes_.capacity());
+  output_shapes_.resize(output_ids_.size() * (XNN_MAX_TENSOR_DIMS + 1));
+  setup_data_.resize(externals_.size());
+  is_reshaped_ = false;
+  needs_setup_ = true;
+
   return Error::Ok;
 }
 
@@ -65,6 +72,10 @@ ET_NODISCARD Error XNNExecutor::initialize(
  * changed. The reshapes the entire runtime, propagating shape information
  * through the runtime.
  *
+ * Reshaping is skipped when the input shapes are the same as in the last
+ * reshape and no other runtime has been reshaped in the shared workspace
+ * since, as that could have moved this runtime's memory.
+ *
  * Note: the external ids given to the external tensors in the XNNPACK
  * runtime correspond to their index in the list of arg passed into
  * delegate->execute()
@@ -77,6 +88,7 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
 
   // Create xnn_externals_value from evalue args
   xnn_status status;
+  input_shapes_.clear();
   for (uint32_t i = 0; i < externals_.size(); ++i) {
     if (i < input_ids_.size()) {
       externals_[i].id = input_ids_[i];
@@ -97,7 +109,7 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
 
     executorch::aten::DimOrderType dim_order[kTensorDimensionLimit];
 
-    // Reshape runtime inputs
+    // Collect runtime input shapes
     if (i < input_ids_.size()) {
       size_t num_dims = tensor->dim();
       Error err =
@@ -106,7 +118,6 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
           err == Error::Ok,
           Internal,
           "Failed to retrieve dim order from tensor!");
-      size_t dims[XNN_MAX_TENSOR_DIMS];
       ET_CHECK_OR_RETURN_ERROR(
           num_dims <= XNN_MAX_TENSOR_DIMS,
           InvalidArgument,
@@ -114,18 +125,36 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
           XNN_MAX_TENSOR_DIMS,
           num_dims);
 
+      input_shapes_.push_back(num_dims);
       for (int j = 0; j < num_dims; ++j) {
-        dims[j] = tensor->size(static_cast<int>(dim_order[j]));
+        input_shapes_.push_back(tensor->size(static_cast<int>(dim_order[j])));
       }
-      status =
-          xnn_reshape_external_value(runtime_.get(), ext_id, num_dims, dims);
-      ET_CHECK_OR_RETURN_ERROR(
-          status == xnn_status_success,
-          Internal,
-          "Internal Error: Reshape Input Tensor Failed with code: %s",
-          xnn_status_to_string(status));
     }
   }
+
+  if (is_reshaped_ && input_shapes_ == reshaped_input_shapes_ &&
+      (workspace_ == nullptr ||
+       workspace_->get_generation() == reshape_generation_)) {
+    return Error::Ok;
+  }
+
+  // Until the reshape succeeds, the runtime is in no known shape.
+  is_reshaped_ = false;
+  needs_setup_ = true;
+
+  // Reshape runtime inputs
+  size_t pos = 0;
+  for (uint32_t i = 0; i < input_ids_.size(); ++i) {
+    size_t num_dims = input_shapes_[pos];
+    status = xnn_reshape_external_value(
+        runtime_.get(), externals_[i].id, num_dims, &input_shapes_[pos + 1]);
+    ET_CHECK_OR_RETURN_ERROR(
+        status == xnn_status_success,
+        Internal,
+        "Internal Error: Reshape Input Tensor Failed with code: %s",
+        xnn_status_to_string(status));
+    pos += num_dims + 1;
+  }
   // // Propagate Input Shape and Memory Plan for increased allocation
   status = xnn_reshape_runtime(runtime_.get());
 
@@ -135,6 +164,23 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
       "Internal Error: Propagating input shapes failed with code: %s",
       xnn_status_to_string(status));
 
+  // Fetch the updated output shapes from xnnpack runtime
+  for (size_t i = 0; i < output_ids_.size(); ++i) {
+    size_t* shape = &output_shapes_[i * (XNN_MAX_TENSOR_DIMS + 1)];
+    status = xnn_get_external_value_shape(
+        runtime_.get(), output_ids_[i], &shape[0], &shape[1]);
+    ET_CHECK_OR_RETURN_ERROR(
+        status == xnn_status_success,
+        Internal,
+        "Internal Error: Failed to retrieve graph output shapes");
+  }
+
+  reshaped_input_shapes_.swap(input_shapes_);
+  if (workspace_ != nullptr) {
+    reshape_generation_ = workspace_->increment_generation();
+  }
+  is_reshaped_ = true;
+
   return Error::Ok;
 }
 
@@ -142,7 +188,9 @@ ET_NODISCARD Error XNNExecutor::prepare_args(EValue** args) {
  * Runs the XNNPACK Runtime.
  *
  * We first setup the runtime by feeding the externals_ to runtime setup.
- * After which we then execute the runtime through invoke_runtime.
+ * After which we then execute the runtime through invoke_runtime. Setup is
+ * skipped when the runtime was not reshaped and the data pointers are the
+ * same as in the last setup.
  */
 ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
   ET_CHECK_OR_RETURN_ERROR(
@@ -150,14 +198,26 @@ ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
       Internal,
       "XNNPACK Delegate did not compile correctly");
 
-  xnn_status status = xnn_setup_runtime_v2(
-      runtime_.get(), externals_.size(), externals_.data());
+  xnn_status status;
+  bool needs_setup = needs_setup_;
+  for (size_t i = 0; !needs_setup && i < externals_.size(); ++i) {
+    needs_setup = externals_[i].data != setup_data_[i];
+  }
+  if (needs_setup) {
+    status = xnn_setup_runtime_v2(
+        runtime_.get(), externals_.size(), externals_.data());
 
-  ET_CHECK_OR_RETURN_ERROR(
-      status == xnn_status_success,
-      Internal,
-      "Internal Error: Setting up the runtime failed with code: %s",
-      xnn_status_to_string(status));
+    ET_CHECK_OR_RETURN_ERROR(
+        status == xnn_status_success,
+        Internal,
+        "Internal Error: Setting up the runtime failed with code: %s",
+        xnn_status_to_string(status));
+
+    for (size_t i = 0; i < externals_.size(); ++i) {
+      setup_data_[i] = externals_[i].data;
+    }
+    needs_setup_ = false;
+  }
 
   auto error = profiler_.start(context.event_tracer());
   if (error != Error::Ok) {
@@ -190,7 +250,7 @@ ET_NODISCARD Error XNNExecutor::forward(BackendExecutionContext& context) {
  * Prepares the outputs for ExecuTorch
  *
  * Resizes the output tensors based on the output shapes returned by
- * the xnnpack runtime.
+ * the xnnpack runtime at the last reshape.
  *
  * Note: For arg_max pooling, we recast the output index tensor. Since
  * XNNPACK gives the index tensor to us as int32, we need to convert it
@@ -202,17 +262,10 @@ ET_NODISCARD Error XNNExecutor::resize_outputs(EValue** args) const {
     uint32_t ext_id = externals_[i].id;
     Tensor* out_tensor = &args[ext_id]->toTensor();
 
-    size_t num_dim;
-    size_t dims[XNN_MAX_TENSOR_DIMS];
-
-    // Fetch the updated output shapes from xnnpack runtime
-    xnn_status status =
-        xnn_get_external_value_shape(runtime_.get(), ext_id, &num_dim, dims);
-
-    ET_CHECK_OR_RETURN_ERROR(
-        status == xnn_status_success,
-        Internal,
-        "Internal Error: Failed to retrieve graph output shapes");
+    const size_t* shape =
+        &output_shapes_[(i - output_idx_start) * (XNN_MAX_TENSOR_DIMS + 1)];
+    size_t num_dim = shape[0];
+    const size_t* dims = &shape[1];
 
     // Convert new output shape into SizesType
     SizesType expected_output_size[kTensorDimensionLimit];
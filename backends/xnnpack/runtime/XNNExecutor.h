@@ -9,6 +9,7 @@
 #pragma once
 
 #include <executorch/backends/xnnpack/runtime/XNNStatus.h>
+#include <executorch/backends/xnnpack/runtime/XNNWorkspaceManager.h>
 #include <executorch/backends/xnnpack/runtime/profiling/XNNProfiler.h>
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/error.h>
@@ -26,6 +27,8 @@ namespace delegate {
 
 class XNNExecutor {
  private:
+  // Declared before runtime_ so that it outlives the runtime using it.
+  std::shared_ptr<XNNWorkspace> workspace_;
   std::unique_ptr<xnn_runtime, decltype(&xnn_delete_runtime)> runtime_{
       nullptr,
       &xnn_delete_runtime};
@@ -36,6 +39,21 @@ class XNNExecutor {
   std::vector<xnn_external_value> externals_;
   std::vector<std::string> packed_data_names_;
 
+  // Input shapes the runtime was last reshaped for, as the number of dims
+  // followed by the dims of each input in order. input_shapes_ holds the
+  // shapes of the current call.
+  std::vector<size_t> reshaped_input_shapes_;
+  std::vector<size_t> input_shapes_;
+  // Output shapes after the last reshape, XNN_MAX_TENSOR_DIMS + 1 entries per
+  // output laid out like the input shapes.
+  std::vector<size_t> output_shapes_;
+  bool is_reshaped_ = false;
+  // Workspace generation after the last reshape.
+  uint64_t reshape_generation_ = 0;
+  // Data pointers of externals_ at the last setup.
+  std::vector<void*> setup_data_;
+  bool needs_setup_ = true;
+
  public:
   XNNExecutor() = default;
 
@@ -51,6 +69,18 @@ class XNNExecutor {
     return packed_data_names_;
   }
 
+  /**
+   * Sets the workspace that the runtime will be created in. Its mutex must be
+   * held while using this executor.
+   */
+  inline void set_workspace(std::shared_ptr<XNNWorkspace> workspace) {
+    workspace_ = std::move(workspace);
+  }
+
+  inline const std::shared_ptr<XNNWorkspace>& get_workspace() const {
+    return workspace_;
+  }
+
   /**
    * Initialize the XNNExecutor with a given runtime and input/output ids.
    * The input/output ids are expected to be sorted in order of their
@@ -66,13 +96,15 @@ class XNNExecutor {
    * Prepares the arguments for runtime graph execution.
    * args is an array of EValues that will be passed into the runtime.
    * input shapes will be propagated through the runtime, and perform
-   * any additional memory planning as needed
+   * any additional memory planning as needed. This is skipped when the input
+   * shapes match the previous call.
    */
   ET_NODISCARD executorch::runtime::Error prepare_args(
       executorch::runtime::EValue** args);
 
   /**
-   * Executes the graph using the args prepared at prepare_args().
+   * Executes the graph using the args prepared at prepare_args(). The runtime
+   * is only set up again if it was reshaped or the data pointers changed.
    */
   ET_NODISCARD executorch::runtime::Error forward(
       executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext& context);
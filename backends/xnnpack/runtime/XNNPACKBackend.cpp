@@ -7,32 +7,42 @@
  */
 
 #include <executorch/backends/xnnpack/runtime/XNNCompiler.h>
+#include <executorch/backends/xnnpack/runtime/XNNPACKBackend.h>
 #include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
+#include <executorch/backends/xnnpack/runtime/XNNWorkspaceManager.h>
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/evalue.h>
 #include <executorch/runtime/executor/pte_data_map.h>
 
+#include <cstring>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 
 namespace executorch {
 namespace backends {
 
+using executorch::backends::xnnpack::WorkspaceSharingMode;
 using executorch::backends::xnnpack::delegate::XNNWeightsCache;
+using executorch::backends::xnnpack::delegate::XNNWorkspace;
+using executorch::backends::xnnpack::delegate::XNNWorkspaceManager;
 using executorch::ET_RUNTIME_NAMESPACE::Backend;
 using executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext;
 using executorch::ET_RUNTIME_NAMESPACE::BackendInitContext;
+using executorch::ET_RUNTIME_NAMESPACE::BackendOptionContext;
 using executorch::ET_RUNTIME_NAMESPACE::CompileSpec;
 using executorch::ET_RUNTIME_NAMESPACE::DelegateHandle;
 using executorch::ET_RUNTIME_NAMESPACE::NamedDataMap;
 using executorch::runtime::ArrayRef;
+using executorch::runtime::BackendOption;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
 using executorch::runtime::FreeableBuffer;
 using executorch::runtime::Result;
+using executorch::runtime::Span;
 
 class XnnpackBackend final
     : public ::executorch::ET_RUNTIME_NAMESPACE::BackendInterface {
@@ -49,24 +59,6 @@ class XnnpackBackend final
           (unsigned int)status);
       return;
     }
-
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    // Create a workspace for the XNNExecutor to use. This workspace will be
-    // shared across all delegate instances.
-    ET_LOG(Debug, "Creating XNN workspace");
-    xnn_workspace_t workspace = nullptr;
-    status = xnn_create_workspace(&workspace);
-    if (status != xnn_status_success) {
-      ET_LOG(
-          Error,
-          "Failed to create XNN workspace, XNNPACK status: 0x%x",
-          (unsigned int)status);
-      workspace = nullptr;
-      return;
-    }
-    workspace_.reset(workspace);
-    ET_LOG(Debug, "Created XNN workspace: %p", workspace_.get());
-#endif // ENABLE_XNNPACK_SHARED_WORKSPACE
   }
 
   bool is_available() const override {
@@ -84,14 +76,18 @@ class XnnpackBackend final
     }
 
     const NamedDataMap* named_data_map = context.get_named_data_map();
-    // thread safe. This can heppen when multiple threads call init() on
-    // the same backend instance.
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    const std::lock_guard<std::mutex> lock(workspace_mutex_);
-#endif
+    Result<std::shared_ptr<XNNWorkspace>> workspace =
+        workspace_manager_.acquire();
+    if (!workspace.ok()) {
+      return workspace.error();
+    }
+    // Creating runtimes in a shared workspace is not thread safe. This can
+    // happen when multiple threads call init() on the same backend instance.
+    const std::lock_guard<std::mutex> lock(workspace.get()->mutex());
 
 #ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
-    const std::lock_guard<std::mutex> lock_weight_cache(weights_cache_mutex_);
+    const std::unique_lock<std::shared_mutex> lock_weight_cache(
+        weights_cache_mutex_);
     weights_cache_->initialize_for_runtime(
         context.get_runtime_allocator(), named_data_map);
 #endif
@@ -101,12 +97,13 @@ class XnnpackBackend final
     // new and since this type is not trivially destructible, we must call the
     // destructor manually in destroy().
     new (executor) xnnpack::delegate::XNNExecutor;
+    executor->set_workspace(workspace.get());
     Error err = xnnpack::delegate::XNNCompiler::compileModel(
         processed->data(),
         processed->size(),
         executor,
         weights_cache_.get(),
-        workspace_.get(),
+        workspace.get()->get(),
         named_data_map);
     // This backend does not need its processed data after compiling the model.
     processed->Free();
@@ -129,12 +126,14 @@ class XnnpackBackend final
       EValue** args) const override {
     auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
 
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-    const std::lock_guard<std::mutex> lock(workspace_mutex_);
-#endif
+    // Only executions of delegate instances sharing a workspace wait for each
+    // other.
+    const std::lock_guard<std::mutex> lock(executor->get_workspace()->mutex());
 
 #ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
-    const std::lock_guard<std::mutex> lock_weights_cache(weights_cache_mutex_);
+    // Running only reads packed weights, so executions share the cache.
+    const std::shared_lock<std::shared_mutex> lock_weights_cache(
+        weights_cache_mutex_);
 #endif
 
     // Prepare Inputs/Outputs and Propagate Input Shapes
@@ -155,23 +154,100 @@ class XnnpackBackend final
     return err;
   }
 
+  Error set_option(
+      __ET_UNUSED BackendOptionContext& context,
+      const Span<BackendOption>& backend_options) override {
+    for (const auto& backend_option : backend_options) {
+      if (strcmp(backend_option.key, xnnpack::kWeightsCachePathOption) == 0) {
+        const auto* path = std::get_if<
+            std::array<char, executorch::runtime::kMaxOptionValueLength>>(
+            &backend_option.value);
+        if (path == nullptr) {
+          ET_LOG(Error, "Option %s must be a string", backend_option.key);
+          return Error::InvalidArgument;
+        }
+#ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
+        const std::unique_lock<std::shared_mutex> lock_weights_cache(
+            weights_cache_mutex_);
+        Error err = weights_cache_->set_packed_weights_file(path->data());
+        if (err != Error::Ok) {
+          return err;
+        }
+#else
+        ET_LOG(
+            Error,
+            "Option %s requires building with the XNNPACK weights cache",
+            backend_option.key);
+        return Error::NotSupported;
+#endif
+      } else if (
+          strcmp(backend_option.key, xnnpack::kWorkspaceSharingModeOption) ==
+          0) {
+        const int* mode = std::get_if<int>(&backend_option.value);
+        if (mode == nullptr) {
+          ET_LOG(Error, "Option %s must be an int", backend_option.key);
+          return Error::InvalidArgument;
+        }
+        Error err = workspace_manager_.set_sharing_mode(*mode);
+        if (err != Error::Ok) {
+          return err;
+        }
+      } else if (
+          strcmp(backend_option.key, xnnpack::kWorkspacePoolSizeOption) == 0) {
+        const int* pool_size = std::get_if<int>(&backend_option.value);
+        if (pool_size == nullptr) {
+          ET_LOG(Error, "Option %s must be an int", backend_option.key);
+          return Error::InvalidArgument;
+        }
+        Error err = workspace_manager_.set_pool_size(*pool_size);
+        if (err != Error::Ok) {
+          return err;
+        }
+      } else {
+        ET_LOG(Error, "Unknown XNNPACK backend option %s", backend_option.key);
+        return Error::InvalidArgument;
+      }
+    }
+    return Error::Ok;
+  }
+
+  Error get_option(
+      __ET_UNUSED BackendOptionContext& context,
+      Span<BackendOption>& backend_options) override {
+    for (auto& backend_option : backend_options) {
+      if (strcmp(backend_option.key, xnnpack::kWorkspaceSharingModeOption) ==
+          0) {
+        backend_option.value =
+            static_cast<int>(workspace_manager_.get_sharing_mode());
+      } else if (
+          strcmp(backend_option.key, xnnpack::kWorkspacePoolSizeOption) == 0) {
+        backend_option.value =
+            static_cast<int>(workspace_manager_.get_pool_size());
+      } else {
+        ET_LOG(Error, "Unknown XNNPACK backend option %s", backend_option.key);
+        return Error::InvalidArgument;
+      }
+    }
+    return Error::Ok;
+  }
+
   void destroy(DelegateHandle* handle) const override {
     if (handle != nullptr) {
+      auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
+
       // This is needed to serialize access to xnn_delete_runtime which is not
       // thread safe. This can heppen when multiple threads call destroy() on
-      // the same backend instance.
-#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
-      const std::lock_guard<std::mutex> lock(workspace_mutex_);
-#endif
-
-      auto executor = static_cast<xnnpack::delegate::XNNExecutor*>(handle);
+      // the same backend instance. Keep a reference so that the workspace and
+      // its mutex outlive the executor.
+      const std::shared_ptr<XNNWorkspace> workspace = executor->get_workspace();
+      const std::lock_guard<std::mutex> lock(workspace->mutex());
 
 #ifdef ENABLE_XNNPACK_PROFILING
       executor->print_avg_op_timings();
 #endif
 
 #ifdef ENABLE_XNNPACK_WEIGHTS_CACHE
-      const std::lock_guard<std::mutex> lock_weights_cache(
+      const std::unique_lock<std::shared_mutex> lock_weights_cache(
           weights_cache_mutex_);
       weights_cache_->delete_packed_data(executor->get_packed_data_names());
 #endif
@@ -182,25 +258,29 @@ class XnnpackBackend final
   }
 
  private:
-  // This is a global workspace for all delegate instances.
-  mutable std::mutex workspace_mutex_;
-  std::unique_ptr<xnn_workspace, decltype(&xnn_release_workspace)> workspace_{
-      nullptr,
-      &xnn_release_workspace};
-
-  // Weights cache is global to all delegate instances.
-  mutable std::mutex weights_cache_mutex_;
+  // Hands out the workspaces of new delegate instances.
+  mutable XNNWorkspaceManager workspace_manager_{
+#ifdef ENABLE_XNNPACK_SHARED_WORKSPACE
+      WorkspaceSharingMode::Global
+#else
+      WorkspaceSharingMode::PerDelegate
+#endif
+  };
+
+  // Weights cache is global to all delegate instances. Executions only read
+  // it, so they take it shared.
+  mutable std::shared_mutex weights_cache_mutex_;
   std::unique_ptr<XNNWeightsCache> weights_cache_ =
       std::make_unique<XNNWeightsCache>();
 
   // Lock Hiearchy for Mutexes:
-  // workspace_mutex_
+  // XNNWorkspace::mutex()
   // weights_cache_mutex_
 };
 
 namespace {
 auto cls = XnnpackBackend();
-Backend backend{"XnnpackBackend", &cls};
+Backend backend{xnnpack::kXnnpackBackendName, &cls};
 static auto success_with_compiler = register_backend(backend);
 } // namespace
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+
+/// Name under which the XNNPACK backend is registered.
+constexpr char kXnnpackBackendName[] = "XnnpackBackend";
+
+/**
+ * String option: path of a file that keeps the packed weights of the weights
+ * cache across processes. Only available when the backend is built with the
+ * weights cache (ENABLE_XNNPACK_WEIGHTS_CACHE); see
+ * XNNWeightsCache::set_packed_weights_file().
+ *
+ * Example:
+ *
+ *   BackendOptions<1> options;
+ *   options.set_option(kWeightsCachePathOption, "/data/model.xnnwc");
+ *   set_option(kXnnpackBackendName, options.view());
+ */
+constexpr char kWeightsCachePathOption[] = "weights_cache_path";
+
+/**
+ * How delegate instances share XNNPACK workspaces, which hold the memory for
+ * intermediate tensors. Delegate instances sharing a workspace cannot execute
+ * at the same time, while every workspace costs the memory of the largest
+ * graph using it.
+ */
+enum class WorkspaceSharingMode : int {
+  /// Every delegate instance has its own workspace and never waits for
+  /// others. The default unless built with ENABLE_XNNPACK_SHARED_WORKSPACE.
+  PerDelegate = 0,
+  /// All delegate instances share one workspace, so executions are
+  /// serialized. The default when built with ENABLE_XNNPACK_SHARED_WORKSPACE.
+  Global = 1,
+  /// Delegate instances initialized on the same thread share a workspace.
+  /// Suits one thread per model, with models loaded on their own thread.
+  PerThread = 2,
+  /// Delegate instances are assigned round robin to a fixed number of
+  /// workspaces; see kWorkspacePoolSizeOption.
+  Pooled = 3,
+};
+
+/**
+ * Int option: the WorkspaceSharingMode for delegate instances initialized
+ * from now on. Existing instances keep their workspace.
+ */
+constexpr char kWorkspaceSharingModeOption[] = "workspace_sharing_mode";
+
+/**
+ * Int option: the number of workspaces in WorkspaceSharingMode::Pooled.
+ * Defaults to the number of hardware threads.
+ */
+constexpr char kWorkspacePoolSizeOption[] = "workspace_pool_size";
+
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
@@ -9,11 +9,30 @@
 #include <executorch/backends/xnnpack/runtime/XNNWeightsCache.h>
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/core/memory_allocator.h>
+#include <cpuinfo.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <xnnpack.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <map>
 #include <string>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Packed weights are only reused by builds of the same XNNPACK revision, which
+// the build system passes in. Without it, only reuse packed weights written by
+// this very build.
+#ifndef ET_XNNPACK_REVISION
+#define ET_XNNPACK_REVISION __DATE__ " " __TIME__
+#endif
+
 namespace executorch {
 namespace backends {
 namespace xnnpack {
@@ -22,6 +41,138 @@ namespace delegate {
 using executorch::ET_RUNTIME_NAMESPACE::NamedDataMap;
 using executorch::runtime::MemoryAllocator;
 
+namespace {
+
+/*
+ * Layout of the packed weights file:
+ *
+ *   PackedWeightsFileHeader
+ *   PackedWeightsFileEntry[num_entries]
+ *   names of the entries, not null terminated
+ *   padding up to data_offset
+ *   packed data of each entry, aligned to kPackedAllocationAlignment
+ *
+ * All integers are in host byte order; the fingerprint covers it.
+ */
+constexpr char kPackedWeightsFileMagic[4] = {'X', 'N', 'W', 'C'};
+constexpr uint32_t kPackedWeightsFileVersion = 1;
+
+struct PackedWeightsFileHeader {
+  char magic[4];
+  uint32_t version;
+  // See get_packed_weights_fingerprint().
+  uint64_t fingerprint;
+  uint64_t num_entries;
+  // Checksum of the entries and names, up to data_offset.
+  uint64_t index_checksum;
+  uint64_t data_offset;
+};
+
+struct PackedWeightsFileEntry {
+  // Position of the name relative to the end of the entries.
+  uint64_t name_offset;
+  uint64_t name_size;
+  // Position of the packed data relative to the start of the file.
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint64_t data_checksum;
+  uint32_t seed;
+  uint32_t padding;
+};
+
+/// Word-wise FNV-1a. Detects truncated or corrupted files; not cryptographic.
+uint64_t checksum(const uint8_t* data, size_t size, uint64_t hash = 0) {
+  constexpr uint64_t kPrime = 1099511628211ULL;
+  hash ^= 14695981039346656037ULL;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ data[i]) * kPrime;
+  }
+  return hash;
+}
+
+/**
+ * Identifies everything besides the cache key that decides how XNNPACK packs
+ * weights: its revision, the ISA extensions it may pick microkernels for, and
+ * the byte order and pointer size of the host.
+ */
+uint64_t get_packed_weights_fingerprint() {
+  cpuinfo_initialize();
+  // cpuinfo answers false for the extensions of other architectures.
+  const bool isa[] = {
+      cpuinfo_has_x86_sse4_1(),
+      cpuinfo_has_x86_avx(),
+      cpuinfo_has_x86_f16c(),
+      cpuinfo_has_x86_fma3(),
+      cpuinfo_has_x86_avx2(),
+      cpuinfo_has_x86_avx512f(),
+      cpuinfo_has_x86_avx512bw(),
+      cpuinfo_has_x86_avx512dq(),
+      cpuinfo_has_x86_avx512vl(),
+      cpuinfo_has_x86_avx512vnni(),
+      cpuinfo_has_x86_avxvnni(),
+      cpuinfo_has_arm_neon(),
+      cpuinfo_has_arm_neon_fp16(),
+      cpuinfo_has_arm_neon_fp16_arith(),
+      cpuinfo_has_arm_neon_dot(),
+      cpuinfo_has_arm_neon_bf16(),
+      cpuinfo_has_arm_i8mm(),
+      cpuinfo_has_arm_sve(),
+      cpuinfo_has_arm_sve2(),
+  };
+  uint64_t isa_flags = 0;
+  for (size_t i = 0; i < sizeof(isa) / sizeof(isa[0]); ++i) {
+    isa_flags |= static_cast<uint64_t>(isa[i]) << i;
+  }
+  const uint32_t byte_order = 0x01020304;
+  const uint32_t pointer_size = sizeof(void*);
+#ifdef ENABLE_XNNPACK_KLEIDI
+  const uint32_t kleidi = 1;
+#else
+  const uint32_t kleidi = 0;
+#endif
+  uint64_t hash = checksum(
+      reinterpret_cast<const uint8_t*>(ET_XNNPACK_REVISION),
+      sizeof(ET_XNNPACK_REVISION));
+  hash = checksum(
+      reinterpret_cast<const uint8_t*>(&isa_flags), sizeof(isa_flags), hash);
+  hash = checksum(
+      reinterpret_cast<const uint8_t*>(&byte_order), sizeof(byte_order), hash);
+  hash = checksum(
+      reinterpret_cast<const uint8_t*>(&pointer_size),
+      sizeof(pointer_size),
+      hash);
+  return checksum(
+      reinterpret_cast<const uint8_t*>(&kleidi), sizeof(kleidi), hash);
+}
+
+size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool write_all(FILE* file, const void* data, size_t size) {
+  return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+bool write_padding(FILE* file, size_t size) {
+  static const uint8_t kZeros[XNNWeightsCache::kPackedAllocationAlignment] = {};
+  while (size > 0) {
+    const size_t n = size < sizeof(kZeros) ? size : sizeof(kZeros);
+    if (!write_all(file, kZeros, n)) {
+      return false;
+    }
+    size -= n;
+  }
+  return true;
+}
+
+} // namespace
+
 XNNWeightsCache::XNNWeightsCache() {
   weights_cache_.context = this;
   weights_cache_.look_up = (size_t(*)(
@@ -38,6 +189,282 @@ XNNWeightsCache::XNNWeightsCache() {
       (enum xnn_status(*)(void*))XNNWeightsCache::delete_cache;
 }
 
+XNNWeightsCache::~XNNWeightsCache() {
+#ifndef _WIN32
+  for (const auto& mapping : file_mappings_) {
+    munmap(mapping.first, mapping.second);
+  }
+#endif
+}
+
+Error XNNWeightsCache::set_packed_weights_file(const std::string& path) {
+#ifdef _WIN32
+  (void)path;
+  ET_LOG(Error, "The XNNPACK packed weights file is not supported on Windows");
+  return Error::NotSupported;
+#else
+  packed_weights_path_ = path;
+  name_to_file_packed_data_.clear();
+  packed_weights_file_is_stale_ = !path.empty();
+  if (path.empty()) {
+    return Error::Ok;
+  }
+  // The cache works without the file, so only log why it can't be used.
+  if (load_packed_weights_file() == Error::Ok) {
+    packed_weights_file_is_stale_ = false;
+    for (const auto& entry : name_to_packed_data_metadata_) {
+      if (name_to_file_packed_data_.count(entry.first) == 0) {
+        packed_weights_file_is_stale_ = true;
+      }
+    }
+  }
+  return Error::Ok;
+#endif
+}
+
+Error XNNWeightsCache::load_packed_weights_file() {
+#ifdef _WIN32
+  return Error::NotSupported;
+#else
+  const char* path = packed_weights_path_.c_str();
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    ET_LOG(
+        Info,
+        "No XNNPACK packed weights file at %s: %s",
+        path,
+        strerror(errno));
+    return Error::NotFound;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(PackedWeightsFileHeader)) {
+    close(fd);
+    ET_LOG(Info, "Ignoring truncated XNNPACK packed weights file %s", path);
+    return Error::InvalidExternalData;
+  }
+  const size_t file_size = st.st_size;
+  void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    ET_LOG(Error, "Failed to map %s: %s", path, strerror(errno));
+    return Error::AccessFailed;
+  }
+
+  const uint8_t* base = static_cast<const uint8_t*>(mapping);
+  PackedWeightsFileHeader header;
+  memcpy(&header, base, sizeof(header));
+  const size_t max_entries = (file_size - sizeof(header)) /
+      sizeof(PackedWeightsFileEntry);
+  const size_t names_offset = sizeof(header) +
+      header.num_entries * sizeof(PackedWeightsFileEntry);
+  bool valid = memcmp(
+                   header.magic,
+                   kPackedWeightsFileMagic,
+                   sizeof(kPackedWeightsFileMagic)) == 0 &&
+      header.version == kPackedWeightsFileVersion &&
+      header.fingerprint == get_packed_weights_fingerprint() &&
+      header.num_entries <= max_entries && header.data_offset >= names_offset &&
+      header.data_offset <= file_size &&
+      header.index_checksum ==
+          checksum(
+              base + sizeof(header), header.data_offset - sizeof(header));
+
+  std::unordered_map<std::string, FilePackedData> entries;
+  for (size_t i = 0; valid && i < header.num_entries; ++i) {
+    PackedWeightsFileEntry entry;
+    memcpy(
+        &entry,
+        base + sizeof(header) + i * sizeof(PackedWeightsFileEntry),
+        sizeof(entry));
+    const size_t names_size = header.data_offset - names_offset;
+    valid = entry.name_offset <= names_size &&
+        entry.name_size <= names_size - entry.name_offset &&
+        entry.data_offset >= header.data_offset &&
+        entry.data_offset <= file_size &&
+        entry.data_size <= file_size - entry.data_offset &&
+        entry.data_offset % kPackedAllocationAlignment == 0;
+    if (valid) {
+      entries[std::string(
+          reinterpret_cast<const char*>(
+              base + names_offset + entry.name_offset),
+          entry.name_size)] = FilePackedData{
+          .seed = entry.seed,
+          .data = base + entry.data_offset,
+          .size = entry.data_size,
+          .checksum = entry.data_checksum,
+          .verified = false};
+    }
+  }
+  if (!valid) {
+    munmap(mapping, file_size);
+    ET_LOG(
+        Info,
+        "Ignoring XNNPACK packed weights file %s written by another build, "
+        "for another CPU, or corrupted",
+        path);
+    return Error::InvalidExternalData;
+  }
+
+  file_mappings_.emplace_back(mapping, file_size);
+  name_to_file_packed_data_ = std::move(entries);
+  return Error::Ok;
+#endif
+}
+
+Error XNNWeightsCache::save_packed_weights_file() {
+#ifdef _WIN32
+  return Error::NotSupported;
+#else
+  // Keep whatever the file held for other models, and sort by name so the
+  // same weights always produce the same file.
+  std::map<std::string, FilePackedData> packed_data;
+  for (const auto& entry : name_to_file_packed_data_) {
+    packed_data[entry.first] = entry.second;
+  }
+  for (const auto& entry : name_to_packed_data_metadata_) {
+    const PackedDataMeta& meta = entry.second;
+    const uint8_t* data =
+        static_cast<const uint8_t*>(packed_data_ptrs_[meta.offset]);
+    auto file_entry = packed_data.find(entry.first);
+    if (file_entry != packed_data.end() && file_entry->second.data == data) {
+      continue;
+    }
+    packed_data[entry.first] = FilePackedData{
+        .seed = meta.seed,
+        .data = data,
+        .size = meta.size,
+        .checksum = checksum(data, meta.size),
+        .verified = true};
+  }
+
+  PackedWeightsFileHeader header;
+  memcpy(header.magic, kPackedWeightsFileMagic, sizeof(header.magic));
+  header.version = kPackedWeightsFileVersion;
+  header.fingerprint = get_packed_weights_fingerprint();
+  header.num_entries = packed_data.size();
+
+  std::vector<uint8_t> index(
+      packed_data.size() * sizeof(PackedWeightsFileEntry));
+  size_t names_size = 0;
+  for (const auto& entry : packed_data) {
+    names_size += entry.first.size();
+  }
+  header.data_offset = align_up(
+      sizeof(header) + index.size() + names_size, kPackedAllocationAlignment);
+  size_t data_offset = header.data_offset;
+  size_t name_offset = 0;
+  size_t i = 0;
+  for (const auto& entry : packed_data) {
+    PackedWeightsFileEntry file_entry = {};
+    file_entry.name_offset = name_offset;
+    file_entry.name_size = entry.first.size();
+    file_entry.data_offset = data_offset;
+    file_entry.data_size = entry.second.size;
+    file_entry.data_checksum = entry.second.checksum;
+    file_entry.seed = entry.second.seed;
+    memcpy(
+        index.data() + i++ * sizeof(PackedWeightsFileEntry),
+        &file_entry,
+        sizeof(file_entry));
+    name_offset += entry.first.size();
+    data_offset += align_up(entry.second.size, kPackedAllocationAlignment);
+  }
+  for (const auto& entry : packed_data) {
+    index.insert(index.end(), entry.first.begin(), entry.first.end());
+  }
+  index.resize(header.data_offset - sizeof(header));
+  header.index_checksum = checksum(index.data(), index.size());
+
+  // Write a temporary file and rename it over the old one, so that a reader
+  // never sees a partially written file and our own mappings stay valid. The
+  // name is unique so that processes saving at the same time don't write to
+  // the same temporary file.
+  std::string tmp_path = packed_weights_path_ + ".XXXXXX";
+  int fd = mkstemp(&tmp_path[0]);
+  FILE* file = fd < 0 ? nullptr : fdopen(fd, "wb");
+  if (file == nullptr) {
+    ET_LOG(
+        Error,
+        "Failed to open %s for writing: %s",
+        tmp_path.c_str(),
+        strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+      remove(tmp_path.c_str());
+    }
+    return Error::AccessFailed;
+  }
+  bool ok = write_all(file, &header, sizeof(header)) &&
+      write_all(file, index.data(), index.size());
+  for (const auto& entry : packed_data) {
+    ok = ok && write_all(file, entry.second.data, entry.second.size) &&
+        write_padding(
+             file,
+             align_up(entry.second.size, kPackedAllocationAlignment) -
+                 entry.second.size);
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(tmp_path.c_str(), packed_weights_path_.c_str()) != 0) {
+    ET_LOG(
+        Error,
+        "Failed to write XNNPACK packed weights file %s: %s",
+        packed_weights_path_.c_str(),
+        strerror(errno));
+    remove(tmp_path.c_str());
+    return Error::AccessFailed;
+  }
+
+  // Point the file entries at the file just written. Otherwise the packed data
+  // added by this save would only be found in memory, and would be left out of
+  // the next save once delete_packed_data() freed it.
+  Error err = load_packed_weights_file();
+  if (err != Error::Ok) {
+    ET_LOG(
+        Error,
+        "Failed to map the XNNPACK packed weights file %s just written",
+        packed_weights_path_.c_str());
+  }
+  return err;
+#endif
+}
+
+size_t XNNWeightsCache::look_up_in_file(
+    const std::string& name,
+    uint32_t seed) {
+  auto entry = name_to_file_packed_data_.find(name);
+  if (entry == name_to_file_packed_data_.end() || entry->second.seed != seed) {
+    return SIZE_MAX;
+  }
+  FilePackedData& file_data = entry->second;
+  // Checking the data on first use only touches the pages of the weights that
+  // are actually used.
+  if (!file_data.verified) {
+    if (checksum(file_data.data, file_data.size) != file_data.checksum) {
+      ET_LOG(
+          Info,
+          "Checksum mismatch for %s in the XNNPACK packed weights file, "
+          "packing it again",
+          name.c_str());
+      name_to_file_packed_data_.erase(entry);
+      packed_weights_file_is_stale_ = true;
+      return SIZE_MAX;
+    }
+    file_data.verified = true;
+  }
+
+  size_t offset = packed_data_ptrs_.size();
+  packed_data_ptrs_.push_back(const_cast<uint8_t*>(file_data.data));
+  name_to_packed_data_metadata_[name] = PackedDataMeta{
+      .offset = offset,
+      .ref_count = 0,
+      .in_current_runtime = true,
+      .seed = seed,
+      .size = file_data.size};
+  num_packed_data_from_file_++;
+  return offset;
+}
+
 Error XNNWeightsCache::initialize_for_runtime(
     MemoryAllocator* runtime_allocator,
     const NamedDataMap* named_data_map) {
@@ -70,6 +497,13 @@ Result<std::vector<std::string>> XNNWeightsCache::finalize_for_runtime() {
     }
   }
 
+  if (!packed_weights_path_.empty() && packed_weights_file_is_stale_) {
+    // The cache works without the file, so only log if it can't be written.
+    if (save_packed_weights_file() == Error::Ok) {
+      packed_weights_file_is_stale_ = false;
+    }
+  }
+
   return packed_data_names;
 }
 
@@ -148,7 +582,7 @@ size_t XNNWeightsCache::look_up(
   auto packed_weight_entry =
       context->name_to_packed_data_metadata_.find(weight_bias_name);
   if (packed_weight_entry == context->name_to_packed_data_metadata_.end()) {
-    return SIZE_MAX;
+    return context->look_up_in_file(weight_bias_name, cache_key->seed);
   }
   packed_weight_entry->second.in_current_runtime = true;
 
@@ -205,9 +639,12 @@ size_t XNNWeightsCache::look_up_or_insert(
         .offset = next_offset,
         .ref_count =
             0, // ref_count is only incremented after finalizing for runtime
-        .in_current_runtime = true};
+        .in_current_runtime = true,
+        .seed = cache_key->seed,
+        .size = size};
     context->name_to_packed_data_metadata_[weight_bias_name] =
         packed_data_metadata;
+    context->packed_weights_file_is_stale_ = true;
   } else {
     ET_LOG(
         Info,
@@ -14,8 +14,10 @@
 #include <executorch/runtime/core/memory_allocator.h>
 #include <executorch/runtime/core/result.h>
 #include <executorch/runtime/executor/pte_data_map.h>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace executorch {
@@ -36,11 +38,19 @@ struct PackedDataMeta {
   // true if this packed data was inserted or looked up for the
   // current runtime being created
   bool in_current_runtime;
+  // Seed of the XNNPACK cache key and size of the packed data, which are saved
+  // along with it in the packed weights file
+  uint32_t seed;
+  size_t size;
 };
 
 class XNNWeightsCache {
  public:
   XNNWeightsCache();
+  ~XNNWeightsCache();
+
+  XNNWeightsCache(const XNNWeightsCache&) = delete;
+  XNNWeightsCache& operator=(const XNNWeightsCache&) = delete;
 
   /**
    * Initializes the XNNWeightsCache for the next xnn_create_runtime
@@ -107,6 +117,28 @@ class XNNWeightsCache {
    */
   Result<const uint8_t*> load_unpacked_data(const std::string& name);
 
+  /**
+   * Uses the file at `path` to keep packed weights across processes. The file
+   * is memory mapped, and packed weights found in it are handed to XNNPACK
+   * instead of being packed again. When a runtime packs weights that the file
+   * lacks, finalize_for_runtime() rewrites the file to include them.
+   *
+   * A missing file is created on the next write. A file written by another
+   * XNNPACK revision or for a CPU with other ISA extensions, or that fails its
+   * checksums, is ignored and replaced. An empty path stops using the file.
+   *
+   * Not supported on Windows.
+   */
+  Error set_packed_weights_file(const std::string& path);
+
+  /**
+   * Returns the number of packed data that were taken from the packed weights
+   * file rather than packed by XNNPACK.
+   */
+  inline size_t get_num_packed_data_from_file() {
+    return num_packed_data_from_file_;
+  }
+
   /**
    * Deletes the packed data associated with the names given.
    * Decrements the ref_count if the packed data is used by other
@@ -137,6 +169,32 @@ class XNNWeightsCache {
   // whether or not the weight cache is finalized
   bool is_finalized_;
 
+  // Packed data available in the packed weights file
+  struct FilePackedData {
+    uint32_t seed;
+    const uint8_t* data;
+    size_t size;
+    uint64_t checksum;
+    // true once the checksum has been checked against the data
+    bool verified;
+  };
+  // Path of the packed weights file, empty if there is none
+  std::string packed_weights_path_;
+  // Map of data names to packed data in the packed weights file
+  std::unordered_map<std::string, FilePackedData> name_to_file_packed_data_;
+  // Address and size of every mapping of a packed weights file. Mappings are
+  // kept until destruction since runtimes may still use their packed data.
+  std::vector<std::pair<void*, size_t>> file_mappings_;
+  // true if packed data was added that the packed weights file lacks
+  bool packed_weights_file_is_stale_ = false;
+  size_t num_packed_data_from_file_ = 0;
+
+  Error load_packed_weights_file();
+  Error save_packed_weights_file();
+  // Returns the offset of the packed data in the packed weights file for the
+  // given name and seed, adding it to the cache, or SIZE_MAX if there is none.
+  size_t look_up_in_file(const std::string& name, uint32_t seed);
+
   // Function pointers to override XNNPACK's default xnn_weights_cache_provider
   // functions.
   static size_t look_up(
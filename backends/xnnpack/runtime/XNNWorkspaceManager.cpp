@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNWorkspaceManager.h>
+
+#include <executorch/backends/xnnpack/runtime/XNNStatus.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+using executorch::runtime::Error;
+using executorch::runtime::Result;
+
+Result<std::shared_ptr<XNNWorkspace>> XNNWorkspace::create() {
+  xnn_workspace_t workspace = nullptr;
+  xnn_status status = xnn_create_workspace(&workspace);
+  if (status != xnn_status_success) {
+    ET_LOG(
+        Error,
+        "Failed to create XNN workspace, XNNPACK status: %s",
+        xnn_status_to_string(status));
+    return Error::Internal;
+  }
+  return std::shared_ptr<XNNWorkspace>(new XNNWorkspace(workspace));
+}
+
+XNNWorkspaceManager::XNNWorkspaceManager(WorkspaceSharingMode mode)
+    : mode_(mode), pool_size_(std::thread::hardware_concurrency()) {
+  if (pool_size_ == 0) {
+    pool_size_ = 1;
+  }
+}
+
+Error XNNWorkspaceManager::set_sharing_mode(int mode) {
+  if (mode < static_cast<int>(WorkspaceSharingMode::PerDelegate) ||
+      mode > static_cast<int>(WorkspaceSharingMode::Pooled)) {
+    ET_LOG(Error, "Invalid XNNPACK workspace sharing mode %d", mode);
+    return Error::InvalidArgument;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  mode_ = static_cast<WorkspaceSharingMode>(mode);
+  return Error::Ok;
+}
+
+WorkspaceSharingMode XNNWorkspaceManager::get_sharing_mode() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return mode_;
+}
+
+Error XNNWorkspaceManager::set_pool_size(int pool_size) {
+  if (pool_size <= 0) {
+    ET_LOG(Error, "Invalid XNNPACK workspace pool size %d", pool_size);
+    return Error::InvalidArgument;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  pool_size_ = pool_size;
+  return Error::Ok;
+}
+
+size_t XNNWorkspaceManager::get_pool_size() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return pool_size_;
+}
+
+Result<std::shared_ptr<XNNWorkspace>> XNNWorkspaceManager::acquire() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  switch (mode_) {
+    case WorkspaceSharingMode::PerDelegate:
+      return XNNWorkspace::create();
+    case WorkspaceSharingMode::Global:
+      return get_or_create(global_workspace_);
+    case WorkspaceSharingMode::PerThread: {
+      // Forget the workspaces of threads whose delegate instances are gone.
+      for (auto it = thread_workspaces_.begin();
+           it != thread_workspaces_.end();) {
+        it = it->second.expired() ? thread_workspaces_.erase(it) : ++it;
+      }
+      return get_or_create(thread_workspaces_[std::this_thread::get_id()]);
+    }
+    case WorkspaceSharingMode::Pooled: {
+      if (pooled_workspaces_.size() < pool_size_) {
+        pooled_workspaces_.resize(pool_size_);
+      }
+      const size_t index = next_pooled_workspace_++ % pool_size_;
+      return get_or_create(pooled_workspaces_[index]);
+    }
+  }
+  return Error::Internal;
+}
+
+Result<std::shared_ptr<XNNWorkspace>> XNNWorkspaceManager::get_or_create(
+    std::weak_ptr<XNNWorkspace>& slot) {
+  std::shared_ptr<XNNWorkspace> workspace = slot.lock();
+  if (workspace != nullptr) {
+    return workspace;
+  }
+  Result<std::shared_ptr<XNNWorkspace>> created = XNNWorkspace::create();
+  if (created.ok()) {
+    slot = created.get();
+  }
+  return created;
+}
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
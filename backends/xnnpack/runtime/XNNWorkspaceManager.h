@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/backends/xnnpack/runtime/XNNPACKBackend.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+
+#include <xnnpack.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace executorch {
+namespace backends {
+namespace xnnpack {
+namespace delegate {
+
+/**
+ * An XNNPACK workspace and the mutex that serializes the runtimes using it.
+ * Runtimes keep their workspace alive through a shared_ptr.
+ */
+class XNNWorkspace {
+ public:
+  static executorch::runtime::Result<std::shared_ptr<XNNWorkspace>> create();
+
+  XNNWorkspace(const XNNWorkspace&) = delete;
+  XNNWorkspace& operator=(const XNNWorkspace&) = delete;
+
+  inline xnn_workspace_t get() {
+    return workspace_.get();
+  }
+
+  /**
+   * Must be held while creating, reshaping, running or deleting a runtime
+   * that uses this workspace.
+   */
+  inline std::mutex& mutex() {
+    return mutex_;
+  }
+
+  /**
+   * Counts the reshapes of runtimes in this workspace. A reshape may move the
+   * memory of every runtime using the workspace, so a runtime whose last
+   * reshape is older has to reshape and set up again before running. Only
+   * access while holding mutex().
+   */
+  inline uint64_t get_generation() const {
+    return generation_;
+  }
+
+  inline uint64_t increment_generation() {
+    return ++generation_;
+  }
+
+ private:
+  explicit XNNWorkspace(xnn_workspace_t workspace)
+      : workspace_(workspace, &xnn_release_workspace) {}
+
+  std::unique_ptr<xnn_workspace, decltype(&xnn_release_workspace)> workspace_;
+  std::mutex mutex_;
+  uint64_t generation_ = 0;
+};
+
+/**
+ * Hands out workspaces to new delegate instances according to a
+ * WorkspaceSharingMode. Thread safe.
+ */
+class XNNWorkspaceManager {
+ public:
+  explicit XNNWorkspaceManager(WorkspaceSharingMode mode);
+
+  XNNWorkspaceManager(const XNNWorkspaceManager&) = delete;
+  XNNWorkspaceManager& operator=(const XNNWorkspaceManager&) = delete;
+
+  /**
+   * Sets the mode for delegate instances initialized from now on. Returns
+   * Error::InvalidArgument for an unknown mode.
+   */
+  executorch::runtime::Error set_sharing_mode(int mode);
+
+  WorkspaceSharingMode get_sharing_mode();
+
+  /**
+   * Sets the number of workspaces used in WorkspaceSharingMode::Pooled.
+   * Returns Error::InvalidArgument if it is not positive.
+   */
+  executorch::runtime::Error set_pool_size(int pool_size);
+
+  size_t get_pool_size();
+
+  /**
+   * Returns the workspace for a new delegate instance.
+   */
+  executorch::runtime::Result<std::shared_ptr<XNNWorkspace>> acquire();
+
+ private:
+  // Returns the workspace in `slot`, creating it if it expired.
+  executorch::runtime::Result<std::shared_ptr<XNNWorkspace>> get_or_create(
+      std::weak_ptr<XNNWorkspace>& slot);
+
+  std::mutex mutex_;
+  WorkspaceSharingMode mode_;
+  size_t pool_size_;
+  // Workspaces are only referenced weakly, so they are released with the last
+  // delegate instance using them.
+  std::weak_ptr<XNNWorkspace> global_workspace_;
+  std::unordered_map<std::thread::id, std::weak_ptr<XNNWorkspace>>
+      thread_workspaces_;
+  std::vector<std::weak_ptr<XNNWorkspace>> pooled_workspaces_;
+  size_t next_pooled_workspace_ = 0;
+};
+
+} // namespace delegate
+} // namespace xnnpack
+} // namespace backends
+} // namespace executorch
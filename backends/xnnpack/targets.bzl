@@ -41,10 +41,14 @@ def define_common_targets():
                 "runtime/*.cpp",
                 "runtime/profiling/*.cpp",
             ]),
-            headers = native.glob([
-                "runtime/*.h",
-                "runtime/profiling/*.h",
-            ]),
+            headers = native.glob(
+                [
+                    "runtime/*.h",
+                    "runtime/profiling/*.h",
+                ],
+                exclude = ["runtime/XNNPACKBackend.h"],
+            ),
+            exported_headers = ["runtime/XNNPACKBackend.h"],
             visibility = [
                 "//executorch/exir/backend:backend_lib",
                 "//executorch/exir/backend/test/...",
@@ -63,6 +67,7 @@ def define_common_targets():
             ],
             deps = [
                 third_party_dep("XNNPACK"),
+                third_party_dep("cpuinfo"),
                 "//executorch/backends/xnnpack/serialization:xnnpack_flatbuffer_header",
                 "//executorch/extension/threadpool:threadpool",
                 "//executorch/runtime/core/exec_aten/util:tensor_util" + aten_suffix,
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/backends/xnnpack/runtime/XNNWorkspaceManager.h>
+
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+#include <xnnpack.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using executorch::backends::xnnpack::WorkspaceSharingMode;
+using executorch::backends::xnnpack::delegate::XNNWorkspace;
+using executorch::backends::xnnpack::delegate::XNNWorkspaceManager;
+using executorch::runtime::Error;
+
+class XNNWorkspaceManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+    ASSERT_EQ(xnn_initialize(nullptr), xnn_status_success);
+  }
+
+  static std::shared_ptr<XNNWorkspace> acquire(XNNWorkspaceManager& manager) {
+    auto workspace = manager.acquire();
+    EXPECT_TRUE(workspace.ok());
+    return workspace.ok() ? workspace.get() : nullptr;
+  }
+};
+
+TEST_F(XNNWorkspaceManagerTest, PerDelegate) {
+  XNNWorkspaceManager manager(WorkspaceSharingMode::PerDelegate);
+  auto first = acquire(manager);
+  auto second = acquire(manager);
+  ASSERT_NE(first, nullptr);
+  EXPECT_NE(first, second);
+  EXPECT_NE(first->get(), second->get());
+}
+
+TEST_F(XNNWorkspaceManagerTest, Global) {
+  XNNWorkspaceManager manager(WorkspaceSharingMode::Global);
+  auto first = acquire(manager);
+  auto second = acquire(manager);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first, second);
+
+  // The workspace is released with its last user, and a new one is created
+  // on demand.
+  std::weak_ptr<XNNWorkspace> released = first;
+  first.reset();
+  second.reset();
+  EXPECT_TRUE(released.expired());
+  EXPECT_NE(acquire(manager), nullptr);
+}
+
+TEST_F(XNNWorkspaceManagerTest, PerThread) {
+  XNNWorkspaceManager manager(WorkspaceSharingMode::PerThread);
+  auto first = acquire(manager);
+  auto second = acquire(manager);
+  std::shared_ptr<XNNWorkspace> other_thread;
+  std::thread([&]() { other_thread = acquire(manager); }).join();
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, other_thread);
+}
+
+TEST_F(XNNWorkspaceManagerTest, Pooled) {
+  XNNWorkspaceManager manager(WorkspaceSharingMode::Pooled);
+  ASSERT_EQ(manager.set_pool_size(2), Error::Ok);
+  std::vector<std::shared_ptr<XNNWorkspace>> workspaces;
+  for (int i = 0; i < 6; ++i) {
+    workspaces.push_back(acquire(manager));
+  }
+  EXPECT_NE(workspaces[0], workspaces[1]);
+  for (int i = 2; i < 6; ++i) {
+    EXPECT_EQ(workspaces[i], workspaces[i % 2]);
+  }
+}
+
+TEST_F(XNNWorkspaceManagerTest, InvalidOptions) {
+  XNNWorkspaceManager manager(WorkspaceSharingMode::PerDelegate);
+  EXPECT_EQ(manager.set_sharing_mode(-1), Error::InvalidArgument);
+  EXPECT_EQ(manager.set_sharing_mode(4), Error::InvalidArgument);
+  EXPECT_EQ(manager.set_pool_size(0), Error::InvalidArgument);
+  EXPECT_EQ(manager.get_sharing_mode(), WorkspaceSharingMode::PerDelegate);
+
+  EXPECT_EQ(
+      manager.set_sharing_mode(static_cast<int>(WorkspaceSharingMode::Pooled)),
+      Error::Ok);
+  EXPECT_EQ(manager.get_sharing_mode(), WorkspaceSharingMode::Pooled);
+}
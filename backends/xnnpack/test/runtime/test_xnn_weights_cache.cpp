@@ -284,3 +284,86 @@ TEST_F(XNNWeightsCacheTest, ReusePackedWeights) {
   packed_data_names = weight_cache.get_packed_data_names();
   ASSERT_EQ(packed_data_names.size(), 0);
 }
+
+TEST_F(XNNWeightsCacheTest, ReusePackedWeightsFromFile) {
+  // Starts out empty, which the cache treats like a missing file.
+  TempFile packed_weights_file("");
+  std::vector<size_t> batches{1, 2, 3};
+  size_t input_channels = 3;
+  size_t output_channels = 4;
+  std::vector<float> input_tensor(6 * input_channels + 32, 1.0f);
+  std::vector<float> expected_output(6 * output_channels, 0.0f);
+  std::vector<float> output(6 * output_channels, 0.0f);
+
+  {
+    XNNWeightsCache weight_cache;
+    ASSERT_EQ(
+        weight_cache.set_packed_weights_file(packed_weights_file.path()),
+        Error::Ok);
+    weight_cache.initialize_for_runtime(
+        memory_allocator_.get(), data_map_.get());
+    BuildAndRunGraphWithWeightsCache(
+        weight_cache,
+        batches,
+        input_channels,
+        output_channels,
+        input_tensor.data(),
+        expected_output.data());
+    EXPECT_EQ(weight_cache.get_num_packed_data_from_file(), 0);
+  }
+
+  // A new cache, as in a new process, takes the packed weights from the file.
+  XNNWeightsCache weight_cache;
+  ASSERT_EQ(
+      weight_cache.set_packed_weights_file(packed_weights_file.path()),
+      Error::Ok);
+  weight_cache.initialize_for_runtime(memory_allocator_.get(), data_map_.get());
+  BuildAndRunGraphWithWeightsCache(
+      weight_cache,
+      batches,
+      input_channels,
+      output_channels,
+      input_tensor.data(),
+      output.data());
+  EXPECT_EQ(weight_cache.get_num_packed_data_from_file(), 1);
+  EXPECT_EQ(output, expected_output);
+
+  weight_cache.delete_packed_data(weight_cache.get_packed_data_names());
+  EXPECT_EQ(weight_cache.get_packed_data_names().size(), 0);
+}
+
+TEST_F(XNNWeightsCacheTest, PackedWeightsOutliveDeleteOnceSaved) {
+  TempFile packed_weights_file("");
+  std::vector<size_t> batches{1, 2, 3};
+  size_t input_channels = 3;
+  size_t output_channels = 4;
+  std::vector<float> input_tensor(6 * input_channels + 32, 1.0f);
+  std::vector<float> output(6 * output_channels, 0.0f);
+
+  XNNWeightsCache weight_cache;
+  ASSERT_EQ(
+      weight_cache.set_packed_weights_file(packed_weights_file.path()),
+      Error::Ok);
+  weight_cache.initialize_for_runtime(memory_allocator_.get(), data_map_.get());
+  BuildAndRunGraphWithWeightsCache(
+      weight_cache,
+      batches,
+      input_channels,
+      output_channels,
+      input_tensor.data(),
+      output.data());
+  EXPECT_EQ(weight_cache.get_num_packed_data_from_file(), 0);
+  weight_cache.delete_packed_data(weight_cache.get_packed_data_names());
+  EXPECT_EQ(weight_cache.get_packed_data_names().size(), 0);
+
+  // The saved file still holds the packed weights deleted from memory.
+  weight_cache.initialize_for_runtime(memory_allocator_.get(), data_map_.get());
+  BuildAndRunGraphWithWeightsCache(
+      weight_cache,
+      batches,
+      input_channels,
+      output_channels,
+      input_tensor.data(),
+      output.data());
+  EXPECT_EQ(weight_cache.get_num_packed_data_from_file(), 1);
+}
@@ -11,7 +11,9 @@
 #include <gtest/gtest.h>
 #include <xnnpack.h>
 
+using executorch::aten::TensorShapeDynamism;
 using executorch::backends::xnnpack::delegate::XNNExecutor;
+using executorch::ET_RUNTIME_NAMESPACE::BackendExecutionContext;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
 using executorch::runtime::testing::TensorFactory;
@@ -93,3 +95,74 @@ TEST(XNNExecutorTest, ArgumentWithTooManyDimensions) {
   // Check for invalid number of dimensions should fail without stack overflow.
   EXPECT_EQ(executor.prepare_args(args.data()), Error::InvalidArgument);
 }
+
+TEST(XNNExecutorTest, ReusesReshapeForRepeatedInputShapes) {
+  XNNExecutor executor;
+  xnn_subgraph_t subgraph = nullptr;
+  xnn_runtime_t rt = nullptr;
+  et_pal_init();
+  ASSERT_EQ(xnn_initialize(nullptr), xnn_status_success);
+  ASSERT_EQ(xnn_create_subgraph(2, 0, &subgraph), xnn_status_success);
+  std::unique_ptr<xnn_subgraph, decltype(&xnn_delete_subgraph)> auto_subgraph(
+      subgraph, xnn_delete_subgraph);
+
+  std::vector<size_t> dims = {1, 3};
+  auto input_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/0,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_INPUT,
+          &input_id));
+  auto output_id = XNN_INVALID_VALUE_ID;
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_tensor_value(
+          subgraph,
+          xnn_datatype_fp32,
+          dims.size(),
+          dims.data(),
+          nullptr,
+          /*external_id=*/1,
+          /*flags=*/XNN_VALUE_FLAG_EXTERNAL_OUTPUT,
+          &output_id));
+  ASSERT_EQ(
+      xnn_status_success,
+      xnn_define_clamp(subgraph, 0.0f, 6.0f, input_id, output_id, 0));
+
+  ASSERT_EQ(xnn_create_runtime(subgraph, &rt), xnn_status_success);
+  ASSERT_EQ(executor.initialize(rt, {0}, {1}, {}), Error::Ok);
+
+  TensorFactory<executorch::aten::ScalarType::Float> tf;
+  auto output_tensor = tf.zeros({4, 3}, TensorShapeDynamism::DYNAMIC_BOUND);
+  EValue output_ev(output_tensor);
+  BackendExecutionContext context;
+
+  // Alternate between shapes, repeating each one, so that the runtime is run
+  // both with and without being reshaped in between.
+  for (int32_t rows : {2, 2, 4, 4, 2}) {
+    std::vector<float> data(rows * 3);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<float>(i) - 2.0f;
+    }
+    auto input_tensor = tf.make({rows, 3}, data);
+    EValue input_ev(input_tensor);
+    std::array<EValue*, 2> args = {&input_ev, &output_ev};
+
+    ASSERT_EQ(executor.prepare_args(args.data()), Error::Ok);
+    ASSERT_EQ(executor.forward(context), Error::Ok);
+    ASSERT_EQ(executor.resize_outputs(args.data()), Error::Ok);
+
+    ASSERT_EQ(output_tensor.size(0), rows);
+    ASSERT_EQ(output_tensor.size(1), 3);
+    const float* out = output_tensor.const_data_ptr<float>();
+    for (size_t i = 0; i < data.size(); ++i) {
+      EXPECT_EQ(out[i], std::min(std::max(data[i], 0.0f), 6.0f));
+    }
+  }
+}
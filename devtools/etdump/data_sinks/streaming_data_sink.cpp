@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/data_sinks/streaming_data_sink.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio> // For FILE operations
+#include <cstring>
+#include <thread>
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace executorch {
+namespace etdump {
+
+struct StreamingDataSink::State {
+  State(FILE* file_, size_t capacity_)
+      : file(file_),
+        ring(new uint8_t[capacity_]),
+        capacity(capacity_),
+        mask(capacity_ - 1) {}
+
+  /// Body of the background thread: moves bytes from the ring to the file
+  /// until stopped and the ring is empty.
+  void drain();
+
+  /// Waits for the background thread while the ring is full or not yet
+  /// drained far enough.
+  static void wait_for_writer() {
+    std::this_thread::yield();
+  }
+
+  FILE* file;
+  std::unique_ptr<uint8_t[]> ring;
+  const size_t capacity;
+  const size_t mask;
+
+  // Total bytes published by the producer and consumed by the background
+  // thread. They only grow, so head - tail is the number of queued bytes. Kept
+  // on separate cache lines so that the two sides do not contend.
+  alignas(64) std::atomic<uint64_t> head{0};
+  alignas(64) std::atomic<uint64_t> tail{0};
+  // Bytes that the background thread has handed to the OS with fflush().
+  std::atomic<uint64_t> flushed{0};
+
+  std::atomic<bool> stop{false};
+  std::atomic<bool> failed{false};
+  std::atomic<uint64_t> num_stalls{0};
+
+  // Producer-side size of the logical debug buffer.
+  size_t debug_bytes = 0;
+
+  std::thread writer;
+};
+
+void StreamingDataSink::State::drain() {
+  uint64_t consumed = tail.load(std::memory_order_relaxed);
+  while (true) {
+    // Check for stop before loading head, so that everything the producer
+    // published before stopping is seen below.
+    const bool stopping = stop.load(std::memory_order_acquire);
+    const uint64_t published = head.load(std::memory_order_acquire);
+    if (published == consumed) {
+      if (flushed.load(std::memory_order_relaxed) != consumed) {
+        // Idle: let readers of the file see everything written so far.
+        if (!failed.load(std::memory_order_relaxed) && fflush(file) != 0) {
+          ET_LOG(Error, "Flushing the stream file failed.");
+          failed.store(true, std::memory_order_relaxed);
+        }
+        flushed.store(consumed, std::memory_order_release);
+        continue;
+      }
+      if (stopping) {
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+
+    const size_t start = consumed & mask;
+    const size_t length =
+        std::min<uint64_t>(published - consumed, capacity - start);
+    // After a failure, keep consuming so that writers never block forever;
+    // they report the error instead.
+    if (!failed.load(std::memory_order_relaxed)) {
+      const size_t written = fwrite(ring.get() + start, 1, length, file);
+      if (written != length) {
+        ET_LOG(Error, "Write failed: wrote %zu bytes of %zu", written, length);
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+    consumed += length;
+    tail.store(consumed, std::memory_order_release);
+  }
+}
+
+Result<StreamingDataSink> StreamingDataSink::create(
+    const char* file_path,
+    size_t ring_capacity) {
+  if (ring_capacity == 0) {
+    ET_LOG(Error, "Ring capacity must be positive.");
+    return Error::InvalidArgument;
+  }
+  size_t capacity = 1;
+  while (capacity < ring_capacity) {
+    capacity <<= 1;
+  }
+
+  FILE* file = fopen(file_path, "wb");
+  if (!file) {
+    ET_LOG(Error, "File %s cannot be accessed or created.", file_path);
+    return Error::AccessFailed;
+  }
+
+  auto state = std::make_unique<State>(file, capacity);
+  State* raw_state = state.get();
+  state->writer = std::thread([raw_state]() { raw_state->drain(); });
+  return StreamingDataSink(std::move(state));
+}
+
+StreamingDataSink::StreamingDataSink(std::unique_ptr<State> state)
+    : state_(std::move(state)) {}
+
+StreamingDataSink::StreamingDataSink(StreamingDataSink&& other) noexcept =
+    default;
+
+StreamingDataSink& StreamingDataSink::operator=(
+    StreamingDataSink&& other) noexcept {
+  if (this != &other) {
+    close();
+    state_ = std::move(other.state_);
+  }
+  return *this;
+}
+
+StreamingDataSink::~StreamingDataSink() {
+  close();
+}
+
+Error StreamingDataSink::push_frame(
+    StreamFrameKind kind,
+    uint64_t offset,
+    const void* data,
+    size_t size) {
+  if (!state_) {
+    ET_LOG(Error, "Stream closed, unable to write.");
+    return Error::AccessFailed;
+  }
+  State& state = *state_;
+
+  StreamFrameHeader header;
+  std::memcpy(header.magic, kStreamFrameMagic, sizeof(header.magic));
+  header.version = kStreamFrameVersion;
+  header.kind = static_cast<uint16_t>(kind);
+  header.offset = offset;
+  header.size = size;
+
+  // Only this thread moves head, so the relaxed load is up to date.
+  uint64_t head = state.head.load(std::memory_order_relaxed);
+  const auto push = [&state, &head](const uint8_t* src, size_t length) {
+    while (length > 0) {
+      if (state.failed.load(std::memory_order_relaxed)) {
+        return Error::Internal;
+      }
+      const uint64_t queued =
+          head - state.tail.load(std::memory_order_acquire);
+      const size_t available = state.capacity - queued;
+      if (available == 0) {
+        state.num_stalls.fetch_add(1, std::memory_order_relaxed);
+        do {
+          State::wait_for_writer();
+        } while (head - state.tail.load(std::memory_order_acquire) ==
+                 state.capacity);
+        continue;
+      }
+      const size_t n = std::min(length, available);
+      const size_t start = head & state.mask;
+      const size_t first = std::min(n, state.capacity - start);
+      std::memcpy(state.ring.get() + start, src, first);
+      std::memcpy(state.ring.get(), src + first, n - first);
+      head += n;
+      // Publish the bytes to the background thread.
+      state.head.store(head, std::memory_order_release);
+      src += n;
+      length -= n;
+    }
+    return Error::Ok;
+  };
+
+  Error err = push(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+  if (err != Error::Ok) {
+    return err;
+  }
+  return push(static_cast<const uint8_t*>(data), size);
+}
+
+Result<size_t> StreamingDataSink::write(const void* ptr, size_t size) {
+  if (!state_) {
+    ET_LOG(Error, "Stream closed, unable to write.");
+    return Error::AccessFailed;
+  }
+  const size_t offset = state_->debug_bytes;
+  if (size == 0) {
+    // No data to write, return current offset
+    return offset;
+  }
+  Error err = push_frame(StreamFrameKind::kDebugData, offset, ptr, size);
+  if (err != Error::Ok) {
+    return err;
+  }
+  state_->debug_bytes += size;
+  return offset;
+}
+
+Error StreamingDataSink::write_etdump(const void* data, size_t size) {
+  return push_frame(StreamFrameKind::kETDump, 0, data, size);
+}
+
+Error StreamingDataSink::flush() {
+  if (!state_) {
+    ET_LOG(Error, "Stream closed, unable to flush.");
+    return Error::AccessFailed;
+  }
+  const uint64_t target = state_->head.load(std::memory_order_relaxed);
+  while (state_->flushed.load(std::memory_order_acquire) < target &&
+         !state_->failed.load(std::memory_order_relaxed)) {
+    State::wait_for_writer();
+  }
+  return state_->failed.load(std::memory_order_relaxed) ? Error::Internal
+                                                        : Error::Ok;
+}
+
+size_t StreamingDataSink::get_used_bytes() const {
+  return state_ ? state_->debug_bytes : 0;
+}
+
+uint64_t StreamingDataSink::get_num_stalls() const {
+  return state_ ? state_->num_stalls.load(std::memory_order_relaxed) : 0;
+}
+
+void StreamingDataSink::close() {
+  if (state_) {
+    state_->stop.store(true, std::memory_order_release);
+    state_->writer.join();
+    fclose(state_->file);
+    state_.reset();
+  }
+}
+
+} // namespace etdump
+} // namespace executorch
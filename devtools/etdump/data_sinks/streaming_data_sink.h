@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/devtools/etdump/data_sinks/data_sink_base.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace executorch {
+namespace etdump {
+
+/**
+ * Header of every frame in a file written by StreamingDataSink. Fields are in
+ * the byte order of the device (little-endian on all supported targets) and
+ * the payload of `size` bytes follows the header directly.
+ */
+struct StreamFrameHeader {
+  /// Always kStreamFrameMagic.
+  char magic[4];
+  /// Currently always kStreamFrameVersion.
+  uint16_t version;
+  /// A StreamFrameKind.
+  uint16_t kind;
+  /// For kDebugData frames, the offset of the payload in the debug buffer.
+  /// Unused for kETDump frames.
+  uint64_t offset;
+  uint64_t size;
+};
+static_assert(sizeof(StreamFrameHeader) == 24, "Frame header layout changed");
+
+constexpr char kStreamFrameMagic[4] = {'E', 'T', 'S', 'F'};
+constexpr uint16_t kStreamFrameVersion = 1;
+
+enum class StreamFrameKind : uint16_t {
+  /// A blob written through DataSinkBase::write(), e.g. a logged tensor.
+  kDebugData = 1,
+  /// A complete, size-prefixed ETDump flatbuffer as returned by
+  /// ETDumpGen::get_etdump_data().
+  kETDump = 2,
+};
+
+/**
+ * StreamingDataSink streams debug data and ETDump flatbuffers to a file while
+ * the model runs, so long sessions neither need a debug buffer sized for the
+ * whole run nor stall on file I/O in the middle of an execution.
+ *
+ * Writes are copied into a fixed-size single-producer/single-consumer
+ * lock-free ring and a background thread drains the ring to the file. Every
+ * write becomes a frame (a StreamFrameHeader followed by the payload), so the
+ * file can be read incrementally while it is still being written, e.g. with
+ * `devtools/etdump/etdump_stream.py`. A trailing frame may be incomplete until
+ * the writer catches up.
+ *
+ * Debug data offsets returned by write() refer to a single logical debug
+ * buffer spanning the whole stream: the reader rebuilds it by placing each
+ * kDebugData payload at its offset. Attach the sink with keep_across_runs set
+ * so ETDumpGen keeps it for every execution. To stream the events as well,
+ * push the ETDump of each execution once it is done:
+ *
+ * @code
+ *   Result<StreamingDataSink> sink = StreamingDataSink::create(path);
+ *   ETDumpGen etdump_gen;
+ *   etdump_gen.set_data_sink(&sink.get(), true);
+ *   while (...) {
+ *     method.execute();
+ *     ETDumpResult result = etdump_gen.get_etdump_data();
+ *     sink->write_etdump(result.buf, result.size);
+ *     free(result.buf);
+ *   }
+ *   sink->close();
+ * @endcode
+ *
+ * Like ETDumpGen, a StreamingDataSink must not be written to from several
+ * threads at the same time. When the ring is full, writes wait for the
+ * background thread instead of dropping data, since dropped debug data would
+ * invalidate the offsets recorded in the ETDump.
+ */
+class StreamingDataSink : public DataSinkBase {
+ public:
+  static constexpr size_t kDefaultRingCapacity = 1 << 20;
+
+  /**
+   * Creates a StreamingDataSink that writes to a new file and starts its
+   * background writer thread.
+   *
+   * @param[in] file_path The path to the file for writing data.
+   * @param[in] ring_capacity The size of the ring in bytes, rounded up to a
+   *     power of two. Writes larger than the ring are streamed through it in
+   *     pieces.
+   * @return A Result object containing either:
+   *         - A StreamingDataSink object if success, or
+   *         - InvalidArgument Error if ring_capacity is 0, or
+   *         - AccessFailed Error when the file cannot be accessed or created
+   */
+  static ::executorch::runtime::Result<StreamingDataSink> create(
+      const char* file_path,
+      size_t ring_capacity = kDefaultRingCapacity);
+
+  /**
+   * Destructor that drains the ring and closes the file.
+   */
+  ~StreamingDataSink() override;
+
+  StreamingDataSink(const StreamingDataSink&) = delete;
+  StreamingDataSink& operator=(const StreamingDataSink&) = delete;
+
+  StreamingDataSink(StreamingDataSink&& other) noexcept;
+  StreamingDataSink& operator=(StreamingDataSink&& other) noexcept;
+
+  /**
+   * Queues a kDebugData frame holding a copy of the data.
+   *
+   * This function does not perform any alignment.
+   *
+   * @param[in] ptr A pointer to the data to be written.
+   * @param[in] size The size of the data in bytes.
+   * @return A Result object containing either:
+   *         - The offset of the data within the logical debug buffer, or
+   *         - AccessFailed Error if the sink has been closed, or
+   *         - Internal Error if writing to the file failed.
+   */
+  ::executorch::runtime::Result<size_t> write(const void* ptr, size_t size)
+      override;
+
+  /**
+   * Queues a kETDump frame holding a copy of a serialized ETDump.
+   *
+   * @param[in] data The buffer returned by ETDumpGen::get_etdump_data().
+   * @param[in] size Its size in bytes.
+   * @return Error::Ok, or the same errors as write().
+   */
+  ::executorch::runtime::Error write_etdump(const void* data, size_t size);
+
+  /**
+   * Waits until everything queued so far has been handed to the OS.
+   *
+   * @return Error::Ok, AccessFailed Error if the sink has been closed, or
+   *     Internal Error if writing to the file failed.
+   */
+  ::executorch::runtime::Error flush();
+
+  /**
+   * Gets the size of the logical debug buffer, i.e. the number of bytes
+   * passed to write() so far.
+   */
+  size_t get_used_bytes() const override;
+
+  /**
+   * Gets the number of times a write had to wait because the ring was full.
+   * A steadily growing count means the ring is too small for the rate of
+   * logged data.
+   */
+  uint64_t get_num_stalls() const;
+
+  /**
+   * Drains the ring, stops the background thread and closes the file, if it
+   * is open.
+   */
+  void close();
+
+ private:
+  struct State;
+
+  explicit StreamingDataSink(std::unique_ptr<State> state);
+
+  ::executorch::runtime::Error push_frame(
+      StreamFrameKind kind,
+      uint64_t offset,
+      const void* data,
+      size_t size);
+
+  std::unique_ptr<State> state_;
+};
+
+} // namespace etdump
+} // namespace executorch
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/etdump/data_sinks/streaming_data_sink.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gtest/gtest.h>
+#include <stdio.h> // tmpnam(), remove()
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+using ::executorch::etdump::kStreamFrameMagic;
+using ::executorch::etdump::kStreamFrameVersion;
+using ::executorch::etdump::StreamFrameHeader;
+using ::executorch::etdump::StreamFrameKind;
+using ::executorch::etdump::StreamingDataSink;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+namespace {
+
+struct Frame {
+  StreamFrameKind kind;
+  uint64_t offset;
+  std::string payload;
+};
+
+} // namespace
+
+class StreamingDataSinkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Initialize the runtime environment
+    torch::executor::runtime_init();
+
+    // Define the file path for testing
+    std::array<char, L_tmpnam> buf;
+    const char* ret = std::tmpnam(buf.data());
+    ASSERT_NE(ret, nullptr) << "Could not generate temp file";
+    buf[L_tmpnam - 1] = '\0';
+    file_path_ = std::string(buf.data()) + "-executorch-testing";
+  }
+
+  void TearDown() override {
+    // Remove the test file
+    std::remove(file_path_.c_str());
+  }
+
+  // Parses the complete frames of the file and fails on a partial one.
+  std::vector<Frame> read_frames() {
+    std::ifstream file(file_path_, std::ios::binary);
+    const std::string contents(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    std::vector<Frame> frames;
+    size_t pos = 0;
+    while (pos < contents.size()) {
+      StreamFrameHeader header;
+      EXPECT_LE(pos + sizeof(header), contents.size());
+      if (pos + sizeof(header) > contents.size()) {
+        break;
+      }
+      std::memcpy(&header, contents.data() + pos, sizeof(header));
+      EXPECT_EQ(std::memcmp(header.magic, kStreamFrameMagic, 4), 0);
+      EXPECT_EQ(header.version, kStreamFrameVersion);
+      pos += sizeof(header);
+      EXPECT_LE(pos + header.size, contents.size());
+      frames.push_back(
+          {static_cast<StreamFrameKind>(header.kind),
+           header.offset,
+           contents.substr(pos, header.size)});
+      pos += header.size;
+    }
+    return frames;
+  }
+
+  std::string file_path_;
+};
+
+TEST_F(StreamingDataSinkTest, CreationExpectFail) {
+  Result<StreamingDataSink> fail_with_invalid_file_path =
+      StreamingDataSink::create("");
+  EXPECT_EQ(fail_with_invalid_file_path.error(), Error::AccessFailed);
+
+  Result<StreamingDataSink> fail_with_empty_ring =
+      StreamingDataSink::create(file_path_.c_str(), 0);
+  EXPECT_EQ(fail_with_empty_ring.error(), Error::InvalidArgument);
+}
+
+TEST_F(StreamingDataSinkTest, WritesFramesInOrder) {
+  Result<StreamingDataSink> result =
+      StreamingDataSink::create(file_path_.c_str());
+  ASSERT_TRUE(result.ok());
+  StreamingDataSink* sink = &result.get();
+
+  Result<size_t> first = sink->write("Hello", 5);
+  ASSERT_TRUE(first.ok());
+  EXPECT_EQ(first.get(), 0);
+  ASSERT_EQ(sink->write_etdump("etdump", 6), Error::Ok);
+  Result<size_t> second = sink->write(", World!", 8);
+  ASSERT_TRUE(second.ok());
+  EXPECT_EQ(second.get(), 5);
+  // Empty writes do not produce frames.
+  EXPECT_EQ(sink->write(nullptr, 0).get(), 13);
+  EXPECT_EQ(sink->get_used_bytes(), 13);
+  sink->close();
+
+  std::vector<Frame> frames = read_frames();
+  ASSERT_EQ(frames.size(), 3);
+  EXPECT_EQ(frames[0].kind, StreamFrameKind::kDebugData);
+  EXPECT_EQ(frames[0].offset, 0);
+  EXPECT_EQ(frames[0].payload, "Hello");
+  EXPECT_EQ(frames[1].kind, StreamFrameKind::kETDump);
+  EXPECT_EQ(frames[1].payload, "etdump");
+  EXPECT_EQ(frames[2].kind, StreamFrameKind::kDebugData);
+  EXPECT_EQ(frames[2].offset, 5);
+  EXPECT_EQ(frames[2].payload, ", World!");
+}
+
+TEST_F(StreamingDataSinkTest, FlushMakesDataVisible) {
+  Result<StreamingDataSink> result =
+      StreamingDataSink::create(file_path_.c_str());
+  ASSERT_TRUE(result.ok());
+  StreamingDataSink* sink = &result.get();
+
+  ASSERT_TRUE(sink->write("abc", 3).ok());
+  ASSERT_EQ(sink->flush(), Error::Ok);
+
+  // The sink is still open.
+  std::vector<Frame> frames = read_frames();
+  ASSERT_EQ(frames.size(), 1);
+  EXPECT_EQ(frames[0].payload, "abc");
+}
+
+TEST_F(StreamingDataSinkTest, StreamsWritesLargerThanTheRing) {
+  // Rounded up to 16 bytes, smaller than a single frame header.
+  Result<StreamingDataSink> result =
+      StreamingDataSink::create(file_path_.c_str(), 10);
+  ASSERT_TRUE(result.ok());
+  StreamingDataSink* sink = &result.get();
+
+  std::string data(10000, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 7);
+  }
+  ASSERT_TRUE(sink->write(data.data(), data.size()).ok());
+  EXPECT_GT(sink->get_num_stalls(), 0);
+  sink->close();
+
+  std::vector<Frame> frames = read_frames();
+  ASSERT_EQ(frames.size(), 1);
+  EXPECT_EQ(frames[0].payload, data);
+}
+
+TEST_F(StreamingDataSinkTest, ManySmallWrites) {
+  Result<StreamingDataSink> result =
+      StreamingDataSink::create(file_path_.c_str(), 256);
+  ASSERT_TRUE(result.ok());
+  StreamingDataSink* sink = &result.get();
+
+  constexpr int kNumWrites = 5000;
+  size_t expected_offset = 0;
+  for (int i = 0; i < kNumWrites; ++i) {
+    const std::string data = std::to_string(i);
+    Result<size_t> offset = sink->write(data.data(), data.size());
+    ASSERT_TRUE(offset.ok());
+    ASSERT_EQ(offset.get(), expected_offset);
+    expected_offset += data.size();
+  }
+  sink->close();
+
+  std::vector<Frame> frames = read_frames();
+  ASSERT_EQ(frames.size(), kNumWrites);
+  for (int i = 0; i < kNumWrites; ++i) {
+    EXPECT_EQ(frames[i].payload, std::to_string(i));
+  }
+}
+
+TEST_F(StreamingDataSinkTest, WriteAfterCloseFails) {
+  Result<StreamingDataSink> result =
+      StreamingDataSink::create(file_path_.c_str());
+  ASSERT_TRUE(result.ok());
+  StreamingDataSink sink = std::move(result.get());
+  sink.close();
+
+  EXPECT_EQ(sink.write("abc", 3).error(), Error::AccessFailed);
+  EXPECT_EQ(sink.write_etdump("abc", 3), Error::AccessFailed);
+  EXPECT_EQ(sink.flush(), Error::AccessFailed);
+}
@@ -21,3 +21,4 @@ def define_common_targets():
 
     define_data_sink_test("buffer_data_sink")
     define_data_sink_test("file_data_sink")
+    define_data_sink_test("streaming_data_sink")
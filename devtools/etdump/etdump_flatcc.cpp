@@ -153,6 +153,7 @@ void ETDumpGen::reset() {
   state_ = State::Init;
   num_blocks_ = 0;
   data_sink_ = nullptr;
+  keep_data_sink_ = false;
   flatcc_builder_reset(builder_);
   flatbuffers_buffer_start(builder_, etdump_ETDump_file_identifier);
   etdump_ETDump_start_as_root_with_size(builder_);
@@ -165,7 +166,16 @@ void ETDumpGen::create_event_block(const char* name) {
   if (state_ == State::AddingEvents) {
     etdump_RunData_events_end(builder_);
   } else if (state_ == State::Done) {
-    reset();
+    if (keep_data_sink_) {
+      // The caller asked to log the debug data of every execution to the same
+      // sink, e.g. a StreamingDataSink that receives each ETDump.
+      DataSinkBase* data_sink = data_sink_;
+      reset();
+      data_sink_ = data_sink;
+      keep_data_sink_ = true;
+    } else {
+      reset();
+    }
   }
   if (num_blocks_ > 0) {
     etdump_ETDump_run_data_push_end(builder_);
@@ -552,11 +562,15 @@ Result<bool> ETDumpGen::set_debug_buffer(Span<uint8_t> buffer) {
 
   buffer_data_sink_ = std::move(bds_ret.get());
   data_sink_ = &buffer_data_sink_;
+  keep_data_sink_ = false;
   return true;
 }
 
-void ETDumpGen::set_data_sink(DataSinkBase* data_sink) {
+void ETDumpGen::set_data_sink(
+    DataSinkBase* data_sink,
+    bool keep_across_runs) {
   data_sink_ = data_sink;
+  keep_data_sink_ = keep_across_runs;
 }
 
 Result<bool> ETDumpGen::log_evalue(
@@ -155,7 +155,17 @@ class ETDumpGen : public ::executorch::runtime::EventTracer {
       EventTracerFilterBase* event_tracer_filter) override;
 
   Result<bool> set_debug_buffer(::executorch::runtime::Span<uint8_t> buffer);
-  void set_data_sink(DataSinkBase* data_sink);
+
+  /**
+   * Set the sink that receives the debug data logged by this ETDumpGen.
+   *
+   * By default the sink is cleared when create_event_block() starts a new
+   * ETDump after get_etdump_data(), so it has to be set again for every
+   * execution. If keep_across_runs is true, the sink is kept until it is
+   * replaced or reset() is called, and the caller must keep it alive until
+   * then.
+   */
+  void set_data_sink(DataSinkBase* data_sink, bool keep_across_runs = false);
   ETDumpResult get_etdump_data();
   size_t get_num_blocks();
   DataSinkBase* get_data_sink();
@@ -189,6 +199,8 @@ class ETDumpGen : public ::executorch::runtime::EventTracer {
   struct flatcc_builder* builder_;
   size_t num_blocks_ = 0;
   DataSinkBase* data_sink_;
+  // Whether data_sink_ survives the start of a new ETDump.
+  bool keep_data_sink_ = false;
 
   // It is only for set_debug_buffer function.
   BufferDataSink buffer_data_sink_;
@@ -0,0 +1,158 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+"""
+Reader for the framed files written by the runtime's StreamingDataSink
+(devtools/etdump/data_sinks/streaming_data_sink.h).
+
+Such a file is a sequence of frames, each a 24-byte header followed by a
+payload. Debug data frames hold blobs of the logical debug buffer at the offset
+given in their header; ETDump frames hold complete ETDump flatbuffers, usually
+one per execution. Since the runtime may still be appending to the file, the
+reader accepts the bytes in arbitrary pieces and keeps an incomplete trailing
+frame until the rest of it arrives.
+"""
+
+import struct
+from dataclasses import dataclass
+from enum import IntEnum
+from typing import BinaryIO, List, Optional, Union
+
+from executorch.devtools.etdump.schema_flatcc import ETDumpFlatCC
+from executorch.devtools.etdump.serialize import deserialize_from_etdump_flatcc
+
+STREAM_FRAME_MAGIC = b"ETSF"
+STREAM_FRAME_VERSION = 1
+
+# magic, version, kind, offset, size; see StreamFrameHeader.
+_FRAME_HEADER = struct.Struct("<4sHHQQ")
+
+
+class StreamFrameKind(IntEnum):
+    DEBUG_DATA = 1
+    ETDUMP = 2
+
+
+@dataclass
+class StreamFrame:
+    kind: StreamFrameKind
+    # Offset of the payload in the debug buffer, for DEBUG_DATA frames.
+    offset: int
+    data: bytes
+
+
+def is_etdump_stream(data: Union[bytes, str]) -> bool:
+    """
+    Returns whether the given bytes, or the file at the given path, start like a
+    StreamingDataSink stream rather than a plain ETDump.
+    """
+    if isinstance(data, str):
+        with open(data, "rb") as f:
+            data = f.read(len(STREAM_FRAME_MAGIC))
+    return data[: len(STREAM_FRAME_MAGIC)] == STREAM_FRAME_MAGIC
+
+
+class ETDumpStreamReader:
+    """
+    Incrementally parses a StreamingDataSink stream.
+
+    Example, following a file while the model runs:
+
+        reader = ETDumpStreamReader()
+        with open(path, "rb") as f:
+            while running():
+                for frame in reader.read_from(f):
+                    ...
+
+    The debug buffer rebuilt from the debug data frames seen so far is
+    available as `debug_buffer`, and get_etdump() merges the run data of all
+    complete ETDump frames into a single ETDump.
+    """
+
+    def __init__(self) -> None:
+        self._pending = bytearray()
+        self._etdump_frames: List[bytes] = []
+        self._etdumps: List[ETDumpFlatCC] = []
+        self.debug_buffer = bytearray()
+
+    def feed(self, data: bytes) -> List[StreamFrame]:
+        """
+        Parses the next bytes of the stream and returns the frames they
+        completed, in order.
+        """
+        self._pending += data
+        frames = []
+        pos = 0
+        while len(self._pending) - pos >= _FRAME_HEADER.size:
+            magic, version, kind, offset, size = _FRAME_HEADER.unpack_from(
+                self._pending, pos
+            )
+            if magic != STREAM_FRAME_MAGIC:
+                raise ValueError(f"Invalid ETDump stream frame magic {magic!r}")
+            if version != STREAM_FRAME_VERSION:
+                raise ValueError(f"Unsupported ETDump stream version {version}")
+            end = pos + _FRAME_HEADER.size + size
+            if end > len(self._pending):
+                break
+            frame = StreamFrame(
+                kind=StreamFrameKind(kind),
+                offset=offset,
+                data=bytes(self._pending[pos + _FRAME_HEADER.size : end]),
+            )
+            self._apply(frame)
+            frames.append(frame)
+            pos = end
+        del self._pending[:pos]
+        return frames
+
+    def read_from(self, f: BinaryIO) -> List[StreamFrame]:
+        """
+        Parses whatever can be read from the file object now. Calling it again
+        later picks up the data that was appended in the meantime.
+        """
+        return self.feed(f.read())
+
+    @property
+    def has_partial_frame(self) -> bool:
+        """Whether the stream seen so far ends in the middle of a frame."""
+        return len(self._pending) > 0
+
+    def get_etdump(self) -> Optional[ETDumpFlatCC]:
+        """
+        Returns one ETDump holding the run data of every ETDump frame seen so
+        far, or None if there was none.
+        """
+        while len(self._etdumps) < len(self._etdump_frames):
+            self._etdumps.append(
+                deserialize_from_etdump_flatcc(
+                    self._etdump_frames[len(self._etdumps)]
+                )
+            )
+        if not self._etdumps:
+            return None
+        run_data = []
+        for etdump in self._etdumps:
+            run_data.extend(etdump.run_data)
+        return ETDumpFlatCC(version=self._etdumps[0].version, run_data=run_data)
+
+    def _apply(self, frame: StreamFrame) -> None:
+        if frame.kind == StreamFrameKind.ETDUMP:
+            self._etdump_frames.append(frame.data)
+            return
+        end = frame.offset + len(frame.data)
+        if end > len(self.debug_buffer):
+            self.debug_buffer.extend(bytes(end - len(self.debug_buffer)))
+        self.debug_buffer[frame.offset : end] = frame.data
+
+
+def read_etdump_stream(path: str) -> ETDumpStreamReader:
+    """Parses the whole stream file at the given path."""
+    reader = ETDumpStreamReader()
+    with open(path, "rb") as f:
+        reader.read_from(f)
+    return reader
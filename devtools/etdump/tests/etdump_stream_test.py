@@ -0,0 +1,127 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+import os
+import struct
+import tempfile
+import unittest
+from unittest import mock
+
+import executorch.devtools.etdump.schema_flatcc as flatcc
+
+from executorch.devtools.etdump.etdump_stream import (
+    ETDumpStreamReader,
+    is_etdump_stream,
+    read_etdump_stream,
+    StreamFrameKind,
+)
+from executorch.devtools.etdump.serialize import (
+    deserialize_from_etdump_flatcc,
+    serialize_to_etdump_flatcc,
+)
+
+
+def make_frame(kind: StreamFrameKind, data: bytes, offset: int = 0) -> bytes:
+    return struct.pack("<4sHHQQ", b"ETSF", 1, kind, offset, len(data)) + data
+
+
+def make_etdump(block_name: str) -> flatcc.ETDumpFlatCC:
+    return flatcc.ETDumpFlatCC(
+        version=0,
+        run_data=[
+            flatcc.RunData(
+                name=block_name,
+                bundled_input_index=-1,
+                allocators=[],
+                events=[
+                    flatcc.Event(
+                        allocation_event=flatcc.AllocationEvent(
+                            allocator_id=1, allocation_size=8
+                        ),
+                        profile_event=None,
+                        debug_event=None,
+                    )
+                ],
+            )
+        ],
+    )
+
+
+class TestETDumpStream(unittest.TestCase):
+    def test_reads_frames_split_at_any_byte(self) -> None:
+        stream = (
+            make_frame(StreamFrameKind.DEBUG_DATA, b"Hello", 0)
+            + make_frame(StreamFrameKind.ETDUMP, b"etdump")
+            + make_frame(StreamFrameKind.DEBUG_DATA, b", World!", 5)
+        )
+        for split in range(len(stream) + 1):
+            reader = ETDumpStreamReader()
+            frames = reader.feed(stream[:split])
+            self.assertEqual(reader.has_partial_frame, split not in (0, 29, 59, 91))
+            frames += reader.feed(stream[split:])
+            self.assertFalse(reader.has_partial_frame)
+            self.assertEqual(
+                [frame.kind for frame in frames],
+                [
+                    StreamFrameKind.DEBUG_DATA,
+                    StreamFrameKind.ETDUMP,
+                    StreamFrameKind.DEBUG_DATA,
+                ],
+            )
+            self.assertEqual(frames[1].data, b"etdump")
+            self.assertEqual(bytes(reader.debug_buffer), b"Hello, World!")
+
+    def test_debug_buffer_follows_offsets(self) -> None:
+        reader = ETDumpStreamReader()
+        reader.feed(make_frame(StreamFrameKind.DEBUG_DATA, b"cd", 2))
+        reader.feed(make_frame(StreamFrameKind.DEBUG_DATA, b"ab", 0))
+        self.assertEqual(bytes(reader.debug_buffer), b"abcd")
+
+    def test_rejects_invalid_stream(self) -> None:
+        self.assertFalse(is_etdump_stream(b"\x00\x00\x00\x00ETDP"))
+        with self.assertRaises(ValueError):
+            ETDumpStreamReader().feed(b"\x00" * 24)
+
+    def test_follows_a_growing_file(self) -> None:
+        with tempfile.TemporaryDirectory() as d:
+            path = os.path.join(d, "run.etstream")
+            frame = make_frame(StreamFrameKind.DEBUG_DATA, b"abcdef", 0)
+            reader = ETDumpStreamReader()
+            with open(path, "wb") as out, open(path, "rb") as f:
+                out.write(frame[:10])
+                out.flush()
+                self.assertEqual(reader.read_from(f), [])
+                out.write(frame[10:])
+                out.flush()
+                frames = reader.read_from(f)
+            self.assertEqual(len(frames), 1)
+            self.assertTrue(is_etdump_stream(path))
+            self.assertEqual(bytes(reader.debug_buffer), b"abcdef")
+
+    def test_merges_etdump_frames(self) -> None:
+        with tempfile.TemporaryDirectory() as d:
+            path = os.path.join(d, "run.etstream")
+            with open(path, "wb") as f:
+                for name in ("run_0", "run_1"):
+                    f.write(
+                        make_frame(
+                            StreamFrameKind.ETDUMP,
+                            serialize_to_etdump_flatcc(make_etdump(name)),
+                        )
+                    )
+            # The runtime writes size-prefixed ETDumps, unlike the serializer.
+            with mock.patch(
+                "executorch.devtools.etdump.etdump_stream.deserialize_from_etdump_flatcc",
+                lambda data: deserialize_from_etdump_flatcc(data, size_prefixed=False),
+            ):
+                etdump = read_etdump_stream(path).get_etdump()
+        self.assertIsNotNone(etdump)
+        self.assertEqual(
+            [run_data.name for run_data in etdump.run_data], ["run_0", "run_1"]
+        )
+        self.assertIsNone(ETDumpStreamReader().get_etdump())
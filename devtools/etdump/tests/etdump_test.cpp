@@ -961,6 +961,55 @@ TEST_F(ProfilerETDumpTest, WriteAfterGetETDumpData) {
   }
 }
 
+TEST_F(ProfilerETDumpTest, DataSinkIsClearedForNextRunByDefault) {
+  for (size_t i = 0; i < 2; i++) {
+    Result<FileDataSink> file_data_sink =
+        FileDataSink::create(dump_file_path.c_str());
+    ASSERT_TRUE(file_data_sink.ok());
+    etdump_gen[i]->set_data_sink(&file_data_sink.get());
+
+    etdump_gen[i]->create_event_block("test_block");
+    EXPECT_EQ(etdump_gen[i]->get_data_sink(), &file_data_sink.get());
+    ETDumpResult result = etdump_gen[i]->get_etdump_data();
+    ASSERT_TRUE(result.buf != nullptr);
+    if (!etdump_gen[i]->is_static_etdump()) {
+      free(result.buf);
+    }
+
+    etdump_gen[i]->create_event_block("test_block");
+    EXPECT_EQ(etdump_gen[i]->get_data_sink(), nullptr);
+    etdump_gen[i]->reset();
+  }
+}
+
+TEST_F(ProfilerETDumpTest, DataSinkIsKeptAcrossRunsWhenRequested) {
+  TensorFactory<ScalarType::Float> tf;
+  EValue evalue(tf.ones({3, 2}));
+  const size_t tensor_size = evalue.toTensor().nbytes();
+
+  for (size_t i = 0; i < 2; i++) {
+    Result<FileDataSink> file_data_sink =
+        FileDataSink::create(dump_file_path.c_str());
+    ASSERT_TRUE(file_data_sink.ok());
+    etdump_gen[i]->set_data_sink(
+        &file_data_sink.get(), /*keep_across_runs=*/true);
+
+    for (size_t j = 0; j < 2; j++) {
+      etdump_gen[i]->create_event_block("test_block");
+      EXPECT_EQ(etdump_gen[i]->get_data_sink(), &file_data_sink.get());
+      etdump_gen[i]->log_evalue(evalue);
+      EXPECT_EQ(file_data_sink->get_used_bytes(), (j + 1) * tensor_size);
+
+      ETDumpResult result = etdump_gen[i]->get_etdump_data();
+      ASSERT_TRUE(result.buf != nullptr);
+      if (!etdump_gen[i]->is_static_etdump()) {
+        free(result.buf);
+      }
+    }
+    etdump_gen[i]->reset();
+  }
+}
+
 TEST_F(ProfilerETDumpTest, LogWithRegexAndUnsetDelegateDebugIdOnTensor) {
   check_log_with_filter(
       "filtered_event",
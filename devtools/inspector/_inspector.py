@@ -34,6 +34,11 @@ import numpy as np
 import pandas as pd
 
 from executorch.devtools.debug_format.et_schema import OperatorGraph, OperatorNode
+from executorch.devtools.etdump.etdump_stream import (
+    ETDumpStreamReader,
+    is_etdump_stream,
+    read_etdump_stream,
+)
 from executorch.devtools.etdump.schema_flatcc import (
     DebugEvent,
     ETDumpFlatCC,
@@ -1021,8 +1026,8 @@ class Inspector:
         and optional ETRecord path.
 
         Args:
-            etdump_path: Path to the ETDump file. Either this parameter or etdump_data should be provided.
-            etdump_data: ETDump binary. Either this parameter or etdump_path should be provided.
+            etdump_path: Path to the ETDump file, or to the stream file of a StreamingDataSink. Either this parameter or etdump_data should be provided.
+            etdump_data: ETDump binary, or the contents of a StreamingDataSink stream. Either this parameter or etdump_path should be provided.
             etrecord: Optional ETRecord object or path to the ETRecord file.
             source_time_scale: The time scale of the performance data retrieved from the runtime. The default time hook implentation in the runtime returns NS.
             target_time_scale: The target time scale to which the users want their performance data converted to. Defaults to MS.
@@ -1068,11 +1073,27 @@ class Inspector:
                 "Expecting exactly one of etdump_path or etdump_data to be specified."
             )
 
-        # Create EventBlocks from ETDump
-        etdump = gen_etdump_object(etdump_path=etdump_path, etdump_data=etdump_data)
+        # Create EventBlocks from ETDump, or from the stream of a
+        # StreamingDataSink which carries its own debug buffer.
+        stream: Optional[ETDumpStreamReader] = None
+        if etdump_path is not None and is_etdump_stream(etdump_path):
+            stream = read_etdump_stream(etdump_path)
+        elif etdump_data is not None and is_etdump_stream(etdump_data):
+            stream = ETDumpStreamReader()
+            stream.feed(etdump_data)
+        if stream is not None:
+            etdump = stream.get_etdump()
+            if etdump is None:
+                raise ValueError("The ETDump stream does not contain any ETDump.")
+        else:
+            etdump = gen_etdump_object(
+                etdump_path=etdump_path, etdump_data=etdump_data
+            )
         if debug_buffer_path is not None:
             with open(debug_buffer_path, "rb") as f:
                 output_buffer = f.read()
+        elif stream is not None:
+            output_buffer = bytes(stream.debug_buffer)
         else:
             output_buffer = None
             warnings.warn(
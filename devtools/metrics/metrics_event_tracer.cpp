@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/devtools/metrics/metrics_event_tracer.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/compiler.h>
+#include <executorch/runtime/platform/log.h>
+
+using ::executorch::runtime::ArrayRef;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::EValue;
+using ::executorch::runtime::EventTracerFilterBase;
+using ::executorch::runtime::kUnsetChainId;
+using ::executorch::runtime::kUnsetDebugHandle;
+using ::executorch::runtime::kUnsetDelegateDebugIntId;
+using ::executorch::runtime::LoggedEValueType;
+
+namespace executorch::metrics {
+
+namespace {
+
+constexpr uint32_t kSlotEmpty = 0;
+constexpr uint32_t kSlotClaimed = 1;
+constexpr uint32_t kSlotReady = 2;
+
+constexpr double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+size_t round_up_to_power_of_two(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+void copy_name(
+    const char* name,
+    char (&dst)[MetricsEventTracer::kMaxNameLength]) {
+  if (name == nullptr) {
+    dst[0] = '\0';
+    return;
+  }
+  const size_t len = strnlen(name, sizeof(dst) - 1);
+  memcpy(dst, name, len);
+  dst[len] = '\0';
+}
+
+/// Compares a stored (possibly truncated) name with a caller's name.
+bool name_equals(const char* stored, const char* name) {
+  if (name == nullptr) {
+    return stored[0] == '\0';
+  }
+  return strncmp(stored, name, MetricsEventTracer::kMaxNameLength - 1) == 0;
+}
+
+void atomic_max(std::atomic<uint64_t>& target, uint64_t value) {
+  uint64_t current = target.load(std::memory_order_relaxed);
+  while (current < value &&
+         !target.compare_exchange_weak(
+             current, value, std::memory_order_relaxed)) {
+  }
+}
+
+/// Appends formatted text to a fixed buffer, counting what did not fit.
+class TextWriter {
+ public:
+  TextWriter(char* buffer, size_t size) : buffer_(buffer), size_(size) {
+    if (size_ > 0) {
+      buffer_[0] = '\0';
+    }
+  }
+
+  ET_PRINTFLIKE(2, 3) void append(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    char* dst = length_ < size_ ? buffer_ + length_ : nullptr;
+    const size_t available = length_ < size_ ? size_ - length_ : 0;
+    const int written = vsnprintf(dst, available, format, args);
+    va_end(args);
+    if (written > 0) {
+      length_ += static_cast<size_t>(written);
+    }
+  }
+
+  /// Writes a label value, escaped as the exposition format requires.
+  void escaped(const char* value) {
+    for (const char* c = value; *c != '\0'; ++c) {
+      switch (*c) {
+        case '\\':
+          append("\\\\");
+          break;
+        case '"':
+          append("\\\"");
+          break;
+        case '\n':
+          append("\\n");
+          break;
+        default:
+          append("%c", *c);
+      }
+    }
+  }
+
+  size_t length() const {
+    return length_;
+  }
+
+ private:
+  char* buffer_;
+  size_t size_;
+  size_t length_ = 0;
+};
+
+} // namespace
+
+void LatencyHistogram::record(uint64_t value_ns) {
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_ns_.fetch_add(value_ns, std::memory_order_relaxed);
+  buckets_[bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+  atomic_max(max_ns_, value_ns);
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value_ns) {
+  if (value_ns < kSubBuckets) {
+    return static_cast<size_t>(value_ns);
+  }
+  if (value_ns >= (uint64_t(1) << kMaxExponent)) {
+    return kNumBuckets - 1;
+  }
+#if defined(__GNUC__)
+  const size_t exponent = 63 - __builtin_clzll(value_ns);
+#else
+  size_t exponent = 63;
+  while ((value_ns >> exponent) == 0) {
+    --exponent;
+  }
+#endif
+  const size_t sub_bucket =
+      (value_ns >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+  return kSubBuckets * (exponent - kSubBucketBits + 1) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_lower_bound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const size_t exponent = index / kSubBuckets - 1 + kSubBucketBits;
+  const uint64_t sub_bucket = index % kSubBuckets;
+  return (kSubBuckets + sub_bucket) << (exponent - kSubBucketBits);
+}
+
+uint64_t LatencyHistogram::value_at_quantile(double quantile) const {
+  // Use the bucket counts rather than count_ so that a concurrent record()
+  // cannot make the target unreachable.
+  uint64_t total = 0;
+  for (const auto& bucket : buckets_) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+  const double clamped = std::min(std::max(quantile, 0.0), 1.0);
+  const uint64_t target = std::max<uint64_t>(
+      1,
+      static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(total))));
+  const uint64_t max_value = max_ns();
+  uint64_t seen = 0;
+  for (size_t i = 0; i + 1 < kNumBuckets; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= target) {
+      return std::min(bucket_lower_bound(i + 1) - 1, max_value);
+    }
+  }
+  return max_value;
+}
+
+MetricsEventTracer::MetricsEventTracer(size_t max_events)
+    : slots_(new EventSlot[round_up_to_power_of_two(
+          std::max<size_t>(max_events, 1))]),
+      slot_mask_(round_up_to_power_of_two(std::max<size_t>(max_events, 1)) - 1),
+      ticks_to_ns_(et_pal_ticks_to_ns_multiplier()) {}
+
+MetricsEventTracer::~MetricsEventTracer() = default;
+
+uint64_t MetricsEventTracer::hash_key(const EventKey& key) {
+  // FNV-1a over the name, then the integer parts of the key.
+  uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](uint64_t byte) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  };
+  if (key.name != nullptr) {
+    for (size_t i = 0; key.name[i] != '\0' && i < kMaxNameLength - 1; ++i) {
+      mix(static_cast<unsigned char>(key.name[i]));
+    }
+  }
+  mix(static_cast<uint64_t>(key.kind));
+  mix(static_cast<uint32_t>(key.chain_id));
+  mix(key.debug_handle);
+  mix(static_cast<uint32_t>(key.delegate_debug_index));
+  return hash;
+}
+
+bool MetricsEventTracer::slot_matches(
+    const EventSlot& slot,
+    uint64_t hash,
+    const EventKey& key) {
+  return slot.hash == hash && slot.kind == key.kind &&
+      slot.chain_id == key.chain_id && slot.debug_handle == key.debug_handle &&
+      slot.delegate_debug_index == key.delegate_debug_index &&
+      name_equals(slot.name, key.name);
+}
+
+int64_t MetricsEventTracer::find_or_claim(const EventKey& key) {
+  const uint64_t hash = hash_key(key);
+  for (size_t probe = 0; probe <= slot_mask_; ++probe) {
+    const size_t index = (hash + probe) & slot_mask_;
+    EventSlot& slot = slots_[index];
+    uint32_t state = slot.state.load(std::memory_order_acquire);
+    if (state == kSlotEmpty) {
+      if (slot.state.compare_exchange_strong(
+              state, kSlotClaimed, std::memory_order_acquire)) {
+        slot.hash = hash;
+        slot.kind = key.kind;
+        copy_name(key.name, slot.name);
+        slot.chain_id = key.chain_id;
+        slot.debug_handle = key.debug_handle;
+        slot.delegate_debug_index = key.delegate_debug_index;
+        slot.state.store(kSlotReady, std::memory_order_release);
+        return static_cast<int64_t>(index);
+      }
+    }
+    // Another thread is filling in this slot; it only takes a few stores.
+    while (state != kSlotReady) {
+      state = slot.state.load(std::memory_order_acquire);
+    }
+    if (slot_matches(slot, hash, key)) {
+      return static_cast<int64_t>(index);
+    }
+  }
+  dropped_events_.fetch_add(1, std::memory_order_relaxed);
+  return -1;
+}
+
+int64_t MetricsEventTracer::find(const EventKey& key) const {
+  const uint64_t hash = hash_key(key);
+  for (size_t probe = 0; probe <= slot_mask_; ++probe) {
+    const size_t index = (hash + probe) & slot_mask_;
+    const EventSlot& slot = slots_[index];
+    const uint32_t state = slot.state.load(std::memory_order_acquire);
+    if (state == kSlotEmpty) {
+      return -1;
+    }
+    if (state == kSlotReady && slot_matches(slot, hash, key)) {
+      return static_cast<int64_t>(index);
+    }
+  }
+  return -1;
+}
+
+void MetricsEventTracer::record(
+    int64_t slot_index,
+    et_timestamp_t start,
+    et_timestamp_t end) {
+  if (slot_index < 0) {
+    return;
+  }
+  const uint64_t ticks = end > start ? end - start : 0;
+  const uint64_t ns = ticks * ticks_to_ns_.numerator / ticks_to_ns_.denominator;
+  slots_[slot_index].latency.record(ns);
+}
+
+MetricsEventTracer::EventKey MetricsEventTracer::delegate_key(
+    const char* name,
+    DelegateDebugIntId index) const {
+  // Delegate events belong to the instruction that called the delegate.
+  if (index == kUnsetDelegateDebugIntId) {
+    return EventKey{
+        EventKind::kDelegateName,
+        name,
+        chain_id_,
+        debug_handle_,
+        kUnsetDelegateDebugIntId};
+  }
+  return EventKey{
+      EventKind::kDelegateIndex, nullptr, chain_id_, debug_handle_, index};
+}
+
+void MetricsEventTracer::create_event_block(const char* /*name*/) {}
+
+EventTracerEntry MetricsEventTracer::start_profiling(
+    const char* name,
+    ChainID chain_id,
+    DebugHandle debug_handle) {
+  EventTracerEntry prof_entry;
+  if (chain_id == kUnsetChainId) {
+    prof_entry.chain_id = chain_id_;
+    prof_entry.debug_handle = debug_handle_;
+  } else {
+    prof_entry.chain_id = chain_id;
+    prof_entry.debug_handle = debug_handle;
+  }
+  prof_entry.event_id = find_or_claim(EventKey{
+      EventKind::kProfiling,
+      name,
+      prof_entry.chain_id,
+      prof_entry.debug_handle,
+      kUnsetDelegateDebugIntId});
+  prof_entry.delegate_event_id_type =
+      ::executorch::runtime::DelegateDebugIdType::kNone;
+  prof_entry.start_time = ::executorch::runtime::pal_current_ticks();
+  return prof_entry;
+}
+
+void MetricsEventTracer::end_profiling(EventTracerEntry prof_entry) {
+  record(
+      prof_entry.event_id,
+      prof_entry.start_time,
+      ::executorch::runtime::pal_current_ticks());
+}
+
+EventTracerEntry MetricsEventTracer::start_profiling_delegate(
+    const char* name,
+    DelegateDebugIntId delegate_debug_index) {
+  ET_CHECK_MSG(
+      (name == nullptr) ^ (delegate_debug_index == kUnsetDelegateDebugIntId),
+      "Only name or delegate_debug_index can be valid. Check DelegateMappingBuilder documentation for more details.");
+  EventTracerEntry prof_entry;
+  prof_entry.chain_id = chain_id_;
+  prof_entry.debug_handle = debug_handle_;
+  prof_entry.event_id =
+      find_or_claim(delegate_key(name, delegate_debug_index));
+  prof_entry.delegate_event_id_type = name == nullptr
+      ? ::executorch::runtime::DelegateDebugIdType::kInt
+      : ::executorch::runtime::DelegateDebugIdType::kStr;
+  prof_entry.start_time = ::executorch::runtime::pal_current_ticks();
+  return prof_entry;
+}
+
+void MetricsEventTracer::end_profiling_delegate(
+    EventTracerEntry event_tracer_entry,
+    const void* /*metadata*/,
+    size_t /*metadata_len*/) {
+  record(
+      event_tracer_entry.event_id,
+      event_tracer_entry.start_time,
+      ::executorch::runtime::pal_current_ticks());
+}
+
+void MetricsEventTracer::log_profiling_delegate(
+    const char* name,
+    DelegateDebugIntId delegate_debug_index,
+    et_timestamp_t start_time,
+    et_timestamp_t end_time,
+    const void* /*metadata*/,
+    size_t /*metadata_len*/) {
+  ET_CHECK_MSG(
+      (name == nullptr) ^ (delegate_debug_index == kUnsetDelegateDebugIntId),
+      "Only name or delegate_debug_index can be valid. Check DelegateMappingBuilder documentation for more details.");
+  record(
+      find_or_claim(delegate_key(name, delegate_debug_index)),
+      start_time,
+      end_time);
+}
+
+AllocatorID MetricsEventTracer::track_allocator(const char* name) {
+  const uint32_t index =
+      num_allocators_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= kMaxAllocators) {
+    ET_LOG(
+        Error,
+        "Only %zu allocators can be tracked; ignoring %s",
+        kMaxAllocators,
+        name != nullptr ? name : "(null)");
+    return static_cast<AllocatorID>(kMaxAllocators);
+  }
+  copy_name(name, allocators_[index].name);
+  allocators_[index].ready.store(true, std::memory_order_release);
+  return index;
+}
+
+void MetricsEventTracer::track_allocation(AllocatorID id, size_t size) {
+  if (id >= kMaxAllocators) {
+    return;
+  }
+  allocators_[id].allocations.fetch_add(1, std::memory_order_relaxed);
+  allocators_[id].bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+Result<bool> MetricsEventTracer::log_evalue(
+    const EValue& /*evalue*/,
+    LoggedEValueType /*evalue_type*/) {
+  return false;
+}
+
+Result<bool> MetricsEventTracer::log_intermediate_output_delegate(
+    const char* /*name*/,
+    DelegateDebugIntId /*delegate_debug_index*/,
+    const executorch::aten::Tensor& /*output*/) {
+  return false;
+}
+
+Result<bool> MetricsEventTracer::log_intermediate_output_delegate(
+    const char* /*name*/,
+    DelegateDebugIntId /*delegate_debug_index*/,
+    const ArrayRef<executorch::aten::Tensor> /*output*/) {
+  return false;
+}
+
+Result<bool> MetricsEventTracer::log_intermediate_output_delegate(
+    const char* /*name*/,
+    DelegateDebugIntId /*delegate_debug_index*/,
+    const int& /*output*/) {
+  return false;
+}
+
+Result<bool> MetricsEventTracer::log_intermediate_output_delegate(
+    const char* /*name*/,
+    DelegateDebugIntId /*delegate_debug_index*/,
+    const bool& /*output*/) {
+  return false;
+}
+
+Result<bool> MetricsEventTracer::log_intermediate_output_delegate(
+    const char* /*name*/,
+    DelegateDebugIntId /*delegate_debug_index*/,
+    const double& /*output*/) {
+  return false;
+}
+
+void MetricsEventTracer::set_delegation_intermediate_output_filter(
+    EventTracerFilterBase* /*event_tracer_filter*/) {}
+
+Result<EventStats> MetricsEventTracer::stats_for(const EventKey& key) const {
+  const int64_t index = find(key);
+  if (index < 0) {
+    return Error::NotFound;
+  }
+  const LatencyHistogram& latency = slots_[index].latency;
+  return EventStats{
+      latency.count(),
+      latency.total_ns(),
+      latency.max_ns(),
+      latency.value_at_quantile(0.5),
+      latency.value_at_quantile(0.9),
+      latency.value_at_quantile(0.99),
+      latency.value_at_quantile(0.999)};
+}
+
+Result<EventStats> MetricsEventTracer::get_event_stats(
+    const char* name,
+    ChainID chain_id,
+    DebugHandle debug_handle) const {
+  return stats_for(EventKey{
+      EventKind::kProfiling,
+      name,
+      chain_id,
+      debug_handle,
+      kUnsetDelegateDebugIntId});
+}
+
+Result<EventStats> MetricsEventTracer::get_delegate_event_stats(
+    const char* name,
+    DelegateDebugIntId delegate_debug_index) const {
+  // Lookups ignore which instruction called the delegate, so scan for the
+  // first match rather than hashing.
+  const EventKind kind = delegate_debug_index == kUnsetDelegateDebugIntId
+      ? EventKind::kDelegateName
+      : EventKind::kDelegateIndex;
+  for (size_t i = 0; i <= slot_mask_; ++i) {
+    const EventSlot& slot = slots_[i];
+    if (slot.state.load(std::memory_order_acquire) == kSlotReady &&
+        slot.kind == kind &&
+        slot.delegate_debug_index == delegate_debug_index &&
+        (kind == EventKind::kDelegateIndex || name_equals(slot.name, name))) {
+      return stats_for(EventKey{
+          slot.kind,
+          slot.name,
+          slot.chain_id,
+          slot.debug_handle,
+          slot.delegate_debug_index});
+    }
+  }
+  return Error::NotFound;
+}
+
+size_t MetricsEventTracer::write_prometheus_text(char* buffer, size_t size)
+    const {
+  TextWriter out(buffer, size);
+
+  const auto write_summaries = [&](bool delegates) {
+    const char* metric = delegates ? "executorch_delegate_event_seconds"
+                                   : "executorch_event_seconds";
+    out.append(
+        "# HELP %s %s\n# TYPE %s summary\n",
+        metric,
+        delegates ? "Latency of delegate events."
+                  : "Latency of profiling events, such as operator calls.",
+        metric);
+    for (size_t i = 0; i <= slot_mask_; ++i) {
+      const EventSlot& slot = slots_[i];
+      if (slot.state.load(std::memory_order_acquire) != kSlotReady ||
+          (slot.kind != EventKind::kProfiling) != delegates) {
+        continue;
+      }
+      const LatencyHistogram& latency = slot.latency;
+      // Each series repeats the same labels.
+      const auto labels = [&]() {
+        out.append("name=\"");
+        if (slot.kind == EventKind::kDelegateIndex) {
+          out.append("%" PRId32, slot.delegate_debug_index);
+        } else {
+          out.escaped(slot.name);
+        }
+        out.append("\"");
+        if (slot.chain_id != kUnsetChainId) {
+          out.append(
+              ",chain=\"%" PRId32 "\",debug_handle=\"%" PRIu32 "\"",
+              slot.chain_id,
+              slot.debug_handle);
+        }
+      };
+      for (const double quantile : kQuantiles) {
+        out.append("%s{", metric);
+        labels();
+        out.append(
+            ",quantile=\"%g\"} %.9g\n",
+            quantile,
+            static_cast<double>(latency.value_at_quantile(quantile)) * 1e-9);
+      }
+      out.append("%s_sum{", metric);
+      labels();
+      out.append(
+          "} %.9g\n", static_cast<double>(latency.total_ns()) * 1e-9);
+      out.append("%s_count{", metric);
+      labels();
+      out.append("} %" PRIu64 "\n", latency.count());
+    }
+  };
+  write_summaries(/*delegates=*/false);
+  write_summaries(/*delegates=*/true);
+
+  out.append(
+      "# HELP executorch_allocations_total Allocations made by tracked "
+      "allocators.\n# TYPE executorch_allocations_total counter\n");
+  const uint32_t num_allocators = std::min<uint32_t>(
+      num_allocators_.load(std::memory_order_relaxed), kMaxAllocators);
+  for (uint32_t i = 0; i < num_allocators; ++i) {
+    if (allocators_[i].ready.load(std::memory_order_acquire)) {
+      out.append("executorch_allocations_total{allocator=\"");
+      out.escaped(allocators_[i].name);
+      out.append(
+          "\"} %" PRIu64 "\n",
+          allocators_[i].allocations.load(std::memory_order_relaxed));
+    }
+  }
+  out.append(
+      "# HELP executorch_allocated_bytes_total Bytes allocated by tracked "
+      "allocators.\n# TYPE executorch_allocated_bytes_total counter\n");
+  for (uint32_t i = 0; i < num_allocators; ++i) {
+    if (allocators_[i].ready.load(std::memory_order_acquire)) {
+      out.append("executorch_allocated_bytes_total{allocator=\"");
+      out.escaped(allocators_[i].name);
+      out.append(
+          "\"} %" PRIu64 "\n",
+          allocators_[i].bytes.load(std::memory_order_relaxed));
+    }
+  }
+
+  out.append(
+      "# HELP executorch_dropped_events_total Events not recorded because "
+      "the event table was full.\n"
+      "# TYPE executorch_dropped_events_total counter\n"
+      "executorch_dropped_events_total %" PRIu64 "\n",
+      dropped_events());
+  return out.length();
+}
+
+} // namespace executorch::metrics
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <executorch/runtime/core/event_tracer.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/platform.h>
+
+namespace executorch::metrics {
+
+using ::executorch::runtime::AllocatorID;
+using ::executorch::runtime::ChainID;
+using ::executorch::runtime::DebugHandle;
+using ::executorch::runtime::DelegateDebugIntId;
+using ::executorch::runtime::EventTracerEntry;
+using ::executorch::runtime::Result;
+
+/**
+ * Latency histogram with a fixed relative precision, in the spirit of
+ * HdrHistogram: every power-of-two range of nanoseconds is split into
+ * kSubBuckets linear buckets, so any recorded value is reported with at most
+ * 1 / kSubBuckets relative error. Recording is a handful of relaxed atomic
+ * increments and never blocks.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 2;
+  static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+  /// Values of 2^kMaxExponent ns (about 137 s) and above share the last
+  /// bucket.
+  static constexpr size_t kMaxExponent = 37;
+  static constexpr size_t kNumBuckets =
+      (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(uint64_t value_ns);
+
+  uint64_t count() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t total_ns() const {
+    return total_ns_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t max_ns() const {
+    return max_ns_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the smallest value such that at least `quantile` of the recorded
+   * values are at or below it, rounded up to its bucket's upper bound (and
+   * capped by the maximum recorded value). Returns 0 if nothing was recorded.
+   *
+   * @param[in] quantile A value in [0, 1].
+   */
+  uint64_t value_at_quantile(double quantile) const;
+
+  static size_t bucket_index(uint64_t value_ns);
+  /// The smallest value that lands in bucket `index`.
+  static uint64_t bucket_lower_bound(size_t index);
+
+ private:
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> total_ns_{0};
+  std::atomic<uint64_t> max_ns_{0};
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+};
+
+/**
+ * Aggregates of one profiling event, as returned by
+ * MetricsEventTracer::get_event_stats().
+ */
+struct EventStats {
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t p50_ns;
+  uint64_t p90_ns;
+  uint64_t p99_ns;
+  uint64_t p999_ns;
+};
+
+/**
+ * MetricsEventTracer is an EventTracer meant to stay attached in production.
+ * Instead of recording every event like ETDumpGen, it keeps running
+ * aggregates: for every distinct profiling event (name, chain id and debug
+ * handle, so each operator instruction of a method gets its own entry) and
+ * every delegate event, a call count and a LatencyHistogram; for every
+ * tracked allocator, the number of allocations and bytes allocated.
+ *
+ * All recording paths are lock-free and may be called from several threads
+ * running methods concurrently. The first occurrence of an event claims a slot
+ * in a fixed-capacity open-addressing table; later occurrences only hash the
+ * key and bump atomic counters. Events that do not fit in the table are
+ * counted as dropped.
+ *
+ * The aggregates can be exported at any time, concurrently with recording, in
+ * the Prometheus text exposition format with write_prometheus_text(), e.g. to
+ * serve them to a local scraper.
+ *
+ * Note that the runtime only calls into an EventTracer when it is built with
+ * ET_EVENT_TRACER_ENABLED.
+ */
+class MetricsEventTracer : public ::executorch::runtime::EventTracer {
+ public:
+  /// Longer event and allocator names are truncated.
+  static constexpr size_t kMaxNameLength = 64;
+  static constexpr size_t kMaxAllocators = 32;
+
+  /**
+   * @param[in] max_events The number of distinct events that can be tracked.
+   * Rounded up to a power of two. Each event takes a bit over 1 KiB.
+   */
+  explicit MetricsEventTracer(size_t max_events = 1024);
+  ~MetricsEventTracer() override;
+
+  MetricsEventTracer(const MetricsEventTracer&) = delete;
+  MetricsEventTracer& operator=(const MetricsEventTracer&) = delete;
+
+  void create_event_block(const char* name) override;
+  EventTracerEntry start_profiling(
+      const char* name,
+      ChainID chain_id = ::executorch::runtime::kUnsetChainId,
+      DebugHandle debug_handle = ::executorch::runtime::kUnsetDebugHandle)
+      override;
+  void end_profiling(EventTracerEntry prof_entry) override;
+  EventTracerEntry start_profiling_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index) override;
+  void end_profiling_delegate(
+      EventTracerEntry event_tracer_entry,
+      const void* metadata = nullptr,
+      size_t metadata_len = 0) override;
+  void log_profiling_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index,
+      et_timestamp_t start_time,
+      et_timestamp_t end_time,
+      const void* metadata = nullptr,
+      size_t metadata_len = 0) override;
+  void track_allocation(AllocatorID id, size_t size) override;
+  AllocatorID track_allocator(const char* name) override;
+
+  /// Values are not aggregated; these always return false.
+  Result<bool> log_evalue(
+      const ::executorch::runtime::EValue& evalue,
+      ::executorch::runtime::LoggedEValueType evalue_type) override;
+  Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index,
+      const executorch::aten::Tensor& output) override;
+  Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index,
+      const ::executorch::runtime::ArrayRef<executorch::aten::Tensor> output)
+      override;
+  Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index,
+      const int& output) override;
+  Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index,
+      const bool& output) override;
+  Result<bool> log_intermediate_output_delegate(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index,
+      const double& output) override;
+  void set_delegation_intermediate_output_filter(
+      ::executorch::runtime::EventTracerFilterBase* event_tracer_filter)
+      override;
+
+  /**
+   * Returns the aggregates of the profiling event recorded with this name,
+   * chain id and debug handle, or Error::NotFound if it was never recorded.
+   */
+  Result<EventStats> get_event_stats(
+      const char* name,
+      ChainID chain_id = ::executorch::runtime::kUnsetChainId,
+      DebugHandle debug_handle = ::executorch::runtime::kUnsetDebugHandle)
+      const;
+
+  /**
+   * Returns the aggregates of a delegate event, identified like in
+   * start_profiling_delegate() by either its name or its integer id, or
+   * Error::NotFound if it was never recorded.
+   */
+  Result<EventStats> get_delegate_event_stats(
+      const char* name,
+      DelegateDebugIntId delegate_debug_index) const;
+
+  /// Number of events that were not recorded because the table was full.
+  uint64_t dropped_events() const {
+    return dropped_events_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Writes all aggregates in the Prometheus text exposition format: latency
+   * summaries with 0.5/0.9/0.99/0.999 quantiles in seconds for profiling and
+   * delegate events, and counters for allocations and dropped events.
+   *
+   * Like snprintf, writes at most `size` bytes including the terminating null
+   * character and returns the length of the full text, so a return value of
+   * `size` or more means the output was truncated.
+   */
+  size_t write_prometheus_text(char* buffer, size_t size) const;
+
+ private:
+  enum class EventKind : uint8_t {
+    kProfiling,
+    kDelegateName,
+    kDelegateIndex,
+  };
+
+  struct EventKey {
+    EventKind kind;
+    const char* name;
+    ChainID chain_id;
+    DebugHandle debug_handle;
+    DelegateDebugIntId delegate_debug_index;
+  };
+
+  struct EventSlot {
+    // kEmpty -> kClaimed by the first thread to record the event, which then
+    // fills in the key and publishes it with kReady.
+    std::atomic<uint32_t> state{0};
+    uint64_t hash = 0;
+    EventKind kind = EventKind::kProfiling;
+    char name[kMaxNameLength] = {};
+    ChainID chain_id = ::executorch::runtime::kUnsetChainId;
+    DebugHandle debug_handle = ::executorch::runtime::kUnsetDebugHandle;
+    DelegateDebugIntId delegate_debug_index =
+        ::executorch::runtime::kUnsetDelegateDebugIntId;
+    LatencyHistogram latency;
+  };
+
+  struct AllocatorSlot {
+    std::atomic<bool> ready{false};
+    char name[kMaxNameLength] = {};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+
+  static uint64_t hash_key(const EventKey& key);
+  static bool slot_matches(
+      const EventSlot& slot,
+      uint64_t hash,
+      const EventKey& key);
+
+  /// Returns the slot index for key, claiming a slot if needed, or -1 if the
+  /// table is full.
+  int64_t find_or_claim(const EventKey& key);
+  /// Returns the slot index for key, or -1 if it was never recorded.
+  int64_t find(const EventKey& key) const;
+  void record(int64_t slot_index, et_timestamp_t start, et_timestamp_t end);
+  EventKey delegate_key(const char* name, DelegateDebugIntId index) const;
+  Result<EventStats> stats_for(const EventKey& key) const;
+
+  std::unique_ptr<EventSlot[]> slots_;
+  size_t slot_mask_;
+  std::array<AllocatorSlot, kMaxAllocators> allocators_;
+  std::atomic<uint32_t> num_allocators_{0};
+  std::atomic<uint64_t> dropped_events_{0};
+  et_tick_ratio_t ticks_to_ns_;
+};
+
+} // namespace executorch::metrics
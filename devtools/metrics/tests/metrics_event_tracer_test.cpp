@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <executorch/devtools/metrics/metrics_event_tracer.h>
+#include <executorch/runtime/platform/clock.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using ::executorch::metrics::EventStats;
+using ::executorch::metrics::LatencyHistogram;
+using ::executorch::metrics::MetricsEventTracer;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::kUnsetDelegateDebugIntId;
+using ::executorch::runtime::Result;
+using ::executorch::runtime::ticks_to_ns;
+
+class MetricsEventTracerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    torch::executor::runtime_init();
+  }
+
+  std::string prometheus_text(const MetricsEventTracer& tracer) {
+    const size_t length = tracer.write_prometheus_text(nullptr, 0);
+    std::string text(length, '\0');
+    EXPECT_EQ(tracer.write_prometheus_text(text.data(), length + 1), length);
+    return text;
+  }
+};
+
+TEST_F(MetricsEventTracerTest, HistogramBucketsHaveBoundedRelativeError) {
+  for (uint64_t value = 0; value < (uint64_t(1) << 20);
+       value = value * 5 / 4 + 1) {
+    const size_t index = LatencyHistogram::bucket_index(value);
+    ASSERT_LT(index, LatencyHistogram::kNumBuckets - 1);
+    const uint64_t lower = LatencyHistogram::bucket_lower_bound(index);
+    const uint64_t upper = LatencyHistogram::bucket_lower_bound(index + 1);
+    EXPECT_LE(lower, value);
+    EXPECT_LT(value, upper);
+    EXPECT_LE(upper - lower, lower / LatencyHistogram::kSubBuckets + 1);
+  }
+  EXPECT_EQ(
+      LatencyHistogram::bucket_index(UINT64_MAX),
+      LatencyHistogram::kNumBuckets - 1);
+}
+
+TEST_F(MetricsEventTracerTest, HistogramQuantiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.value_at_quantile(0.5), 0);
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(histogram.count(), 1000);
+  EXPECT_EQ(histogram.total_ns(), 500500);
+  EXPECT_EQ(histogram.max_ns(), 1000);
+  // Quantiles are rounded up to the bucket bound, at most 25% above.
+  EXPECT_GE(histogram.value_at_quantile(0.5), 500);
+  EXPECT_LE(histogram.value_at_quantile(0.5), 625);
+  EXPECT_GE(histogram.value_at_quantile(0.99), 990);
+  EXPECT_EQ(histogram.value_at_quantile(1.0), 1000);
+}
+
+TEST_F(MetricsEventTracerTest, AggregatesProfilingEventsPerInstruction) {
+  MetricsEventTracer tracer;
+  for (int i = 0; i < 3; ++i) {
+    tracer.set_chain_debug_handle(0, 7);
+    tracer.end_profiling(tracer.start_profiling("OPERATOR_CALL"));
+  }
+  tracer.set_chain_debug_handle(0, 8);
+  tracer.end_profiling(tracer.start_profiling("OPERATOR_CALL"));
+  tracer.set_chain_debug_handle(-1, 0);
+  tracer.end_profiling(tracer.start_profiling("Method::execute"));
+
+  Result<EventStats> op7 = tracer.get_event_stats("OPERATOR_CALL", 0, 7);
+  ASSERT_TRUE(op7.ok());
+  EXPECT_EQ(op7->count, 3);
+  EXPECT_LE(op7->p50_ns, op7->max_ns);
+  Result<EventStats> op8 = tracer.get_event_stats("OPERATOR_CALL", 0, 8);
+  ASSERT_TRUE(op8.ok());
+  EXPECT_EQ(op8->count, 1);
+  Result<EventStats> execute = tracer.get_event_stats("Method::execute");
+  ASSERT_TRUE(execute.ok());
+  EXPECT_EQ(execute->count, 1);
+
+  EXPECT_EQ(
+      tracer.get_event_stats("OPERATOR_CALL", 0, 9).error(), Error::NotFound);
+  EXPECT_EQ(tracer.dropped_events(), 0);
+}
+
+TEST_F(MetricsEventTracerTest, AggregatesDelegateEvents) {
+  MetricsEventTracer tracer;
+  tracer.log_profiling_delegate("conv", kUnsetDelegateDebugIntId, 100, 1100);
+  tracer.log_profiling_delegate("conv", kUnsetDelegateDebugIntId, 100, 3100);
+  tracer.log_profiling_delegate(nullptr, 4, 0, 10);
+  tracer.end_profiling_delegate(tracer.start_profiling_delegate(nullptr, 4));
+
+  Result<EventStats> conv =
+      tracer.get_delegate_event_stats("conv", kUnsetDelegateDebugIntId);
+  ASSERT_TRUE(conv.ok());
+  EXPECT_EQ(conv->count, 2);
+  EXPECT_EQ(conv->total_ns, ticks_to_ns(1000) + ticks_to_ns(3000));
+  EXPECT_EQ(conv->max_ns, ticks_to_ns(3000));
+
+  Result<EventStats> indexed = tracer.get_delegate_event_stats(nullptr, 4);
+  ASSERT_TRUE(indexed.ok());
+  EXPECT_EQ(indexed->count, 2);
+
+  // Delegate events do not show up as profiling events.
+  EXPECT_EQ(tracer.get_event_stats("conv").error(), Error::NotFound);
+}
+
+TEST_F(MetricsEventTracerTest, CountsDroppedEventsWhenFull) {
+  MetricsEventTracer tracer(/*max_events=*/2);
+  tracer.end_profiling(tracer.start_profiling("a"));
+  tracer.end_profiling(tracer.start_profiling("b"));
+  tracer.end_profiling(tracer.start_profiling("c"));
+  tracer.end_profiling(tracer.start_profiling("a"));
+
+  EXPECT_EQ(tracer.dropped_events(), 1);
+  EXPECT_EQ(tracer.get_event_stats("a")->count, 2);
+  EXPECT_EQ(tracer.get_event_stats("c").error(), Error::NotFound);
+}
+
+TEST_F(MetricsEventTracerTest, RecordsFromManyThreads) {
+  MetricsEventTracer tracer;
+  constexpr int kThreads = 4;
+  constexpr int kEventsPerThread = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&tracer, t]() {
+      for (int i = 0; i < kEventsPerThread; ++i) {
+        tracer.end_profiling(
+            tracer.start_profiling("OPERATOR_CALL", 0, i % 8));
+        tracer.log_profiling_delegate(
+            nullptr, t, 0, static_cast<et_timestamp_t>(i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  uint64_t total = 0;
+  for (uint32_t handle = 0; handle < 8; ++handle) {
+    Result<EventStats> stats =
+        tracer.get_event_stats("OPERATOR_CALL", 0, handle);
+    ASSERT_TRUE(stats.ok());
+    total += stats->count;
+  }
+  EXPECT_EQ(total, kThreads * kEventsPerThread);
+  for (int t = 0; t < kThreads; ++t) {
+    EXPECT_EQ(
+        tracer.get_delegate_event_stats(nullptr, t)->count, kEventsPerThread);
+  }
+}
+
+TEST_F(MetricsEventTracerTest, TracksAllocations) {
+  MetricsEventTracer tracer;
+  const auto planned = tracer.track_allocator("planned");
+  const auto temp = tracer.track_allocator("temp");
+  tracer.track_allocation(planned, 64);
+  tracer.track_allocation(planned, 32);
+  tracer.track_allocation(temp, 8);
+
+  const std::string text = prometheus_text(tracer);
+  EXPECT_NE(
+      text.find("executorch_allocations_total{allocator=\"planned\"} 2\n"),
+      std::string::npos);
+  EXPECT_NE(
+      text.find("executorch_allocated_bytes_total{allocator=\"planned\"} 96\n"),
+      std::string::npos);
+  EXPECT_NE(
+      text.find("executorch_allocated_bytes_total{allocator=\"temp\"} 8\n"),
+      std::string::npos);
+}
+
+TEST_F(MetricsEventTracerTest, WritesPrometheusText) {
+  MetricsEventTracer tracer;
+  tracer.log_profiling_delegate("say \"hi\"", kUnsetDelegateDebugIntId, 0, 10);
+  tracer.set_chain_debug_handle(1, 2);
+  tracer.end_profiling(tracer.start_profiling("OPERATOR_CALL"));
+
+  const std::string text = prometheus_text(tracer);
+  EXPECT_NE(
+      text.find("# TYPE executorch_event_seconds summary\n"),
+      std::string::npos);
+  EXPECT_NE(
+      text.find("executorch_event_seconds{name=\"OPERATOR_CALL\",chain=\"1\","
+                "debug_handle=\"2\",quantile=\"0.99\"} "),
+      std::string::npos);
+  EXPECT_NE(
+      text.find("executorch_event_seconds_count{name=\"OPERATOR_CALL\","
+                "chain=\"1\",debug_handle=\"2\"} 1\n"),
+      std::string::npos);
+  EXPECT_NE(
+      text.find("executorch_delegate_event_seconds_count{name=\"say "
+                "\\\"hi\\\"\"} 1\n"),
+      std::string::npos);
+  EXPECT_NE(
+      text.find("executorch_dropped_events_total 0\n"), std::string::npos);
+
+  // Truncated output is null-terminated and reports the full length.
+  char small[16];
+  EXPECT_EQ(tracer.write_prometheus_text(small, sizeof(small)), text.size());
+  EXPECT_EQ(std::string(small), text.substr(0, sizeof(small) - 1));
+}
@@ -0,0 +1,19 @@
+load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
+
+def define_common_targets():
+    """Defines targets that should be shared between fbcode and xplat.
+
+    The directory containing this targets.bzl file should also contain both
+    TARGETS and BUCK files that call this function.
+    """
+
+    runtime.cxx_test(
+        name = "metrics_event_tracer_test",
+        srcs = [
+            "metrics_event_tracer_test.cpp",
+        ],
+        deps = [
+            "//executorch/devtools/metrics:metrics_event_tracer",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
@@ -375,6 +375,8 @@ def _extract_named_data(
                 )
             )
         named_data.append(NamedData(key=name, segment_index=segment_index))
+    # The runtime binary searches named_data when it is sorted by key.
+    named_data.sort(key=lambda entry: entry.key.encode("utf-8"))
     program.named_data = named_data
 
 
@@ -0,0 +1,865 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/async_file_data_loader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <executorch/runtime/platform/compat_unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ET_HAVE_IO_URING 1
+#endif
+#endif // defined(__linux__)
+
+#ifndef ET_HAVE_IO_URING
+#define ET_HAVE_IO_URING 0
+#endif
+
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+namespace executorch {
+namespace extension {
+
+namespace {
+
+bool is_power_of_2(size_t value) {
+  return value > 0 && (value & ~(value - 1)) == value;
+}
+
+/// Tracks the completion of a group of read requests.
+struct ReadBatch {
+  // Both fields are guarded by the lock of the engine running the batch.
+  size_t remaining = 0;
+  bool failed = false;
+};
+
+/// A read into part of a buffer. Updated in place as partial reads complete.
+struct ReadRequest {
+  ReadBatch* batch;
+  int fd;
+  uint8_t* buffer;
+  size_t size;
+  size_t offset;
+#if ET_HAVE_IO_URING
+  struct iovec iov;
+#endif
+};
+
+/// Issues read requests asynchronously.
+class IoEngine {
+ public:
+  virtual ~IoEngine() = default;
+
+  /// Starts the requests, which must stay valid until their batch completes.
+  virtual void submit(ReadRequest* requests, size_t count) = 0;
+
+  /// Blocks until every request of the batch has completed.
+  virtual void wait(ReadBatch& batch) = 0;
+
+  virtual AsyncFileDataLoader::IoBackend backend() const = 0;
+};
+
+/// Reads with pread() on a pool of threads.
+class ThreadPoolEngine final : public IoEngine {
+ public:
+  explicit ThreadPoolEngine(size_t num_threads) {
+    threads_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this]() { worker_loop(); });
+    }
+  }
+
+  ~ThreadPoolEngine() override {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void submit(ReadRequest* requests, size_t count) override {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      for (size_t i = 0; i < count; ++i) {
+        queue_.push_back(&requests[i]);
+      }
+    }
+    work_available_.notify_all();
+  }
+
+  void wait(ReadBatch& batch) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&batch]() { return batch.remaining == 0; });
+  }
+
+  AsyncFileDataLoader::IoBackend backend() const override {
+    return AsyncFileDataLoader::IoBackend::ThreadPool;
+  }
+
+ private:
+  void worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_available_.wait(
+          lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      ReadRequest* request = queue_.front();
+      queue_.pop_front();
+      lock.unlock();
+      const bool ok = read(*request);
+      lock.lock();
+      request->batch->failed |= !ok;
+      request->batch->remaining -= 1;
+      if (request->batch->remaining == 0) {
+        done_.notify_all();
+      }
+    }
+  }
+
+  static bool read(ReadRequest& request) {
+    while (request.size > 0) {
+      // Reads on macOS will fail with EINVAL if size > INT32_MAX.
+      const auto chunk_size = std::min<size_t>(
+          request.size,
+          static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+      const auto nread =
+          ::pread(request.fd, request.buffer, chunk_size, request.offset);
+      if (nread < 0 && errno == EINTR) {
+        continue;
+      }
+      if (nread <= 0) {
+        ET_LOG(
+            Error,
+            "Failed to read %zu bytes at offset %zu: %s",
+            request.size,
+            request.offset,
+            nread == 0 ? "EOF" : strerror(errno));
+        return false;
+      }
+      request.buffer += nread;
+      request.size -= nread;
+      request.offset += nread;
+    }
+    return true;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable done_;
+  std::deque<ReadRequest*> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+#if ET_HAVE_IO_URING
+
+/// Reads through an io_uring instance, using the raw system calls so that
+/// there is no dependency on liburing.
+class IoUringEngine final : public IoEngine {
+ public:
+  /// Returns null if io_uring isn't available, e.g. because the kernel is too
+  /// old or a seccomp policy blocks it.
+  static std::unique_ptr<IoUringEngine> create(size_t queue_depth) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const int ring_fd = static_cast<int>(::syscall(
+        __NR_io_uring_setup, static_cast<unsigned>(queue_depth), &params));
+    if (ring_fd < 0) {
+      ET_LOG(
+          Info,
+          "io_uring_setup failed: %s (%d); reading with threads",
+          ::strerror(errno),
+          errno);
+      return nullptr;
+    }
+    std::unique_ptr<IoUringEngine> engine(new IoUringEngine(ring_fd));
+    if (!engine->map_rings(params)) {
+      return nullptr;
+    }
+    return engine;
+  }
+
+  ~IoUringEngine() override {
+    if (sqes_ != nullptr) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+      ::munmap(sq_ring_, sq_ring_size_);
+    }
+    ::close(ring_fd_);
+  }
+
+  void submit(ReadRequest* requests, size_t count) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (size_t i = 0; i < count; ++i) {
+      backlog_.push_back(&requests[i]);
+    }
+    flush();
+  }
+
+  void wait(ReadBatch& batch) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    while (batch.remaining > 0) {
+      flush();
+      if (reap() > 0) {
+        continue;
+      }
+      enter_checked(/*min_complete=*/1);
+    }
+  }
+
+  AsyncFileDataLoader::IoBackend backend() const override {
+    return AsyncFileDataLoader::IoBackend::IoUring;
+  }
+
+ private:
+  explicit IoUringEngine(int ring_fd) : ring_fd_(ring_fd) {}
+
+  bool map_rings(const struct io_uring_params& params) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == nullptr) {
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == nullptr) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) {
+      return false;
+    }
+
+    auto* sq = static_cast<uint8_t*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cq_entries_ = params.cq_entries;
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  void* map(size_t size, off_t offset) {
+    void* ptr = ::mmap(
+        nullptr,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ring_fd_,
+        offset);
+    if (ptr == MAP_FAILED) {
+      ET_LOG(
+          Info,
+          "Mapping io_uring rings failed: %s (%d); reading with threads",
+          ::strerror(errno),
+          errno);
+      return nullptr;
+    }
+    return ptr;
+  }
+
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(
+        __NR_io_uring_enter,
+        ring_fd_,
+        to_submit,
+        min_complete,
+        flags,
+        nullptr,
+        0));
+  }
+
+  // Moves requests from the backlog to the submission queue, without ever
+  // having more requests in flight than the completion queue can hold.
+  void flush() {
+    unsigned tail = *sq_tail_;
+    unsigned queued = 0;
+    while (!backlog_.empty() && in_flight_ < cq_entries_ &&
+           tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) < sq_entries_) {
+      ReadRequest* request = backlog_.front();
+      backlog_.pop_front();
+      const unsigned index = tail & sq_mask_;
+      struct io_uring_sqe* sqe = &sqes_[index];
+      std::memset(sqe, 0, sizeof(*sqe));
+      // Reads on some file systems fail with EINVAL if size > INT32_MAX.
+      request->iov.iov_base = request->buffer;
+      request->iov.iov_len = std::min<size_t>(
+          request->size,
+          static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = request->fd;
+      sqe->off = request->offset;
+      sqe->addr = reinterpret_cast<uint64_t>(&request->iov);
+      sqe->len = 1;
+      sqe->user_data = reinterpret_cast<uint64_t>(request);
+      sq_array_[index] = index;
+      tail += 1;
+      queued += 1;
+      in_flight_ += 1;
+    }
+    if (queued == 0) {
+      return;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    enter_checked(/*min_complete=*/0);
+  }
+
+  // Submits the entries that the kernel hasn't consumed yet, and optionally
+  // waits for completions.
+  void enter_checked(unsigned min_complete) {
+    const unsigned to_submit =
+        *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (to_submit == 0 && min_complete == 0) {
+      return;
+    }
+    const int ret = enter(
+        to_submit, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+    // Transient failures leave the entries in the submission queue, and the
+    // next call submits them. Anything else means the ring is unusable while
+    // reads into caller buffers may be in flight, so there's no way to
+    // recover.
+    ET_CHECK_MSG(
+        ret >= 0 || errno == EINTR || errno == EAGAIN || errno == EBUSY,
+        "io_uring_enter failed: %s (%d)",
+        ::strerror(errno),
+        errno);
+  }
+
+  // Processes every available completion. Returns the number processed.
+  size_t reap() {
+    size_t count = 0;
+    unsigned head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      auto* request = reinterpret_cast<ReadRequest*>(cqe.user_data);
+      const int res = cqe.res;
+      head += 1;
+      count += 1;
+      in_flight_ -= 1;
+      if (res == -EINTR || res == -EAGAIN) {
+        backlog_.push_front(request);
+        continue;
+      }
+      if (res <= 0) {
+        ET_LOG(
+            Error,
+            "Failed to read %zu bytes at offset %zu: %s",
+            request->size,
+            request->offset,
+            res == 0 ? "EOF" : ::strerror(-res));
+        request->batch->failed = true;
+        request->batch->remaining -= 1;
+        continue;
+      }
+      request->buffer += res;
+      request->size -= res;
+      request->offset += res;
+      if (request->size > 0) {
+        // Short read; issue the rest.
+        backlog_.push_front(request);
+        continue;
+      }
+      request->batch->remaining -= 1;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+  }
+
+  const int ring_fd_;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  struct io_uring_sqe* sqes_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+  unsigned cq_mask_ = 0;
+  unsigned cq_entries_ = 0;
+
+  // Guards the rings and everything below. Any thread waiting for a batch
+  // processes the completions of all batches.
+  std::mutex mutex_;
+  std::deque<ReadRequest*> backlog_;
+  size_t in_flight_ = 0;
+};
+
+#endif // ET_HAVE_IO_URING
+
+inline void* et_aligned_alloc(size_t size, size_t alignment) {
+  return ::operator new(size, std::align_val_t(alignment), std::nothrow);
+}
+
+inline void et_aligned_free(void* ptr, size_t alignment) {
+  ::operator delete(ptr, std::align_val_t(alignment));
+}
+
+/**
+ * FreeableBuffer::FreeFn-compatible callback.
+ *
+ * `data` is the original buffer pointer.
+ * `context` is the original alignment.
+ *
+ * `size` is unused.
+ */
+void FreeSegment(void* context, void* data, ET_UNUSED size_t size) {
+  et_aligned_free(data, reinterpret_cast<uintptr_t>(context));
+}
+
+} // namespace
+
+/// The parts of the loader that must not move: the I/O engine and the reads
+/// started by prefetch().
+class AsyncFileDataLoader::State final {
+ public:
+  struct Prefetch {
+    size_t offset;
+    size_t size;
+    uint8_t* buffer;
+    size_t alignment;
+    ReadBatch batch;
+    std::vector<ReadRequest> requests;
+  };
+
+  explicit State(std::unique_ptr<IoEngine> engine)
+      : engine(std::move(engine)) {}
+
+  ~State() {
+    // The engine may still be writing into the buffers.
+    for (auto& prefetch : prefetches) {
+      engine->wait(prefetch.batch);
+      et_aligned_free(prefetch.buffer, prefetch.alignment);
+    }
+  }
+
+  std::unique_ptr<IoEngine> engine;
+  std::mutex mutex;
+  // Guarded by `mutex`. A list so that entries don't move while their
+  // requests are in flight.
+  std::list<Prefetch> prefetches;
+};
+
+AsyncFileDataLoader::~AsyncFileDataLoader() {
+  // Finish the reads before closing the files. state_ is null if this
+  // instance was moved from.
+  delete state_;
+  // file_name_ can be nullptr if this instance was moved from, but freeing a
+  // null pointer is safe.
+  std::free(const_cast<char*>(file_name_));
+  if (direct_fd_ >= 0) {
+    ::close(direct_fd_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+Result<AsyncFileDataLoader> AsyncFileDataLoader::from(const char* file_name) {
+  return from(file_name, Config());
+}
+
+Result<AsyncFileDataLoader> AsyncFileDataLoader::from(
+    const char* file_name,
+    const Config& config) {
+  ET_CHECK_OR_RETURN_ERROR(
+      is_power_of_2(config.alignment),
+      InvalidArgument,
+      "Alignment %zu is not a power of 2",
+      config.alignment);
+  ET_CHECK_OR_RETURN_ERROR(
+      config.request_size > 0 && config.queue_depth > 0 &&
+          config.num_threads > 0,
+      InvalidArgument,
+      "request_size, queue_depth and num_threads must be positive");
+  ET_CHECK_OR_RETURN_ERROR(
+      file_name != nullptr, InvalidArgument, "File name cannot be empty.");
+
+  int fd = ::open(file_name, O_RDONLY);
+  if (fd < 0) {
+    ET_LOG(
+        Error, "Failed to open %s: %s (%d)", file_name, strerror(errno), errno);
+    return Error::AccessFailed;
+  }
+
+  // Cache the file size.
+  struct stat st;
+  int err = ::fstat(fd, &st);
+  if (err < 0) {
+    ET_LOG(
+        Error,
+        "Could not get length of %s: %s (%d)",
+        file_name,
+        ::strerror(errno),
+        errno);
+    ::close(fd);
+    return Error::AccessFailed;
+  }
+  size_t file_size = st.st_size;
+
+  int direct_fd = -1;
+#ifdef O_DIRECT
+  if (config.use_direct_io) {
+    direct_fd = ::open(file_name, O_RDONLY | O_DIRECT);
+    if (direct_fd < 0) {
+      // Some file systems, like tmpfs, don't support O_DIRECT.
+      ET_LOG(
+          Info,
+          "O_DIRECT is unavailable for %s: %s (%d); using the page cache",
+          file_name,
+          ::strerror(errno),
+          errno);
+    }
+  }
+#endif // O_DIRECT
+
+  // Copy the filename so we can print better debug messages if reads fail.
+  const char* file_name_copy = ::strdup(file_name);
+  if (file_name_copy == nullptr) {
+    ET_LOG(Error, "strdup(%s) failed", file_name);
+    if (direct_fd >= 0) {
+      ::close(direct_fd);
+    }
+    ::close(fd);
+    return Error::MemoryAllocationFailed;
+  }
+
+  std::unique_ptr<IoEngine> engine;
+#if ET_HAVE_IO_URING
+  if (config.use_io_uring) {
+    engine = IoUringEngine::create(config.queue_depth);
+  }
+#endif // ET_HAVE_IO_URING
+  if (engine == nullptr) {
+    engine = std::make_unique<ThreadPoolEngine>(config.num_threads);
+  }
+
+  return AsyncFileDataLoader(
+      fd,
+      direct_fd,
+      file_size,
+      config.alignment,
+      config.request_size,
+      file_name_copy,
+      new State(std::move(engine)));
+}
+
+Error AsyncFileDataLoader::validate_input(size_t offset, size_t size) const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      fd_ >= 0,
+      InvalidState,
+      "Uninitialized");
+  ET_CHECK_OR_RETURN_ERROR(
+      offset + size <= file_size_,
+      InvalidArgument,
+      "File %s: offset %zu + size %zu > file_size_ %zu",
+      file_name_,
+      offset,
+      size,
+      file_size_);
+  return Error::Ok;
+}
+
+size_t AsyncFileDataLoader::buffer_alignment(size_t offset) const {
+  if (direct_fd_ >= 0 && offset % kDirectIoAlignment == 0) {
+    return std::max(alignment_, kDirectIoAlignment);
+  }
+  return alignment_;
+}
+
+namespace {
+
+// Splits a read of [offset, offset + size) into `buffer` into requests. The
+// largest prefix whose buffer, offset and size are aligned for direct I/O is
+// read from `direct_fd`, if there is one.
+void make_requests(
+    int fd,
+    int direct_fd,
+    size_t request_size,
+    size_t offset,
+    size_t size,
+    uint8_t* buffer,
+    ReadBatch* batch,
+    std::vector<ReadRequest>& requests) {
+  size_t direct_size = 0;
+  if (direct_fd >= 0 &&
+      reinterpret_cast<uintptr_t>(buffer) %
+              AsyncFileDataLoader::kDirectIoAlignment ==
+          0 &&
+      offset % AsyncFileDataLoader::kDirectIoAlignment == 0) {
+    direct_size = size & ~(AsyncFileDataLoader::kDirectIoAlignment - 1);
+    // Keep direct requests aligned too.
+    request_size = std::max(
+        request_size & ~(AsyncFileDataLoader::kDirectIoAlignment - 1),
+        AsyncFileDataLoader::kDirectIoAlignment);
+  }
+  requests.clear();
+  for (size_t begin = 0; begin < size;) {
+    const bool direct = begin < direct_size;
+    const size_t end =
+        std::min(begin + request_size, direct ? direct_size : size);
+    ReadRequest request{};
+    request.batch = batch;
+    request.fd = direct ? direct_fd : fd;
+    request.buffer = buffer + begin;
+    request.size = end - begin;
+    request.offset = offset + begin;
+    requests.push_back(request);
+    begin = end;
+  }
+  batch->remaining = requests.size();
+  batch->failed = false;
+}
+
+} // namespace
+
+Result<FreeableBuffer> AsyncFileDataLoader::load(
+    size_t offset,
+    size_t size,
+    const DataLoader::SegmentInfo& segment_info) const {
+  auto err = validate_input(offset, size);
+  if (err != Error::Ok) {
+    return err;
+  }
+
+  // Don't bother allocating/freeing for empty segments.
+  if (size == 0) {
+    return FreeableBuffer(nullptr, 0, /*free_fn=*/nullptr);
+  }
+
+  // Pick up the region if it was prefetched. Splicing the entry out of the
+  // list keeps its address, which its in-flight requests point to.
+  std::list<State::Prefetch> prefetched;
+  {
+    std::lock_guard<std::mutex> guard(state_->mutex);
+    auto& prefetches = state_->prefetches;
+    auto it = std::find_if(
+        prefetches.begin(),
+        prefetches.end(),
+        [offset, size](const State::Prefetch& prefetch_entry) {
+          return prefetch_entry.offset == offset && prefetch_entry.size == size;
+        });
+    if (it != prefetches.end()) {
+      prefetched.splice(prefetched.end(), prefetches, it);
+    }
+  }
+  if (!prefetched.empty()) {
+    State::Prefetch& prefetch_entry = prefetched.front();
+    state_->engine->wait(prefetch_entry.batch);
+    if (prefetch_entry.batch.failed) {
+      et_aligned_free(prefetch_entry.buffer, prefetch_entry.alignment);
+      ET_LOG(
+          Error,
+          "Reading from %s: failed to prefetch %zu bytes at offset %zu",
+          file_name_,
+          size,
+          offset);
+      return Error::AccessFailed;
+    }
+    return FreeableBuffer(
+        prefetch_entry.buffer,
+        size,
+        FreeSegment,
+        // NOLINTNEXTLINE(performance-no-int-to-ptr)
+        reinterpret_cast<void*>(
+            static_cast<uintptr_t>(prefetch_entry.alignment)));
+  }
+
+  const size_t alignment = buffer_alignment(offset);
+  void* aligned_buffer = et_aligned_alloc(size, alignment);
+  if (aligned_buffer == nullptr) {
+    ET_LOG(
+        Error,
+        "Reading from %s at offset %zu: et_aligned_alloc(%zu, %zu) failed",
+        file_name_,
+        offset,
+        size,
+        alignment);
+    return Error::MemoryAllocationFailed;
+  }
+
+  err = load_into(offset, size, segment_info, aligned_buffer);
+  if (err != Error::Ok) {
+    et_aligned_free(aligned_buffer, alignment);
+    return err;
+  }
+
+  // Pass the alignment as context to FreeSegment.
+  return FreeableBuffer(
+      aligned_buffer,
+      size,
+      FreeSegment,
+      // NOLINTNEXTLINE(performance-no-int-to-ptr)
+      reinterpret_cast<void*>(static_cast<uintptr_t>(alignment)));
+}
+
+Result<size_t> AsyncFileDataLoader::size() const {
+  ET_CHECK_OR_RETURN_ERROR(
+      // Probably had its value moved to another instance.
+      fd_ >= 0,
+      InvalidState,
+      "Uninitialized");
+  return file_size_;
+}
+
+Error AsyncFileDataLoader::load_into(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const SegmentInfo& segment_info,
+    void* buffer) const {
+  auto err = validate_input(offset, size);
+  if (err != Error::Ok) {
+    return err;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer != nullptr, InvalidArgument, "Provided buffer cannot be null");
+  if (size == 0) {
+    return Error::Ok;
+  }
+
+  ReadBatch batch;
+  std::vector<ReadRequest> requests;
+  make_requests(
+      fd_,
+      direct_fd_,
+      request_size_,
+      offset,
+      size,
+      static_cast<uint8_t*>(buffer),
+      &batch,
+      requests);
+  state_->engine->submit(requests.data(), requests.size());
+  state_->engine->wait(batch);
+  ET_CHECK_OR_RETURN_ERROR(
+      !batch.failed,
+      AccessFailed,
+      "Reading from %s: failed to read %zu bytes at offset %zu",
+      file_name_,
+      size,
+      offset);
+  return Error::Ok;
+}
+
+Error AsyncFileDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+  auto err = validate_input(offset, size);
+  if (err != Error::Ok) {
+    return err;
+  }
+  if (size == 0) {
+    return Error::Ok;
+  }
+
+  std::lock_guard<std::mutex> guard(state_->mutex);
+  // Only one load() would pick up a second prefetch of the same region.
+  const auto& prefetches = state_->prefetches;
+  if (std::any_of(
+          prefetches.begin(),
+          prefetches.end(),
+          [offset, size](const State::Prefetch& prefetch_entry) {
+            return prefetch_entry.offset == offset &&
+                prefetch_entry.size == size;
+          })) {
+    return Error::Ok;
+  }
+  const size_t alignment = buffer_alignment(offset);
+  auto* buffer = static_cast<uint8_t*>(et_aligned_alloc(size, alignment));
+  ET_CHECK_OR_RETURN_ERROR(
+      buffer != nullptr,
+      MemoryAllocationFailed,
+      "Prefetching from %s at offset %zu: et_aligned_alloc(%zu, %zu) failed",
+      file_name_,
+      offset,
+      size,
+      alignment);
+
+  state_->prefetches.emplace_back();
+  State::Prefetch& prefetch_entry = state_->prefetches.back();
+  prefetch_entry.offset = offset;
+  prefetch_entry.size = size;
+  prefetch_entry.buffer = buffer;
+  prefetch_entry.alignment = alignment;
+  make_requests(
+      fd_,
+      direct_fd_,
+      request_size_,
+      offset,
+      size,
+      buffer,
+      &prefetch_entry.batch,
+      prefetch_entry.requests);
+  state_->engine->submit(
+      prefetch_entry.requests.data(), prefetch_entry.requests.size());
+  return Error::Ok;
+}
+
+AsyncFileDataLoader::IoBackend AsyncFileDataLoader::io_backend() const {
+  return state_->engine->backend();
+}
+
+} // namespace extension
+} // namespace executorch
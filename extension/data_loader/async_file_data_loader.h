@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <executorch/runtime/core/data_loader.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A DataLoader that reads segments from a file with many concurrent requests,
+ * allocating the memory with `malloc()`.
+ *
+ * Each load is split into requests of up to `Config::request_size` bytes that
+ * are all issued at once. On Linux they are submitted through `io_uring`;
+ * where that is unavailable, a small pool of threads issues them with
+ * `pread()`. Deep queues make a large difference on storage with high
+ * per-request latency, such as network file systems, where FileDataLoader
+ * would wait for one read at a time.
+ *
+ * prefetch() starts reading a segment without waiting for it, so that the
+ * I/O overlaps with whatever the caller does next, like parsing the program.
+ * A later load() of the same region picks up the prefetched data without
+ * copying it.
+ *
+ * Note that this will keep the file open for the duration of its lifetime, to
+ * avoid the overhead of opening it again for every load() call.
+ */
+class AsyncFileDataLoader final : public executorch::runtime::DataLoader {
+ public:
+  /// The mechanism used to issue reads.
+  enum class IoBackend {
+    /// Reads are submitted to an `io_uring` instance.
+    IoUring,
+    /// Reads are issued with `pread()` by a pool of threads.
+    ThreadPool,
+  };
+
+  struct Config {
+    /// Alignment in bytes of pointers returned by load(). Must be a power of
+    /// two.
+    size_t alignment = alignof(std::max_align_t);
+    /// The maximum size in bytes of a single read request.
+    size_t request_size = 1024 * 1024;
+    /// The maximum number of requests in flight for the `io_uring` backend.
+    size_t queue_depth = 32;
+    /// The number of threads used by the `pread()` backend.
+    size_t num_threads = 4;
+    /// Whether to try `io_uring` before falling back to threads.
+    bool use_io_uring = true;
+    /// Whether to bypass the page cache with `O_DIRECT` for reads whose
+    /// buffer and file offset are aligned to kDirectIoAlignment. Other reads,
+    /// and reads on systems or file systems without `O_DIRECT`, use the page
+    /// cache.
+    bool use_direct_io = false;
+  };
+
+  /// The alignment of buffers, offsets and sizes that direct reads require.
+  static constexpr size_t kDirectIoAlignment = 4096;
+
+  /**
+   * Creates a new AsyncFileDataLoader that wraps the named file.
+   *
+   * @param[in] file_name Path to the file to read from.
+   * @param[in] config How to issue reads.
+   *
+   * @returns A new AsyncFileDataLoader on success.
+   * @retval Error::InvalidArgument `alignment` is not a power of two, or
+   *     another config value is zero.
+   * @retval Error::AccessFailed `file_name` could not be opened, or its size
+   *     could not be found.
+   * @retval Error::MemoryAllocationFailed Internal memory allocation failure.
+   */
+  static executorch::runtime::Result<AsyncFileDataLoader> from(
+      const char* file_name,
+      const Config& config);
+
+  /// Creates a new AsyncFileDataLoader with the default Config.
+  static executorch::runtime::Result<AsyncFileDataLoader> from(
+      const char* file_name);
+
+  // Movable to be compatible with Result.
+  AsyncFileDataLoader(AsyncFileDataLoader&& rhs) noexcept
+      : file_name_(rhs.file_name_),
+        file_size_(rhs.file_size_),
+        alignment_(rhs.alignment_),
+        request_size_(rhs.request_size_),
+        fd_(rhs.fd_),
+        direct_fd_(rhs.direct_fd_),
+        state_(rhs.state_) {
+    const_cast<const char*&>(rhs.file_name_) = nullptr;
+    const_cast<size_t&>(rhs.file_size_) = 0;
+    const_cast<size_t&>(rhs.alignment_) = 0;
+    const_cast<size_t&>(rhs.request_size_) = 0;
+    const_cast<int&>(rhs.fd_) = -1;
+    const_cast<int&>(rhs.direct_fd_) = -1;
+    const_cast<State*&>(rhs.state_) = nullptr;
+  }
+
+  ~AsyncFileDataLoader() override;
+
+  ET_NODISCARD
+  executorch::runtime::Result<executorch::runtime::FreeableBuffer> load(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
+
+  ET_NODISCARD executorch::runtime::Error load_into(
+      size_t offset,
+      size_t size,
+      ET_UNUSED const SegmentInfo& segment_info,
+      void* buffer) const override;
+
+  /**
+   * Starts reading a region of the file and returns without waiting for it.
+   *
+   * The next load() of exactly the same region waits for the reads, if they
+   * are still in flight, and returns the data without copying it. Prefetching
+   * a region that is already pending does nothing. Prefetched regions that are
+   * never loaded are freed when the loader is destroyed.
+   *
+   * Method::init() calls this for the segments of its delegates, so that
+   * their reads overlap with the initialization of the delegates before them.
+   *
+   * @param[in] offset The byte offset of the region in the file.
+   * @param[in] size The size of the region in bytes.
+   * @param[in] segment_info Information about the segment being loaded.
+   *
+   * @retval Error::Ok The reads were started.
+   * @retval Error::InvalidArgument The region is outside of the file.
+   * @retval Error::MemoryAllocationFailed The buffer couldn't be allocated.
+   */
+  ET_NODISCARD executorch::runtime::Error prefetch(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  /// Returns the mechanism used to issue reads.
+  IoBackend io_backend() const;
+
+  /// Returns true if reads with aligned buffers and offsets bypass the page
+  /// cache.
+  bool uses_direct_io() const {
+    return direct_fd_ >= 0;
+  }
+
+ private:
+  class State;
+
+  AsyncFileDataLoader(
+      int fd,
+      int direct_fd,
+      size_t file_size,
+      size_t alignment,
+      size_t request_size,
+      const char* file_name,
+      State* state)
+      : file_name_(file_name),
+        file_size_(file_size),
+        alignment_(alignment),
+        request_size_(request_size),
+        fd_(fd),
+        direct_fd_(direct_fd),
+        state_(state) {}
+
+  // Not safely copyable.
+  AsyncFileDataLoader(const AsyncFileDataLoader&) = delete;
+  AsyncFileDataLoader& operator=(const AsyncFileDataLoader&) = delete;
+  AsyncFileDataLoader& operator=(AsyncFileDataLoader&&) = delete;
+
+  ET_NODISCARD executorch::runtime::Error validate_input(
+      size_t offset,
+      size_t size) const;
+
+  // Returns the alignment to allocate a buffer for the region with, so that
+  // it can be read directly if possible.
+  size_t buffer_alignment(size_t offset) const;
+
+  const char* const file_name_; // Owned by the instance.
+  const size_t file_size_;
+  const size_t alignment_;
+  const size_t request_size_;
+  const int fd_; // Owned by the instance.
+  const int direct_fd_; // Owned by the instance; -1 without O_DIRECT.
+  State* const state_; // Owned by the instance.
+};
+
+} // namespace extension
+} // namespace executorch
@@ -8,9 +8,16 @@
 
 #include <executorch/extension/data_loader/mmap_data_loader.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -54,9 +61,189 @@ Range get_overlapping_pages(uintptr_t offset, size_t size, size_t page_size) {
   };
 }
 
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Prefetch requests are split into chunks of this size, so that a large
+// low-priority request doesn't hold up higher-priority ones queued after it.
+constexpr size_t kPrefetchChunkSize = 4 * 1024 * 1024;
+
 } // namespace
 
+/**
+ * Reads queued regions of the file into the page cache on background threads.
+ *
+ * Each chunk is mapped separately, hinted with `MADV_WILLNEED` so that the
+ * kernel starts reading the whole chunk at once, and then touched one page at
+ * a time to make sure every page is resident. The mapping is dropped
+ * afterwards; the pages stay in the shared page cache, so mappings created by
+ * load() find them there.
+ */
+class MmapDataLoader::Prefetcher final {
+ public:
+  Prefetcher(int fd, size_t file_size, size_t page_size, size_t num_threads)
+      : fd_(fd), file_size_(file_size), page_size_(page_size) {
+    threads_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this]() { worker_loop(); });
+    }
+  }
+
+  ~Prefetcher() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void enqueue(size_t offset, size_t size, PrefetchPriority priority) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (queue_.empty() && in_flight_ == 0) {
+        busy_since_ns_ = now_ns();
+      }
+      queue_.push(Request{offset, offset + size, priority, next_sequence_++});
+    }
+    requests_ += 1;
+    bytes_requested_ += size;
+    work_available_.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return queue_.empty() && in_flight_ == 0; });
+  }
+
+  void fill_stats(LoadStats& stats) {
+    stats.prefetch_requests = requests_.load();
+    stats.prefetch_bytes_requested = bytes_requested_.load();
+    stats.prefetch_bytes_completed = bytes_completed_.load();
+    stats.prefetch_time_ns = busy_time_ns_.load();
+    std::lock_guard<std::mutex> guard(mutex_);
+    stats.prefetch_wall_time_ns = wall_time_ns_;
+  }
+
+ private:
+  struct Request {
+    size_t begin;
+    size_t end;
+    PrefetchPriority priority;
+    uint64_t sequence;
+
+    // Orders the queue by priority, then by age.
+    bool operator<(const Request& rhs) const {
+      if (priority != rhs.priority) {
+        return priority < rhs.priority;
+      }
+      return sequence > rhs.sequence;
+    }
+  };
+
+  void worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_available_.wait(
+          lock, [this]() { return stopping_ || !queue_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      // Take one chunk and leave the rest of the request in the queue.
+      Request request = queue_.top();
+      queue_.pop();
+      const size_t chunk_end =
+          std::min(request.end, request.begin + kPrefetchChunkSize);
+      if (chunk_end < request.end) {
+        queue_.push(
+            Request{chunk_end, request.end, request.priority, request.sequence});
+        work_available_.notify_one();
+      }
+      in_flight_ += 1;
+      lock.unlock();
+
+      const uint64_t start_ns = now_ns();
+      read_pages(request.begin, chunk_end);
+      busy_time_ns_ += now_ns() - start_ns;
+      bytes_completed_ += chunk_end - request.begin;
+
+      lock.lock();
+      in_flight_ -= 1;
+      if (queue_.empty() && in_flight_ == 0) {
+        wall_time_ns_ += now_ns() - busy_since_ns_;
+        idle_.notify_all();
+      }
+    }
+  }
+
+  void read_pages(size_t begin, size_t end) {
+    Range range = get_overlapping_pages(begin, end - begin, page_size_);
+    const size_t map_size =
+        std::min<size_t>(range.size, file_size_ - range.start);
+    void* pages = ::mmap(
+        nullptr,
+        map_size,
+        PROT_READ,
+        MAP_SHARED,
+        fd_,
+        static_cast<off_t>(range.start));
+    if (pages == MAP_FAILED) {
+      ET_LOG(
+          Error,
+          "Prefetch failed: mmap(..., size=%zu, ..., fd=%d, offset=0x%zx): "
+          "%s (%d) (ignored)",
+          map_size,
+          fd_,
+          (size_t)range.start,
+          ::strerror(errno),
+          errno);
+      return;
+    }
+#ifndef _WIN32
+    // Start reading the whole chunk rather than one fault-around window at a
+    // time. This is only a hint, so failures don't matter.
+    (void)::madvise(pages, map_size, MADV_WILLNEED);
+#endif
+    const volatile uint8_t* data = static_cast<const uint8_t*>(pages);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < map_size; i += page_size_) {
+      sum += data[i];
+    }
+    (void)sum;
+    ::munmap(pages, map_size);
+  }
+
+  const int fd_;
+  const size_t file_size_;
+  const size_t page_size_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable idle_;
+  std::priority_queue<Request> queue_;
+  uint64_t next_sequence_ = 0;
+  size_t in_flight_ = 0;
+  bool stopping_ = false;
+  uint64_t busy_since_ns_ = 0;
+  uint64_t wall_time_ns_ = 0;
+
+  std::atomic<size_t> requests_{0};
+  std::atomic<size_t> bytes_requested_{0};
+  std::atomic<size_t> bytes_completed_{0};
+  std::atomic<uint64_t> busy_time_ns_{0};
+
+  std::vector<std::thread> threads_;
+};
+
 MmapDataLoader::~MmapDataLoader() {
+  // Stop the prefetch threads before closing the file they read from. This is
+  // null if prefetching is disabled or if this instance was moved from.
+  delete prefetcher_;
   // file_name_ can be nullptr if this instance was moved from, but freeing a
   // null pointer is safe.
   std::free(const_cast<char*>(file_name_));
@@ -67,9 +254,28 @@ MmapDataLoader::~MmapDataLoader() {
   }
 }
 
+MmapDataLoader::PrefetchPriority MmapDataLoader::segment_priority(
+    const DataLoader::SegmentInfo& segment_info) {
+  switch (segment_info.segment_type) {
+    case DataLoader::SegmentInfo::Type::Backend:
+      return PrefetchPriority::High;
+    case DataLoader::SegmentInfo::Type::Mutable:
+      return PrefetchPriority::Low;
+    default:
+      return PrefetchPriority::Normal;
+  }
+}
+
 Result<MmapDataLoader> MmapDataLoader::from(
     const char* file_name,
     MmapDataLoader::MlockConfig mlock_config) {
+  return from(file_name, mlock_config, PrefetchConfig());
+}
+
+Result<MmapDataLoader> MmapDataLoader::from(
+    const char* file_name,
+    MmapDataLoader::MlockConfig mlock_config,
+    const MmapDataLoader::PrefetchConfig& prefetch_config) {
   // Cache the page size.
   long page_size = get_os_page_size();
   if (page_size < 0) {
@@ -116,12 +322,23 @@ Result<MmapDataLoader> MmapDataLoader::from(
     return Error::MemoryAllocationFailed;
   }
 
+  Prefetcher* prefetcher = nullptr;
+  if (prefetch_config.num_threads > 0) {
+    prefetcher = new Prefetcher(
+        fd,
+        file_size,
+        static_cast<size_t>(page_size),
+        prefetch_config.num_threads);
+  }
+
   return MmapDataLoader(
       fd,
       file_size,
       file_name_copy,
       static_cast<size_t>(page_size),
-      mlock_config);
+      mlock_config,
+      prefetch_config.prefetch_loaded_segments,
+      prefetcher);
 }
 
 namespace {
@@ -179,7 +396,8 @@ Error MmapDataLoader::validate_input(size_t offset, size_t size) const {
 Result<FreeableBuffer> MmapDataLoader::load(
     size_t offset,
     size_t size,
-    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+    const DataLoader::SegmentInfo& segment_info) const {
+  const uint64_t start_ns = now_ns();
   // Ensure read range is valid.
   auto validation_err = validate_input(offset, size);
   if (validation_err != Error::Ok) {
@@ -225,7 +443,9 @@ Result<FreeableBuffer> MmapDataLoader::load(
 
   if (mlock_config_ == MlockConfig::UseMlock ||
       mlock_config_ == MlockConfig::UseMlockIgnoreErrors) {
+    const uint64_t mlock_start_ns = now_ns();
     int err = ::mlock(pages, size);
+    mlock_time_ns_ += now_ns() - mlock_start_ns;
     if (err < 0) {
       if (mlock_config_ == MlockConfig::UseMlockIgnoreErrors) {
         ET_LOG(
@@ -253,11 +473,22 @@ Result<FreeableBuffer> MmapDataLoader::load(
       }
     }
     // No need to keep track of this. munmap() will unlock as a side effect.
+  } else if (prefetcher_ != nullptr && prefetch_loaded_segments_) {
+#ifndef _WIN32
+    // Let the kernel start reading right away; the prefetch threads make sure
+    // that every page is read.
+    (void)::madvise(pages, map_size, MADV_WILLNEED);
+#endif
+    prefetcher_->enqueue(offset, size, segment_priority(segment_info));
   }
 
   // The requested data is at an offset into the mapped pages.
   const void* data = static_cast<const uint8_t*>(pages) + offset - range.start;
 
+  load_count_ += 1;
+  load_bytes_ += size;
+  load_time_ns_ += now_ns() - start_ns;
+
   return FreeableBuffer(
       // The callback knows to unmap the whole pages that encompass this region.
       data,
@@ -270,6 +501,55 @@ Result<FreeableBuffer> MmapDataLoader::load(
           static_cast<uintptr_t>(page_size_)));
 }
 
+Error MmapDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    MmapDataLoader::PrefetchPriority priority) const {
+  auto err = validate_input(offset, size);
+  if (err != Error::Ok) {
+    return err;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      prefetcher_ != nullptr,
+      NotSupported,
+      "Prefetching is disabled for %s",
+      file_name_);
+  if (size > 0) {
+    prefetcher_->enqueue(offset, size, priority);
+  }
+  return Error::Ok;
+}
+
+Error MmapDataLoader::prefetch(
+    size_t offset,
+    size_t size,
+    ET_UNUSED const DataLoader::SegmentInfo& segment_info) const {
+  // Unlike the explicit overload, a disabled prefetcher isn't an error here:
+  // the runtime asks every loader.
+  if (prefetcher_ == nullptr) {
+    return Error::NotImplemented;
+  }
+  return prefetch(offset, size, PrefetchPriority::Normal);
+}
+
+void MmapDataLoader::wait_for_prefetch() const {
+  if (prefetcher_ != nullptr) {
+    prefetcher_->wait();
+  }
+}
+
+MmapDataLoader::LoadStats MmapDataLoader::stats() const {
+  LoadStats stats{};
+  stats.load_count = load_count_.load();
+  stats.load_bytes = load_bytes_.load();
+  stats.load_time_ns = load_time_ns_.load();
+  stats.mlock_time_ns = mlock_time_ns_.load();
+  if (prefetcher_ != nullptr) {
+    prefetcher_->fill_stats(stats);
+  }
+  return stats;
+}
+
 Result<size_t> MmapDataLoader::size() const {
   ET_CHECK_OR_RETURN_ERROR(
       // Probably had its value moved to another instance.
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include <executorch/runtime/core/data_loader.h>
 #include <executorch/runtime/core/result.h>
 #include <executorch/runtime/platform/compiler.h>
@@ -40,6 +43,65 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
     UseMlockIgnoreErrors,
   };
 
+  /// Order in which queued prefetch requests are served.
+  enum class PrefetchPriority : uint8_t {
+    Low,
+    Normal,
+    High,
+  };
+
+  /**
+   * Describes how to read pages ahead of their first use.
+   *
+   * Prefetching lets loading return as soon as the pages are mapped, while
+   * background threads read them into the page cache. With `NoMlock`, this
+   * moves the page faults of the first inference off the critical path
+   * without blocking load() the way `mlock()` does.
+   */
+  struct PrefetchConfig {
+    /// The number of background threads that read prefetched pages. Zero
+    /// disables prefetching.
+    size_t num_threads = 0;
+    /// Whether to prefetch the pages of every segment returned by load(),
+    /// using segment_priority() to order them. Pages locked with `mlock()`
+    /// are already resident and are never prefetched.
+    bool prefetch_loaded_segments = true;
+  };
+
+  /**
+   * Counters describing the time spent making file data available, to help
+   * analyze startup latency. Times are in nanoseconds.
+   */
+  struct LoadStats {
+    /// The number of successful load() calls.
+    size_t load_count;
+    /// The number of bytes returned by load().
+    size_t load_bytes;
+    /// Time spent in load(), including `mlock()`.
+    uint64_t load_time_ns;
+    /// Time spent in `mlock()`.
+    uint64_t mlock_time_ns;
+    /// The number of prefetch requests queued.
+    size_t prefetch_requests;
+    /// The number of bytes covered by queued prefetch requests.
+    size_t prefetch_bytes_requested;
+    /// The number of bytes read by the prefetch threads so far.
+    size_t prefetch_bytes_completed;
+    /// Time the prefetch threads spent reading pages, summed over threads.
+    uint64_t prefetch_time_ns;
+    /// Time from the first prefetch request until the prefetch queue last
+    /// drained.
+    uint64_t prefetch_wall_time_ns;
+  };
+
+  /**
+   * Returns the default prefetch priority for a segment: backend segments are
+   * read while methods are initialized so they come first, and mutable
+   * segments, which are copied before use, come last.
+   */
+  static PrefetchPriority segment_priority(
+      const DataLoader::SegmentInfo& segment_info);
+
   /**
    * Creates a new MmapDataLoader that wraps the named file. Fails if
    * the file can't be opened for reading or if its size can't be found.
@@ -54,6 +116,20 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
       const char* file_name,
       MlockConfig mlock_config = MlockConfig::UseMlock);
 
+  /**
+   * Creates a new MmapDataLoader that wraps the named file and reads pages
+   * ahead of their first use on background threads.
+   *
+   * @param[in] file_name The path to the file to load from.
+   * @param[in] mlock_config How and whether to lock loaded pages with
+   *     `mlock()`.
+   * @param[in] prefetch_config How to prefetch pages.
+   */
+  static executorch::runtime::Result<MmapDataLoader> from(
+      const char* file_name,
+      MlockConfig mlock_config,
+      const PrefetchConfig& prefetch_config);
+
   /// DEPRECATED: Use the lowercase `from()` instead.
   ET_DEPRECATED static executorch::runtime::Result<MmapDataLoader> From(
       const char* file_name,
@@ -77,12 +153,19 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
         file_size_(rhs.file_size_),
         page_size_(rhs.page_size_),
         fd_(rhs.fd_),
-        mlock_config_(rhs.mlock_config_) {
+        mlock_config_(rhs.mlock_config_),
+        prefetch_loaded_segments_(rhs.prefetch_loaded_segments_),
+        prefetcher_(rhs.prefetcher_),
+        load_count_(rhs.load_count_.load()),
+        load_bytes_(rhs.load_bytes_.load()),
+        load_time_ns_(rhs.load_time_ns_.load()),
+        mlock_time_ns_(rhs.mlock_time_ns_.load()) {
     const_cast<const char*&>(rhs.file_name_) = nullptr;
     const_cast<size_t&>(rhs.file_size_) = 0;
     const_cast<size_t&>(rhs.page_size_) = 0;
     const_cast<int&>(rhs.fd_) = -1;
     const_cast<MlockConfig&>(rhs.mlock_config_) = MlockConfig::NoMlock;
+    const_cast<Prefetcher*&>(rhs.prefetcher_) = nullptr;
   }
 
   ~MmapDataLoader() override;
@@ -95,6 +178,50 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
 
   ET_NODISCARD executorch::runtime::Result<size_t> size() const override;
 
+  /**
+   * Queues a region of the file to be read into memory by the prefetch
+   * threads, and returns without waiting for it. Requests are served in
+   * order of priority, then in the order they were queued.
+   *
+   * The region doesn't need to be loaded: prefetching reads the file through
+   * the shared page cache, so later load() calls of the region don't have to
+   * wait for the disk.
+   *
+   * @param[in] offset The byte offset of the region in the file.
+   * @param[in] size The size of the region in bytes.
+   * @param[in] priority The priority of the request.
+   *
+   * @retval Error::Ok The request was queued.
+   * @retval Error::NotSupported Prefetching is disabled for this loader.
+   * @retval Error::InvalidArgument The region is outside of the file.
+   */
+  ET_NODISCARD executorch::runtime::Error prefetch(
+      size_t offset,
+      size_t size,
+      PrefetchPriority priority = PrefetchPriority::Normal) const;
+
+  /**
+   * Queues a segment that is about to be loaded with Normal priority, like
+   * prefetch() above.
+   *
+   * @retval Error::Ok The request was queued.
+   * @retval Error::NotImplemented Prefetching is disabled for this loader.
+   * @retval Error::InvalidArgument The region is outside of the file.
+   */
+  ET_NODISCARD executorch::runtime::Error prefetch(
+      size_t offset,
+      size_t size,
+      const DataLoader::SegmentInfo& segment_info) const override;
+
+  /**
+   * Blocks until every queued prefetch request has been served. Returns
+   * immediately if prefetching is disabled.
+   */
+  void wait_for_prefetch() const;
+
+  /// Returns the startup latency counters of this loader.
+  LoadStats stats() const;
+
   ET_NODISCARD
   executorch::runtime::Error load_into(
       size_t offset,
@@ -103,17 +230,23 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
       void* buffer) const override;
 
  private:
+  class Prefetcher;
+
   MmapDataLoader(
       int fd,
       size_t file_size,
       const char* file_name,
       size_t page_size,
-      MlockConfig mlock_config)
+      MlockConfig mlock_config,
+      bool prefetch_loaded_segments,
+      Prefetcher* prefetcher)
       : file_name_(file_name),
         file_size_(file_size),
         page_size_(page_size),
         fd_(fd),
-        mlock_config_(mlock_config) {}
+        mlock_config_(mlock_config),
+        prefetch_loaded_segments_(prefetch_loaded_segments),
+        prefetcher_(prefetcher) {}
 
   // Not safely copyable.
   MmapDataLoader(const MmapDataLoader&) = delete;
@@ -129,6 +262,15 @@ class MmapDataLoader final : public executorch::runtime::DataLoader {
   const size_t page_size_;
   const int fd_; // Owned by the instance.
   const MlockConfig mlock_config_;
+  const bool prefetch_loaded_segments_;
+  // Owned by the instance; null if prefetching is disabled. Heap-allocated so
+  // that its threads keep working when the loader is moved.
+  Prefetcher* const prefetcher_;
+
+  mutable std::atomic<size_t> load_count_{0};
+  mutable std::atomic<size_t> load_bytes_{0};
+  mutable std::atomic<uint64_t> load_time_ns_{0};
+  mutable std::atomic<uint64_t> mlock_time_ns_{0};
 };
 
 } // namespace extension
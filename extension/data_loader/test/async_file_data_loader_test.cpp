@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/data_loader/async_file_data_loader.h>
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/testing_util/temp_file.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/runtime.h>
+
+using namespace ::testing;
+using executorch::extension::AsyncFileDataLoader;
+using executorch::extension::testing::TempFile;
+using executorch::runtime::DataLoader;
+using executorch::runtime::Error;
+using executorch::runtime::FreeableBuffer;
+using executorch::runtime::Result;
+
+class AsyncFileDataLoaderTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    // Since these tests cause ET_LOG to be called, the PAL must be initialized
+    // first.
+    executorch::runtime::runtime_init();
+
+    contents_.resize(64 * 1024 + 123);
+    for (size_t i = 0; i < contents_.size(); ++i) {
+      contents_[i] = static_cast<uint8_t>((i * 31) ^ (i >> 8));
+    }
+    temp_file_ = std::make_unique<TempFile>(contents_.data(), contents_.size());
+  }
+
+  // A config with small requests, so that loads are split into many of them.
+  // Whether to try io_uring is set by the INSTANTIATE_TEST_SUITE_P call below.
+  AsyncFileDataLoader::Config config() const {
+    AsyncFileDataLoader::Config config;
+    config.alignment = 64;
+    config.request_size = 1000;
+    config.queue_depth = 8;
+    config.num_threads = 3;
+    config.use_io_uring = GetParam();
+    return config;
+  }
+
+  Result<AsyncFileDataLoader> make_loader() const {
+    return AsyncFileDataLoader::from(temp_file_->path().c_str(), config());
+  }
+
+  std::vector<uint8_t> contents_;
+  std::unique_ptr<TempFile> temp_file_;
+};
+
+TEST_P(AsyncFileDataLoaderTest, InBoundsLoadsSucceed) {
+  Result<AsyncFileDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+  if (!GetParam()) {
+    EXPECT_EQ(
+        loader->io_backend(), AsyncFileDataLoader::IoBackend::ThreadPool);
+  }
+  EXPECT_EQ(loader->size().get(), contents_.size());
+
+  const size_t regions[][2] = {
+      {0, contents_.size()}, {1, 999}, {4095, 1}, {5000, 20000}, {0, 0}};
+  for (const auto& region : regions) {
+    Result<FreeableBuffer> fb = loader->load(
+        region[0],
+        region[1],
+        DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Constant));
+    ASSERT_EQ(fb.error(), Error::Ok);
+    ASSERT_EQ(fb->size(), region[1]);
+    if (region[1] > 0) {
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(fb->data()) % 64, 0);
+      EXPECT_EQ(
+          0, std::memcmp(fb->data(), contents_.data() + region[0], region[1]));
+    }
+  }
+}
+
+TEST_P(AsyncFileDataLoaderTest, LoadIntoCopiesCorrectly) {
+  Result<AsyncFileDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  std::vector<uint8_t> buffer(30000);
+  ASSERT_EQ(
+      loader->load_into(
+          /*offset=*/17,
+          buffer.size(),
+          DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend),
+          buffer.data()),
+      Error::Ok);
+  EXPECT_EQ(0, std::memcmp(buffer.data(), contents_.data() + 17, buffer.size()));
+
+  EXPECT_EQ(
+      loader->load_into(
+          0,
+          1,
+          DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend),
+          nullptr),
+      Error::InvalidArgument);
+}
+
+TEST_P(AsyncFileDataLoaderTest, OutOfBoundsLoadFails) {
+  Result<AsyncFileDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  EXPECT_EQ(
+      loader
+          ->load(
+              contents_.size(),
+              1,
+              DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program))
+          .error(),
+      Error::InvalidArgument);
+  EXPECT_EQ(
+      loader->prefetch(
+          1,
+          contents_.size(),
+          DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Program)),
+      Error::InvalidArgument);
+}
+
+TEST_P(AsyncFileDataLoaderTest, PrefetchedRegionsAreReused) {
+  Result<AsyncFileDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  const DataLoader::SegmentInfo info(DataLoader::SegmentInfo::Type::Constant);
+  ASSERT_EQ(loader->prefetch(100, 10000, info), Error::Ok);
+  ASSERT_EQ(loader->prefetch(20000, 30000, info), Error::Ok);
+  // Already pending, so no second read is started.
+  ASSERT_EQ(loader->prefetch(20000, 30000, info), Error::Ok);
+  // Never loaded; freed by the destructor.
+  ASSERT_EQ(loader->prefetch(0, 5000, info), Error::Ok);
+
+  for (int i = 0; i < 2; ++i) {
+    // The second load of a region reads it again.
+    Result<FreeableBuffer> fb = loader->load(20000, 30000, info);
+    ASSERT_EQ(fb.error(), Error::Ok);
+    EXPECT_EQ(0, std::memcmp(fb->data(), contents_.data() + 20000, 30000));
+  }
+  // Overlapping but different regions are read separately.
+  Result<FreeableBuffer> partial = loader->load(100, 9000, info);
+  ASSERT_EQ(partial.error(), Error::Ok);
+  EXPECT_EQ(0, std::memcmp(partial->data(), contents_.data() + 100, 9000));
+  Result<FreeableBuffer> full = loader->load(100, 10000, info);
+  ASSERT_EQ(full.error(), Error::Ok);
+  EXPECT_EQ(0, std::memcmp(full->data(), contents_.data() + 100, 10000));
+}
+
+TEST_P(AsyncFileDataLoaderTest, ConcurrentLoads) {
+  Result<AsyncFileDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = 0; i < 8; ++i) {
+        const size_t offset = (t * 7919 + i * 1031) % 40000;
+        const size_t size = 1 + (t * 4001 + i * 2749) % 20000;
+        const DataLoader::SegmentInfo info(
+            DataLoader::SegmentInfo::Type::Constant);
+        if (i % 2 == 0) {
+          ASSERT_EQ(loader->prefetch(offset, size, info), Error::Ok);
+        }
+        Result<FreeableBuffer> fb = loader->load(offset, size, info);
+        ASSERT_EQ(fb.error(), Error::Ok);
+        EXPECT_EQ(0, std::memcmp(fb->data(), contents_.data() + offset, size));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST_P(AsyncFileDataLoaderTest, DirectIo) {
+  AsyncFileDataLoader::Config direct_config = config();
+  direct_config.use_direct_io = true;
+  direct_config.request_size = 3 * AsyncFileDataLoader::kDirectIoAlignment;
+  Result<AsyncFileDataLoader> loader =
+      AsyncFileDataLoader::from(temp_file_->path().c_str(), direct_config);
+  ASSERT_EQ(loader.error(), Error::Ok);
+
+  // Direct I/O depends on the file system; the results must be the same
+  // either way.
+  constexpr size_t kAlignment = AsyncFileDataLoader::kDirectIoAlignment;
+  const size_t size = contents_.size() - kAlignment;
+  std::unique_ptr<uint8_t, void (*)(uint8_t*)> buffer(
+      static_cast<uint8_t*>(::operator new(size, std::align_val_t(kAlignment))),
+      [](uint8_t* ptr) { ::operator delete(ptr, std::align_val_t(kAlignment)); });
+  ASSERT_EQ(
+      loader->load_into(
+          kAlignment,
+          size,
+          DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend),
+          buffer.get()),
+      Error::Ok);
+  EXPECT_EQ(0, std::memcmp(buffer.get(), contents_.data() + kAlignment, size));
+
+  Result<FreeableBuffer> fb = loader->load(
+      2 * kAlignment,
+      5 * kAlignment + 3,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  ASSERT_EQ(fb.error(), Error::Ok);
+  if (loader->uses_direct_io()) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(fb->data()) % kAlignment, 0);
+  }
+  EXPECT_EQ(
+      0,
+      std::memcmp(
+          fb->data(), contents_.data() + 2 * kAlignment, 5 * kAlignment + 3));
+}
+
+TEST_P(AsyncFileDataLoaderTest, MoveCtor) {
+  Result<AsyncFileDataLoader> loader = make_loader();
+  ASSERT_EQ(loader.error(), Error::Ok);
+  const DataLoader::SegmentInfo info(DataLoader::SegmentInfo::Type::Program);
+  ASSERT_EQ(loader->prefetch(0, 100, info), Error::Ok);
+
+  AsyncFileDataLoader loader2(std::move(*loader));
+  EXPECT_EQ(loader->size().error(), Error::InvalidState);
+  EXPECT_EQ(loader->load(0, 1, info).error(), Error::InvalidState);
+
+  Result<FreeableBuffer> fb = loader2.load(0, 100, info);
+  ASSERT_EQ(fb.error(), Error::Ok);
+  EXPECT_EQ(0, std::memcmp(fb->data(), contents_.data(), 100));
+}
+
+TEST_P(AsyncFileDataLoaderTest, InvalidConfigFails) {
+  AsyncFileDataLoader::Config bad_config = config();
+  bad_config.alignment = 3;
+  EXPECT_EQ(
+      AsyncFileDataLoader::from(temp_file_->path().c_str(), bad_config).error(),
+      Error::InvalidArgument);
+  bad_config = config();
+  bad_config.request_size = 0;
+  EXPECT_EQ(
+      AsyncFileDataLoader::from(temp_file_->path().c_str(), bad_config).error(),
+      Error::InvalidArgument);
+  EXPECT_EQ(
+      AsyncFileDataLoader::from(
+          "/tmp/FILE_DOES_NOT_EXIST_EXECUTORCH_ASYNC_LOADER_TEST")
+          .error(),
+      Error::AccessFailed);
+}
+
+// Run all tests with and without io_uring. Where io_uring is unavailable,
+// both fall back to threads.
+INSTANTIATE_TEST_SUITE_P(
+    IoBackends,
+    AsyncFileDataLoaderTest,
+    ::testing::Values(true, false));
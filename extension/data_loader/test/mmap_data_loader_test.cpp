@@ -428,4 +428,105 @@ TEST_F(MmapDataLoaderTest, LoadIntoCopiesOffsetCorrectly) {
 
   // Verify memory copied correctly.
   EXPECT_EQ(0, std::memcmp(dst, contents + offset, size));
-}
\ No newline at end of file
+}
+// Tests that loaded segments are prefetched and counted.
+TEST_F(MmapDataLoaderTest, PrefetchLoadedSegments) {
+  const size_t contents_size = 8 * page_size_;
+  auto contents = std::make_unique<uint8_t[]>(contents_size);
+  for (size_t i = 0; i < contents_size; ++i) {
+    contents[i] = static_cast<uint8_t>(i * 7);
+  }
+  TempFile tf(contents.get(), contents_size);
+
+  MmapDataLoader::PrefetchConfig prefetch_config;
+  prefetch_config.num_threads = 2;
+  Result<MmapDataLoader> mdl = MmapDataLoader::from(
+      tf.path().c_str(), MmapDataLoader::MlockConfig::NoMlock, prefetch_config);
+  ASSERT_EQ(mdl.error(), Error::Ok);
+
+  Result<FreeableBuffer> constants = mdl->load(
+      /*offset=*/page_size_,
+      /*size=*/3 * page_size_,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Constant));
+  ASSERT_EQ(constants.error(), Error::Ok);
+  Result<FreeableBuffer> backend = mdl->load(
+      /*offset=*/4 * page_size_ + 1,
+      /*size=*/page_size_,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Backend));
+  ASSERT_EQ(backend.error(), Error::Ok);
+  mdl->wait_for_prefetch();
+
+  EXPECT_EQ(
+      0,
+      std::memcmp(
+          constants->data(), contents.get() + page_size_, constants->size()));
+  EXPECT_EQ(
+      0,
+      std::memcmp(
+          backend->data(),
+          contents.get() + 4 * page_size_ + 1,
+          backend->size()));
+
+  MmapDataLoader::LoadStats stats = mdl->stats();
+  EXPECT_EQ(stats.load_count, 2);
+  EXPECT_EQ(stats.load_bytes, 4 * page_size_);
+  EXPECT_EQ(stats.mlock_time_ns, 0);
+  EXPECT_EQ(stats.prefetch_requests, 2);
+  EXPECT_EQ(stats.prefetch_bytes_requested, 4 * page_size_);
+  EXPECT_EQ(stats.prefetch_bytes_completed, 4 * page_size_);
+}
+
+// Tests explicit prefetch requests.
+TEST_F(MmapDataLoaderTest, PrefetchRegions) {
+  const size_t contents_size = 8 * page_size_;
+  auto contents = std::make_unique<uint8_t[]>(contents_size);
+  TempFile tf(contents.get(), contents_size);
+
+  // Prefetching must be enabled.
+  Result<MmapDataLoader> disabled = MmapDataLoader::from(tf.path().c_str());
+  ASSERT_EQ(disabled.error(), Error::Ok);
+  EXPECT_EQ(disabled->prefetch(0, page_size_), Error::NotSupported);
+  const DataLoader::SegmentInfo backend_info(
+      DataLoader::SegmentInfo::Type::Backend);
+  const DataLoader& disabled_base = *disabled;
+  EXPECT_EQ(
+      disabled_base.prefetch(0, page_size_, backend_info),
+      Error::NotImplemented);
+  disabled->wait_for_prefetch();
+
+  MmapDataLoader::PrefetchConfig prefetch_config;
+  prefetch_config.num_threads = 1;
+  prefetch_config.prefetch_loaded_segments = false;
+  Result<MmapDataLoader> mdl = MmapDataLoader::from(
+      tf.path().c_str(), MmapDataLoader::MlockConfig::NoMlock, prefetch_config);
+  ASSERT_EQ(mdl.error(), Error::Ok);
+
+  EXPECT_EQ(
+      mdl->prefetch(0, 2 * page_size_, MmapDataLoader::PrefetchPriority::Low),
+      Error::Ok);
+  EXPECT_EQ(
+      mdl->prefetch(
+          contents_size - 1, 1, MmapDataLoader::PrefetchPriority::High),
+      Error::Ok);
+  EXPECT_EQ(mdl->prefetch(contents_size, 1), Error::InvalidArgument);
+  // The runtime prefetches segments through the DataLoader interface.
+  const DataLoader& base = *mdl;
+  EXPECT_EQ(base.prefetch(4 * page_size_, page_size_, backend_info), Error::Ok);
+
+  // Segments are not prefetched when disabled in the config.
+  Result<FreeableBuffer> fb = mdl->load(
+      /*offset=*/0,
+      /*size=*/page_size_,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::Constant));
+  ASSERT_EQ(fb.error(), Error::Ok);
+
+  // Moving the loader keeps the queued requests.
+  MmapDataLoader mdl2(std::move(*mdl));
+  mdl2.wait_for_prefetch();
+  MmapDataLoader::LoadStats stats = mdl2.stats();
+  EXPECT_EQ(stats.load_count, 1);
+  EXPECT_EQ(stats.prefetch_requests, 3);
+  EXPECT_EQ(stats.prefetch_bytes_requested, 3 * page_size_ + 1);
+  EXPECT_EQ(stats.prefetch_bytes_completed, 3 * page_size_ + 1);
+  EXPECT_EQ(mdl->prefetch(0, 1), Error::InvalidState);
+}
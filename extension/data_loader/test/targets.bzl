@@ -38,6 +38,17 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "async_file_data_loader_test",
+        srcs = [
+            "async_file_data_loader_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/testing_util:temp_file",
+            "//executorch/extension/data_loader:async_file_data_loader",
+        ],
+    )
+
     runtime.cxx_test(
         name = "file_descriptor_data_loader_test",
         srcs = [
@@ -19,6 +19,9 @@
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/platform/compiler.h>
 
+#include <algorithm>
+#include <cstring>
+
 using executorch::runtime::Error;
 using executorch::runtime::FreeableBuffer;
 using executorch::runtime::Result;
@@ -44,46 +47,94 @@ bool is_aligned(const void* data) {
   return addr % kMinimumAlignment == 0;
 }
 
+/// Orders keys bytewise, shorter keys first on a common prefix, which is how
+/// the serializer sorts named_data.
+int compare_keys(
+    const flatbuffers::String* lhs,
+    executorch::aten::string_view rhs) {
+  const size_t common = std::min<size_t>(lhs->size(), rhs.size());
+  const int cmp = common == 0 ? 0 : memcmp(lhs->data(), rhs.data(), common);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return lhs->size() < rhs.size() ? -1 : (lhs->size() > rhs.size() ? 1 : 0);
+}
+
+bool are_keys_sorted(
+    const flatbuffers::Vector<
+        flatbuffers::Offset<flat_tensor_flatbuffer::NamedData>>* named_data) {
+  for (uint32_t i = 1; i < named_data->size(); i++) {
+    const flatbuffers::String* prev = named_data->Get(i - 1)->key();
+    const flatbuffers::String* key = named_data->Get(i)->key();
+    if (compare_keys(prev, {key->data(), key->size()}) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Result<const flat_tensor_flatbuffer::NamedData*> get_named_data(
     executorch::aten::string_view key,
     const flatbuffers::Vector<
         flatbuffers::Offset<flat_tensor_flatbuffer::NamedData>>* named_data,
+    bool keys_sorted,
     const flatbuffers::Vector<
         flatbuffers::Offset<flat_tensor_flatbuffer::DataSegment>>* segments,
     size_t segment_end_offset) {
-  // Linear search by name.
   if (named_data == nullptr) {
     return Error::NotFound;
   }
-  for (int i = 0; i < named_data->size(); i++) {
-    if (std::strncmp(
-            named_data->Get(i)->key()->c_str(),
-            key.data(),
-            named_data->Get(i)->key()->size()) == 0) {
-      const auto* found = named_data->Get(i);
-      // Validate the named_data.
-      size_t segment_index = found->segment_index();
-      ET_CHECK_OR_RETURN_ERROR(
-          segment_index >= 0 && segment_index < segments->size(),
-          InvalidExternalData,
-          "Segment index %zu for key %.*s is out of bounds for segment size %d. Malformed PTD file.",
-          segment_index,
-          static_cast<int>(key.size()),
-          key.data(),
-          segments->size());
-      // Validate the segment.
-      ET_CHECK_OR_RETURN_ERROR(
-          segments->Get(segment_index)->offset() < segment_end_offset,
-          InvalidExternalData,
-          "Invalid segment offset %" PRIu64
-          " is larger than the segment_base_offset + segment_data_size %" PRIu64
-          "; malformed PTD file.",
-          segments->Get(segment_index)->offset(),
-          static_cast<uint64_t>(segment_end_offset));
-      return found;
+  const flat_tensor_flatbuffer::NamedData* found = nullptr;
+  if (keys_sorted) {
+    // Binary search by name.
+    uint32_t low = 0;
+    uint32_t high = named_data->size();
+    while (low < high) {
+      const uint32_t mid = low + (high - low) / 2;
+      const int cmp = compare_keys(named_data->Get(mid)->key(), key);
+      if (cmp == 0) {
+        found = named_data->Get(mid);
+        break;
+      }
+      if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
     }
+  } else {
+    // Linear search by name, for files written before named_data was sorted.
+    for (uint32_t i = 0; i < named_data->size(); i++) {
+      if (compare_keys(named_data->Get(i)->key(), key) == 0) {
+        found = named_data->Get(i);
+        break;
+      }
+    }
+  }
+  if (found == nullptr) {
+    return Error::NotFound;
   }
-  return Error::NotFound;
+
+  // Validate the named_data.
+  size_t segment_index = found->segment_index();
+  ET_CHECK_OR_RETURN_ERROR(
+      segment_index >= 0 && segment_index < segments->size(),
+      InvalidExternalData,
+      "Segment index %zu for key %.*s is out of bounds for segment size %d. Malformed PTD file.",
+      segment_index,
+      static_cast<int>(key.size()),
+      key.data(),
+      segments->size());
+  // Validate the segment.
+  ET_CHECK_OR_RETURN_ERROR(
+      segments->Get(segment_index)->offset() < segment_end_offset,
+      InvalidExternalData,
+      "Invalid segment offset %" PRIu64
+      " is larger than the segment_base_offset + segment_data_size %" PRIu64
+      "; malformed PTD file.",
+      segments->Get(segment_index)->offset(),
+      static_cast<uint64_t>(segment_end_offset));
+  return found;
 }
 
 Result<const TensorLayout> create_tensor_layout(
@@ -106,6 +157,7 @@ ET_NODISCARD Result<const TensorLayout> FlatTensorDataMap::get_tensor_layout(
   Result<const flat_tensor_flatbuffer::NamedData*> named_data = get_named_data(
       key,
       flat_tensor_->named_data(),
+      keys_sorted_,
       flat_tensor_->segments(),
       header_.segment_base_offset + header_.segment_data_size);
   if (!named_data.ok()) {
@@ -119,6 +171,7 @@ ET_NODISCARD Result<FreeableBuffer> FlatTensorDataMap::get_data(
   Result<const flat_tensor_flatbuffer::NamedData*> named_data = get_named_data(
       key,
       flat_tensor_->named_data(),
+      keys_sorted_,
       flat_tensor_->segments(),
       header_.segment_base_offset + header_.segment_data_size);
   if (!named_data.ok()) {
@@ -143,6 +196,7 @@ ET_NODISCARD Error FlatTensorDataMap::load_data_into(
   Result<const flat_tensor_flatbuffer::NamedData*> named_data = get_named_data(
       key,
       flat_tensor_->named_data(),
+      keys_sorted_,
       flat_tensor_->segments(),
       header_.segment_base_offset + header_.segment_data_size);
   if (!named_data.ok()) {
@@ -262,7 +316,11 @@ ET_NODISCARD Result<const char*> FlatTensorDataMap::get_key(
       "FlatTensor segments is nullptr, malformed PTD file.");
 
   return FlatTensorDataMap(
-      fh.get(), std::move(flat_tensor_data.get()), flat_tensor, loader);
+      fh.get(),
+      std::move(flat_tensor_data.get()),
+      flat_tensor,
+      loader,
+      are_keys_sorted(flat_tensor->named_data()));
 }
 
 } // namespace extension
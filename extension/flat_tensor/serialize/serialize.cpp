@@ -73,7 +73,8 @@ runtime::Error save_ptd(
   std::vector<flatbuffers::Offset<::flat_tensor_flatbuffer::DataSegment>>
       segments;
 
-  // Write the tensors.
+  // Write the tensors. std::map iterates in byte order of the keys, which
+  // keeps named_data sorted so the runtime can binary search it.
   size_t total_segment_size = 0;
   uint32_t i = 0;
   for (const auto& [name, tensor] : tensor_map) {
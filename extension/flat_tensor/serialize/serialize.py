@@ -247,7 +247,8 @@ def _extract_named_data(
         segments: A list of segments to append data to. Modified in-place.
 
     Returns:
-        A list of NamedData describing the offsets to the opaque blob data.
+        A list of NamedData, sorted by key, describing the offsets to the opaque
+        blob data.
     """
 
     # Map from buffer_idx to segment_idx.
@@ -273,6 +274,8 @@ def _extract_named_data(
                 tensor_layout=data_entry.tensor_layout,
             )
         )
+    # The runtime binary searches named_data when it is sorted by key.
+    named_data.sort(key=lambda entry: entry.key.encode("utf-8"))
     return named_data
 
 
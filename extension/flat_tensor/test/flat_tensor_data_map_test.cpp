@@ -112,6 +112,10 @@ TEST_F(FlatTensorDataMapTest, FlatTensorDataMap_GetData) {
   // Check get_data fails when key is not found.
   Result<FreeableBuffer> data_c_res = data_map->get_data("c");
   EXPECT_EQ(data_c_res.error(), Error::NotFound);
+
+  // Keys must match exactly, not just by prefix.
+  Result<FreeableBuffer> data_ab_res = data_map->get_data("ab");
+  EXPECT_EQ(data_ab_res.error(), Error::NotFound);
 }
 
 TEST_F(FlatTensorDataMapTest, FlatTensorDataMap_Keys) {
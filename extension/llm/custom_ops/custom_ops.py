@@ -265,6 +265,87 @@ def update_cache_with_indices_meta(
     return torch.empty((1,), dtype=value.dtype, device="meta")
 
 
+def _validate_paged_cache_params(
+    value,
+    cache,
+    block_table,
+    start_pos,
+):
+    assert (
+        value.dim() == 4
+    ), f"Expected value to be 4 dimensional but got {value.dim()} dimensions."
+    assert (
+        cache.dim() == 4
+    ), f"Expected cache to be 4 dimensional [num_blocks, block_size, heads, head_dim] but got {cache.dim()} dimensions."
+    assert (
+        value.dtype == cache.dtype
+    ), f"Expected value and cache to be of the same type but got value type {value.dtype} and cache type {cache.dtype}"
+    assert (
+        block_table.dim() == 2
+    ), f"Expected block_table to be 2 dimensional but got {block_table.dim()} dimensions."
+    assert (
+        block_table.dtype == torch.int64
+    ), f"Expected block_table to be int64 but got {block_table.dtype}"
+    assert block_table.size(0) == value.size(
+        0
+    ), f"Expected block_table batch dimension to match batch dimension but got {block_table.size(0)} and {value.size(0)}"
+    assert (
+        start_pos.dim() == 1
+    ), f"Expected start_pos to be 1 dimensional but got {start_pos.dim()} dimensions."
+    assert (
+        start_pos.dtype == torch.int64
+    ), f"Expected start_pos to be int64 but got {start_pos.dtype}"
+    assert start_pos.size(0) == value.size(
+        0
+    ), f"Expected start_pos to have one position per sequence but got {start_pos.size(0)} for batch size {value.size(0)}"
+
+
+@impl(custom_ops_lib, "update_cache_paged", "Meta")
+def update_cache_paged_meta(
+    value,
+    cache,
+    block_table,
+    start_pos,
+):
+    _validate_paged_cache_params(value, cache, block_table, start_pos)
+    for i in [2, 3]:
+        assert value.size(i) == cache.size(
+            i
+        ), f"Expected value and cache to have same size in dimension {i} but got {value.size(i)} and {cache.size(i)}"
+
+    # See update_cache_meta.
+    return torch.empty((1,), dtype=value.dtype, device="meta")
+
+
+@impl(custom_ops_lib, "sdpa_paged", "Meta")
+def sdpa_paged_meta(
+    query,
+    key_cache,
+    value_cache,
+    block_table,
+    start_pos,
+    attn_mask=None,
+    drpout_p=0.0,
+    is_causal=False,
+    scale=None,
+):
+    _validate_paged_cache_params(query, key_cache, block_table, start_pos)
+    assert (
+        key_cache.shape == value_cache.shape
+    ), f"Expected key and value caches to have the same shape but got {key_cache.shape} and {value_cache.shape}"
+    assert (
+        query.size(3) == key_cache.size(3)
+    ), f"Expected query and caches to have the same head dim but got {query.size(3)} and {key_cache.size(3)}"
+    assert (
+        query.size(2) % key_cache.size(2) == 0
+    ), f"Expected query heads {query.size(2)} to be a multiple of kv heads {key_cache.size(2)}"
+    assert not (
+        attn_mask is not None and is_causal
+    ), "attn_mask and is_causal cannot be set at the same time"
+
+    return torch.empty_like(query)
+
+
 def _validate_quantized_sdpa_params(
     query,
     key,
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/custom_ops/kv_block_allocator.h>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+using executorch::runtime::Error;
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+KVBlockAllocator::KVBlockAllocator(
+    int64_t num_blocks,
+    int64_t block_size,
+    int64_t max_blocks_per_seq)
+    : num_blocks_(num_blocks),
+      block_size_(block_size),
+      max_blocks_per_seq_(max_blocks_per_seq) {
+  ET_CHECK_MSG(num_blocks > 0, "num_blocks must be positive");
+  ET_CHECK_MSG(block_size > 0, "block_size must be positive");
+  ET_CHECK_MSG(max_blocks_per_seq > 0, "max_blocks_per_seq must be positive");
+  free_blocks_.reserve(num_blocks);
+  // Hand out low block ids first.
+  for (int64_t block = num_blocks - 1; block >= 0; --block) {
+    free_blocks_.push_back(block);
+  }
+}
+
+Error KVBlockAllocator::reserve(int64_t* table_row, int64_t num_tokens) {
+  ET_CHECK_OR_RETURN_ERROR(
+      num_tokens >= 0 && blocks_for(num_tokens) <= max_blocks_per_seq_,
+      InvalidArgument,
+      "%" PRId64 " tokens don't fit in %" PRId64 " blocks of %" PRId64,
+      num_tokens,
+      max_blocks_per_seq_,
+      block_size_);
+  const int64_t needed = blocks_for(num_tokens);
+  int64_t missing = 0;
+  for (int64_t i = 0; i < needed; ++i) {
+    if (table_row[i] < 0) {
+      ++missing;
+    }
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      missing <= num_free_blocks(),
+      MemoryAllocationFailed,
+      "Need %" PRId64 " more KV cache blocks but only %" PRId64 " are free",
+      missing,
+      num_free_blocks());
+  for (int64_t i = 0; i < needed; ++i) {
+    if (table_row[i] < 0) {
+      table_row[i] = free_blocks_.back();
+      free_blocks_.pop_back();
+    }
+  }
+  return Error::Ok;
+}
+
+void KVBlockAllocator::release(int64_t* table_row) {
+  for (int64_t i = 0; i < max_blocks_per_seq_; ++i) {
+    if (table_row[i] >= 0) {
+      free_blocks_.push_back(table_row[i]);
+      table_row[i] = -1;
+    }
+  }
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <executorch/runtime/core/error.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Hands out the blocks of a paged KV cache pool to sequences.
+ *
+ * The pool passed to update_cache_paged and sdpa_paged has a fixed number of
+ * blocks of `block_size` tokens each. Every sequence owns a row of the block
+ * table that maps its logical blocks to physical blocks in the pool; blocks
+ * are only taken from the free list when a sequence grows into them, so the
+ * cache scales with the tokens actually in use rather than with
+ * `max_seq_len` times the batch size.
+ *
+ * Unused block table entries hold -1. Not thread-safe.
+ */
+class KVBlockAllocator final {
+ public:
+  /**
+   * @param[in] num_blocks The number of blocks in the pool.
+   * @param[in] block_size The number of tokens in each block.
+   * @param[in] max_blocks_per_seq The width of a block table row.
+   */
+  KVBlockAllocator(
+      int64_t num_blocks,
+      int64_t block_size,
+      int64_t max_blocks_per_seq);
+
+  /**
+   * Makes sure that the sequence that owns `table_row` has blocks for its
+   * first `num_tokens` tokens, allocating new ones as needed.
+   *
+   * @param[in,out] table_row The sequence's block table row, with
+   *     `max_blocks_per_seq()` entries.
+   * @param[in] num_tokens The number of tokens the sequence will hold.
+   *
+   * @retval Error::Ok The blocks are allocated.
+   * @retval Error::InvalidArgument `num_tokens` doesn't fit in a row.
+   * @retval Error::MemoryAllocationFailed There are not enough free blocks.
+   *     `table_row` is left unchanged.
+   */
+  runtime::Error reserve(int64_t* table_row, int64_t num_tokens);
+
+  /**
+   * Returns all blocks of the sequence that owns `table_row` to the pool and
+   * resets its entries to -1.
+   */
+  void release(int64_t* table_row);
+
+  /// Returns the number of blocks needed to hold `num_tokens` tokens.
+  int64_t blocks_for(int64_t num_tokens) const {
+    return (num_tokens + block_size_ - 1) / block_size_;
+  }
+
+  int64_t num_blocks() const {
+    return num_blocks_;
+  }
+
+  int64_t num_free_blocks() const {
+    return static_cast<int64_t>(free_blocks_.size());
+  }
+
+  int64_t block_size() const {
+    return block_size_;
+  }
+
+  int64_t max_blocks_per_seq() const {
+    return max_blocks_per_seq_;
+  }
+
+ private:
+  const int64_t num_blocks_;
+  const int64_t block_size_;
+  const int64_t max_blocks_per_seq_;
+  std::vector<int64_t> free_blocks_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
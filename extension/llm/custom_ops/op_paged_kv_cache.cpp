@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/custom_ops/op_paged_kv_cache.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+// @lint-ignore CLANGTIDY facebook-unused-include-check
+#include <executorch/runtime/core/exec_aten/util/scalar_type_util.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
+
+#include <executorch/extension/kernel_util/make_boxed_from_unboxed_functor.h>
+
+namespace torch {
+namespace executor {
+
+namespace native {
+
+namespace {
+
+bool validate_paged_cache(const Tensor& cache, const char* name) {
+  ET_CHECK_OR_RETURN_FALSE(
+      cache.dim() == 4,
+      "%s must be a 4D tensor [num_blocks, block_size, heads, head_dim]",
+      name);
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(cache.dim_order().data(), cache.dim()),
+      "%s must be in contiguous dim order",
+      name);
+  return true;
+}
+
+// Checks that start_pos holds a non-negative position for each sequence.
+bool validate_start_pos(const Tensor& start_pos, int64_t batch_size) {
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.dim() == 1, "start_pos must be a 1D tensor [batch_size]");
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.scalar_type() == ScalarType::Long,
+      "start_pos must be of Long (int64_t) type");
+  ET_CHECK_OR_RETURN_FALSE(
+      start_pos.size(0) == batch_size,
+      "start_pos size %zd does not match batch size %" PRId64,
+      start_pos.size(0),
+      batch_size);
+  const int64_t* positions = start_pos.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < batch_size; ++b) {
+    ET_CHECK_OR_RETURN_FALSE(
+        positions[b] >= 0,
+        "start_pos[%" PRId64 "] must be non-negative: %" PRId64,
+        b,
+        positions[b]);
+  }
+  return true;
+}
+
+// Checks that the first start_pos[b] + seq_len tokens of every sequence b in
+// block_table live in valid blocks of the pool.
+bool validate_block_table(
+    const Tensor& block_table,
+    const Tensor& cache,
+    const Tensor& start_pos,
+    int64_t batch_size,
+    int64_t seq_len) {
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.dim() == 2,
+      "block_table must be a 2D tensor [batch_size, max_blocks_per_seq]");
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.scalar_type() == ScalarType::Long,
+      "block_table must be of Long (int64_t) type");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(
+          block_table.dim_order().data(), block_table.dim()),
+      "block_table must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(
+      block_table.size(0) == batch_size,
+      "block_table batch size %zd does not match %" PRId64,
+      block_table.size(0),
+      batch_size);
+
+  const int64_t block_size = cache.size(1);
+  const int64_t num_blocks = cache.size(0);
+  const int64_t* positions = start_pos.const_data_ptr<int64_t>();
+  const int64_t* table = block_table.const_data_ptr<int64_t>();
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const int64_t num_tokens = positions[b] + seq_len;
+    const int64_t blocks_needed = (num_tokens + block_size - 1) / block_size;
+    ET_CHECK_OR_RETURN_FALSE(
+        blocks_needed <= block_table.size(1),
+        "%" PRId64 " tokens need %" PRId64
+        " blocks but block_table has room for %zd",
+        num_tokens,
+        blocks_needed,
+        block_table.size(1));
+    for (int64_t i = 0; i < blocks_needed; ++i) {
+      const int64_t block = table[b * block_table.size(1) + i];
+      ET_CHECK_OR_RETURN_FALSE(
+          block >= 0 && block < num_blocks,
+          "block_table[%" PRId64 "][%" PRId64 "] = %" PRId64
+          " is not in [0, %" PRId64 ")",
+          b,
+          i,
+          block,
+          num_blocks);
+    }
+  }
+  return true;
+}
+
+bool validate_update_cache_paged_args(
+    const Tensor& value,
+    const Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos) {
+  ET_CHECK_OR_RETURN_FALSE(value.dim() == 4, "value must be a 4D tensor");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(value.dim_order().data(), value.dim()),
+      "value must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(validate_paged_cache(cache, "cache"), "bad cache");
+  ET_CHECK_OR_RETURN_FALSE(
+      value.scalar_type() == cache.scalar_type(),
+      "value and cache must have the same data type");
+  ET_CHECK_OR_RETURN_FALSE(
+      value.size(2) == cache.size(2) && value.size(3) == cache.size(3),
+      "value heads and head dim must match the cache");
+  ET_CHECK_OR_RETURN_FALSE(
+      validate_start_pos(start_pos, value.size(0)), "bad start_pos");
+  return validate_block_table(
+      block_table, cache, start_pos, value.size(0), value.size(1));
+}
+
+bool validate_sdpa_paged_args(
+    const Tensor& q,
+    const Tensor& k_cache,
+    const Tensor& v_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask) {
+  ET_CHECK_OR_RETURN_FALSE(q.dim() == 4, "query must be a 4D tensor");
+  ET_CHECK_OR_RETURN_FALSE(
+      is_contiguous_dim_order(q.dim_order().data(), q.dim()),
+      "query must be in contiguous dim order");
+  ET_CHECK_OR_RETURN_FALSE(
+      validate_paged_cache(k_cache, "k_cache"), "bad key cache");
+  ET_CHECK_OR_RETURN_FALSE(
+      validate_paged_cache(v_cache, "v_cache"), "bad value cache");
+  ET_CHECK_OR_RETURN_FALSE(
+      q.scalar_type() == ScalarType::Float, "Query must be Float type");
+  ET_CHECK_OR_RETURN_FALSE(
+      q.scalar_type() == k_cache.scalar_type() &&
+          q.scalar_type() == v_cache.scalar_type(),
+      "Key and Value caches must have the same data type as Query");
+  ET_CHECK_OR_RETURN_FALSE(
+      k_cache.sizes() == v_cache.sizes(),
+      "Key and Value caches must have the same shape");
+  ET_CHECK_OR_RETURN_FALSE(
+      q.size(3) == k_cache.size(3),
+      "Q/K/V should have the same head size");
+  ET_CHECK_OR_RETURN_FALSE(
+      q.size(2) % k_cache.size(2) == 0,
+      "number of query heads %zd must be a multiple of kv heads %zd",
+      q.size(2),
+      k_cache.size(2));
+  ET_CHECK_OR_RETURN_FALSE(
+      validate_start_pos(start_pos, q.size(0)), "bad start_pos");
+
+  if (attn_mask.has_value()) {
+    const int64_t* positions = start_pos.const_data_ptr<int64_t>();
+    int64_t max_start_pos = 0;
+    for (int64_t b = 0; b < q.size(0); ++b) {
+      max_start_pos = std::max(max_start_pos, positions[b]);
+    }
+    const int64_t num_keys = max_start_pos + q.size(1);
+    const Tensor& mask = attn_mask.value();
+    ET_CHECK_OR_RETURN_FALSE(
+        mask.dim() == 2, "Attention mask must be a 2D tensor");
+    ET_CHECK_OR_RETURN_FALSE(
+        mask.scalar_type() == ScalarType::Float,
+        "Attention mask must be a Float tensor");
+    ET_CHECK_OR_RETURN_FALSE(
+        is_contiguous_dim_order(mask.dim_order().data(), mask.dim()),
+        "Attention mask must be in contiguous dim order");
+    ET_CHECK_OR_RETURN_FALSE(
+        mask.size(0) == q.size(1) && mask.size(1) >= num_keys,
+        "Attention mask must be at least [%zd, %" PRId64 "]",
+        q.size(1),
+        num_keys);
+  }
+  return validate_block_table(
+      block_table, k_cache, start_pos, q.size(0), q.size(1));
+}
+
+// Computes one row of attention with an online softmax, visiting the keys of
+// the sequence block by block so that the cache never has to be gathered
+// into a contiguous buffer.
+template <typename scalar_t>
+void paged_attention_row(
+    const scalar_t* q_row,
+    const scalar_t* k_data,
+    const scalar_t* v_data,
+    const int64_t* table_row,
+    const float* mask_row,
+    int64_t num_keys,
+    int64_t block_size,
+    int64_t block_stride,
+    int64_t token_stride,
+    int64_t head_dim,
+    scalar_t scaling_factor,
+    scalar_t* scores,
+    scalar_t* acc,
+    scalar_t* out_row) {
+  using Vec = ::at::vec::Vectorized<scalar_t>;
+  scalar_t running_max = -std::numeric_limits<scalar_t>::infinity();
+  scalar_t running_sum = 0;
+  std::fill(acc, acc + head_dim, static_cast<scalar_t>(0));
+
+  for (int64_t start = 0; start < num_keys; start += block_size) {
+    const int64_t n = std::min(block_size, num_keys - start);
+    const int64_t offset = table_row[start / block_size] * block_stride;
+    const scalar_t* k_block = k_data + offset;
+    const scalar_t* v_block = v_data + offset;
+
+    scalar_t block_max = -std::numeric_limits<scalar_t>::infinity();
+    for (int64_t t = 0; t < n; ++t) {
+      scalar_t score = ::at::vec::map2_reduce_all<scalar_t>(
+          [](Vec x, Vec y) { return x * y; },
+          [](Vec x, Vec y) { return x + y; },
+          q_row,
+          k_block + t * token_stride,
+          head_dim);
+      score *= scaling_factor;
+      if (mask_row != nullptr) {
+        score += static_cast<scalar_t>(mask_row[start + t]);
+      }
+      scores[t] = score;
+      block_max = std::max(block_max, score);
+    }
+    if (block_max == -std::numeric_limits<scalar_t>::infinity()) {
+      // Everything in this block is masked out.
+      continue;
+    }
+
+    const scalar_t new_max = std::max(running_max, block_max);
+    const scalar_t correction = std::exp(running_max - new_max);
+    running_sum *= correction;
+    ::at::vec::map<scalar_t>(
+        [correction](Vec x) { return x * Vec(correction); },
+        acc,
+        acc,
+        head_dim);
+    for (int64_t t = 0; t < n; ++t) {
+      const scalar_t p = std::exp(scores[t] - new_max);
+      running_sum += p;
+      ::at::vec::map2<scalar_t>(
+          [p](Vec a, Vec v) { return a + Vec(p) * v; },
+          acc,
+          acc,
+          v_block + t * token_stride,
+          head_dim);
+    }
+    running_max = new_max;
+  }
+
+  const scalar_t sum_reciprocal =
+      running_sum > 0 ? static_cast<scalar_t>(1) / running_sum : 0;
+  ::at::vec::map<scalar_t>(
+      [sum_reciprocal](Vec x) { return x * Vec(sum_reciprocal); },
+      out_row,
+      acc,
+      head_dim);
+}
+
+template <typename scalar_t>
+void sdpa_paged_impl(
+    const Tensor& q,
+    const Tensor& k_cache,
+    const Tensor& v_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    bool is_causal,
+    double scale,
+    Tensor& output) {
+  const int64_t batch_size = q.size(0);
+  const int64_t seq_len = q.size(1);
+  const int64_t num_heads = q.size(2);
+  const int64_t head_dim = q.size(3);
+  const int64_t block_size = k_cache.size(1);
+  const int64_t num_heads_kv = k_cache.size(2);
+  const int64_t num_reps = num_heads / num_heads_kv;
+  const int64_t max_blocks_per_seq = block_table.size(1);
+  // Strides within the pool, in elements.
+  const int64_t token_stride = num_heads_kv * head_dim;
+  const int64_t block_stride = block_size * token_stride;
+
+  const scalar_t* q_data = q.const_data_ptr<scalar_t>();
+  const scalar_t* k_data = k_cache.const_data_ptr<scalar_t>();
+  const scalar_t* v_data = v_cache.const_data_ptr<scalar_t>();
+  const int64_t* table = block_table.const_data_ptr<int64_t>();
+  const int64_t* positions = start_pos.const_data_ptr<int64_t>();
+  const float* mask_data = attn_mask.has_value()
+      ? attn_mask.value().const_data_ptr<float>()
+      : nullptr;
+  const int64_t mask_stride =
+      attn_mask.has_value() ? attn_mask.value().size(1) : 0;
+  scalar_t* out_data = output.mutable_data_ptr<scalar_t>();
+  const scalar_t scaling_factor = static_cast<scalar_t>(scale);
+
+  // Rows are ordered (batch, head, query) so that the rows of a chunk share
+  // the same blocks.
+  auto compute_lambda = [&](int64_t begin, int64_t end) {
+    std::vector<scalar_t> scores(block_size);
+    std::vector<scalar_t> acc(head_dim);
+    for (int64_t index = begin; index < end; ++index) {
+      const int64_t s = index % seq_len;
+      const int64_t h = (index / seq_len) % num_heads;
+      const int64_t b = index / (seq_len * num_heads);
+      const int64_t row_offset = ((b * seq_len + s) * num_heads + h) * head_dim;
+      const int64_t num_keys =
+          is_causal ? positions[b] + s + 1 : positions[b] + seq_len;
+      paged_attention_row<scalar_t>(
+          q_data + row_offset,
+          k_data + (h / num_reps) * head_dim,
+          v_data + (h / num_reps) * head_dim,
+          table + b * max_blocks_per_seq,
+          mask_data != nullptr ? mask_data + s * mask_stride : nullptr,
+          num_keys,
+          block_size,
+          block_stride,
+          token_stride,
+          head_dim,
+          scaling_factor,
+          scores.data(),
+          acc.data(),
+          out_data + row_offset);
+    }
+  };
+  torch::executor::parallel_for(
+      0, batch_size * num_heads * seq_len, 1, compute_lambda);
+}
+
+} // anonymous namespace
+
+Tensor& update_cache_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output) {
+  ET_KERNEL_CHECK(
+      ctx,
+      validate_update_cache_paged_args(value, cache, block_table, start_pos),
+      InvalidArgument,
+      output);
+
+  const int64_t batch_size = value.size(0);
+  const int64_t seq_len = value.size(1);
+  const int64_t block_size = cache.size(1);
+  const int64_t max_blocks_per_seq = block_table.size(1);
+  const size_t bytes_per_token =
+      value.size(2) * value.size(3) * value.element_size();
+
+  const uint8_t* value_data =
+      static_cast<const uint8_t*>(value.const_data_ptr());
+  uint8_t* cache_data = static_cast<uint8_t*>(cache.mutable_data_ptr());
+  const int64_t* table = block_table.const_data_ptr<int64_t>();
+  const int64_t* positions = start_pos.const_data_ptr<int64_t>();
+
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const int64_t* table_row = table + b * max_blocks_per_seq;
+    // Copy runs of tokens that land in the same block at once.
+    int64_t s = 0;
+    while (s < seq_len) {
+      const int64_t pos = positions[b] + s;
+      const int64_t slot = pos % block_size;
+      const int64_t n = std::min(block_size - slot, seq_len - s);
+      const int64_t cache_token = table_row[pos / block_size] * block_size +
+          slot;
+      std::memcpy(
+          cache_data + cache_token * bytes_per_token,
+          value_data + (b * seq_len + s) * bytes_per_token,
+          n * bytes_per_token);
+      s += n;
+    }
+  }
+
+  // Noone uses output. Just a placeholder.
+  return output;
+}
+
+Tensor& sdpa_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k_cache,
+    const Tensor& v_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  (void)dropout_p;
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      !attn_mask.has_value() || !is_causal,
+      InvalidArgument,
+      output,
+      "attn_mask and is_causal cannot be set at the same time");
+
+  ET_KERNEL_CHECK_MSG(
+      ctx,
+      validate_sdpa_paged_args(
+          q, k_cache, v_cache, block_table, start_pos, attn_mask),
+      InvalidArgument,
+      output,
+      "Invalid arguments");
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(output, q.sizes()) == Error::Ok,
+      InvalidArgument,
+      output);
+
+  ET_KERNEL_CHECK(
+      ctx, output.scalar_type() == q.scalar_type(), InvalidArgument, output);
+
+  const double softmax_scale =
+      scale.has_value() ? scale.value() : 1.0 / std::sqrt(q.size(3));
+
+  ET_SWITCH_FLOAT_TYPES(output.scalar_type(), ctx, "sdpa_paged", CTYPE, [&] {
+    sdpa_paged_impl<CTYPE>(
+        q,
+        k_cache,
+        v_cache,
+        block_table,
+        start_pos,
+        attn_mask,
+        is_causal,
+        softmax_scale,
+        output);
+  });
+  return output;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "update_cache_paged.out",
+    torch::executor::native::update_cache_paged_out);
+
+EXECUTORCH_LIBRARY(
+    llama,
+    "sdpa_paged.out",
+    torch::executor::native::sdpa_paged_out);
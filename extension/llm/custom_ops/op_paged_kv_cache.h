@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch {
+namespace executor {
+
+namespace native {
+
+/*
+  Writes value into a paged cache.
+
+  @param[in] value Projected keys or values of the new tokens.
+  Format [batch size, seq_len, num kv heads, head dim]
+  @param[in] cache Pool of cache blocks shared by all sequences.
+  Format [num blocks, block size, num kv heads, head dim]
+  @param[in] block_table Physical block of each logical block of each
+  sequence, or -1 if it is not allocated. Long tensor.
+  Format [batch size, max blocks per seq]
+  @param[in] start_pos Position of the first new token in each sequence.
+  Long tensor. Format [batch size]
+*/
+Tensor& update_cache_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output);
+
+/*
+  Scaled dot product attention over a paged cache. Attends to the first
+  start_pos[b] + seq_len tokens of every sequence b, which must already have
+  been written with update_cache_paged. Sequences may be at different
+  positions.
+
+  @param[in] q Projected query.
+  Format [batch size, seq_len, num heads, head dim]
+  @param[in] k_cache Pool of key cache blocks.
+  Format [num blocks, block size, num kv heads, head dim]
+  @param[in] v_cache Pool of value cache blocks.
+  Format [num blocks, block size, num kv heads, head dim]
+  @param[in] block_table Format [batch size, max blocks per seq]
+  @param[in] start_pos Position of the first query token in each sequence.
+  Long tensor. Format [batch size]
+  @param[in] attn_mask Optional additive mask shared by all sequences.
+  Format [seq_len, max(start_pos) + seq_len]
+*/
+Tensor& sdpa_paged_out(
+    RuntimeContext& ctx,
+    const Tensor& q,
+    const Tensor& k_cache,
+    const Tensor& v_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    const optional<Tensor>& attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output);
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <executorch/extension/llm/custom_ops/kv_block_allocator.h>
+#include <executorch/extension/llm/custom_ops/op_paged_kv_cache.h>
+
+#include <executorch/kernels/test/TestUtil.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::extension::llm::KVBlockAllocator;
+using executorch::runtime::Error;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+std::vector<float> make_data(size_t size, float seed) {
+  std::vector<float> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = std::sin(seed + 0.37f * static_cast<float>(i));
+  }
+  return data;
+}
+
+// Attention over contiguous [batch, num_keys, heads_kv, head_dim] keys and
+// values, for rows [batch, seq_len, heads, head_dim] of queries. Sequence b
+// starts at start_pos[b]; the mask is [seq_len, mask_stride].
+std::vector<float> reference_attention(
+    const std::vector<float>& q,
+    const std::vector<float>& k,
+    const std::vector<float>& v,
+    int64_t batch,
+    int64_t seq_len,
+    int64_t heads,
+    int64_t heads_kv,
+    int64_t head_dim,
+    const std::vector<int64_t>& start_pos,
+    int64_t max_keys,
+    const float* mask,
+    int64_t mask_stride,
+    bool is_causal) {
+  std::vector<float> out(q.size());
+  const float scale = 1.0f / std::sqrt(static_cast<float>(head_dim));
+  for (int64_t b = 0; b < batch; ++b) {
+    for (int64_t s = 0; s < seq_len; ++s) {
+      for (int64_t h = 0; h < heads; ++h) {
+        const int64_t h_kv = h / (heads / heads_kv);
+        const float* q_row = &q[((b * seq_len + s) * heads + h) * head_dim];
+        const int64_t num_keys =
+            is_causal ? start_pos[b] + s + 1 : start_pos[b] + seq_len;
+        std::vector<float> scores(num_keys);
+        float max_score = -std::numeric_limits<float>::infinity();
+        for (int64_t t = 0; t < num_keys; ++t) {
+          const float* k_row =
+              &k[((b * max_keys + t) * heads_kv + h_kv) * head_dim];
+          float score = 0;
+          for (int64_t d = 0; d < head_dim; ++d) {
+            score += q_row[d] * k_row[d];
+          }
+          score *= scale;
+          if (mask != nullptr) {
+            score += mask[s * mask_stride + t];
+          }
+          scores[t] = score;
+          max_score = std::max(max_score, score);
+        }
+        float sum = 0;
+        for (auto& score : scores) {
+          score = std::exp(score - max_score);
+          sum += score;
+        }
+        float* out_row = &out[((b * seq_len + s) * heads + h) * head_dim];
+        for (int64_t t = 0; t < num_keys; ++t) {
+          const float* v_row =
+              &v[((b * max_keys + t) * heads_kv + h_kv) * head_dim];
+          for (int64_t d = 0; d < head_dim; ++d) {
+            out_row[d] += scores[t] / sum * v_row[d];
+          }
+        }
+      }
+    }
+  }
+  return out;
+}
+
+// Copies tokens [start_pos[b], start_pos[b] + seq_len) of each sequence b of
+// `all` ([batch, max_keys, heads_kv, head_dim]) into a [batch, seq_len,
+// heads_kv, head_dim] vector.
+std::vector<float> slice_tokens(
+    const std::vector<float>& all,
+    int64_t max_keys,
+    int64_t token_size,
+    const std::vector<int64_t>& start_pos,
+    int64_t seq_len) {
+  std::vector<float> slice;
+  for (int64_t b = 0; b < int64_t(start_pos.size()); ++b) {
+    const auto begin =
+        all.begin() + (b * max_keys + start_pos[b]) * token_size;
+    slice.insert(slice.end(), begin, begin + seq_len * token_size);
+  }
+  return slice;
+}
+
+} // namespace
+
+class OpPagedKVCacheTest : public OperatorTest {
+ protected:
+  Tensor& op_update_cache_paged(
+      const Tensor& value,
+      Tensor& cache,
+      const Tensor& block_table,
+      const std::vector<int64_t>& start_pos,
+      Tensor& out) {
+    return torch::executor::native::update_cache_paged_out(
+        context_,
+        value,
+        cache,
+        block_table,
+        tf_long_.make({int32_t(start_pos.size())}, start_pos),
+        out);
+  }
+
+  Tensor& op_sdpa_paged(
+      const Tensor& q,
+      const Tensor& k_cache,
+      const Tensor& v_cache,
+      const Tensor& block_table,
+      const std::vector<int64_t>& start_pos,
+      const std::optional<Tensor>& attn_mask,
+      bool is_causal,
+      Tensor& out) {
+    return torch::executor::native::sdpa_paged_out(
+        context_,
+        q,
+        k_cache,
+        v_cache,
+        block_table,
+        tf_long_.make({int32_t(start_pos.size())}, start_pos),
+        attn_mask,
+        0.0,
+        is_causal,
+        std::nullopt,
+        out);
+  }
+
+  TensorFactory<ScalarType::Long> tf_long_;
+};
+
+TEST_F(OpPagedKVCacheTest, UpdateCacheScattersTokensIntoBlocks) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  // 4 blocks of 2 tokens, 1 head of dim 2.
+  Tensor cache = tf.zeros({4, 2, 1, 2});
+  Tensor block_table = tf_long.make({1, 3}, {3, 1, -1});
+  Tensor value = tf.make({1, 3, 1, 2}, {1, 2, 3, 4, 5, 6});
+  Tensor out = tf.zeros({1});
+
+  op_update_cache_paged(value, cache, block_table, {1}, out);
+
+  // Position 1 is the second slot of block 3; positions 2 and 3 fill block 1.
+  Tensor expected = tf.make(
+      {4, 2, 1, 2}, {0, 0, 0, 0, 3, 4, 5, 6, 0, 0, 0, 0, 0, 0, 1, 2});
+  EXPECT_TENSOR_EQ(cache, expected);
+}
+
+TEST_F(OpPagedKVCacheTest, UpdateCacheRejectsUnallocatedBlock) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  Tensor cache = tf.zeros({4, 2, 1, 2});
+  Tensor block_table = tf_long.make({1, 2}, {0, -1});
+  Tensor value = tf.make({1, 1, 1, 2}, {1, 2});
+  Tensor out = tf.zeros({1});
+
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_update_cache_paged(value, cache, block_table, {2}, out));
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_update_cache_paged(value, cache, block_table, {-1}, out));
+  // One position per sequence.
+  ET_EXPECT_KERNEL_FAILURE(
+      context_, op_update_cache_paged(value, cache, block_table, {0, 0}, out));
+}
+
+TEST_F(OpPagedKVCacheTest, SdpaMatchesContiguousAttention) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  constexpr int64_t kBatch = 2;
+  constexpr int64_t kHeads = 4;
+  constexpr int64_t kHeadsKv = 2;
+  constexpr int64_t kHeadDim = 8;
+  constexpr int64_t kBlockSize = 4;
+  constexpr int64_t kMaxBlocks = 3;
+  constexpr int64_t kMaxKeys = kBlockSize * kMaxBlocks;
+  constexpr int64_t kTokenSize = kHeadsKv * kHeadDim;
+
+  const auto all_k = make_data(kBatch * kMaxKeys * kTokenSize, 0.5f);
+  const auto all_v = make_data(kBatch * kMaxKeys * kTokenSize, 1.5f);
+
+  // Blocks of the two sequences are interleaved out of order in the pool.
+  Tensor k_cache = tf.zeros({8, kBlockSize, kHeadsKv, kHeadDim});
+  Tensor v_cache = tf.zeros({8, kBlockSize, kHeadsKv, kHeadDim});
+  Tensor block_table =
+      tf_long.make({kBatch, kMaxBlocks}, {5, 0, 7, 2, 6, 1});
+  Tensor update_out = tf.zeros({1});
+
+  // Prefill 5 tokens, then decode two more one at a time.
+  const std::vector<std::pair<int64_t, int64_t>> steps = {
+      {0, 5}, {5, 1}, {6, 1}};
+  for (const auto& [pos, seq_len] : steps) {
+    const std::vector<int64_t> start_pos(kBatch, pos);
+    const auto k_new =
+        slice_tokens(all_k, kMaxKeys, kTokenSize, start_pos, seq_len);
+    const auto v_new =
+        slice_tokens(all_v, kMaxKeys, kTokenSize, start_pos, seq_len);
+    Tensor k = tf.make({kBatch, int32_t(seq_len), kHeadsKv, kHeadDim}, k_new);
+    Tensor v = tf.make({kBatch, int32_t(seq_len), kHeadsKv, kHeadDim}, v_new);
+    op_update_cache_paged(k, k_cache, block_table, start_pos, update_out);
+    op_update_cache_paged(v, v_cache, block_table, start_pos, update_out);
+
+    const auto q_data =
+        make_data(kBatch * seq_len * kHeads * kHeadDim, float(pos));
+    Tensor q = tf.make({kBatch, int32_t(seq_len), kHeads, kHeadDim}, q_data);
+    Tensor out = tf.zeros({kBatch, int32_t(seq_len), kHeads, kHeadDim});
+    op_sdpa_paged(
+        q, k_cache, v_cache, block_table, start_pos, std::nullopt, true, out);
+
+    const auto expected = reference_attention(
+        q_data,
+        all_k,
+        all_v,
+        kBatch,
+        seq_len,
+        kHeads,
+        kHeadsKv,
+        kHeadDim,
+        start_pos,
+        kMaxKeys,
+        nullptr,
+        0,
+        true);
+    EXPECT_TENSOR_CLOSE(
+        out,
+        tf.make({kBatch, int32_t(seq_len), kHeads, kHeadDim}, expected));
+  }
+}
+
+TEST_F(OpPagedKVCacheTest, SdpaHandlesSequencesAtDifferentPositions) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  constexpr int64_t kBatch = 2;
+  constexpr int64_t kHeads = 2;
+  constexpr int64_t kHeadDim = 4;
+  constexpr int64_t kBlockSize = 2;
+  constexpr int64_t kMaxBlocks = 4;
+  constexpr int64_t kMaxKeys = kBlockSize * kMaxBlocks;
+  constexpr int64_t kTokenSize = kHeads * kHeadDim;
+
+  const auto all_k = make_data(kBatch * kMaxKeys * kTokenSize, 0.75f);
+  const auto all_v = make_data(kBatch * kMaxKeys * kTokenSize, 1.25f);
+
+  Tensor k_cache = tf.zeros({6, kBlockSize, kHeads, kHeadDim});
+  Tensor v_cache = tf.zeros({6, kBlockSize, kHeads, kHeadDim});
+  const std::vector<int64_t> table = {4, 0, 2, 3, 1, 5, -1, -1};
+  Tensor block_table = tf_long.make({kBatch, kMaxBlocks}, table);
+  Tensor update_out = tf.zeros({1});
+
+  // Prefill each sequence on its own: 6 tokens for the first, 2 for the
+  // second.
+  const std::vector<int64_t> prompt_lens = {6, 2};
+  for (int64_t b = 0; b < kBatch; ++b) {
+    Tensor row_table = tf_long.make(
+        {1, kMaxBlocks},
+        std::vector<int64_t>(
+            table.begin() + b * kMaxBlocks,
+            table.begin() + (b + 1) * kMaxBlocks));
+    const int32_t len = int32_t(prompt_lens[b]);
+    const auto begin = b * kMaxKeys * kTokenSize;
+    const auto end = begin + len * kTokenSize;
+    Tensor k = tf.make(
+        {1, len, kHeads, kHeadDim},
+        std::vector<float>(all_k.begin() + begin, all_k.begin() + end));
+    Tensor v = tf.make(
+        {1, len, kHeads, kHeadDim},
+        std::vector<float>(all_v.begin() + begin, all_v.begin() + end));
+    op_update_cache_paged(k, k_cache, row_table, {0}, update_out);
+    op_update_cache_paged(v, v_cache, row_table, {0}, update_out);
+  }
+
+  // Decode one token of both sequences in a single batch.
+  const std::vector<int64_t> start_pos = prompt_lens;
+  Tensor k = tf.make(
+      {kBatch, 1, kHeads, kHeadDim},
+      slice_tokens(all_k, kMaxKeys, kTokenSize, start_pos, 1));
+  Tensor v = tf.make(
+      {kBatch, 1, kHeads, kHeadDim},
+      slice_tokens(all_v, kMaxKeys, kTokenSize, start_pos, 1));
+  op_update_cache_paged(k, k_cache, block_table, start_pos, update_out);
+  op_update_cache_paged(v, v_cache, block_table, start_pos, update_out);
+
+  const auto q_data = make_data(kBatch * kHeads * kHeadDim, 4.0f);
+  Tensor q = tf.make({kBatch, 1, kHeads, kHeadDim}, q_data);
+  Tensor out = tf.zeros({kBatch, 1, kHeads, kHeadDim});
+  op_sdpa_paged(
+      q, k_cache, v_cache, block_table, start_pos, std::nullopt, true, out);
+
+  const auto expected = reference_attention(
+      q_data,
+      all_k,
+      all_v,
+      kBatch,
+      1,
+      kHeads,
+      kHeads,
+      kHeadDim,
+      start_pos,
+      kMaxKeys,
+      nullptr,
+      0,
+      true);
+  EXPECT_TENSOR_CLOSE(out, tf.make({kBatch, 1, kHeads, kHeadDim}, expected));
+}
+
+TEST_F(OpPagedKVCacheTest, SdpaAppliesAttentionMask) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tf_long;
+
+  constexpr int64_t kHeadDim = 4;
+  constexpr int64_t kBlockSize = 2;
+  constexpr int64_t kSeqLen = 3;
+
+  const auto all_k = make_data(kSeqLen * kHeadDim, 0.25f);
+  const auto all_v = make_data(kSeqLen * kHeadDim, 2.0f);
+  Tensor k_cache = tf.zeros({2, kBlockSize, 1, kHeadDim});
+  Tensor v_cache = tf.zeros({2, kBlockSize, 1, kHeadDim});
+  Tensor block_table = tf_long.make({1, 2}, {1, 0});
+  Tensor update_out = tf.zeros({1});
+  op_update_cache_paged(
+      tf.make({1, kSeqLen, 1, kHeadDim}, all_k),
+      k_cache,
+      block_table,
+      {0},
+      update_out);
+  op_update_cache_paged(
+      tf.make({1, kSeqLen, 1, kHeadDim}, all_v),
+      v_cache,
+      block_table,
+      {0},
+      update_out);
+
+  const float inf = std::numeric_limits<float>::infinity();
+  const std::vector<float> mask = {0, -inf, 0, 0, 0, -inf, -inf, 0, 0};
+  const auto q_data = make_data(kSeqLen * kHeadDim, 3.0f);
+  Tensor q = tf.make({1, kSeqLen, 1, kHeadDim}, q_data);
+  Tensor out = tf.zeros({1, kSeqLen, 1, kHeadDim});
+  op_sdpa_paged(
+      q,
+      k_cache,
+      v_cache,
+      block_table,
+      {0},
+      tf.make({kSeqLen, kSeqLen}, mask),
+      false,
+      out);
+
+  const auto expected = reference_attention(
+      q_data,
+      all_k,
+      all_v,
+      1,
+      kSeqLen,
+      1,
+      1,
+      kHeadDim,
+      {0},
+      kSeqLen,
+      mask.data(),
+      kSeqLen,
+      false);
+  EXPECT_TENSOR_CLOSE(out, tf.make({1, kSeqLen, 1, kHeadDim}, expected));
+}
+
+TEST(KVBlockAllocatorTest, ReservesBlocksOnDemand) {
+  KVBlockAllocator allocator(/*num_blocks=*/4, /*block_size=*/16, 3);
+  std::vector<int64_t> row(3, -1);
+
+  ASSERT_EQ(allocator.reserve(row.data(), 1), Error::Ok);
+  EXPECT_EQ(row[0], 0);
+  EXPECT_EQ(row[1], -1);
+  EXPECT_EQ(allocator.num_free_blocks(), 3);
+
+  // Growing within the same block doesn't allocate.
+  ASSERT_EQ(allocator.reserve(row.data(), 16), Error::Ok);
+  EXPECT_EQ(allocator.num_free_blocks(), 3);
+
+  ASSERT_EQ(allocator.reserve(row.data(), 33), Error::Ok);
+  EXPECT_EQ(row[1], 1);
+  EXPECT_EQ(row[2], 2);
+  EXPECT_EQ(allocator.num_free_blocks(), 1);
+
+  EXPECT_EQ(allocator.reserve(row.data(), 49), Error::InvalidArgument);
+
+  allocator.release(row.data());
+  EXPECT_EQ(row, std::vector<int64_t>(3, -1));
+  EXPECT_EQ(allocator.num_free_blocks(), 4);
+}
+
+TEST(KVBlockAllocatorTest, FailsWithoutEnoughFreeBlocks) {
+  KVBlockAllocator allocator(/*num_blocks=*/3, /*block_size=*/4, 2);
+  std::vector<int64_t> first(2, -1);
+  std::vector<int64_t> second(2, -1);
+
+  ASSERT_EQ(allocator.reserve(first.data(), 8), Error::Ok);
+  ASSERT_EQ(allocator.reserve(second.data(), 4), Error::Ok);
+  const auto before = second;
+  EXPECT_EQ(
+      allocator.reserve(second.data(), 8), Error::MemoryAllocationFailed);
+  EXPECT_EQ(second, before);
+
+  // Freed blocks are reused by other sequences.
+  allocator.release(first.data());
+  EXPECT_EQ(allocator.reserve(second.data(), 8), Error::Ok);
+  EXPECT_EQ(allocator.num_free_blocks(), 1);
+}
@@ -8,6 +8,7 @@
 
 #include <executorch/extension/aten_util/make_aten_functor_from_et_functor.h>
 #include <executorch/extension/kernel_util/make_boxed_from_unboxed_functor.h>
+#include <executorch/extension/llm/custom_ops/op_paged_kv_cache.h>
 #include <executorch/extension/llm/custom_ops/op_sdpa.h>
 #include <executorch/extension/llm/custom_ops/op_update_cache.h>
 
@@ -377,6 +378,86 @@ at::Tensor update_cache_with_indices_aten(
   return output;
 }
 
+// Implementations for the paged KV cache
+Tensor& update_cache_paged_out_no_context(
+    const Tensor& value,
+    Tensor& cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::update_cache_paged_out(
+      context, value, cache, block_table, start_pos, output);
+}
+
+at::Tensor update_cache_paged_aten(
+    const at::Tensor& value,
+    at::Tensor& cache,
+    const at::Tensor& block_table,
+    const at::Tensor& start_pos) {
+  auto output = at::empty({1});
+  WRAP_TO_ATEN(update_cache_paged_out_no_context, 4)
+  (value, cache, block_table, start_pos, output);
+  return output;
+}
+
+Tensor& sdpa_paged_out_no_context(
+    const Tensor& q,
+    const Tensor& k_cache,
+    const Tensor& v_cache,
+    const Tensor& block_table,
+    const Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const optional<double> scale,
+    Tensor& output) {
+  executorch::aten::RuntimeContext context{};
+  return torch::executor::native::sdpa_paged_out(
+      context,
+      q,
+      k_cache,
+      v_cache,
+      block_table,
+      start_pos,
+      attn_mask,
+      dropout_p,
+      is_causal,
+      scale,
+      output);
+}
+
+at::Tensor sdpa_paged_aten(
+    const at::Tensor& q,
+    const at::Tensor& k_cache,
+    const at::Tensor& v_cache,
+    const at::Tensor& block_table,
+    const at::Tensor& start_pos,
+    // @lint-ignore CLANGTIDY facebook-hte-ConstantArgumentPassByValue
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<at::Tensor> attn_mask,
+    const double dropout_p,
+    const bool is_causal,
+    // @lint-ignore CLANGTIDY facebook-hte-ParameterMightThrowOnCopy
+    const std::optional<double> scale) {
+  auto output = at::empty(q.sizes());
+  WRAP_TO_ATEN(sdpa_paged_out_no_context, 9)
+  (q,
+   k_cache,
+   v_cache,
+   block_table,
+   start_pos,
+   attn_mask,
+   dropout_p,
+   is_causal,
+   scale,
+   output);
+  return output;
+}
+
 } // namespace native
 } // namespace executor
 } // namespace torch
@@ -410,6 +491,21 @@ TORCH_LIBRARY_FRAGMENT(llama, m) {
   m.def(
       "update_cache_with_indices.out(Tensor value, Tensor(a!) cache, "
       "SymInt start_pos, Tensor indices, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "update_cache_paged(Tensor value, Tensor(a!) cache, "
+      "Tensor block_table, Tensor start_pos) -> Tensor");
+  m.def(
+      "update_cache_paged.out(Tensor value, Tensor(a!) cache, "
+      "Tensor block_table, Tensor start_pos, *, Tensor(b!) out) -> Tensor(b!)");
+  m.def(
+      "sdpa_paged(Tensor query, Tensor key_cache, Tensor value_cache, "
+      "Tensor block_table, Tensor start_pos, Tensor? attn_mask=None, "
+      "float drpout_p=0.0, bool is_causal=False, float? scale=None) -> Tensor");
+  m.def(
+      "sdpa_paged.out(Tensor query, Tensor key_cache, Tensor value_cache, "
+      "Tensor block_table, Tensor start_pos, Tensor? attn_mask=None, "
+      "float drpout_p=0.0, bool is_causal=False, float? scale=None, *, "
+      "Tensor(a!) out) -> Tensor(a!)");
   m.def(
       "custom_quantized_sdpa(Tensor query, Tensor key, Tensor value, SymInt start_pos, "
       "Tensor? attn_mask=None, float drpout_p=0.0, bool is_causal=False, "
@@ -448,6 +544,16 @@ TORCH_LIBRARY_IMPL(llama, CompositeExplicitAutograd, m) {
       WRAP_TO_ATEN(
           torch::executor::native::update_cache_with_indices_out_no_context,
           4));
+  m.impl(
+      "update_cache_paged", torch::executor::native::update_cache_paged_aten);
+  m.impl(
+      "update_cache_paged.out",
+      WRAP_TO_ATEN(
+          torch::executor::native::update_cache_paged_out_no_context, 4));
+  m.impl("sdpa_paged", torch::executor::native::sdpa_paged_aten);
+  m.impl(
+      "sdpa_paged.out",
+      WRAP_TO_ATEN(torch::executor::native::sdpa_paged_out_no_context, 9));
   m.impl(
       "custom_quantized_sdpa",
       torch::executor::native::custom_quantized_sdpa_aten);
@@ -31,14 +31,18 @@ def define_common_targets():
         runtime.cxx_library(
             name = "custom_ops" + mkl_dep,
             srcs = [
+                "kv_block_allocator.cpp",
                 "op_fallback.cpp",
                 "op_fast_hadamard_transform.cpp",
+                "op_paged_kv_cache.cpp",
                 "op_sdpa.cpp",
                 "op_update_cache.cpp",
             ],
             exported_headers = [
+                "kv_block_allocator.h",
                 "op_fallback.h",
                 "op_fast_hadamard_transform.h",
+                "op_paged_kv_cache.h",
                 "op_sdpa.h",
                 "op_update_cache.h",
             ],
@@ -139,6 +143,20 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "op_paged_kv_cache_test",
+        srcs = [
+            "op_paged_kv_cache_test.cpp",
+        ],
+        visibility = ["//executorch/..."],
+        deps = [
+            "//executorch/runtime/core/exec_aten:lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+            "//executorch/kernels/test:test_util",
+            ":custom_ops",
+        ],
+    )
+
     ## For preprocess
     runtime.python_library(
         name = "preprocess_custom_ops_py",
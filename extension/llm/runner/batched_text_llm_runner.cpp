@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate text for several independent sequences with one batched forward
+// pass per step.
+
+#include <executorch/extension/llm/runner/batched_text_llm_runner.h>
+
+#include <ctime>
+
+#include <executorch/extension/llm/runner/util.h>
+
+namespace executorch::extension::llm {
+
+using ::executorch::extension::Module;
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+BatchedTextLLMRunner::BatchedTextLLMRunner(
+    std::unique_ptr<::tokenizers::Tokenizer> tokenizer,
+    std::unique_ptr<Module> module,
+    std::unique_ptr<TextDecoderRunner> text_decoder_runner,
+    int32_t max_batch_size,
+    int64_t max_context_len,
+    std::unique_ptr<std::unordered_set<uint64_t>> eos_ids)
+    : tokenizer_(std::move(tokenizer)),
+      module_(std::move(module)),
+      text_decoder_runner_(std::move(text_decoder_runner)),
+      max_batch_size_(max_batch_size),
+      max_context_len_(max_context_len),
+      eos_ids_(std::move(eos_ids)),
+      sequences_(max_batch_size),
+      input_tokens_(max_batch_size, 0),
+      input_positions_(max_batch_size, 0),
+      next_tokens_(max_batch_size, 0),
+      next_pieces_(max_batch_size) {}
+
+bool BatchedTextLLMRunner::is_loaded() const {
+  return tokenizer_->is_loaded() && text_decoder_runner_->is_method_loaded();
+}
+
+Error BatchedTextLLMRunner::load() {
+  if (is_loaded()) {
+    return Error::Ok;
+  }
+  return text_decoder_runner_->load();
+}
+
+int32_t BatchedTextLLMRunner::num_active_sequences() const {
+  int32_t num_active = 0;
+  for (const auto& sequence : sequences_) {
+    num_active += sequence.is_active();
+  }
+  return num_active;
+}
+
+Result<int64_t> BatchedTextLLMRunner::add_sequence(
+    const std::string& prompt,
+    const GenerationConfig& config,
+    std::function<void(const std::string&)> token_callback,
+    std::function<void(const Stats&)> stats_callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      !prompt.empty(), InvalidArgument, "Prompt cannot be empty");
+  if (!is_loaded()) {
+    ET_CHECK_OK_OR_RETURN_ERROR(load());
+  }
+
+  Sequence* sequence = nullptr;
+  for (auto& candidate : sequences_) {
+    if (!candidate.is_active()) {
+      sequence = &candidate;
+      break;
+    }
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      sequence != nullptr,
+      OutOfResources,
+      "All %" PRId32 " sequence slots are in use",
+      max_batch_size_);
+
+  const long start_ms = time_in_ms();
+  ::tokenizers::Result<std::vector<uint64_t>> encode_res = tokenizer_->encode(
+      prompt,
+      /*bos=*/config.num_bos,
+      /*eos=*/config.num_eos);
+  ET_CHECK_TK_OK_OR_RETURN_ERROR(
+      encode_res.error(), "Failed to encode prompt %s", prompt.c_str());
+  std::vector<uint64_t> prompt_tokens = std::move(encode_res.get());
+  const int32_t num_prompt_tokens = prompt_tokens.size();
+
+  ET_CHECK_OR_RETURN_ERROR(
+      num_prompt_tokens >= 1,
+      InvalidArgument,
+      "Expected at least 1 prompt token");
+  ET_CHECK_OR_RETURN_ERROR(
+      num_prompt_tokens < max_context_len_,
+      InvalidArgument,
+      "num_prompt_tokens %" PRId32 " >= max_context_len %" PRId64,
+      num_prompt_tokens,
+      max_context_len_);
+  const int32_t max_new_tokens =
+      config.resolve_max_new_tokens(max_context_len_, num_prompt_tokens);
+  ET_CHECK_OR_RETURN_ERROR(
+      max_new_tokens > 0,
+      InvalidArgument,
+      "Max new tokens %" PRId32 " is less than or equal to 0",
+      max_new_tokens);
+
+  sequence->id = next_sequence_id_++;
+  sequence->tokens = std::move(prompt_tokens);
+  sequence->num_prompt_tokens = num_prompt_tokens;
+  sequence->pos = 0;
+  sequence->max_new_tokens = max_new_tokens;
+  sequence->num_generated_tokens = 0;
+  sequence->temperature = config.temperature;
+  sequence->sampler.reset();
+  sequence->token_callback = std::move(token_callback);
+  sequence->stats_callback = std::move(stats_callback);
+  sequence->stats.reset();
+  sequence->stats.inference_start_ms = start_ms;
+  sequence->stats.num_prompt_tokens = num_prompt_tokens;
+
+  if (config.echo && sequence->token_callback) {
+    sequence->token_callback(prompt);
+  }
+  return sequence->id;
+}
+
+void BatchedTextLLMRunner::remove_sequence(int64_t id) {
+  for (auto& sequence : sequences_) {
+    if (sequence.is_active() && sequence.id == id) {
+      finish(sequence);
+      return;
+    }
+  }
+}
+
+Error BatchedTextLLMRunner::step() {
+  // Every active sequence runs the token at its position: a prompt token, or
+  // the token it generated last.
+  bool has_active = false;
+  for (int32_t slot = 0; slot < max_batch_size_; ++slot) {
+    const auto& sequence = sequences_[slot];
+    if (sequence.is_active()) {
+      input_tokens_[slot] = sequence.tokens[sequence.pos];
+      input_positions_[slot] = sequence.pos;
+      has_active = true;
+    } else {
+      input_tokens_[slot] = 0;
+      input_positions_[slot] = 0;
+    }
+  }
+  if (!has_active) {
+    return Error::Ok;
+  }
+
+  auto tokens = from_blob(
+      input_tokens_.data(),
+      {max_batch_size_, 1},
+      executorch::aten::ScalarType::Long);
+  auto positions = from_blob(
+      input_positions_.data(),
+      {max_batch_size_},
+      executorch::aten::ScalarType::Long);
+  auto logits_res = text_decoder_runner_->step_batch(tokens, positions);
+  ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+  const executorch::aten::Tensor& logits = logits_res.get();
+
+  // Sample and decode the next token of every sequence that has consumed its
+  // prompt before updating any of them, so that an error leaves all
+  // sequences as they were before the step.
+  for (int32_t slot = 0; slot < max_batch_size_; ++slot) {
+    auto& sequence = sequences_[slot];
+    if (!sequence.is_active() ||
+        sequence.pos + 1 < static_cast<int64_t>(sequence.tokens.size())) {
+      // Still consuming the prompt; the logits are not needed.
+      continue;
+    }
+    auto next_token_res = sample(sequence, logits, slot);
+    ET_CHECK_OK_OR_RETURN_ERROR(next_token_res.error());
+    next_tokens_[slot] = next_token_res.get();
+    next_pieces_[slot] = ET_UNWRAP_TOKENIZER(
+        tokenizer_->decode(sequence.tokens.back(), next_tokens_[slot]));
+  }
+
+  for (int32_t slot = 0; slot < max_batch_size_; ++slot) {
+    auto& sequence = sequences_[slot];
+    if (!sequence.is_active()) {
+      continue;
+    }
+    sequence.pos++;
+    if (sequence.pos < static_cast<int64_t>(sequence.tokens.size())) {
+      continue;
+    }
+
+    const uint64_t next_token = next_tokens_[slot];
+    if (sequence.num_generated_tokens == 0) {
+      sequence.stats.first_token_ms = time_in_ms();
+      sequence.stats.prompt_eval_end_ms = sequence.stats.first_token_ms;
+    }
+    sequence.tokens.push_back(next_token);
+    sequence.num_generated_tokens++;
+
+    if (sequence.token_callback) {
+      sequence.token_callback(next_pieces_[slot]);
+    }
+
+    if (eos_ids_->find(next_token) != eos_ids_->end() ||
+        sequence.num_generated_tokens >= sequence.max_new_tokens) {
+      finish(sequence);
+    }
+  }
+  return Error::Ok;
+}
+
+Error BatchedTextLLMRunner::run() {
+  while (num_active_sequences() > 0) {
+    ET_CHECK_OK_OR_RETURN_ERROR(step());
+  }
+  return Error::Ok;
+}
+
+Result<uint64_t> BatchedTextLLMRunner::sample(
+    Sequence& sequence,
+    const executorch::aten::Tensor& logits,
+    int32_t slot) {
+  const auto scalar_type = logits.scalar_type();
+  ET_CHECK_OR_RETURN_ERROR(
+      scalar_type == executorch::aten::ScalarType::Float ||
+          scalar_type == executorch::aten::ScalarType::Half ||
+          scalar_type == executorch::aten::ScalarType::BFloat16,
+      InvalidProgram,
+      "Unsupported logits dtype %s",
+      ::executorch::runtime::toString(scalar_type));
+  const ssize_t vocab_size = logits.size(logits.dim() - 1);
+  // If there are several logits per sequence, use the last ones.
+  const ssize_t row_size = logits.numel() / max_batch_size_;
+  const ssize_t offset = slot * row_size + row_size - vocab_size;
+
+  if (!sequence.sampler) {
+    // Give each sequence its own random stream.
+    const unsigned long long seed = static_cast<unsigned long long>(
+        std::time(nullptr) + sequence.id * 0x9E3779B97F4A7C15ULL);
+    sequence.sampler = std::make_unique<Sampler>(
+        vocab_size, sequence.temperature, kTopp, seed);
+  }
+
+  int32_t result = 0;
+  ET_SWITCH_THREE_TYPES(
+      Float, Half, BFloat16, scalar_type, unused, "sample", CTYPE, [&]() {
+        result = sequence.sampler->sample(
+            logits.mutable_data_ptr<CTYPE>() + offset);
+      });
+  return static_cast<uint64_t>(result);
+}
+
+void BatchedTextLLMRunner::finish(Sequence& sequence) {
+  sequence.stats.inference_end_ms = time_in_ms();
+  sequence.stats.num_generated_tokens = sequence.num_generated_tokens;
+  if (sequence.stats_callback) {
+    sequence.stats_callback(sequence.stats);
+  }
+  sequence.id = -1;
+  sequence.tokens.clear();
+  sequence.sampler.reset();
+  sequence.token_callback = nullptr;
+  sequence.stats_callback = nullptr;
+}
+
+} // namespace executorch::extension::llm
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Generate text for several independent sequences with one batched forward
+// pass per step.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <executorch/extension/llm/runner/irunner.h>
+#include <executorch/extension/llm/runner/stats.h>
+#include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/llm/sampler/sampler.h>
+#include <executorch/extension/module/module.h>
+#include <pytorch/tokenizers/tokenizer.h>
+
+namespace executorch::extension::llm {
+
+/**
+ * @brief Decodes several independent sequences together
+ *
+ * Decoding a single sequence reads all of the weights to produce one token,
+ * so it is bound by memory bandwidth. This runner packs the next token of up
+ * to `max_batch_size` sequences into one [batch, 1] forward pass, which reads
+ * the weights once for all of them.
+ *
+ * The model's "forward" method must take tokens of shape [max_batch_size, 1]
+ * and positions of shape [max_batch_size], and keep a KV cache slot per row.
+ * Each sequence owns a slot while it is active. Sequences join and leave
+ * between steps (continuous batching): add_sequence() claims a free slot, and
+ * the slot is released when the sequence hits an EOS token, its token budget
+ * or remove_sequence(). Rows of free slots are padded and their logits are
+ * ignored.
+ *
+ * Prompts are consumed one token per step alongside the decoding sequences,
+ * so a sequence can join without stalling the others.
+ *
+ * Not thread-safe.
+ */
+class ET_EXPERIMENTAL BatchedTextLLMRunner {
+ public:
+  /**
+   * @brief Constructor for BatchedTextLLMRunner with dependency injection
+   *
+   * @param tokenizer Tokenizer for converting between text and token IDs
+   * @param module The underlying model module that performs inference
+   * @param text_decoder_runner Component that runs the batched forward pass
+   * @param max_batch_size Batch size the model was exported with
+   * @param max_context_len Size of the KV cache slot of each sequence
+   * @param eos_ids Tokens that end a sequence
+   */
+  BatchedTextLLMRunner(
+      std::unique_ptr<::tokenizers::Tokenizer> tokenizer,
+      std::unique_ptr<::executorch::extension::Module> module,
+      std::unique_ptr<TextDecoderRunner> text_decoder_runner,
+      int32_t max_batch_size,
+      int64_t max_context_len,
+      std::unique_ptr<std::unordered_set<uint64_t>> eos_ids);
+
+  bool is_loaded() const;
+
+  ::executorch::runtime::Error load();
+
+  /**
+   * @brief Adds a sequence to be decoded from the next step on
+   *
+   * @param prompt The input text to generate from
+   * @param config Configuration parameters for text generation. Only
+   * max_new_tokens, seq_len, temperature, echo, num_bos and num_eos are used.
+   * @param token_callback Function called for each generated token with the
+   * decoded text
+   * @param stats_callback Function called with the statistics of the sequence
+   * once it is done
+   * @return The id of the sequence, or OutOfResources if all slots are
+   * taken
+   */
+  ::executorch::runtime::Result<int64_t> add_sequence(
+      const std::string& prompt,
+      const GenerationConfig& config,
+      std::function<void(const std::string&)> token_callback = {},
+      std::function<void(const Stats&)> stats_callback = {});
+
+  /**
+   * @brief Stops decoding a sequence and releases its slot
+   *
+   * Its stats_callback is called as if it had finished.
+   *
+   * @param id The id returned by add_sequence()
+   */
+  void remove_sequence(int64_t id);
+
+  /**
+   * @brief Runs one forward pass for all active sequences
+   *
+   * Consumes one prompt token or generates one token for each sequence, and
+   * releases the slots of sequences that are done. If an error occurs, no
+   * sequence advances.
+   *
+   * @return Error::Ok if successful, an error otherwise
+   */
+  ::executorch::runtime::Error step();
+
+  /**
+   * @brief Runs steps until all sequences are done
+   *
+   * @return Error::Ok if successful, an error otherwise
+   */
+  ::executorch::runtime::Error run();
+
+  int32_t max_batch_size() const {
+    return max_batch_size_;
+  }
+
+  /// The number of sequences that are being decoded.
+  int32_t num_active_sequences() const;
+
+  bool has_free_slot() const {
+    return num_active_sequences() < max_batch_size_;
+  }
+
+ private:
+  struct Sequence {
+    int64_t id = -1;
+    // The prompt followed by the generated tokens.
+    std::vector<uint64_t> tokens;
+    int64_t num_prompt_tokens = 0;
+    // The position of the next token to run, which is also the number of
+    // tokens that are in the KV cache slot.
+    int64_t pos = 0;
+    int32_t max_new_tokens = 0;
+    int32_t num_generated_tokens = 0;
+    float temperature = 0.0f;
+    std::unique_ptr<Sampler> sampler;
+    std::function<void(const std::string&)> token_callback;
+    std::function<void(const Stats&)> stats_callback;
+    Stats stats;
+
+    bool is_active() const {
+      return id >= 0;
+    }
+  };
+
+  // Samples the next token of the sequence in `slot` from its logits.
+  ::executorch::runtime::Result<uint64_t> sample(
+      Sequence& sequence,
+      const executorch::aten::Tensor& logits,
+      int32_t slot);
+
+  // Reports the stats of the sequence and frees its slot.
+  void finish(Sequence& sequence);
+
+  std::unique_ptr<::tokenizers::Tokenizer> tokenizer_;
+  std::unique_ptr<::executorch::extension::Module>
+      module_; // Manage module's lifecycle, make sure it outlives
+               // text_decoder_runner_.
+  std::unique_ptr<TextDecoderRunner> text_decoder_runner_;
+  int32_t max_batch_size_;
+  int64_t max_context_len_;
+  std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
+
+  // One per KV cache slot.
+  std::vector<Sequence> sequences_;
+  int64_t next_sequence_id_ = 0;
+
+  // Inputs of the forward pass, reused across steps.
+  std::vector<int64_t> input_tokens_;
+  std::vector<int64_t> input_positions_;
+  // Sampled tokens and their text, per slot, until the step commits them.
+  std::vector<uint64_t> next_tokens_;
+  std::vector<std::string> next_pieces_;
+};
+
+} // namespace executorch::extension::llm
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Propose tokens for speculative decoding.
+
+#include <executorch/extension/llm/runner/drafter.h>
+
+#include <algorithm>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Error;
+using ::executorch::runtime::Result;
+
+PromptLookupDrafter::PromptLookupDrafter(
+    int32_t max_ngram_size,
+    int32_t min_ngram_size)
+    : max_ngram_size_(max_ngram_size),
+      min_ngram_size_(std::max<int32_t>(min_ngram_size, 1)) {}
+
+Result<std::vector<uint64_t>> PromptLookupDrafter::draft(
+    const std::vector<uint64_t>& tokens,
+    int32_t max_draft_tokens) {
+  const int64_t num_tokens = tokens.size();
+  if (max_draft_tokens <= 0) {
+    return std::vector<uint64_t>{};
+  }
+  for (int64_t n = std::min<int64_t>(max_ngram_size_, num_tokens - 1);
+       n >= min_ngram_size_;
+       --n) {
+    const auto suffix = tokens.end() - n;
+    // Prefer the latest occurrence, it's the most likely to continue the same
+    // way.
+    for (int64_t start = num_tokens - n - 1; start >= 0; --start) {
+      if (std::equal(suffix, tokens.end(), tokens.begin() + start)) {
+        const int64_t begin = start + n;
+        const int64_t end = std::min(begin + max_draft_tokens, num_tokens);
+        return std::vector<uint64_t>(
+            tokens.begin() + begin, tokens.begin() + end);
+      }
+    }
+  }
+  return std::vector<uint64_t>{};
+}
+
+ModelDrafter::ModelDrafter(
+    std::unique_ptr<Module> module,
+    int64_t max_seq_len,
+    int64_t max_context_len,
+    bool enable_parallel_prefill)
+    : module_(std::move(module)),
+      text_decoder_runner_(std::make_unique<TextDecoderRunner>(module_.get())),
+      text_prefiller_(std::make_unique<TextPrefiller>(
+          text_decoder_runner_.get(),
+          /*use_kv_cache=*/true,
+          enable_parallel_prefill,
+          max_seq_len)),
+      max_context_len_(max_context_len) {}
+
+Error ModelDrafter::load() {
+  return text_prefiller_->load();
+}
+
+Result<std::vector<uint64_t>> ModelDrafter::draft(
+    const std::vector<uint64_t>& tokens,
+    int32_t max_draft_tokens) {
+  if (max_draft_tokens <= 0 || tokens.empty() ||
+      static_cast<int64_t>(tokens.size()) + max_draft_tokens >
+          max_context_len_) {
+    return std::vector<uint64_t>{};
+  }
+
+  // Roll back to the longest prefix the draft model has seen. The last token
+  // always has to be run to get the logits that follow it.
+  size_t num_seen = 0;
+  while (num_seen < seen_tokens_.size() && num_seen + 1 < tokens.size() &&
+         seen_tokens_[num_seen] == tokens[num_seen]) {
+    ++num_seen;
+  }
+  seen_tokens_.resize(num_seen);
+
+  std::vector<uint64_t> new_tokens(tokens.begin() + num_seen, tokens.end());
+  int64_t pos = num_seen;
+  auto next_token = text_prefiller_->prefill(new_tokens, pos);
+  if (!next_token.ok()) {
+    // The KV cache may have been partially written.
+    seen_tokens_.clear();
+    return next_token.error();
+  }
+  seen_tokens_.insert(seen_tokens_.end(), new_tokens.begin(), new_tokens.end());
+
+  std::vector<uint64_t> draft_tokens;
+  draft_tokens.reserve(max_draft_tokens);
+  uint64_t cur_token = next_token.get();
+  draft_tokens.push_back(cur_token);
+
+  auto tokens_managed =
+      from_blob(&cur_token, {1, 1}, executorch::aten::ScalarType::Long);
+  while (static_cast<int32_t>(draft_tokens.size()) < max_draft_tokens) {
+    auto logits_res = text_decoder_runner_->step(tokens_managed, pos);
+    if (!logits_res.ok()) {
+      seen_tokens_.clear();
+      return logits_res.error();
+    }
+    seen_tokens_.push_back(cur_token);
+    pos++;
+    cur_token = text_decoder_runner_->logits_to_token(logits_res.get());
+    draft_tokens.push_back(cur_token);
+  }
+  return draft_tokens;
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Propose tokens for speculative decoding.
+#pragma once
+
+#include <executorch/extension/llm/runner/text_decoder_runner.h>
+#include <executorch/extension/llm/runner/text_prefiller.h>
+#include <executorch/extension/module/module.h>
+#include <executorch/runtime/core/error.h>
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/compiler.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * Proposes the tokens that are likely to follow a sequence, so that the
+ * target model can verify several of them in a single forward pass. Drafts
+ * only affect speed: a wrong draft is rejected by the target model.
+ */
+class ET_EXPERIMENTAL Drafter {
+ public:
+  virtual ~Drafter() = default;
+
+  /**
+   * Load the resources needed to draft tokens.
+   */
+  virtual ::executorch::runtime::Error load() {
+    return ::executorch::runtime::Error::Ok;
+  }
+
+  /**
+   * Propose the tokens that follow `tokens`.
+   * @param tokens The sequence so far: the prompt followed by the tokens
+   * generated for it.
+   * @param max_draft_tokens The maximum number of tokens to propose.
+   * @return Up to `max_draft_tokens` tokens. May be empty if there is no good
+   * guess.
+   */
+  virtual ::executorch::runtime::Result<std::vector<uint64_t>> draft(
+      const std::vector<uint64_t>& tokens,
+      int32_t max_draft_tokens) = 0;
+};
+
+/**
+ * Drafts by prompt lookup: finds the latest earlier occurrence of the last
+ * few tokens of the sequence and proposes the tokens that followed it. This
+ * needs no model and works well when the output repeats parts of the prompt,
+ * e.g. for summarization, code editing or retrieval-augmented generation.
+ */
+class ET_EXPERIMENTAL PromptLookupDrafter : public Drafter {
+ public:
+  /**
+   * @param max_ngram_size The longest suffix of the sequence to look up.
+   * @param min_ngram_size The shortest suffix of the sequence to look up.
+   * Longer suffixes are tried first.
+   */
+  explicit PromptLookupDrafter(
+      int32_t max_ngram_size = 3,
+      int32_t min_ngram_size = 1);
+
+  ::executorch::runtime::Result<std::vector<uint64_t>> draft(
+      const std::vector<uint64_t>& tokens,
+      int32_t max_draft_tokens) override;
+
+ private:
+  int32_t max_ngram_size_;
+  int32_t min_ngram_size_;
+};
+
+/**
+ * Drafts greedily with a smaller model that shares the tokenizer of the target
+ * model.
+ *
+ * The draft model keeps its own KV cache. Its positions are tracked separately
+ * from the target model: tokens the target model rejected are rolled back by
+ * rewinding to the longest prefix of the sequence that the draft model has
+ * already seen, and only the rest is fed to it.
+ */
+class ET_EXPERIMENTAL ModelDrafter : public Drafter {
+ public:
+  /**
+   * @param module The draft model. It must take tokens and their start
+   * position like the target model.
+   * @param max_seq_len The maximum number of tokens the draft model takes in
+   * one forward pass.
+   * @param max_context_len The size of the KV cache of the draft model. No
+   * tokens are drafted for sequences that don't fit in it.
+   * @param enable_parallel_prefill Whether the draft model takes several
+   * tokens in one forward pass.
+   */
+  ModelDrafter(
+      std::unique_ptr<Module> module,
+      int64_t max_seq_len,
+      int64_t max_context_len,
+      bool enable_parallel_prefill = true);
+
+  ::executorch::runtime::Error load() override;
+
+  ::executorch::runtime::Result<std::vector<uint64_t>> draft(
+      const std::vector<uint64_t>& tokens,
+      int32_t max_draft_tokens) override;
+
+ private:
+  std::unique_ptr<Module> module_;
+  std::unique_ptr<TextDecoderRunner> text_decoder_runner_;
+  std::unique_ptr<TextPrefiller> text_prefiller_;
+  int64_t max_context_len_;
+  // The tokens in the KV cache of the draft model, at positions 0, 1, ...
+  std::vector<uint64_t> seen_tokens_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -49,6 +49,14 @@ struct GenerationConfig {
   // Temperature for sampling (higher = more random)
   float temperature = 0.8f;
 
+  // Penalties for tokens among the last penalty_window tokens of the prompt
+  // and the generated text, to discourage repetition. See
+  // Sampler::set_penalties(); the defaults disable them.
+  float repetition_penalty = 1.0f;
+  float frequency_penalty = 0.0f;
+  float presence_penalty = 0.0f;
+  int32_t penalty_window = 64;
+
   // Number of eos and bos to add to the prompt
   int32_t num_bos = 0;
   int32_t num_eos = 0;
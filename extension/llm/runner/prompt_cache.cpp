@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/prompt_cache.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <executorch/runtime/platform/assert.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+using ::executorch::runtime::Span;
+
+namespace {
+// FNV-1a over the bytes of each token.
+constexpr uint64_t kHashSeed = 14695981039346656037ULL;
+constexpr uint64_t kHashPrime = 1099511628211ULL;
+
+inline uint64_t hash_token(uint64_t hash, uint64_t token) {
+  for (int i = 0; i < 8; ++i) {
+    hash ^= (token >> (8 * i)) & 0xff;
+    hash *= kHashPrime;
+  }
+  return hash;
+}
+
+size_t common_prefix(
+    const std::vector<uint64_t>& a,
+    const std::vector<uint64_t>& b,
+    size_t max_tokens) {
+  const size_t limit = std::min({a.size(), b.size(), max_tokens});
+  size_t n = 0;
+  while (n < limit && a[n] == b[n]) {
+    ++n;
+  }
+  return n;
+}
+} // namespace
+
+PromptCache::PromptCache(size_t capacity_bytes, size_t block_size)
+    : capacity_bytes_(capacity_bytes), block_size_(block_size) {
+  ET_CHECK_MSG(block_size > 0, "block_size must be positive");
+}
+
+std::vector<uint64_t> PromptCache::prefix_hashes(
+    const std::vector<uint64_t>& tokens,
+    size_t max_tokens) const {
+  const size_t limit = std::min(tokens.size(), max_tokens);
+  std::vector<uint64_t> hashes;
+  hashes.reserve(limit / block_size_);
+  uint64_t hash = kHashSeed;
+  for (size_t i = 0; i < limit; ++i) {
+    hash = hash_token(hash, tokens[i]);
+    if ((i + 1) % block_size_ == 0) {
+      hashes.push_back(hash);
+    }
+  }
+  return hashes;
+}
+
+std::pair<PromptCache::EntryList::iterator, size_t> PromptCache::find(
+    const std::vector<uint64_t>& tokens,
+    size_t max_tokens) {
+  const auto hashes = prefix_hashes(tokens, max_tokens);
+  // Every entry sharing at least k blocks is indexed under the hash of the
+  // first k blocks, so the longest match is among the entries found for the
+  // longest prefix that has any.
+  for (size_t k = hashes.size(); k > 0; --k) {
+    auto range = index_.equal_range(hashes[k - 1]);
+    auto best = entries_.end();
+    size_t best_length = 0;
+    for (auto it = range.first; it != range.second; ++it) {
+      const size_t length =
+          common_prefix(it->second->tokens, tokens, max_tokens);
+      // Guard against hash collisions.
+      if (length >= k * block_size_ && length > best_length) {
+        best = it->second;
+        best_length = length;
+      }
+    }
+    if (best != entries_.end()) {
+      return {best, best_length};
+    }
+  }
+  return {entries_.end(), 0};
+}
+
+size_t PromptCache::restore(
+    const std::vector<uint64_t>& tokens,
+    size_t max_tokens,
+    Span<const Span<uint8_t>> state) {
+  auto [entry, length] = find(tokens, max_tokens);
+  if (entry == entries_.end()) {
+    return 0;
+  }
+  if (entry->buffers.size() != state.size()) {
+    ET_LOG(Error, "Cached prompt state doesn't match the decoder's buffers");
+    return 0;
+  }
+  for (size_t i = 0; i < state.size(); ++i) {
+    if (entry->buffers[i].size() != state[i].size()) {
+      ET_LOG(Error, "Cached prompt state doesn't match the decoder's buffers");
+      return 0;
+    }
+  }
+  for (size_t i = 0; i < state.size(); ++i) {
+    std::memcpy(state[i].data(), entry->buffers[i].data(), state[i].size());
+  }
+  entries_.splice(entries_.begin(), entries_, entry);
+  return length;
+}
+
+void PromptCache::store(
+    const std::vector<uint64_t>& tokens,
+    Span<const Span<uint8_t>> state) {
+  if (tokens.size() < block_size_) {
+    // Too short to ever be found.
+    return;
+  }
+  size_t bytes = tokens.size() * sizeof(uint64_t);
+  for (const auto& buffer : state) {
+    bytes += buffer.size();
+  }
+  if (bytes > capacity_bytes_) {
+    ET_LOG(
+        Info,
+        "Prompt state of %zu bytes exceeds the cache capacity of %zu bytes",
+        bytes,
+        capacity_bytes_);
+    return;
+  }
+
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto next = std::next(it);
+    if (it->tokens.size() <= tokens.size() &&
+        std::equal(it->tokens.begin(), it->tokens.end(), tokens.begin())) {
+      if (it->tokens.size() == tokens.size()) {
+        // Already cached.
+        entries_.splice(entries_.begin(), entries_, it);
+        return;
+      }
+      // Every prefix this entry covers is covered by the new one.
+      erase(it);
+    }
+    it = next;
+  }
+  while (size_bytes_ + bytes > capacity_bytes_) {
+    erase(std::prev(entries_.end()));
+  }
+
+  Entry entry{tokens, {}, bytes};
+  entry.buffers.reserve(state.size());
+  for (const auto& buffer : state) {
+    entry.buffers.emplace_back(buffer.begin(), buffer.end());
+  }
+  entries_.push_front(std::move(entry));
+  size_bytes_ += bytes;
+  for (uint64_t hash : prefix_hashes(tokens, tokens.size())) {
+    index_.emplace(hash, entries_.begin());
+  }
+}
+
+void PromptCache::clear() {
+  index_.clear();
+  entries_.clear();
+  size_bytes_ = 0;
+}
+
+void PromptCache::erase(EntryList::iterator entry) {
+  for (uint64_t hash : prefix_hashes(entry->tokens, entry->tokens.size())) {
+    auto range = index_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == entry) {
+        index_.erase(it);
+        break;
+      }
+    }
+  }
+  size_bytes_ -= entry->bytes;
+  entries_.erase(entry);
+}
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Caches the decoder state after prefilling prompts, so that prompts sharing a
+// prefix with an earlier one don't have to prefill it again.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/runtime/core/span.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace extension {
+namespace llm {
+
+/**
+ * An LRU cache of decoder states keyed by the prompt tokens they were
+ * prefilled with.
+ *
+ * The KV cache entries of a position only depend on the tokens up to that
+ * position, so a state prefilled with one prompt is valid for the first N
+ * positions of any prompt that shares N leading tokens with it. restore()
+ * finds the entry sharing the longest prefix with a new prompt and copies its
+ * state back, after which only the remaining tokens need to be prefilled.
+ *
+ * Prefixes are indexed by hashes of their first `block_size` tokens,
+ * `2 * block_size` tokens, and so on, so a lookup costs one pass over the
+ * prompt regardless of how many entries are cached. Entries are evicted in
+ * least recently used order to stay within `capacity_bytes`.
+ *
+ * Not thread-safe.
+ */
+class ET_EXPERIMENTAL PromptCache {
+ public:
+  /**
+   * @param capacity_bytes The maximum number of bytes of state and tokens to
+   * keep.
+   * @param block_size The granularity in tokens of the prefix index. Prompts
+   * only share an entry if they have at least this many tokens in common.
+   */
+  explicit PromptCache(size_t capacity_bytes, size_t block_size = 64);
+
+  /**
+   * Copies the state of the entry sharing the longest prefix with `tokens`
+   * into `state`.
+   *
+   * @param tokens The prompt about to be prefilled.
+   * @param max_tokens The maximum number of tokens to reuse.
+   * @param state The buffers to restore the state into. They must have the
+   * same sizes as the buffers the entry was stored from.
+   * @return The number of leading tokens of `tokens` that `state` now holds,
+   * or 0 if there was no matching entry.
+   */
+  size_t restore(
+      const std::vector<uint64_t>& tokens,
+      size_t max_tokens,
+      ::executorch::runtime::Span<const ::executorch::runtime::Span<uint8_t>>
+          state);
+
+  /**
+   * Stores a copy of `state`, which holds the decoder state after prefilling
+   * `tokens`. Entries that hold a prefix of `tokens` become redundant and are
+   * dropped.
+   *
+   * @param tokens The prompt tokens that have been prefilled.
+   * @param state The buffers holding the decoder state.
+   */
+  void store(
+      const std::vector<uint64_t>& tokens,
+      ::executorch::runtime::Span<const ::executorch::runtime::Span<uint8_t>>
+          state);
+
+  /// Drops all entries.
+  void clear();
+
+  size_t capacity_bytes() const {
+    return capacity_bytes_;
+  }
+
+  /// The number of bytes held by the cached entries.
+  size_t size_bytes() const {
+    return size_bytes_;
+  }
+
+  size_t num_entries() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::vector<uint64_t> tokens;
+    std::vector<std::vector<uint8_t>> buffers;
+    size_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  // Returns the hashes of the first block_size_, 2 * block_size_, ... tokens
+  // of `tokens`, up to `max_tokens` tokens.
+  std::vector<uint64_t> prefix_hashes(
+      const std::vector<uint64_t>& tokens,
+      size_t max_tokens) const;
+
+  // Returns the entry sharing the longest prefix with `tokens`, and the
+  // length of that prefix capped to `max_tokens`.
+  std::pair<EntryList::iterator, size_t> find(
+      const std::vector<uint64_t>& tokens,
+      size_t max_tokens);
+
+  void erase(EntryList::iterator entry);
+
+  const size_t capacity_bytes_;
+  const size_t block_size_;
+  size_t size_bytes_ = 0;
+  // Most recently used first.
+  EntryList entries_;
+  // Maps the hash of each block-aligned prefix of an entry to the entry.
+  std::unordered_multimap<uint64_t, EntryList::iterator> index_;
+};
+
+} // namespace llm
+} // namespace extension
+} // namespace executorch
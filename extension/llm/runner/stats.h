@@ -49,6 +49,12 @@ struct ET_EXPERIMENTAL Stats {
   int64_t num_prompt_tokens;
   // Token count from generated (total - prompt)
   int64_t num_generated_tokens;
+  // Speculative decoding: tokens proposed by the drafter, how many of them the
+  // model accepted, and the number of model forward passes that verified
+  // them.
+  int64_t num_draft_tokens = 0;
+  int64_t num_accepted_draft_tokens = 0;
+  int64_t num_speculative_steps = 0;
   inline void on_sampling_begin() {
     aggregate_sampling_timer_start_timestamp = time_in_ms();
   }
@@ -75,6 +81,9 @@ struct ET_EXPERIMENTAL Stats {
     aggregate_sampling_time_ms = 0;
     num_prompt_tokens = 0;
     num_generated_tokens = 0;
+    num_draft_tokens = 0;
+    num_accepted_draft_tokens = 0;
+    num_speculative_steps = 0;
     aggregate_sampling_timer_start_timestamp = 0;
   }
 
@@ -93,7 +102,10 @@ inline std::string stats_to_json_string(const Stats& stats) {
      << "\"prompt_eval_end_ms\":" << stats.prompt_eval_end_ms << ","
      << "\"first_token_ms\":" << stats.first_token_ms << ","
      << "\"aggregate_sampling_time_ms\":" << stats.aggregate_sampling_time_ms
-     << "," << "\"SCALING_FACTOR_UNITS_PER_SECOND\":"
+     << "," << "\"draft_tokens\":" << stats.num_draft_tokens << ","
+     << "\"accepted_draft_tokens\":" << stats.num_accepted_draft_tokens << ","
+     << "\"speculative_steps\":" << stats.num_speculative_steps << ","
+     << "\"SCALING_FACTOR_UNITS_PER_SECOND\":"
      << stats.SCALING_FACTOR_UNITS_PER_SECOND << "}";
   return ss.str();
 }
@@ -150,6 +162,23 @@ inline void print_report(const Stats& stats) {
       ((double)(stats.first_token_ms - stats.inference_start_ms) /
        stats.SCALING_FACTOR_UNITS_PER_SECOND));
 
+  if (stats.num_speculative_steps > 0) {
+    // The generation rate above is the effective rate with speculation.
+    double acceptance_rate = stats.num_draft_tokens > 0
+        ? (double)stats.num_accepted_draft_tokens / stats.num_draft_tokens
+        : 0.0;
+    ET_LOG(
+        Info,
+        "\tSpeculative decoding:\t%" PRId64 "/%" PRId64
+        " draft tokens accepted (%f%%), %f tokens per forward pass",
+        stats.num_accepted_draft_tokens,
+        stats.num_draft_tokens,
+        acceptance_rate * 100,
+        (double)(stats.num_speculative_steps +
+                 stats.num_accepted_draft_tokens) /
+            stats.num_speculative_steps);
+  }
+
   ET_LOG(
       Info,
       "\tSampling time over %" PRIu64 " tokens:\t%f (seconds)",
@@ -22,6 +22,19 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_library(
+        name = "prompt_cache",
+        exported_headers = ["prompt_cache.h"],
+        srcs = ["prompt_cache.cpp"],
+        visibility = [
+            "@EXECUTORCH_CLIENTS",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
+
     for aten in (True, False):
         aten_suffix = "_aten" if aten else ""
 
@@ -56,6 +69,20 @@ def define_common_targets():
             ],
         )
 
+        runtime.cxx_library(
+            name = "drafter" + aten_suffix,
+            exported_headers = ["drafter.h"],
+            srcs = ["drafter.cpp"],
+            visibility = [
+                "@EXECUTORCH_CLIENTS",
+            ],
+            exported_deps = [
+                ":text_decoder_runner" + aten_suffix,
+                ":text_prefiller" + aten_suffix,
+                "//executorch/extension/module:module" + aten_suffix,
+            ],
+        )
+
         runtime.cxx_library(
             name = "text_token_generator" + aten_suffix,
             exported_headers = ["text_token_generator.h"],
@@ -63,6 +90,7 @@ def define_common_targets():
                 "@EXECUTORCH_CLIENTS",
             ],
             exported_deps = [
+                ":drafter" + aten_suffix,
                 ":text_decoder_runner" + aten_suffix,
                 "//pytorch/tokenizers:headers",
                 "//executorch/extension/module:module" + aten_suffix,
@@ -84,10 +112,12 @@ def define_common_targets():
         runtime.cxx_library(
             name = "runner_lib" + aten_suffix,
             exported_headers = [
+                "batched_text_llm_runner.h",
                 "multimodal_runner.h",
                 "text_llm_runner.h",
             ],
             srcs = [
+                "batched_text_llm_runner.cpp",
                 "text_llm_runner.cpp",
             ],
             visibility = [
@@ -99,6 +129,7 @@ def define_common_targets():
             exported_deps = [
                 ":image_prefiller" + aten_suffix,
                 ":irunner",
+                ":prompt_cache",
                 ":text_decoder_runner" + aten_suffix,
                 ":text_prefiller" + aten_suffix,
                 ":text_token_generator" + aten_suffix,
@@ -7,6 +7,23 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "runtime")
 
 def define_common_targets():
+    runtime.cxx_test(
+        name = "test_batched_text_llm_runner",
+        srcs = ["test_batched_text_llm_runner.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:runner_lib",
+            "//executorch/runtime/core/exec_aten/testing_util:tensor_util",
+        ],
+    )
+
+    runtime.cxx_test(
+        name = "test_drafter",
+        srcs = ["test_drafter.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:drafter",
+        ],
+    )
+
     runtime.cxx_test(
         name = "test_generation_config",
         srcs = ["test_generation_config.cpp"],
@@ -18,6 +35,15 @@ def define_common_targets():
         ],
     )
 
+    runtime.cxx_test(
+        name = "test_prompt_cache",
+        srcs = ["test_prompt_cache.cpp"],
+        deps = [
+            "//executorch/extension/llm/runner:prompt_cache",
+            "//executorch/runtime/platform:platform",
+        ],
+    )
+
     runtime.cxx_test(
         name = "test_text_llm_runner",
         srcs = ["test_text_llm_runner.cpp"],
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ * @lint-ignore-every CLANGTIDY facebook-hte-Deprecated
+ */
+
+#include <executorch/extension/llm/runner/batched_text_llm_runner.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/platform/runtime.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+
+using namespace ::testing;
+using executorch::extension::llm::BatchedTextLLMRunner;
+using executorch::extension::llm::GenerationConfig;
+using executorch::extension::llm::Stats;
+using executorch::extension::llm::TextDecoderRunner;
+using executorch::runtime::Error;
+using executorch::runtime::Result;
+using executorch::runtime::testing::TensorFactory;
+
+namespace {
+
+constexpr int32_t kVocabSize = 16;
+constexpr uint64_t kEosToken = 15;
+
+class MockTokenizer : public ::tokenizers::Tokenizer {
+ public:
+  MOCK_METHOD(::tokenizers::Error, load, (const std::string&), ());
+  MOCK_METHOD(bool, is_loaded, (), (const));
+  MOCK_METHOD(
+      ::tokenizers::Result<std::vector<uint64_t>>,
+      encode,
+      (const std::string&, int8_t, int8_t),
+      (const));
+  MOCK_METHOD(
+      ::tokenizers::Result<std::string>,
+      decode,
+      (uint64_t, uint64_t),
+      (const));
+  MOCK_METHOD(uint64_t, bos_tok, (), (const));
+  MOCK_METHOD(uint64_t, eos_tok, (), (const));
+  MOCK_METHOD(uint64_t, vocab_size, (), (const));
+};
+
+class MockTextDecoderRunner : public TextDecoderRunner {
+ public:
+  MockTextDecoderRunner() : TextDecoderRunner(nullptr) {}
+  MOCK_METHOD(
+      Result<executorch::aten::Tensor>,
+      step_batch,
+      (executorch::extension::TensorPtr&, executorch::extension::TensorPtr&),
+      ());
+  MOCK_METHOD(bool, is_method_loaded, (), ());
+  MOCK_METHOD(::executorch::runtime::Error, load, (), ());
+};
+
+} // namespace
+
+class BatchedTextLLMRunnerTest : public Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+
+  // A runner whose model predicts the input token plus one, and whose
+  // tokenizer encodes a prompt as its characters minus 'a'.
+  std::unique_ptr<BatchedTextLLMRunner> createRunner(int32_t max_batch_size) {
+    auto tokenizer = std::make_unique<NiceMock<MockTokenizer>>();
+    ON_CALL(*tokenizer, is_loaded()).WillByDefault(Return(true));
+    ON_CALL(*tokenizer, encode)
+        .WillByDefault([](const std::string& prompt, int8_t, int8_t) {
+          std::vector<uint64_t> tokens;
+          for (char c : prompt) {
+            tokens.push_back(c - 'a');
+          }
+          return ::tokenizers::Result<std::vector<uint64_t>>(tokens);
+        });
+    ON_CALL(*tokenizer, decode)
+        .WillByDefault([this](uint64_t, uint64_t token) {
+          if (token == fail_decode_token_) {
+            return ::tokenizers::Result<std::string>(
+                ::tokenizers::Error::DecodeFailure);
+          }
+          return ::tokenizers::Result<std::string>(std::to_string(token));
+        });
+
+    auto text_decoder_runner =
+        std::make_unique<NiceMock<MockTextDecoderRunner>>();
+    ON_CALL(*text_decoder_runner, is_method_loaded())
+        .WillByDefault(Return(true));
+    ON_CALL(*text_decoder_runner, step_batch)
+        .WillByDefault([this](
+                           executorch::extension::TensorPtr& tokens,
+                           executorch::extension::TensorPtr& positions) {
+          const auto batch_size = tokens->size(0);
+          std::vector<int64_t> step_tokens(batch_size);
+          std::vector<int64_t> step_positions(batch_size);
+          std::vector<float> logits(batch_size * kVocabSize, 0.0f);
+          for (ssize_t b = 0; b < batch_size; ++b) {
+            step_tokens[b] = tokens->const_data_ptr<int64_t>()[b];
+            step_positions[b] = positions->const_data_ptr<int64_t>()[b];
+            logits[b * kVocabSize + (step_tokens[b] + 1) % kVocabSize] = 1.0f;
+          }
+          steps_.push_back({step_tokens, step_positions});
+          return Result<executorch::aten::Tensor>(tf_.make(
+              {static_cast<int32_t>(batch_size), 1, kVocabSize}, logits));
+        });
+
+    return std::make_unique<BatchedTextLLMRunner>(
+        std::move(tokenizer),
+        nullptr,
+        std::move(text_decoder_runner),
+        max_batch_size,
+        /*max_context_len=*/kVocabSize,
+        std::make_unique<std::unordered_set<uint64_t>>(
+            std::unordered_set<uint64_t>{kEosToken}));
+  }
+
+  GenerationConfig createConfig(int32_t max_new_tokens) {
+    GenerationConfig config;
+    config.max_new_tokens = max_new_tokens;
+    config.temperature = 0.0f;
+    config.echo = false;
+    return config;
+  }
+
+  struct StepInputs {
+    std::vector<int64_t> tokens;
+    std::vector<int64_t> positions;
+  };
+  std::vector<StepInputs> steps_;
+  uint64_t fail_decode_token_ = std::numeric_limits<uint64_t>::max();
+  TensorFactory<executorch::aten::ScalarType::Float> tf_;
+};
+
+TEST_F(BatchedTextLLMRunnerTest, DecodesSequencesInOneBatch) {
+  auto runner = createRunner(/*max_batch_size=*/2);
+
+  std::vector<std::string> first;
+  std::vector<std::string> second;
+  ASSERT_TRUE(runner
+                  ->add_sequence(
+                      "bc",
+                      createConfig(3),
+                      [&](const std::string& piece) { first.push_back(piece); })
+                  .ok());
+  ASSERT_TRUE(
+      runner
+          ->add_sequence(
+              "f",
+              createConfig(3),
+              [&](const std::string& piece) { second.push_back(piece); })
+          .ok());
+  EXPECT_FALSE(runner->has_free_slot());
+
+  EXPECT_EQ(runner->run(), Error::Ok);
+  EXPECT_EQ(runner->num_active_sequences(), 0);
+
+  EXPECT_EQ(first, (std::vector<std::string>{"3", "4", "5"}));
+  EXPECT_EQ(second, (std::vector<std::string>{"6", "7", "8"}));
+
+  // The second prompt is one token shorter, so it finishes one step earlier
+  // and its slot is padded in the last step.
+  ASSERT_EQ(steps_.size(), 4);
+  EXPECT_EQ(steps_[0].tokens, (std::vector<int64_t>{1, 5}));
+  EXPECT_EQ(steps_[0].positions, (std::vector<int64_t>{0, 0}));
+  EXPECT_EQ(steps_[1].tokens, (std::vector<int64_t>{2, 6}));
+  EXPECT_EQ(steps_[1].positions, (std::vector<int64_t>{1, 1}));
+  EXPECT_EQ(steps_[2].tokens, (std::vector<int64_t>{3, 7}));
+  EXPECT_EQ(steps_[2].positions, (std::vector<int64_t>{2, 2}));
+  EXPECT_EQ(steps_[3].tokens, (std::vector<int64_t>{4, 0}));
+  EXPECT_EQ(steps_[3].positions, (std::vector<int64_t>{3, 0}));
+}
+
+TEST_F(BatchedTextLLMRunnerTest, SequencesJoinFreedSlots) {
+  auto runner = createRunner(/*max_batch_size=*/1);
+
+  int64_t num_finished = 0;
+  auto count_finished = [&](const Stats& stats) {
+    EXPECT_EQ(stats.num_generated_tokens, 2);
+    num_finished++;
+  };
+  ASSERT_TRUE(runner->add_sequence("b", createConfig(2), {}, count_finished)
+                  .ok());
+  auto full = runner->add_sequence("c", createConfig(2));
+  EXPECT_EQ(full.error(), Error::OutOfResources);
+
+  EXPECT_EQ(runner->step(), Error::Ok);
+  EXPECT_EQ(runner->step(), Error::Ok);
+  EXPECT_EQ(num_finished, 1);
+  EXPECT_TRUE(runner->has_free_slot());
+
+  // The new sequence reuses the slot from position 0.
+  ASSERT_TRUE(runner->add_sequence("c", createConfig(2), {}, count_finished)
+                  .ok());
+  EXPECT_EQ(runner->step(), Error::Ok);
+  EXPECT_EQ(steps_.back().tokens, (std::vector<int64_t>{2}));
+  EXPECT_EQ(steps_.back().positions, (std::vector<int64_t>{0}));
+  EXPECT_EQ(runner->run(), Error::Ok);
+  EXPECT_EQ(num_finished, 2);
+}
+
+TEST_F(BatchedTextLLMRunnerTest, StopsAtEosAndOnRemoval) {
+  auto runner = createRunner(/*max_batch_size=*/2);
+
+  // "n" is token 13, so the model generates 14 and then EOS.
+  std::vector<std::string> pieces;
+  auto collect = [&](const std::string& piece) { pieces.push_back(piece); };
+  ASSERT_TRUE(runner->add_sequence("n", createConfig(10), collect).ok());
+  bool removed = false;
+  auto id = runner->add_sequence(
+      "a", createConfig(10), {}, [&](const Stats&) { removed = true; });
+  ASSERT_TRUE(id.ok());
+
+  EXPECT_EQ(runner->step(), Error::Ok);
+  runner->remove_sequence(id.get());
+  EXPECT_TRUE(removed);
+  EXPECT_EQ(runner->num_active_sequences(), 1);
+
+  EXPECT_EQ(runner->run(), Error::Ok);
+  EXPECT_EQ(pieces, (std::vector<std::string>{"14", "15"}));
+}
+
+TEST_F(BatchedTextLLMRunnerTest, FailedStepAdvancesNoSequence) {
+  auto runner = createRunner(/*max_batch_size=*/2);
+
+  std::vector<std::string> pieces;
+  auto collect = [&](const std::string& piece) { pieces.push_back(piece); };
+  ASSERT_TRUE(runner->add_sequence("b", createConfig(2), collect).ok());
+  ASSERT_TRUE(runner->add_sequence("f", createConfig(2), collect).ok());
+
+  // The second sequence fails after the first one has sampled its token.
+  fail_decode_token_ = 6;
+  EXPECT_NE(runner->step(), Error::Ok);
+  EXPECT_TRUE(pieces.empty());
+
+  fail_decode_token_ = std::numeric_limits<uint64_t>::max();
+  EXPECT_EQ(runner->step(), Error::Ok);
+  ASSERT_EQ(steps_.size(), 2);
+  EXPECT_EQ(steps_[1].tokens, steps_[0].tokens);
+  EXPECT_EQ(steps_[1].positions, steps_[0].positions);
+  EXPECT_EQ(pieces, (std::vector<std::string>{"2", "6"}));
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/drafter.h>
+
+#include <gtest/gtest.h>
+
+using executorch::extension::llm::PromptLookupDrafter;
+using executorch::runtime::Error;
+
+using Tokens = std::vector<uint64_t>;
+
+namespace {
+Tokens draft(PromptLookupDrafter& drafter, Tokens tokens, int32_t max_tokens) {
+  auto result = drafter.draft(tokens, max_tokens);
+  EXPECT_EQ(result.error(), Error::Ok);
+  return result.ok() ? result.get() : Tokens{};
+}
+} // namespace
+
+TEST(PromptLookupDrafterTest, ProposesContinuationOfLatestMatch) {
+  PromptLookupDrafter drafter(/*max_ngram_size=*/2);
+
+  // The suffix {1, 2} occurs twice; the latest occurrence wins.
+  EXPECT_EQ(
+      draft(drafter, {1, 2, 3, 4, 1, 2, 5, 6, 1, 2}, 3), (Tokens{5, 6, 1}));
+
+  // The continuation is cut short at the end of the sequence.
+  EXPECT_EQ(draft(drafter, {7, 8, 9, 7, 8}, 5), (Tokens{9, 7, 8}));
+}
+
+TEST(PromptLookupDrafterTest, PrefersLongerNgrams) {
+  PromptLookupDrafter drafter(/*max_ngram_size=*/2);
+
+  // {3} alone last occurred before 9, but {2, 3} only before 4.
+  EXPECT_EQ(draft(drafter, {2, 3, 4, 5, 3, 9, 2, 3}, 2), (Tokens{4, 5}));
+}
+
+TEST(PromptLookupDrafterTest, ProposesNothingWithoutMatch) {
+  PromptLookupDrafter drafter(/*max_ngram_size=*/3, /*min_ngram_size=*/2);
+
+  EXPECT_TRUE(draft(drafter, {1, 2, 3, 4}, 4).empty());
+
+  // A single matching token is shorter than min_ngram_size.
+  EXPECT_TRUE(draft(drafter, {1, 2, 3, 1}, 4).empty());
+
+  EXPECT_TRUE(draft(drafter, {1, 2, 1, 2}, 0).empty());
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/llm/runner/prompt_cache.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using executorch::extension::llm::PromptCache;
+using executorch::runtime::Span;
+
+namespace {
+
+// A decoder state made of two buffers.
+class FakeState {
+ public:
+  FakeState() : first_(8, 0), second_(4, 0) {
+    spans_ = {
+        {first_.data(), first_.size()}, {second_.data(), second_.size()}};
+  }
+
+  void fill(uint8_t value) {
+    std::fill(first_.begin(), first_.end(), value);
+    std::fill(second_.begin(), second_.end(), value);
+  }
+
+  bool filled_with(uint8_t value) const {
+    return first_ == std::vector<uint8_t>(first_.size(), value) &&
+        second_ == std::vector<uint8_t>(second_.size(), value);
+  }
+
+  Span<const Span<uint8_t>> spans() const {
+    return {spans_.data(), spans_.size()};
+  }
+
+ private:
+  std::vector<uint8_t> first_;
+  std::vector<uint8_t> second_;
+  std::vector<Span<uint8_t>> spans_;
+};
+
+// Bytes taken by an entry with `num_tokens` tokens of FakeState.
+size_t entry_bytes(size_t num_tokens) {
+  return num_tokens * sizeof(uint64_t) + 12;
+}
+
+} // namespace
+
+class PromptCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+};
+
+TEST_F(PromptCacheTest, RestoresLongestMatchingPrefix) {
+  PromptCache cache(1024, /*block_size=*/2);
+  FakeState state;
+
+  state.fill(1);
+  cache.store({1, 2, 3, 4}, state.spans());
+  state.fill(2);
+  cache.store({1, 2, 5, 6, 7, 8}, state.spans());
+  EXPECT_EQ(cache.num_entries(), 2);
+
+  state.fill(0);
+  EXPECT_EQ(cache.restore({1, 2, 3, 4, 9}, 100, state.spans()), 4);
+  EXPECT_TRUE(state.filled_with(1));
+
+  // The match extends past the last full block.
+  EXPECT_EQ(cache.restore({1, 2, 5, 6, 7, 9}, 100, state.spans()), 5);
+  EXPECT_TRUE(state.filled_with(2));
+
+  // Both entries share the first block; either state is valid for it.
+  EXPECT_EQ(cache.restore({1, 2, 9}, 100, state.spans()), 2);
+}
+
+TEST_F(PromptCacheTest, RespectsMaxTokens) {
+  PromptCache cache(1024, /*block_size=*/2);
+  FakeState state;
+
+  cache.store({1, 2, 3, 4}, state.spans());
+  EXPECT_EQ(cache.restore({1, 2, 3, 4}, 3, state.spans()), 3);
+  EXPECT_EQ(cache.restore({1, 2, 3, 4}, 1, state.spans()), 0);
+}
+
+TEST_F(PromptCacheTest, MissesWithoutSharedBlock) {
+  PromptCache cache(1024, /*block_size=*/4);
+  FakeState state;
+
+  cache.store({1, 2, 3, 4, 5}, state.spans());
+  EXPECT_EQ(cache.restore({1, 2, 3, 9, 5}, 100, state.spans()), 0);
+  EXPECT_EQ(cache.restore({2, 2, 3, 4, 5}, 100, state.spans()), 0);
+
+  // Prompts shorter than a block aren't cached.
+  cache.store({1, 2}, state.spans());
+  EXPECT_EQ(cache.num_entries(), 1);
+}
+
+TEST_F(PromptCacheTest, RejectsMismatchedState) {
+  PromptCache cache(1024, /*block_size=*/2);
+  FakeState state;
+  cache.store({1, 2, 3}, state.spans());
+
+  std::vector<uint8_t> other(8, 0);
+  Span<uint8_t> other_span(other.data(), other.size());
+  Span<const Span<uint8_t>> other_state(&other_span, 1);
+  EXPECT_EQ(cache.restore({1, 2, 3}, 100, other_state), 0);
+}
+
+TEST_F(PromptCacheTest, DropsEntriesCoveredByLongerPrompt) {
+  PromptCache cache(1024, /*block_size=*/2);
+  FakeState state;
+
+  cache.store({1, 2, 3}, state.spans());
+  cache.store({1, 2, 3, 4, 5}, state.spans());
+  EXPECT_EQ(cache.num_entries(), 1);
+  EXPECT_EQ(cache.size_bytes(), entry_bytes(5));
+
+  // Storing the same prompt again doesn't duplicate it.
+  cache.store({1, 2, 3, 4, 5}, state.spans());
+  EXPECT_EQ(cache.num_entries(), 1);
+}
+
+TEST_F(PromptCacheTest, EvictsLeastRecentlyUsed) {
+  PromptCache cache(2 * entry_bytes(4), /*block_size=*/2);
+  FakeState state;
+
+  cache.store({1, 1, 1, 1}, state.spans());
+  cache.store({2, 2, 2, 2}, state.spans());
+  // Touch the first entry so that the second one is evicted next.
+  EXPECT_EQ(cache.restore({1, 1, 1, 1}, 100, state.spans()), 4);
+  cache.store({3, 3, 3, 3}, state.spans());
+
+  EXPECT_EQ(cache.num_entries(), 2);
+  EXPECT_LE(cache.size_bytes(), cache.capacity_bytes());
+  EXPECT_EQ(cache.restore({1, 1, 1, 1}, 100, state.spans()), 4);
+  EXPECT_EQ(cache.restore({2, 2, 2, 2}, 100, state.spans()), 0);
+  EXPECT_EQ(cache.restore({3, 3, 3, 3}, 100, state.spans()), 4);
+
+  // Entries larger than the whole cache are not stored.
+  cache.store(std::vector<uint64_t>(100, 4), state.spans());
+  EXPECT_EQ(cache.num_entries(), 2);
+
+  cache.clear();
+  EXPECT_EQ(cache.num_entries(), 0);
+  EXPECT_EQ(cache.size_bytes(), 0);
+}
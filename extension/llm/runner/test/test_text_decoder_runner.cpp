@@ -114,6 +114,35 @@ TEST_F(TextDecoderRunnerTest, LogitsToTokenWithTemperature) {
   EXPECT_LT(token, 4);
 }
 
+// Test that logits_to_token() penalizes the recent tokens
+TEST_F(TextDecoderRunnerTest, LogitsToTokenWithPenalties) {
+  TensorFactory<executorch::aten::ScalarType::Float> tf_float;
+  const std::vector<uint64_t> recent_tokens = {2, 0, 2};
+
+  // Without penalties the recent tokens don't matter.
+  auto logits = tf_float.make({1, 4}, {0.1f, 0.2f, 0.8f, 0.4f});
+  EXPECT_EQ(
+      runner_->logits_to_token(
+          logits, 0.0f, {recent_tokens.data(), recent_tokens.size()}),
+      2);
+
+  // Token 2 occurs twice and drops to 0.8 - 2 * 0.25 = 0.3.
+  runner_->set_penalties(1.0f, 0.25f, 0.0f, /*window=*/3);
+  logits = tf_float.make({1, 4}, {0.1f, 0.2f, 0.8f, 0.4f});
+  EXPECT_EQ(
+      runner_->logits_to_token(
+          logits, 0.0f, {recent_tokens.data(), recent_tokens.size()}),
+      3);
+
+  // Only the last token is in the window, so token 2 drops to 0.55.
+  runner_->set_penalties(1.0f, 0.25f, 0.0f, /*window=*/1);
+  logits = tf_float.make({1, 4}, {0.1f, 0.2f, 0.8f, 0.4f});
+  EXPECT_EQ(
+      runner_->logits_to_token(
+          logits, 0.0f, {recent_tokens.data(), recent_tokens.size()}),
+      2);
+}
+
 // Test step() method with all available PTE models
 TEST_F(TextDecoderRunnerTest, StepWithAllModels) {
   // List of all environment variables for PTE models
@@ -16,6 +16,7 @@
 #include <gtest/gtest.h>
 
 using namespace ::testing;
+using executorch::extension::llm::Drafter;
 using executorch::extension::llm::GenerationConfig;
 using executorch::extension::llm::Stats;
 using executorch::extension::llm::TextDecoderRunner;
@@ -72,6 +73,11 @@ class MockTextDecoderRunner : public TextDecoderRunner {
   MOCK_METHOD(bool, is_method_loaded, (), ());
   MOCK_METHOD(Result<uint64_t>, prefill, (std::vector<uint64_t>&, int64_t), ());
   MOCK_METHOD(::executorch::runtime::Error, load, (), ());
+  MOCK_METHOD(
+      Result<std::vector<executorch::runtime::Span<uint8_t>>>,
+      state_buffers,
+      (),
+      ());
 };
 
 class MockTextPrefiller : public TextPrefiller {
@@ -376,3 +382,132 @@ TEST_F(RunnerTest, GenerateFromPosErrorsWithNegativeMaxNewTokens) {
   // Verify that an InvalidArgument error is returned
   EXPECT_EQ(err, Error::InvalidArgument);
 }
+
+// Test that a repeated prompt prefix is restored from the prompt cache instead
+// of being prefilled again
+TEST_F(RunnerTest, PromptCacheSkipsPrefillOfCachedPrefix) {
+  auto tokenizer = createMockTokenizer();
+  auto text_decoder_runner = createMockTextDecoderRunner();
+  auto text_prefiller = createMockTextPrefiller(text_decoder_runner.get());
+
+  // Stands in for the KV cache of the model.
+  std::vector<uint8_t> state(16, 0);
+  EXPECT_CALL(*text_decoder_runner, state_buffers())
+      .WillRepeatedly([&]() {
+        return Result<std::vector<executorch::runtime::Span<uint8_t>>>(
+            std::vector<executorch::runtime::Span<uint8_t>>{
+                {state.data(), state.size()}});
+      });
+  EXPECT_CALL(*tokenizer, encode(_, _, _))
+      .WillOnce(Return(::tokenizers::Result<std::vector<uint64_t>>(
+          std::vector<uint64_t>{1, 2, 3, 4, 5})))
+      .WillOnce(Return(::tokenizers::Result<std::vector<uint64_t>>(
+          std::vector<uint64_t>{1, 2, 3, 4, 6, 7})));
+  EXPECT_CALL(*text_prefiller, prefill(_, _))
+      .WillOnce([&](std::vector<uint64_t>& tokens, int64_t& start_pos) {
+        EXPECT_EQ(tokens.size(), 5);
+        EXPECT_EQ(start_pos, 0);
+        std::fill(state.begin(), state.end(), 7);
+        start_pos += tokens.size();
+        return Result<uint64_t>(4);
+      })
+      .WillOnce([&](std::vector<uint64_t>& tokens, int64_t& start_pos) {
+        // The first four tokens are shared with the previous prompt.
+        EXPECT_EQ(tokens, (std::vector<uint64_t>{6, 7}));
+        EXPECT_EQ(start_pos, 4);
+        EXPECT_EQ(state, std::vector<uint8_t>(16, 7));
+        start_pos += tokens.size();
+        return Result<uint64_t>(4);
+      });
+  EXPECT_CALL(*text_prefiller, is_loaded()).WillRepeatedly(Return(true));
+
+  std::unique_ptr<executorch::llm::Stats> stats =
+      std::make_unique<executorch::llm::Stats>();
+  auto text_token_generator = createTextTokenGenerator(
+      tokenizer.get(), text_decoder_runner.get(), stats.get());
+
+  TextLLMRunner runner(
+      createDefaultMetadata(),
+      std::unique_ptr<::tokenizers::Tokenizer>(tokenizer.release()),
+      std::make_unique<MockModule>(),
+      std::move(text_decoder_runner),
+      std::unique_ptr<::executorch::extension::llm::TextPrefiller>(
+          text_prefiller.release()),
+      std::move(text_token_generator),
+      std::move(stats));
+  runner.load();
+  runner.set_prompt_cache_capacity(1024, /*block_size=*/2);
+
+  GenerationConfig config;
+  config.max_new_tokens = 2;
+  config.echo = false;
+
+  EXPECT_EQ(runner.generate("first prompt", config), Error::Ok);
+  ASSERT_NE(runner.prompt_cache(), nullptr);
+  EXPECT_EQ(runner.prompt_cache()->num_entries(), 1);
+
+  std::fill(state.begin(), state.end(), 0);
+  EXPECT_EQ(runner.generate("second prompt", config), Error::Ok);
+}
+
+// Proposes the next two tokens of a model that counts up, and then a wrong
+// token.
+class CountingDrafter : public Drafter {
+ public:
+  Result<std::vector<uint64_t>> draft(
+      const std::vector<uint64_t>& tokens,
+      int32_t max_draft_tokens) override {
+    std::vector<uint64_t> draft_tokens = {
+        (tokens.back() + 1) % 8, (tokens.back() + 2) % 8, 0};
+    draft_tokens.resize(std::min<size_t>(max_draft_tokens, 3));
+    return draft_tokens;
+  }
+};
+
+// Test that speculative decoding emits the accepted draft tokens plus one
+// token of the model per step
+TEST_F(RunnerTest, SpeculativeDecodingAcceptsMatchingDraftTokens) {
+  auto tokenizer = createMockTokenizer();
+  auto text_decoder_runner = createMockTextDecoderRunner();
+
+  // The model predicts the input token plus one, for every input token.
+  std::vector<int64_t> step_positions;
+  EXPECT_CALL(*text_decoder_runner, step(_, _))
+      .WillRepeatedly(
+          [&](executorch::extension::TensorPtr& input, int64_t start_pos) {
+            step_positions.push_back(start_pos);
+            const auto num_tokens = input->size(1);
+            std::vector<float> logits(num_tokens * 8, 0.0f);
+            for (ssize_t i = 0; i < num_tokens; ++i) {
+              const auto token = input->const_data_ptr<int64_t>()[i];
+              logits[i * 8 + (token + 1) % 8] = 1.0f;
+            }
+            return Result<executorch::aten::Tensor>(
+                tf.make({1, static_cast<int32_t>(num_tokens), 8}, logits));
+          });
+  std::vector<uint64_t> generated;
+  EXPECT_CALL(*tokenizer, decode(_, _))
+      .WillRepeatedly([&](uint64_t, uint64_t token) {
+        generated.push_back(token);
+        return ::tokenizers::Result<std::string>("token");
+      });
+
+  Stats stats;
+  stats.reset();
+  auto text_token_generator = createTextTokenGenerator(
+      tokenizer.get(), text_decoder_runner.get(), &stats);
+  text_token_generator->set_drafter(std::make_unique<CountingDrafter>(), 3);
+
+  auto num_generated = text_token_generator->generate(
+      {1, 2, 3}, 3, 6, 0.0f, [](const std::string&) {});
+  ASSERT_EQ(num_generated.error(), Error::Ok);
+  EXPECT_EQ(num_generated.get(), 6);
+
+  // The first step accepts 4 and 5 and rejects 0 in favor of 6. The second
+  // step may only draft two tokens and accepts both.
+  EXPECT_EQ(generated, (std::vector<uint64_t>{4, 5, 6, 7, 0, 1}));
+  EXPECT_EQ(step_positions, (std::vector<int64_t>{3, 6}));
+  EXPECT_EQ(stats.num_draft_tokens, 5);
+  EXPECT_EQ(stats.num_accepted_draft_tokens, 4);
+  EXPECT_EQ(stats.num_speculative_steps, 2);
+}
@@ -99,6 +99,28 @@ TextDecoderRunner::TextDecoderRunner(Module* module) : module_(module) {}
   }
 }
 
+::executorch::runtime::Result<executorch::aten::Tensor>
+TextDecoderRunner::step_batch(TensorPtr& tokens, TensorPtr& positions) {
+  ET_CHECK_OR_RETURN_ERROR(
+      tokens->dim() == 2 && positions->dim() == 1 &&
+          tokens->size(0) == positions->size(0),
+      InvalidArgument,
+      "Expected tokens of shape [batch, 1] and positions of shape [batch]");
+  auto outputs_res = module_->forward({tokens, positions});
+  ET_CHECK_OK_OR_RETURN_ERROR(outputs_res.error());
+  ET_CHECK_OR_RETURN_ERROR(
+      outputs_res.get().size() == 1 && outputs_res.get()[0].isTensor(),
+      InvalidProgram,
+      "Expected a single tensor of logits from executing LLM");
+  const auto& logits = outputs_res.get()[0].toTensor();
+  ET_CHECK_OR_RETURN_ERROR(
+      logits.dim() >= 2 && logits.size(0) == tokens->size(0),
+      InvalidProgram,
+      "Expected logits for %zd sequences",
+      static_cast<ssize_t>(tokens->size(0)));
+  return logits;
+}
+
 } // namespace llm
 } // namespace extension
 } // namespace executorch
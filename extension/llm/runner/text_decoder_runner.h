@@ -36,6 +36,21 @@ class ET_EXPERIMENTAL TextDecoderRunner {
       TensorPtr& input,
       int64_t start_pos);
 
+  /**
+   * Run LLM text decoder on a batch of independent sequences, one token each.
+   * Row b of the inputs belongs to the sequence in KV cache slot b of the
+   * model, so the model must be exported with a batched KV cache and a
+   * position per row.
+   * @param tokens The next token of each sequence, of shape [batch, 1].
+   * @param positions The position of each token in its sequence, of shape
+   * [batch].
+   * @return The logits of each sequence, of shape [batch, 1, vocab_size] or
+   * [batch, vocab_size].
+   */
+  virtual ::executorch::runtime::Result<executorch::aten::Tensor> step_batch(
+      TensorPtr& tokens,
+      TensorPtr& positions);
+
   /**
    * Load the Module for text decode purpose.
    * @return The error code.
@@ -52,20 +67,58 @@ class ET_EXPERIMENTAL TextDecoderRunner {
     return module_->is_method_loaded("forward");
   }
 
+  /**
+   * Get the buffers that hold the mutable state of the decoder, such as its
+   * KV cache, so that the state can be saved and restored.
+   * @return The buffers, or an error if the state is not accessible.
+   */
+  virtual ::executorch::runtime::Result<
+      std::vector<::executorch::runtime::Span<uint8_t>>>
+  state_buffers() {
+    return module_->planned_buffers("forward");
+  }
+
   inline void stop() {
     should_stop_ = true;
   }
 
+  /**
+   * Penalize tokens that occur among the last `window` tokens passed to
+   * logits_to_token(). See Sampler::set_penalties().
+   */
+  inline void set_penalties(
+      float repetition_penalty,
+      float frequency_penalty,
+      float presence_penalty,
+      int32_t window) {
+    repetition_penalty_ = repetition_penalty;
+    frequency_penalty_ = frequency_penalty;
+    presence_penalty_ = presence_penalty;
+    penalty_window_ = window;
+    if (sampler_) {
+      sampler_->set_penalties(
+          repetition_penalty_, frequency_penalty_, presence_penalty_);
+    }
+  }
+
   /**
    * Sample the next token from the logits tensor.
    * @param logits_tensor The logits tensor.
    * @param temperature The temperature parameter used to control randomness in
    * sampling.
+   * @param recent_tokens The tokens so far, for the penalties set by
+   * set_penalties().
    * @return The next token.
    */
   inline int32_t logits_to_token(
       const executorch::aten::Tensor& logits_tensor,
-      const float temperature = 0.0f) {
+      const float temperature = 0.0f,
+      ::executorch::runtime::ArrayRef<uint64_t> recent_tokens = {}) {
+    const size_t window =
+        static_cast<size_t>(std::max<int32_t>(penalty_window_, 0));
+    if (recent_tokens.size() > window) {
+      recent_tokens = recent_tokens.slice(recent_tokens.size() - window);
+    }
     int32_t result = 0;
     ET_SWITCH_THREE_TYPES(
         Float,
@@ -85,9 +138,18 @@ class ET_EXPERIMENTAL TextDecoderRunner {
             auto num_tokens = logits_tensor.size(1);
             logits += (num_tokens - 1) * vocab_size;
           }
-          // @lint-ignore CLANGTIDY facebook-hte-Deprecated
-          Sampler sampler(vocab_size, temperature);
-          result = sampler.sample(logits);
+          // Reuse the sampler so that its scratch space is only allocated
+          // once and its random state carries over between tokens.
+          if (!sampler_ || sampler_vocab_size_ != vocab_size ||
+              sampler_temperature_ != temperature) {
+            // @lint-ignore CLANGTIDY facebook-hte-Deprecated
+            sampler_ = std::make_unique<Sampler>(vocab_size, temperature);
+            sampler_vocab_size_ = vocab_size;
+            sampler_temperature_ = temperature;
+            sampler_->set_penalties(
+                repetition_penalty_, frequency_penalty_, presence_penalty_);
+          }
+          result = sampler_->sample(logits, recent_tokens);
         });
     return result;
   }
@@ -102,6 +164,13 @@ class ET_EXPERIMENTAL TextDecoderRunner {
    */
   Module* module_;
   bool should_stop_{false};
+  std::unique_ptr<Sampler> sampler_;
+  ssize_t sampler_vocab_size_ = 0;
+  float sampler_temperature_ = 0.0f;
+  float repetition_penalty_ = 1.0f;
+  float frequency_penalty_ = 0.0f;
+  float presence_penalty_ = 0.0f;
+  int32_t penalty_window_ = 0;
 };
 
 } // namespace llm
@@ -169,9 +169,38 @@ Error TextLLMRunner::generate_from_pos(
     wrapped_callback(prompt);
   }
   int64_t pos = start_pos;
-  auto prefill_res = text_prefiller_->prefill(prompt_tokens, pos);
+  // The prompt cache only holds states prefilled from position 0.
+  std::vector<::executorch::runtime::Span<uint8_t>> state;
+  size_t num_cached_tokens = 0;
+  if (prompt_cache_ && start_pos == 0) {
+    auto state_res = text_decoder_runner_->state_buffers();
+    if (state_res.ok()) {
+      state = std::move(state_res.get());
+      // Leave at least one token to prefill, for the logits of the next one.
+      num_cached_tokens = prompt_cache_->restore(
+          prompt_tokens, num_prompt_tokens - 1, {state.data(), state.size()});
+    } else {
+      ET_LOG(Info, "Decoder state is not accessible, skipping prompt cache");
+    }
+  }
+  std::vector<uint64_t> uncached_tokens;
+  if (num_cached_tokens > 0) {
+    RUNNER_ET_LOG(
+        config.warming,
+        "Reusing %zu of %d prompt tokens from the prompt cache",
+        num_cached_tokens,
+        num_prompt_tokens);
+    uncached_tokens.assign(
+        prompt_tokens.begin() + num_cached_tokens, prompt_tokens.end());
+    pos += num_cached_tokens;
+  }
+  auto prefill_res = text_prefiller_->prefill(
+      num_cached_tokens > 0 ? uncached_tokens : prompt_tokens, pos);
   ET_CHECK_OK_OR_RETURN_ERROR(prefill_res.error());
   uint64_t cur_token = prefill_res.get();
+  if (!state.empty()) {
+    prompt_cache_->store(prompt_tokens, {state.data(), state.size()});
+  }
   stats_->first_token_ms = time_in_ms();
   stats_->prompt_eval_end_ms = time_in_ms();
 
@@ -186,6 +215,12 @@ Error TextLLMRunner::generate_from_pos(
   // start the main loop
   prompt_tokens.push_back(cur_token);
 
+  text_decoder_runner_->set_penalties(
+      config.repetition_penalty,
+      config.frequency_penalty,
+      config.presence_penalty,
+      config.penalty_window);
+
   // Generate max_new_tokens - 1 because prefill already generated 1 token.
   int64_t num_generated_tokens = ET_UNWRAP(text_token_generator_->generate(
       prompt_tokens,
@@ -251,6 +286,22 @@ void TextLLMRunner::stop() {
   }
 }
 
+void TextLLMRunner::set_prompt_cache_capacity(
+    size_t capacity_bytes,
+    size_t block_size) {
+  if (capacity_bytes == 0) {
+    prompt_cache_.reset();
+  } else {
+    prompt_cache_ = std::make_unique<PromptCache>(capacity_bytes, block_size);
+  }
+}
+
+void TextLLMRunner::set_drafter(
+    std::unique_ptr<Drafter> drafter,
+    int32_t num_draft_tokens) {
+  text_token_generator_->set_drafter(std::move(drafter), num_draft_tokens);
+}
+
 std::unique_ptr<tokenizers::Tokenizer> load_tokenizer(
     const std::string& tokenizer_path,
     std::unique_ptr<std::vector<std::string>> special_tokens,
@@ -18,6 +18,7 @@
 #include <unordered_map>
 
 #include <executorch/extension/llm/runner/irunner.h>
+#include <executorch/extension/llm/runner/prompt_cache.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/llm/runner/text_prefiller.h>
@@ -133,6 +134,43 @@ class ET_EXPERIMENTAL TextLLMRunner : public IRunner {
   ::executorch::runtime::Error warmup(
       const std::string& prompt,
       int32_t max_new_tokens);
+  /**
+   * @brief Enables reusing the decoder state of earlier prompts
+   *
+   * After each prefill that starts at position 0, the decoder state is saved
+   * in a PromptCache. A later prompt that shares a prefix with a saved one
+   * restores that state and only prefills the rest, which cuts the time to
+   * first token of prompts that repeat a long system prompt or conversation
+   * history. Saving copies all memory-planned buffers of the model, so the
+   * capacity should allow for at least one copy of them.
+   *
+   * @param capacity_bytes Maximum size of the saved states; 0 disables the
+   * cache
+   * @param block_size Granularity in tokens at which prefixes are matched
+   */
+  void set_prompt_cache_capacity(size_t capacity_bytes, size_t block_size = 64);
+
+  /**
+   * @brief Returns the prompt cache, or nullptr if it's disabled
+   */
+  PromptCache* prompt_cache() const {
+    return prompt_cache_.get();
+  }
+
+  /**
+   * @brief Enables speculative decoding
+   *
+   * The drafter proposes tokens that the model verifies in a single forward
+   * pass. This needs a model exported with a dynamic sequence length that
+   * returns the logits of every input token. See
+   * TextTokenGenerator::set_drafter().
+   *
+   * @param drafter Proposes the draft tokens; nullptr disables speculative
+   * decoding
+   * @param num_draft_tokens Maximum number of tokens to draft per step
+   */
+  void set_drafter(std::unique_ptr<Drafter> drafter, int32_t num_draft_tokens);
+
   /**
    * @brief Stops the ongoing text generation process
    *
@@ -157,6 +195,9 @@ class ET_EXPERIMENTAL TextLLMRunner : public IRunner {
   std::unique_ptr<TextPrefiller> text_prefiller_;
   std::unique_ptr<TextTokenGenerator> text_token_generator_;
 
+  // Decoder states of earlier prompts, if enabled.
+  std::unique_ptr<PromptCache> prompt_cache_;
+
   // Stats
   std::unique_ptr<Stats> stats_;
 
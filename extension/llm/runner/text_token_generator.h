@@ -9,6 +9,7 @@
 // Generate tokens in a loop.
 #pragma once
 
+#include <executorch/extension/llm/runner/drafter.h>
 #include <executorch/extension/llm/runner/stats.h>
 #include <executorch/extension/llm/runner/text_decoder_runner.h>
 #include <executorch/extension/tensor/tensor.h>
@@ -56,6 +57,14 @@ class ET_EXPERIMENTAL TextTokenGenerator {
       const std::function<void(const std::string&)>& token_callback = {}) {
     ET_CHECK_MSG(
         !tokens.empty(), "Token generation loop shouldn't take empty tokens");
+    if (drafter_ && use_kv_cache_) {
+      return generate_speculative(
+          std::move(tokens),
+          start_pos,
+          max_new_tokens,
+          temperature,
+          token_callback);
+    }
     int64_t pos = start_pos; // position in the sequence
 
     std::vector<uint64_t> token_data; // allocate space for the tokens
@@ -92,11 +101,12 @@ class ET_EXPERIMENTAL TextTokenGenerator {
       prev_token = cur_token;
 
       stats_->on_sampling_begin();
-      cur_token =
-          text_decoder_runner_->logits_to_token(logits_tensor, temperature);
+      cur_token = text_decoder_runner_->logits_to_token(
+          logits_tensor, temperature, {tokens.data(), tokens.size()});
       stats_->on_sampling_end();
 
       pos++;
+      tokens.push_back(cur_token);
 
       if (use_kv_cache_) {
         // update the token tensor. token_data will not be empty.
@@ -127,6 +137,30 @@ class ET_EXPERIMENTAL TextTokenGenerator {
     return pos - start_pos;
   }
 
+  /**
+   * Enable speculative decoding. In each step, `drafter` proposes up to
+   * `num_draft_tokens` tokens and the model verifies them together with the
+   * current token in a single forward pass, so that a step generates one token
+   * plus every draft token the model agrees with.
+   *
+   * A draft token is accepted if it's the token the model samples at its
+   * position, so the output is the same as without a drafter for the same
+   * sampling decisions. The model must use a KV cache, take several tokens
+   * per forward pass and return the logits of all of them. Rejected tokens
+   * leave stale KV cache entries past the current position, which are
+   * overwritten by the next step.
+   *
+   * @param drafter The drafter to use, or nullptr to disable speculative
+   * decoding.
+   * @param num_draft_tokens The maximum number of tokens to draft per step.
+   */
+  void set_drafter(
+      std::unique_ptr<Drafter> drafter,
+      int32_t num_draft_tokens) {
+    drafter_ = std::move(drafter);
+    num_draft_tokens_ = num_draft_tokens;
+  }
+
   /**
    * Stop the generation loop.
    */
@@ -139,6 +173,9 @@ class ET_EXPERIMENTAL TextTokenGenerator {
    * This method should be called before using the generate() method.
    */
   ::executorch::runtime::Error load() {
+    if (drafter_) {
+      ET_CHECK_OK_OR_RETURN_ERROR(drafter_->load());
+    }
     return text_decoder_runner_->load();
   }
 
@@ -152,6 +189,116 @@ class ET_EXPERIMENTAL TextTokenGenerator {
   }
 
  private:
+  inline ::executorch::runtime::Result<int64_t> generate_speculative(
+      std::vector<uint64_t> tokens,
+      int64_t start_pos,
+      int32_t max_new_tokens,
+      float temperature,
+      const std::function<void(const std::string&)>& token_callback) {
+    const int64_t end_pos = start_pos + max_new_tokens;
+    int64_t pos = start_pos; // position in the sequence
+
+    // Token after prefill
+    uint64_t cur_token = tokens.back();
+
+    // The current token followed by the draft tokens.
+    std::vector<uint64_t> token_data;
+    token_data.reserve(std::max(num_draft_tokens_, 0) + 1);
+
+    should_stop_ = false;
+
+    while (pos < end_pos) {
+      // Every step generates at least one token besides the draft tokens.
+      const int32_t max_draft_tokens = static_cast<int32_t>(
+          std::min<int64_t>(num_draft_tokens_, end_pos - pos - 1));
+      std::vector<uint64_t> draft_tokens;
+      if (max_draft_tokens > 0) {
+        draft_tokens = ET_UNWRAP(drafter_->draft(tokens, max_draft_tokens));
+        if (draft_tokens.size() > static_cast<size_t>(max_draft_tokens)) {
+          draft_tokens.resize(max_draft_tokens);
+        }
+      }
+      token_data.assign(1, cur_token);
+      token_data.insert(
+          token_data.end(), draft_tokens.begin(), draft_tokens.end());
+      auto tokens_managed = from_blob(
+          token_data.data(),
+          {1, static_cast<executorch::aten::SizesType>(token_data.size())},
+          executorch::aten::ScalarType::Long);
+
+      // Run the model on all of them at once.
+      auto logits_res = text_decoder_runner_->step(tokens_managed, pos);
+      ET_CHECK_OK_OR_RETURN_ERROR(logits_res.error());
+      executorch::aten::Tensor& logits_tensor = logits_res.get();
+
+      const ssize_t num_logits =
+          logits_tensor.dim() == 3 ? logits_tensor.size(1) : 1;
+      ET_CHECK_OR_RETURN_ERROR(
+          num_logits == static_cast<ssize_t>(token_data.size()),
+          NotSupported,
+          "Speculative decoding needs logits for all %zu input tokens, got %zd",
+          token_data.size(),
+          num_logits);
+      const auto vocab_size = static_cast<executorch::aten::SizesType>(
+          logits_tensor.size(logits_tensor.dim() - 1));
+      auto* logits_data =
+          static_cast<uint8_t*>(logits_tensor.mutable_data_ptr());
+      const size_t logits_stride = vocab_size * logits_tensor.element_size();
+
+      size_t num_accepted = 0;
+      bool done = false;
+      for (size_t i = 0; i < token_data.size(); ++i) {
+        auto logits = from_blob(
+            logits_data + i * logits_stride,
+            {1, vocab_size},
+            logits_tensor.scalar_type());
+
+        const uint64_t prev_token = cur_token;
+
+        stats_->on_sampling_begin();
+        cur_token = text_decoder_runner_->logits_to_token(
+            *logits, temperature, {tokens.data(), tokens.size()});
+        stats_->on_sampling_end();
+
+        pos++;
+        tokens.push_back(cur_token);
+
+        // print the token as string, decode it with the Tokenizer object
+        token_callback(
+            ET_UNWRAP_TOKENIZER(tokenizer_->decode(prev_token, cur_token)));
+
+        if (should_stop_) {
+          done = true;
+          break;
+        }
+
+        // data-dependent terminating condition: we have n_eos_ number of EOS
+        if (eos_ids_->find(cur_token) != eos_ids_->end()) {
+          printf("\n");
+          ET_LOG(Info, "\nReached to the end of generation");
+          done = true;
+          break;
+        }
+
+        // The logits of the next input are only valid if the model agrees
+        // with the draft token it was computed for.
+        if (i >= draft_tokens.size() || draft_tokens[i] != cur_token) {
+          break;
+        }
+        num_accepted++;
+      }
+
+      stats_->num_draft_tokens += draft_tokens.size();
+      stats_->num_accepted_draft_tokens += num_accepted;
+      stats_->num_speculative_steps++;
+
+      if (done) {
+        break;
+      }
+    }
+    return pos - start_pos;
+  }
+
   /**
    * Note: TextTokenGenerator does not own the tokenizer_ and
    * text_decoder_runner_. The lifecycle of these objects should be managed
@@ -163,6 +310,10 @@ class ET_EXPERIMENTAL TextTokenGenerator {
   std::unique_ptr<std::unordered_set<uint64_t>> eos_ids_;
   bool use_kv_cache_;
 
+  // speculative decoding
+  std::unique_ptr<Drafter> drafter_;
+  int32_t num_draft_tokens_ = 0;
+
   // state machine
   bool should_stop_ = false;
 
@@ -34,127 +34,331 @@
 
 #include <executorch/extension/llm/sampler/sampler.h>
 #include <algorithm>
+#include <cstring>
 #include <ctime>
 
 namespace executorch {
 namespace extension {
 namespace llm {
 
+namespace {
+
+// Number of independent accumulators in reductions, so that the compiler can
+// keep them in SIMD registers.
+constexpr int kLanes = 16;
+// Number of probabilities summed up together, so that sampling can skip over
+// whole blocks.
+constexpr int32_t kBlockSize = 4 * kLanes;
+
+// exp(x) for x <= 0, written without branches or library calls so that loops
+// over it vectorize. Computes 2^n * 2^f with n = round(x * log2(e)) and a
+// polynomial for 2^f, f in [-0.5, 0.5]; the relative error is below 1e-5.
+// Results that would be below 2^-126, including exp(-inf), are 0, and so is
+// exp(NaN).
+inline float exp_nonpositive(float x) {
+  float t = x * 1.44269504f;
+  // Clamp before n is converted to an integer below, which is undefined for
+  // -inf and NaN. NaN fails the comparison and becomes -127 too.
+  t = t > -127.0f ? t : -127.0f;
+  t = t < 0.0f ? t : 0.0f;
+  // Round to nearest by adding and subtracting 1.5 * 2^23.
+  const float n = (t + 12582912.0f) - 12582912.0f;
+  const float f = t - n;
+  float p = 1.5403530e-4f;
+  p = p * f + 1.3333558e-3f;
+  p = p * f + 9.6181291e-3f;
+  p = p * f + 5.5504109e-2f;
+  p = p * f + 2.4022651e-1f;
+  p = p * f + 6.9314718e-1f;
+  p = p * f + 1.0f;
+  const int32_t exponent = static_cast<int32_t>(n);
+  const int32_t scale_bits = (exponent + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &scale_bits, sizeof(scale));
+  const float result = p * scale;
+  // Flush the results for t in [-127, -126) to 0.
+  int32_t result_bits;
+  std::memcpy(&result_bits, &result, sizeof(result_bits));
+  result_bits &= -static_cast<int32_t>(t >= -126.0f);
+  float masked;
+  std::memcpy(&masked, &result_bits, sizeof(masked));
+  return masked;
+}
+
+template <typename T>
+float max_value(const T* x, int32_t size) {
+  float lanes[kLanes];
+  const float first = static_cast<float>(x[0]);
+  for (int j = 0; j < kLanes; j++) {
+    lanes[j] = first;
+  }
+  int32_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    for (int j = 0; j < kLanes; j++) {
+      const float v = static_cast<float>(x[i + j]);
+      lanes[j] = v > lanes[j] ? v : lanes[j];
+    }
+  }
+  float max_val = lanes[0];
+  for (int j = 1; j < kLanes; j++) {
+    max_val = lanes[j] > max_val ? lanes[j] : max_val;
+  }
+  for (; i < size; i++) {
+    const float v = static_cast<float>(x[i]);
+    max_val = v > max_val ? v : max_val;
+  }
+  return max_val;
+}
+
+float sum_block(const float* x, int32_t size) {
+  float lanes[kLanes] = {};
+  int32_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    for (int j = 0; j < kLanes; j++) {
+      lanes[j] += x[i + j];
+    }
+  }
+  float sum = 0;
+  for (int j = 0; j < kLanes; j++) {
+    sum += lanes[j];
+  }
+  for (; i < size; i++) {
+    sum += x[i];
+  }
+  return sum;
+}
+
+bool greater_prob(const ProbIndex<float>& a, const ProbIndex<float>& b) {
+  return a.prob > b.prob;
+}
+
+} // namespace
+
 // sampler stuff
 template <typename T>
-int32_t Sampler::sample_argmax(T* probabilities) {
-  // return the index that has the highest probability
-  int max_i = 0;
-  T max_p = probabilities[0];
-  for (int i = 1; i < vocab_size_; i++) {
-    if (probabilities[i] > max_p) {
-      max_i = i;
-      max_p = probabilities[i];
+int32_t Sampler::sample_argmax(const T* logits) {
+  // return the index that has the highest probability. Finding the maximum
+  // first keeps both loops free of data-dependent branches.
+  const float max_val = max_value(logits, vocab_size_);
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    if (static_cast<float>(logits[i]) == max_val) {
+      return i;
     }
   }
-  return max_i;
+  // Only reachable for NaN logits.
+  return 0;
 }
 
 template <typename T>
-int32_t Sampler::sample_mult(T* probabilities, float coin) {
-  // sample index from probabilities (they must sum to 1!)
+float Sampler::softmax(const T* logits) {
+  if (probs_.empty()) {
+    probs_.resize(vocab_size_);
+    block_sums_.resize((vocab_size_ + kBlockSize - 1) / kBlockSize);
+  }
+  float* probs = probs_.data();
+  // Subtracting the max keeps exp() from overflowing. Scaling by the
+  // temperature afterwards is the same as scaling the logits first, and the
+  // most likely token gets a probability of exactly 1.
+  const float max_val = max_value(logits, vocab_size_);
+  const float inv_temperature = inv_temperature_;
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    probs[i] = exp_nonpositive(
+        (static_cast<float>(logits[i]) - max_val) * inv_temperature);
+  }
+  // Sum up per block, so that sample_mult() only walks one block.
+  float* block_sums = block_sums_.data();
+  float sum = 0;
+  for (int32_t begin = 0; begin < vocab_size_; begin += kBlockSize) {
+    const float block_sum =
+        sum_block(probs + begin, std::min(kBlockSize, vocab_size_ - begin));
+    block_sums[begin / kBlockSize] = block_sum;
+    sum += block_sum;
+  }
+  return sum;
+}
+
+int32_t Sampler::sample_mult(float sum, float coin) {
+  // sample index from the unnormalized probabilities, which sum to `sum`.
   // coin is a random number in [0, 1), usually from random_f32()
-  T cdf = 0.0;
-  for (int i = 0; i < vocab_size_; i++) {
-    cdf += probabilities[i];
-    if (coin < cdf) {
-      return i;
+  const float* probs = probs_.data();
+  const float* block_sums = block_sums_.data();
+  const float r = coin * sum;
+  float cdf = 0.0f;
+  for (int32_t begin = 0; begin < vocab_size_; begin += kBlockSize) {
+    const float block_sum = block_sums[begin / kBlockSize];
+    if (r < cdf + block_sum) {
+      const int32_t end = std::min(begin + kBlockSize, vocab_size_);
+      for (int32_t i = begin; i < end; i++) {
+        cdf += probs[i];
+        if (r < cdf) {
+          return i;
+        }
+      }
+      return end - 1; // in case of rounding errors
     }
+    cdf += block_sum;
   }
   return vocab_size_ - 1; // in case of rounding errors
 }
 
-template <typename T>
-int32_t Sampler::sample_topp(T* probabilities, float coin) {
-  // top-p sampling (or "nucleus sampling") samples from the smallest set of
-  // tokens that exceed probability topp. This way we never sample tokens that
-  // have very low probabilities and are less likely to go "off the rails".
+int32_t Sampler::sample_topk_topp(float sum, float coin) {
+  // Collects the candidates that pass min-p, then keeps the topk most likely
+  // ones, and then the smallest set of those whose probability exceeds topp
+  // ("nucleus sampling"). This way we never sample tokens that have very low
+  // probabilities and are less likely to go "off the rails".
   // coin is a random number in [0, 1), usually from random_f32()
-  int n = vocab_size_;
-  int n0 = 0;
-  // quicksort indices in descending order of probabilities
-  // values smaller than (1 - topp) / (n - 1) cannot be part of the result
-  // so for efficiency we crop these out as candidates before sorting
-  std::unique_ptr<ProbIndex<T>[]> probindex =
-      std::make_unique<ProbIndex<T>[]>(vocab_size_);
-
-  const float cutoff = (1.0f - topp_) / (n - 1);
-  for (int i = 0; i < n; i++) {
-    if (probabilities[i] >= cutoff) {
-      probindex[n0].index = i;
-      probindex[n0].prob = probabilities[i];
+  if (candidates_.empty()) {
+    candidates_.resize(vocab_size_);
+  }
+  const float* probs = probs_.data();
+  ProbIndex<float>* candidates = candidates_.data();
+  const bool use_topp = topp_ > 0 && topp_ < 1;
+  const bool use_topk = topk_ > 0 && topk_ < vocab_size_;
+
+  // The most likely token has probability 1, so min-p is an absolute cutoff.
+  float cutoff = min_p_;
+  if (use_topp && !use_topk && vocab_size_ > 1) {
+    // values smaller than (1 - topp) / (n - 1) of the total cannot be part of
+    // the result, so for efficiency we crop these out as candidates.
+    cutoff = std::max(cutoff, (1.0f - topp_) / (vocab_size_ - 1) * sum);
+  }
+  // Always keep the most likely token.
+  cutoff = std::min(cutoff, 1.0f);
+
+  int32_t n0 = 0;
+  for (int32_t i = 0; i < vocab_size_; i++) {
+    if (probs[i] >= cutoff) {
+      candidates[n0].index = i;
+      candidates[n0].prob = probs[i];
       n0++;
     }
   }
 
-  auto compare = [](const ProbIndex<T>& a, const ProbIndex<T>& b) {
-    return a.prob > b.prob;
-  };
-  std::sort(probindex.get(), probindex.get() + n0, compare);
+  if (use_topk && n0 > topk_) {
+    // Partial selection instead of a full sort.
+    std::nth_element(
+        candidates, candidates + topk_ - 1, candidates + n0, greater_prob);
+    n0 = topk_;
+  }
+  float mass = 0.0f;
+  for (int32_t i = 0; i < n0; i++) {
+    mass += candidates[i].prob;
+  }
+
+  if (use_topp) {
+    // Select the most likely candidates in chunks of doubling size until they
+    // exceed topp of the mass, so that only the nucleus needs sorting.
+    const float target = topp_ * mass;
+    int32_t selected = 0;
+    float selected_mass = 0.0f;
+    int32_t chunk = 32;
+    while (selected < n0 && selected_mass <= target) {
+      const int32_t end = std::min(n0, selected + chunk);
+      if (end < n0) {
+        std::nth_element(
+            candidates + selected,
+            candidates + end - 1,
+            candidates + n0,
+            greater_prob);
+      }
+      for (int32_t i = selected; i < end; i++) {
+        selected_mass += candidates[i].prob;
+      }
+      selected = end;
+      chunk *= 2;
+    }
+    std::sort(candidates, candidates + selected, greater_prob);
 
-  // truncate the list where cumulative probability exceeds topp
-  T cumulative_prob = 0;
-  int last_idx = n0 - 1; // in case of rounding errors consider all elements
-  for (int i = 0; i < n0; i++) {
-    cumulative_prob += probindex[i].prob;
-    if (cumulative_prob > topp_) {
-      last_idx = i;
-      break; // we've exceeded topp by including last_idx
+    // truncate the list where cumulative probability exceeds topp
+    float cumulative_prob = 0.0f;
+    int32_t last_idx = selected - 1; // in case of rounding errors
+    for (int32_t i = 0; i < selected; i++) {
+      cumulative_prob += candidates[i].prob;
+      if (cumulative_prob > target) {
+        last_idx = i;
+        break; // we've exceeded topp by including last_idx
+      }
     }
+    n0 = last_idx + 1;
+    mass = cumulative_prob;
   }
 
   // sample from the truncated list
-  const T& r = coin * cumulative_prob;
-  T cdf = 0;
-  for (int i = 0; i <= last_idx; i++) {
-    cdf += probindex[i].prob;
+  const float r = coin * mass;
+  float cdf = 0.0f;
+  for (int32_t i = 0; i < n0; i++) {
+    cdf += candidates[i].prob;
     if (r < cdf) {
-      return probindex[i].index;
+      return candidates[i].index;
     }
   }
-  return probindex[last_idx].index; // in case of rounding errors
+  return candidates[n0 - 1].index; // in case of rounding errors
+}
+
+template <typename T>
+void Sampler::apply_penalties(
+    T* logits,
+    ::executorch::runtime::ArrayRef<uint64_t> recent_tokens) {
+  if (recent_tokens.empty() ||
+      (repetition_penalty_ == 1.0f && frequency_penalty_ == 0.0f &&
+       presence_penalty_ == 0.0f)) {
+    return;
+  }
+  if (token_counts_.empty()) {
+    token_counts_.resize(vocab_size_, 0);
+  }
+  const uint64_t vocab_size = vocab_size_;
+  for (uint64_t token : recent_tokens) {
+    if (token < vocab_size) {
+      token_counts_[token]++;
+    }
+  }
+  // Penalize every distinct token once, and reset the counts for the next
+  // call on the way.
+  for (uint64_t token : recent_tokens) {
+    if (token >= vocab_size || token_counts_[token] == 0) {
+      continue;
+    }
+    float logit = static_cast<float>(logits[token]);
+    if (repetition_penalty_ != 1.0f) {
+      logit = logit > 0 ? logit / repetition_penalty_
+                        : logit * repetition_penalty_;
+    }
+    logit -= frequency_penalty_ * token_counts_[token] + presence_penalty_;
+    logits[token] = static_cast<T>(logit);
+    token_counts_[token] = 0;
+  }
 }
 
 Sampler::Sampler(
     int vocab_size,
     float temperature,
     float topp,
-    unsigned long long rng_seed)
+    unsigned long long rng_seed,
+    int32_t topk,
+    float min_p)
     : vocab_size_(vocab_size),
       inv_temperature_(static_cast<bool>(temperature) ? 1.0f / temperature : 0),
       topp_(topp),
+      topk_(topk),
+      min_p_(min_p),
       rng_state_(rng_seed) {}
 
 Sampler::Sampler(int vocab_size, float temperature)
     : vocab_size_(vocab_size),
       inv_temperature_(static_cast<bool>(temperature) ? 1.0f / temperature : 0),
       topp_(kTopp),
+      topk_(0),
+      min_p_(0.0f),
       rng_state_(std::time(nullptr)) {}
 
-template <typename T>
-static void softmax(T* x, int size) {
-  // find max value (for numerical stability)
-  T max_val = x[0];
-  for (int i = 1; i < size; i++) {
-    if (x[i] > max_val) {
-      max_val = x[i];
-    }
-  }
-  // exp and sum
-  T sum = 0;
-  for (int i = 0; i < size; i++) {
-    x[i] = expf(x[i] - max_val);
-    sum += x[i];
-  }
-  // normalize
-  for (int i = 0; i < size; i++) {
-    x[i] /= sum;
-  }
+void Sampler::set_penalties(
+    float repetition_penalty,
+    float frequency_penalty,
+    float presence_penalty) {
+  repetition_penalty_ = repetition_penalty;
+  frequency_penalty_ = frequency_penalty;
+  presence_penalty_ = presence_penalty;
 }
 
 static unsigned int random_u32(unsigned long long* state) {
@@ -172,29 +376,31 @@ static float random_f32(unsigned long long* state) { // random float32 in [0,1)
 template <typename T>
 int32_t Sampler::sample(T* logits) {
   // sample the token given the logits and some hyperparameters
-  int next;
   if (inv_temperature_ == 0.0f) {
     // greedy argmax sampling: take the token with the highest probability
-    next = sample_argmax(logits);
-  } else {
-    // apply the temperature to the logits
-    for (int q = 0; q < vocab_size_; q++) {
-      logits[q] *= inv_temperature_;
-    }
-    // apply softmax to the logits to get the probabilities for next token
-    softmax(logits, vocab_size_);
-    // flip a (float) coin (this is our source of entropy for sampling)
-    float coin = random_f32(&rng_state_);
-    // we sample from this distribution to get the next token
-    if (topp_ <= 0 || topp_ >= 1) {
-      // simply sample from the predicted probability distribution
-      next = sample_mult(logits, coin);
-    } else {
-      // top-p (nucleus) sampling, clamping the least likely tokens to zero
-      next = sample_topp(logits, coin);
-    }
+    return sample_argmax(logits);
+  }
+  // apply the temperature and softmax to the logits to get the (unnormalized)
+  // probabilities for next token
+  const float sum = softmax(logits);
+  // flip a (float) coin (this is our source of entropy for sampling)
+  const float coin = random_f32(&rng_state_);
+  // we sample from this distribution to get the next token
+  if ((topp_ <= 0 || topp_ >= 1) && (topk_ <= 0 || topk_ >= vocab_size_) &&
+      min_p_ <= 0) {
+    // simply sample from the predicted probability distribution
+    return sample_mult(sum, coin);
   }
-  return next;
+  // clamp the least likely tokens to zero
+  return sample_topk_topp(sum, coin);
+}
+
+template <typename T>
+int32_t Sampler::sample(
+    T* logits,
+    ::executorch::runtime::ArrayRef<uint64_t> recent_tokens) {
+  apply_penalties(logits, recent_tokens);
+  return sample(logits);
 }
 
 template int32_t Sampler::sample<float>(float* logits);
@@ -202,6 +408,15 @@ template int32_t Sampler::sample<executorch::aten::Half>(
     executorch::aten::Half* logits);
 template int32_t Sampler::sample<executorch::aten::BFloat16>(
     executorch::aten::BFloat16* logits);
+template int32_t Sampler::sample<float>(
+    float* logits,
+    ::executorch::runtime::ArrayRef<uint64_t> recent_tokens);
+template int32_t Sampler::sample<executorch::aten::Half>(
+    executorch::aten::Half* logits,
+    ::executorch::runtime::ArrayRef<uint64_t> recent_tokens);
+template int32_t Sampler::sample<executorch::aten::BFloat16>(
+    executorch::aten::BFloat16* logits,
+    ::executorch::runtime::ArrayRef<uint64_t> recent_tokens);
 
 } // namespace llm
 } // namespace extension
@@ -14,10 +14,12 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <vector>
 #ifdef USE_ATEN_LIB
 #include <torch/torch.h>
 #endif
 
+#include <executorch/runtime/core/array_ref.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/platform/compiler.h>
 
@@ -36,31 +38,86 @@ struct ET_EXPERIMENTAL ProbIndex {
 
 class ET_EXPERIMENTAL Sampler {
  public:
+  /**
+   * @param vocab_size The number of logits per sample.
+   * @param temperature Scales the logits before softmax; 0 samples greedily.
+   * @param topp Only sample from the most likely tokens whose cumulative
+   * probability exceeds topp. Disabled if not in (0, 1).
+   * @param rng_seed Seed of the random number generator.
+   * @param topk Only sample from the topk most likely tokens. Disabled if 0.
+   * @param min_p Only sample from tokens that are at least min_p times as
+   * likely as the most likely one. Disabled if 0.
+   */
   Sampler(
       int32_t vocab_size,
       float temperature,
       float topp,
-      unsigned long long rng_seed);
+      unsigned long long rng_seed,
+      int32_t topk = 0,
+      float min_p = 0.0f);
 
   Sampler(int32_t vocab_size, float temperature);
 
+  /**
+   * Penalize tokens that occur in the recent tokens passed to sample(), to
+   * discourage repetition. Penalties are applied to the logits in place, also
+   * when sampling greedily.
+   *
+   * @param repetition_penalty Divides positive logits and multiplies negative
+   * ones of tokens that occur. 1 disables it.
+   * @param frequency_penalty Subtracted from the logit of a token once per
+   * occurrence. 0 disables it.
+   * @param presence_penalty Subtracted from the logit of a token that occurs.
+   * 0 disables it.
+   */
+  void set_penalties(
+      float repetition_penalty,
+      float frequency_penalty,
+      float presence_penalty);
+
   template <typename T>
   int32_t sample(T* logits);
 
+  /**
+   * Sample after applying the penalties set by set_penalties() for the tokens
+   * in `recent_tokens`.
+   */
+  template <typename T>
+  int32_t sample(
+      T* logits,
+      ::executorch::runtime::ArrayRef<uint64_t> recent_tokens);
+
  private:
   template <typename T>
-  int32_t sample_topp(T* probabilities, float coin);
+  void apply_penalties(
+      T* logits,
+      ::executorch::runtime::ArrayRef<uint64_t> recent_tokens);
   template <typename T>
-  int32_t sample_mult(T* probabilities, float coin);
+  int32_t sample_argmax(const T* logits);
+  // Writes the unnormalized probabilities of the logits to probs_ and their
+  // sums per block to block_sums_, and returns their sum.
   template <typename T>
-  int32_t sample_argmax(T* probabilities);
+  float softmax(const T* logits);
+  int32_t sample_mult(float sum, float coin);
+  int32_t sample_topk_topp(float sum, float coin);
 
  private:
   int32_t vocab_size_;
   // reciprocal of temperature, or 0 if temperature == 0.
   float inv_temperature_;
   float topp_;
+  int32_t topk_;
+  float min_p_;
+  float repetition_penalty_ = 1.0f;
+  float frequency_penalty_ = 0.0f;
+  float presence_penalty_ = 0.0f;
   unsigned long long rng_state_;
+
+  // Scratch space, allocated on first use and reused for every sample.
+  std::vector<float> probs_;
+  std::vector<float> block_sums_;
+  std::vector<ProbIndex<float>> candidates_;
+  std::vector<int32_t> token_counts_;
 };
 
 } // namespace llm
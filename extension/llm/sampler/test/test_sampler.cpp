@@ -11,6 +11,11 @@
 #include <gtest/gtest.h>
 #include <torch/torch.h>
 
+#include <cmath>
+#include <limits>
+#include <set>
+#include <vector>
+
 using namespace ::testing;
 using ::executorch::extension::llm::Sampler;
 
@@ -39,3 +44,121 @@ TEST(SamplerTest, TestArgMaxWithFP16) {
   input[0][0][396] = 1.0f;
   EXPECT_EQ(sampler.sample(input.data_ptr<c10::Half>()), 396);
 }
+
+TEST(SamplerTest, TestSampleFollowsDistribution) {
+  Sampler sampler{
+      /*vocab_size*/ 4,
+      /*temperature*/ 1.0f,
+      /*topp*/ 1.0f,
+      /*rng_seed*/ 42};
+  const std::vector<float> logits = {
+      std::log(0.1f), std::log(0.2f), std::log(0.3f), std::log(0.4f)};
+  std::vector<int> counts(4, 0);
+  const int kSamples = 20000;
+  for (int i = 0; i < kSamples; i++) {
+    std::vector<float> input = logits;
+    counts[sampler.sample(input.data())]++;
+  }
+  for (int i = 0; i < 4; i++) {
+    EXPECT_NEAR(counts[i] / static_cast<double>(kSamples), 0.1 * (i + 1), 0.02);
+  }
+}
+
+TEST(SamplerTest, TestSampleSkipsMaskedLogits) {
+  Sampler sampler{
+      /*vocab_size*/ 4,
+      /*temperature*/ 1.0f,
+      /*topp*/ 1.0f,
+      /*rng_seed*/ 7};
+  const float inf = std::numeric_limits<float>::infinity();
+  for (int i = 0; i < 1000; i++) {
+    std::vector<float> input = {-inf, 0.5f, -inf, 1.0f};
+    const int32_t token = sampler.sample(input.data());
+    EXPECT_TRUE(token == 1 || token == 3);
+  }
+}
+
+TEST(SamplerTest, TestTopK) {
+  Sampler sampler{
+      /*vocab_size*/ 1000,
+      /*temperature*/ 1.0f,
+      /*topp*/ 1.0f,
+      /*rng_seed*/ 42,
+      /*topk*/ 3};
+  std::vector<float> input(1000);
+  for (int i = 0; i < 1000; i++) {
+    input[i] = (i % 10) * 0.1f;
+  }
+  input[17] = 5.0f;
+  input[512] = 5.0f;
+  input[999] = 5.0f;
+  std::set<int32_t> sampled;
+  for (int i = 0; i < 200; i++) {
+    sampled.insert(sampler.sample(input.data()));
+  }
+  EXPECT_EQ(sampled, (std::set<int32_t>{17, 512, 999}));
+}
+
+TEST(SamplerTest, TestTopP) {
+  Sampler sampler{
+      /*vocab_size*/ 128000,
+      /*temperature*/ 1.0f,
+      /*topp*/ 0.9f,
+      /*rng_seed*/ 42};
+  // Token 7 alone has more than 90% of the probability mass.
+  std::vector<float> input(128000, 0.0f);
+  input[7] = 15.0f;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(sampler.sample(input.data()), 7);
+  }
+}
+
+TEST(SamplerTest, TestMinP) {
+  Sampler sampler{
+      /*vocab_size*/ 100,
+      /*temperature*/ 1.0f,
+      /*topp*/ 1.0f,
+      /*rng_seed*/ 42,
+      /*topk*/ 0,
+      /*min_p*/ 0.5f};
+  // Tokens 3 and 4 are within a factor of 2 of the most likely token 5.
+  std::vector<float> input(100, 0.0f);
+  input[3] = 10.0f;
+  input[4] = 10.0f - std::log(1.2f);
+  input[5] = 10.0f + std::log(1.5f);
+  std::set<int32_t> sampled;
+  for (int i = 0; i < 200; i++) {
+    sampled.insert(sampler.sample(input.data()));
+  }
+  EXPECT_EQ(sampled, (std::set<int32_t>{3, 4, 5}));
+}
+
+TEST(SamplerTest, TestPenalties) {
+  Sampler sampler{
+      /*vocab_size*/ 8,
+      /*temperature*/ 0.0f,
+      /*topp*/ 0.9f,
+      /*rng_seed*/ 0};
+  std::vector<float> input = {0.0f, 2.0f, 1.8f, 1.0f, -1.0f, 0, 0, 0};
+  const std::vector<uint64_t> tokens = {1, 1, 4};
+  const executorch::runtime::ArrayRef<uint64_t> recent(
+      tokens.data(), tokens.size());
+
+  sampler.set_penalties(
+      /*repetition_penalty*/ 1.2f,
+      /*frequency_penalty*/ 0.0f,
+      /*presence_penalty*/ 0.0f);
+  EXPECT_EQ(sampler.sample(input.data(), recent), 2);
+  EXPECT_FLOAT_EQ(input[1], 2.0f / 1.2f);
+  EXPECT_FLOAT_EQ(input[4], -1.2f);
+
+  input = {0.0f, 2.0f, 1.8f, 1.0f, -1.0f, 0, 0, 0};
+  sampler.set_penalties(
+      /*repetition_penalty*/ 1.0f,
+      /*frequency_penalty*/ 0.5f,
+      /*presence_penalty*/ 0.25f);
+  EXPECT_EQ(sampler.sample(input.data(), recent), 2);
+  EXPECT_FLOAT_EQ(input[1], 2.0f - 2 * 0.5f - 0.25f);
+  EXPECT_FLOAT_EQ(input[4], -1.0f - 0.5f - 0.25f);
+  EXPECT_FLOAT_EQ(input[2], 1.8f);
+}
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <executorch/runtime/core/result.h>
+#include <executorch/runtime/platform/log.h>
+
+namespace executorch {
+namespace extension {
+
+/**
+ * A thread-safe pool of memory-planned buffers that can be shared by several
+ * Modules.
+ *
+ * Buffers are handed out by size class and go back to the pool when their
+ * Buffer handle is destroyed, so repeatedly loading and unloading methods
+ * reuses already-resident pages instead of going back to the heap. On Linux,
+ * blocks of at least `kHugePageSize` bytes are mapped directly and advised to
+ * use transparent huge pages.
+ *
+ * Subclasses can change how blocks are obtained from the system by overriding
+ * allocate_block() and free_block().
+ */
+class PlannedMemoryPool {
+ public:
+  /// The alignment of every buffer returned by the pool.
+  static constexpr size_t kAlignment = 64;
+  /// The smallest size class. Smaller requests are rounded up to this size.
+  static constexpr size_t kMinBlockSize = 4 * 1024;
+  /// Blocks at least this large are candidates for huge-page backing.
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+  /**
+   * Usage counters for the pool. All sizes are in bytes and are based on
+   * size-class-rounded block sizes.
+   */
+  struct Stats {
+    /// Bytes currently held by the pool, both handed out and cached.
+    size_t resident_bytes = 0;
+    /// Bytes currently handed out to callers.
+    size_t in_use_bytes = 0;
+    /// The maximum value that `in_use_bytes` has reached.
+    size_t peak_in_use_bytes = 0;
+    /// The maximum value that `resident_bytes` has reached.
+    size_t peak_resident_bytes = 0;
+    /// Number of successful acquire() calls.
+    uint64_t acquisitions = 0;
+    /// Number of acquire() calls satisfied by a cached block.
+    uint64_t reuses = 0;
+
+    /// Returns the fraction of acquisitions served from the cache.
+    double reuse_rate() const {
+      return acquisitions == 0
+          ? 0.0
+          : static_cast<double>(reuses) / static_cast<double>(acquisitions);
+    }
+  };
+
+  /**
+   * A move-only handle to a buffer owned by a PlannedMemoryPool. The buffer is
+   * returned to the pool when the handle is destroyed. The pool must outlive
+   * all of its handles.
+   */
+  class Buffer final {
+   public:
+    Buffer() = default;
+
+    Buffer(Buffer&& rhs) noexcept
+        : pool_(rhs.pool_),
+          data_(rhs.data_),
+          size_(rhs.size_),
+          block_size_(rhs.block_size_) {
+      rhs.pool_ = nullptr;
+      rhs.data_ = nullptr;
+      rhs.size_ = 0;
+      rhs.block_size_ = 0;
+    }
+
+    Buffer& operator=(Buffer&& rhs) noexcept {
+      if (this != &rhs) {
+        reset();
+        pool_ = rhs.pool_;
+        data_ = rhs.data_;
+        size_ = rhs.size_;
+        block_size_ = rhs.block_size_;
+        rhs.pool_ = nullptr;
+        rhs.data_ = nullptr;
+        rhs.size_ = 0;
+        rhs.block_size_ = 0;
+      }
+      return *this;
+    }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    ~Buffer() {
+      reset();
+    }
+
+    /// Returns the buffer data, or nullptr if the handle is empty.
+    uint8_t* data() const {
+      return static_cast<uint8_t*>(data_);
+    }
+
+    /// Returns the requested size of the buffer in bytes.
+    size_t size() const {
+      return size_;
+    }
+
+    /// Returns the buffer to its pool and leaves the handle empty.
+    void reset() {
+      if (pool_ != nullptr && data_ != nullptr) {
+        pool_->release(data_, block_size_);
+      }
+      pool_ = nullptr;
+      data_ = nullptr;
+      size_ = 0;
+      block_size_ = 0;
+    }
+
+   private:
+    friend class PlannedMemoryPool;
+
+    Buffer(
+        PlannedMemoryPool* pool,
+        void* data,
+        size_t size,
+        size_t block_size)
+        : pool_(pool), data_(data), size_(size), block_size_(block_size) {}
+
+    PlannedMemoryPool* pool_ = nullptr;
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    size_t block_size_ = 0;
+  };
+
+  /**
+   * Constructs an empty pool.
+   *
+   * @param[in] max_cached_bytes The maximum number of bytes to keep cached
+   *     for reuse. Released blocks that would exceed this budget are freed
+   *     immediately.
+   * @param[in] use_huge_pages Whether to request huge-page backing for large
+   *     blocks where the platform supports it.
+   */
+  explicit PlannedMemoryPool(
+      size_t max_cached_bytes = std::numeric_limits<size_t>::max(),
+      bool use_huge_pages = true)
+      : max_cached_bytes_(max_cached_bytes), use_huge_pages_(use_huge_pages) {}
+
+  PlannedMemoryPool(const PlannedMemoryPool&) = delete;
+  PlannedMemoryPool& operator=(const PlannedMemoryPool&) = delete;
+  PlannedMemoryPool(PlannedMemoryPool&&) = delete;
+  PlannedMemoryPool& operator=(PlannedMemoryPool&&) = delete;
+
+  /**
+   * Frees all cached blocks. Subclasses that override free_block() must call
+   * trim() in their own destructor, since their override is no longer
+   * reachable from this one.
+   */
+  virtual ~PlannedMemoryPool() {
+    trim();
+  }
+
+  /**
+   * Returns the block size that a request of `size` bytes is rounded up to.
+   * Each power-of-two range is split into four classes, so at most a quarter
+   * of a block is wasted.
+   */
+  static size_t size_class(size_t size) {
+    if (size <= kMinBlockSize) {
+      return kMinBlockSize;
+    }
+    size_t power = kMinBlockSize;
+    while (power * 2 < size) {
+      power *= 2;
+    }
+    const size_t step = power / 4;
+    return (size + step - 1) / step * step;
+  }
+
+  /**
+   * Hands out a zero-filled buffer of at least `size` bytes, aligned to
+   * `kAlignment`.
+   *
+   * @param[in] size The number of bytes required.
+   *
+   * @returns A handle to the buffer, or Error::MemoryAllocationFailed.
+   */
+  runtime::Result<Buffer> acquire(size_t size) {
+    const size_t block_size = size_class(size);
+    void* data = nullptr;
+    bool reused = false;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto it = free_blocks_.find(block_size);
+      if (it != free_blocks_.end() && !it->second.empty()) {
+        data = it->second.back();
+        it->second.pop_back();
+        cached_bytes_ -= block_size;
+        reused = true;
+      }
+    }
+    if (data == nullptr) {
+      data = allocate_block(block_size);
+      if (data == nullptr) {
+        ET_LOG(Error, "Failed to allocate planned block of %zu", block_size);
+        return runtime::Error::MemoryAllocationFailed;
+      }
+    }
+    if (reused || !block_is_zeroed(block_size)) {
+      // Planned memory from the heap has always started out zeroed; keep that
+      // behavior for recycled blocks so that stateful buffers don't observe
+      // the contents of a previous owner.
+      std::memset(data, 0, size);
+    }
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stats_.acquisitions += 1;
+      stats_.reuses += reused ? 1 : 0;
+      stats_.in_use_bytes += block_size;
+      if (!reused) {
+        stats_.resident_bytes += block_size;
+      }
+      stats_.peak_in_use_bytes =
+          std::max(stats_.peak_in_use_bytes, stats_.in_use_bytes);
+      stats_.peak_resident_bytes =
+          std::max(stats_.peak_resident_bytes, stats_.resident_bytes);
+    }
+    return Buffer(this, data, size, block_size);
+  }
+
+  /// Returns a snapshot of the pool counters.
+  Stats stats() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return stats_;
+  }
+
+  /// Frees all cached blocks that are not currently handed out.
+  void trim() {
+    std::unordered_map<size_t, std::vector<void*>> blocks;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      blocks.swap(free_blocks_);
+      stats_.resident_bytes -= cached_bytes_;
+      cached_bytes_ = 0;
+    }
+    for (auto& entry : blocks) {
+      for (void* data : entry.second) {
+        free_block(data, entry.first);
+      }
+    }
+  }
+
+ protected:
+  /**
+   * Obtains a new block of `block_size` bytes from the system. Must return
+   * memory aligned to at least `kAlignment`, or nullptr on failure.
+   */
+  virtual void* allocate_block(size_t block_size) {
+#if defined(__linux__)
+    if (block_size >= kHugePageSize) {
+      void* data = ::mmap(
+          nullptr,
+          block_size,
+          PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS,
+          -1,
+          0);
+      if (data == MAP_FAILED) {
+        return nullptr;
+      }
+#if defined(MADV_HUGEPAGE)
+      if (use_huge_pages_) {
+        // Best effort: transparent huge pages may be disabled system-wide.
+        ::madvise(data, block_size, MADV_HUGEPAGE);
+      }
+#endif
+      return data;
+    }
+#endif
+    return ::operator new(
+        block_size, std::align_val_t(kAlignment), std::nothrow);
+  }
+
+  /// Returns a block obtained from allocate_block() to the system.
+  virtual void free_block(void* data, size_t block_size) {
+#if defined(__linux__)
+    if (block_size >= kHugePageSize) {
+      ::munmap(data, block_size);
+      return;
+    }
+#endif
+    ::operator delete(data, std::align_val_t(kAlignment));
+  }
+
+  /**
+   * Returns true if fresh blocks of `block_size` bytes from allocate_block()
+   * are already zero-filled.
+   */
+  virtual bool block_is_zeroed(size_t block_size) const {
+#if defined(__linux__)
+    return block_size >= kHugePageSize;
+#else
+    (void)block_size;
+    return false;
+#endif
+  }
+
+ private:
+  void release(void* data, size_t block_size) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stats_.in_use_bytes -= block_size;
+      if (cached_bytes_ + block_size <= max_cached_bytes_) {
+        free_blocks_[block_size].push_back(data);
+        cached_bytes_ += block_size;
+        return;
+      }
+      stats_.resident_bytes -= block_size;
+    }
+    free_block(data, block_size);
+  }
+
+  const size_t max_cached_bytes_;
+  const bool use_huge_pages_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<void*>> free_blocks_;
+  size_t cached_bytes_ = 0;
+  Stats stats_;
+};
+
+} // namespace extension
+} // namespace executorch
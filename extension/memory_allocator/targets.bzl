@@ -20,3 +20,19 @@ def define_common_targets():
             "@EXECUTORCH_CLIENTS",
         ],
     )
+
+    runtime.cxx_library(
+        name = "planned_memory_pool",
+        exported_headers = [
+            "planned_memory_pool.h",
+        ],
+        exported_deps = [
+            "//executorch/runtime/core:core",
+            "//executorch/runtime/platform:platform",
+        ],
+        visibility = [
+            "//executorch/extension/memory_allocator/test/...",
+            "//executorch/extension/module/...",
+            "@EXECUTORCH_CLIENTS",
+        ],
+    )
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/memory_allocator/planned_memory_pool.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using executorch::extension::PlannedMemoryPool;
+using executorch::runtime::Error;
+
+class PlannedMemoryPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+};
+
+TEST_F(PlannedMemoryPoolTest, SizeClasses) {
+  EXPECT_EQ(PlannedMemoryPool::size_class(1), PlannedMemoryPool::kMinBlockSize);
+  EXPECT_EQ(
+      PlannedMemoryPool::size_class(PlannedMemoryPool::kMinBlockSize),
+      PlannedMemoryPool::kMinBlockSize);
+  // 4097 is in the (4 KiB, 8 KiB] range, whose classes are 1 KiB apart.
+  EXPECT_EQ(PlannedMemoryPool::size_class(4097), 5 * 1024);
+  EXPECT_EQ(PlannedMemoryPool::size_class(8 * 1024), 8 * 1024);
+  EXPECT_EQ(PlannedMemoryPool::size_class(1000000), 1048576);
+
+  // Never wastes more than a quarter of the block.
+  for (size_t size = 1; size < (64 << 20); size = size * 3 / 2 + 1) {
+    const size_t block = PlannedMemoryPool::size_class(size);
+    EXPECT_GE(block, size);
+    if (size > PlannedMemoryPool::kMinBlockSize) {
+      EXPECT_LE(block - size, block / 4) << "size " << size;
+    }
+  }
+}
+
+TEST_F(PlannedMemoryPoolTest, AcquireIsAlignedAndZeroed) {
+  PlannedMemoryPool pool;
+  for (size_t size : {16, 5000, 3 << 20}) {
+    auto buffer = pool.acquire(size);
+    ASSERT_EQ(buffer.error(), Error::Ok);
+    EXPECT_EQ(buffer->size(), size);
+    EXPECT_EQ(
+        reinterpret_cast<uintptr_t>(buffer->data()) %
+            PlannedMemoryPool::kAlignment,
+        0);
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(buffer->data()[i], 0);
+    }
+    // Dirty the buffer so that a recycled block would be noticed below.
+    std::memset(buffer->data(), 0xAB, size);
+  }
+
+  // Recycled blocks are cleared before they are handed out again.
+  auto buffer = pool.acquire(5000);
+  ASSERT_EQ(buffer.error(), Error::Ok);
+  for (size_t i = 0; i < 5000; ++i) {
+    ASSERT_EQ(buffer->data()[i], 0);
+  }
+}
+
+TEST_F(PlannedMemoryPoolTest, ReleasedBuffersAreReused) {
+  PlannedMemoryPool pool;
+  uint8_t* first_data = nullptr;
+  {
+    auto buffer = pool.acquire(10000);
+    ASSERT_EQ(buffer.error(), Error::Ok);
+    first_data = buffer->data();
+  }
+  // Same size class, so the cached block is handed out again.
+  auto buffer = pool.acquire(9000);
+  ASSERT_EQ(buffer.error(), Error::Ok);
+  EXPECT_EQ(buffer->data(), first_data);
+
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.acquisitions, 2);
+  EXPECT_EQ(stats.reuses, 1);
+  EXPECT_DOUBLE_EQ(stats.reuse_rate(), 0.5);
+  EXPECT_EQ(stats.in_use_bytes, PlannedMemoryPool::size_class(10000));
+  EXPECT_EQ(stats.resident_bytes, PlannedMemoryPool::size_class(10000));
+}
+
+TEST_F(PlannedMemoryPoolTest, StatsTrackPeakAndResident) {
+  PlannedMemoryPool pool;
+  const size_t block = PlannedMemoryPool::size_class(20000);
+  {
+    auto a = pool.acquire(20000);
+    auto b = pool.acquire(20000);
+    ASSERT_EQ(a.error(), Error::Ok);
+    ASSERT_EQ(b.error(), Error::Ok);
+    EXPECT_EQ(pool.stats().in_use_bytes, 2 * block);
+  }
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.in_use_bytes, 0);
+  EXPECT_EQ(stats.peak_in_use_bytes, 2 * block);
+  EXPECT_EQ(stats.resident_bytes, 2 * block);
+
+  pool.trim();
+  stats = pool.stats();
+  EXPECT_EQ(stats.resident_bytes, 0);
+  EXPECT_EQ(stats.peak_resident_bytes, 2 * block);
+}
+
+TEST_F(PlannedMemoryPoolTest, CacheBudgetIsRespected) {
+  const size_t block = PlannedMemoryPool::size_class(20000);
+  PlannedMemoryPool pool(/*max_cached_bytes=*/block);
+  {
+    auto a = pool.acquire(20000);
+    auto b = pool.acquire(20000);
+    ASSERT_EQ(a.error(), Error::Ok);
+    ASSERT_EQ(b.error(), Error::Ok);
+  }
+  // Only one of the two released blocks fits in the cache.
+  EXPECT_EQ(pool.stats().resident_bytes, block);
+}
+
+TEST_F(PlannedMemoryPoolTest, MovedBufferIsReleasedOnce) {
+  PlannedMemoryPool pool;
+  {
+    auto buffer = pool.acquire(1024);
+    ASSERT_EQ(buffer.error(), Error::Ok);
+    PlannedMemoryPool::Buffer moved(std::move(buffer.get()));
+    EXPECT_EQ(buffer->data(), nullptr);
+    EXPECT_NE(moved.data(), nullptr);
+  }
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.in_use_bytes, 0);
+  EXPECT_EQ(stats.resident_bytes, PlannedMemoryPool::kMinBlockSize);
+}
+
+TEST_F(PlannedMemoryPoolTest, ConcurrentAcquireRelease) {
+  PlannedMemoryPool pool;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool]() {
+      for (int i = 0; i < 100; ++i) {
+        auto buffer = pool.acquire(4096 * (1 + i % 3));
+        ASSERT_EQ(buffer.error(), Error::Ok);
+        buffer->data()[0] = 1;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.acquisitions, 400);
+  EXPECT_EQ(stats.in_use_bytes, 0);
+  EXPECT_GT(stats.reuses, 0);
+}
@@ -15,3 +15,13 @@ def define_common_targets():
             "//executorch/extension/memory_allocator:malloc_memory_allocator",
         ],
     )
+
+    runtime.cxx_test(
+        name = "planned_memory_pool_test",
+        srcs = [
+            "planned_memory_pool_test.cpp",
+        ],
+        deps = [
+            "//executorch/extension/memory_allocator:planned_memory_pool",
+        ],
+    )
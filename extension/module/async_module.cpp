@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/async_module.h>
+
+#include <algorithm>
+
+#include <executorch/extension/memory_allocator/malloc_memory_allocator.h>
+
+namespace executorch {
+namespace extension {
+namespace ET_MODULE_NAMESPACE {
+
+namespace {
+runtime::Error stage_inputs(
+    Method& method,
+    const std::vector<runtime::EValue>& inputs) {
+  ET_CHECK_OR_RETURN_ERROR(
+      inputs.size() == method.inputs_size(),
+      InvalidArgument,
+      "input size: %zu does not match method input size: %zu",
+      inputs.size(),
+      method.inputs_size());
+  return method.set_inputs(
+      executorch::aten::ArrayRef<runtime::EValue>(inputs.data(), inputs.size()));
+}
+} // namespace
+
+AsyncModule::Response::Response(
+    AsyncModule* owner,
+    Instance* instance,
+    runtime::Error error,
+    std::vector<runtime::EValue> outputs)
+    : owner_(owner),
+      instance_(instance),
+      error_(error),
+      outputs_(std::move(outputs)) {}
+
+AsyncModule::Response::Response(Response&& rhs) noexcept
+    : owner_(rhs.owner_),
+      instance_(rhs.instance_),
+      error_(rhs.error_),
+      outputs_(std::move(rhs.outputs_)) {
+  rhs.owner_ = nullptr;
+  rhs.instance_ = nullptr;
+}
+
+AsyncModule::Response& AsyncModule::Response::operator=(
+    Response&& rhs) noexcept {
+  if (this != &rhs) {
+    release();
+    owner_ = rhs.owner_;
+    instance_ = rhs.instance_;
+    error_ = rhs.error_;
+    outputs_ = std::move(rhs.outputs_);
+    rhs.owner_ = nullptr;
+    rhs.instance_ = nullptr;
+  }
+  return *this;
+}
+
+AsyncModule::Response::~Response() {
+  release();
+}
+
+void AsyncModule::Response::release() {
+  // The outputs point into the instance's memory; drop them first.
+  outputs_.clear();
+  if (owner_ != nullptr && instance_ != nullptr) {
+    owner_->release(instance_);
+  }
+  owner_ = nullptr;
+  instance_ = nullptr;
+}
+
+AsyncModule::AsyncModule(
+    std::unique_ptr<Module> module,
+    size_t num_workers,
+    size_t instances_per_method)
+    : module_(std::move(module)),
+      instances_per_method_(
+          instances_per_method > 0 ? instances_per_method
+                                   : 2 * std::max<size_t>(num_workers, 1)) {
+  const size_t worker_count = std::max<size_t>(num_workers, 1);
+  workers_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+AsyncModule::~AsyncModule() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+runtime::Error AsyncModule::load_method(const std::string& method_name) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return load_method_locked(method_name);
+}
+
+runtime::Error AsyncModule::load_method_locked(const std::string& method_name) {
+  if (methods_.count(method_name) > 0) {
+    return runtime::Error::Ok;
+  }
+  // Load the method once through the Module so that kernels are resolved a
+  // single time, then create the instances from it.
+  ET_CHECK_OK_OR_RETURN_ERROR(module_->load_method(method_name));
+  auto prototype = ET_UNWRAP(module_->method(method_name));
+
+  MethodInstances instances;
+  instances.all.reserve(instances_per_method_);
+  instances.idle.reserve(instances_per_method_);
+  for (size_t i = 0; i < instances_per_method_; ++i) {
+    auto instance = create_instance(*prototype, method_name);
+    if (!instance.ok()) {
+      return instance.error();
+    }
+    instances.idle.push_back(instance.get().get());
+    instances.all.push_back(std::move(instance.get()));
+  }
+  // The instances don't depend on the prototype once they are loaded.
+  module_->unload_method(method_name);
+  methods_.emplace(method_name, std::move(instances));
+  return runtime::Error::Ok;
+}
+
+runtime::Result<std::unique_ptr<AsyncModule::Instance>>
+AsyncModule::create_instance(
+    const Method& prototype,
+    const std::string& method_name) {
+  auto instance = std::make_unique<Instance>();
+  instance->method_name = method_name;
+  instance->method_allocator = std::make_unique<MallocMemoryAllocator>();
+  instance->temp_allocator = std::make_unique<MallocMemoryAllocator>();
+
+  const auto program = module_->program();
+  const auto method_metadata =
+      ET_UNWRAP(program->method_meta(method_name.c_str()));
+  const auto planned_buffers_count =
+      method_metadata.num_memory_planned_buffers();
+  const auto pool = module_->planned_memory_pool();
+  instance->planned_spans.reserve(planned_buffers_count);
+  for (size_t index = 0; index < planned_buffers_count; ++index) {
+    const auto buffer_size =
+        method_metadata.memory_planned_buffer_size(index).get();
+    if (pool) {
+      auto buffer = pool->acquire(buffer_size);
+      if (!buffer.ok()) {
+        return buffer.error();
+      }
+      instance->pooled_buffers.emplace_back(std::move(buffer.get()));
+      instance->planned_spans.emplace_back(
+          instance->pooled_buffers.back().data(), buffer_size);
+    } else {
+      instance->planned_buffers.emplace_back(buffer_size);
+      instance->planned_spans.emplace_back(
+          instance->planned_buffers.back().data(), buffer_size);
+    }
+  }
+  instance->planned_memory =
+      std::make_unique<runtime::HierarchicalAllocator>(runtime::Span(
+          instance->planned_spans.data(), instance->planned_spans.size()));
+  instance->memory_manager = std::make_unique<runtime::MemoryManager>(
+      instance->method_allocator.get(),
+      instance->planned_memory.get(),
+      instance->temp_allocator.get());
+
+  auto method = program->load_method_instance(
+      prototype,
+      instance->memory_manager.get(),
+      /*event_tracer=*/nullptr,
+      module_->data_map_.get());
+  if (!method.ok()) {
+    return method.error();
+  }
+  instance->method = std::make_unique<Method>(std::move(method.get()));
+  return instance;
+}
+
+runtime::Error AsyncModule::execute_async(
+    const std::string& method_name,
+    std::vector<runtime::EValue> input_values,
+    Callback callback) {
+  ET_CHECK_OR_RETURN_ERROR(
+      callback != nullptr, InvalidArgument, "callback must not be empty");
+  Request request;
+  request.method_name = method_name;
+  request.inputs = std::move(input_values);
+  request.callback = std::move(callback);
+  return submit(std::move(request));
+}
+
+std::future<AsyncModule::Response> AsyncModule::execute_async(
+    const std::string& method_name,
+    std::vector<runtime::EValue> input_values) {
+  auto promise = std::make_shared<std::promise<Response>>();
+  auto future = promise->get_future();
+  Request request;
+  request.method_name = method_name;
+  request.inputs = std::move(input_values);
+  request.promise = promise;
+  const auto error = submit(std::move(request));
+  if (error != runtime::Error::Ok) {
+    promise->set_value(Response(this, nullptr, error, {}));
+  }
+  return future;
+}
+
+runtime::Error AsyncModule::submit(Request request) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ET_CHECK_OR_RETURN_ERROR(
+      !stopping_, InvalidState, "AsyncModule is shutting down");
+  ET_CHECK_OK_OR_RETURN_ERROR(load_method_locked(request.method_name));
+  auto& instances = methods_.at(request.method_name);
+  if (instances.unstaged == 0 && !instances.idle.empty()) {
+    // Stage the inputs here, while the workers are busy with earlier
+    // requests. Queue the request first so that it keeps its place.
+    request.instance = instances.idle.back();
+    instances.idle.pop_back();
+    request.staging = true;
+    queue_.push_back(std::move(request));
+    Request& queued = queue_.back();
+    lock.unlock();
+    const auto error = stage_inputs(*queued.instance->method, queued.inputs);
+    lock.lock();
+    queued.staging = false;
+    if (error != runtime::Error::Ok) {
+      // Workers drop the cancelled request; the instance is free again.
+      queued.cancelled = true;
+      instances.idle.push_back(queued.instance);
+      queued.instance = nullptr;
+      lock.unlock();
+      instance_available_.notify_all();
+      work_available_.notify_all();
+      return error;
+    }
+  } else {
+    instances.unstaged += 1;
+    queue_.push_back(std::move(request));
+  }
+  lock.unlock();
+  // Workers wait on a request that is still being staged, so wake all of them
+  // rather than one that may go back to sleep.
+  work_available_.notify_all();
+  return runtime::Error::Ok;
+}
+
+void AsyncModule::worker_loop() {
+  while (true) {
+    Request request;
+    bool staged = true;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // Requests are taken in submission order, so wait for the one at the
+      // front to be staged.
+      work_available_.wait(lock, [this]() {
+        return queue_.empty() ? stopping_ : !queue_.front().staging;
+      });
+      if (queue_.empty()) {
+        // Stopping, and every queued request has been served.
+        return;
+      }
+      request = std::move(queue_.front());
+      queue_.pop_front();
+      if (request.cancelled) {
+        continue;
+      }
+      if (request.instance == nullptr) {
+        auto& instances = methods_.at(request.method_name);
+        instance_available_.wait(
+            lock, [&instances]() { return !instances.idle.empty(); });
+        request.instance = instances.idle.back();
+        instances.idle.pop_back();
+        instances.unstaged -= 1;
+        staged = false;
+      }
+    }
+    Method& method = *request.instance->method;
+    auto error = runtime::Error::Ok;
+    if (!staged) {
+      error = stage_inputs(method, request.inputs);
+    }
+    if (error == runtime::Error::Ok) {
+      error = method.execute();
+    }
+    std::vector<runtime::EValue> outputs;
+    if (error == runtime::Error::Ok) {
+      outputs.resize(method.outputs_size());
+      error = method.get_outputs(outputs.data(), outputs.size());
+      if (error != runtime::Error::Ok) {
+        outputs.clear();
+      }
+    }
+    complete(request, error, std::move(outputs));
+  }
+}
+
+void AsyncModule::complete(
+    Request& request,
+    runtime::Error error,
+    std::vector<runtime::EValue> outputs) {
+  if (request.callback) {
+    request.callback(error, outputs);
+    outputs.clear();
+    release(request.instance);
+  } else {
+    // The Response keeps the instance until it is destroyed.
+    request.promise->set_value(
+        Response(this, request.instance, error, std::move(outputs)));
+  }
+  request.instance = nullptr;
+}
+
+void AsyncModule::release(Instance* instance) {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    methods_.at(instance->method_name).idle.push_back(instance);
+  }
+  instance_available_.notify_all();
+}
+
+} // namespace ET_MODULE_NAMESPACE
+} // namespace extension
+} // namespace executorch
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <executorch/extension/module/module.h>
+
+namespace executorch {
+namespace extension {
+namespace ET_MODULE_NAMESPACE {
+
+/**
+ * Executes methods of a Module asynchronously on a set of managed worker
+ * threads.
+ *
+ * Requests are queued and served in submission order. Each method gets a fixed
+ * number of independent instances, created with
+ * Program::load_method_instance(), so that several requests for the same
+ * method can run concurrently. When an instance is idle at submission time,
+ * the request's inputs are staged into it on the submitting thread, which
+ * overlaps input copies for the next request with the execution of the
+ * current ones.
+ *
+ * Input tensors that are not memory-planned are aliased rather than copied,
+ * so their data must stay valid until the request completes.
+ */
+class AsyncModule final {
+ private:
+  struct Instance;
+
+ public:
+  /**
+   * The result of a request submitted with the future-based execute_async().
+   *
+   * The outputs point into the memory of the method instance that ran the
+   * request. That instance is not reused until the Response is destroyed, so
+   * release Responses promptly: if all instances of a method are held by
+   * Responses, later requests for that method wait. A Response must not
+   * outlive the AsyncModule that produced it.
+   */
+  class Response final {
+   public:
+    Response(Response&& rhs) noexcept;
+    Response& operator=(Response&& rhs) noexcept;
+    Response(const Response&) = delete;
+    Response& operator=(const Response&) = delete;
+    ~Response();
+
+    /// Returns the status of the request.
+    runtime::Error error() const {
+      return error_;
+    }
+
+    /// Returns true if the request succeeded.
+    bool ok() const {
+      return error_ == runtime::Error::Ok;
+    }
+
+    /// Returns the method outputs. Empty if the request failed.
+    const std::vector<runtime::EValue>& outputs() const {
+      return outputs_;
+    }
+
+   private:
+    friend class AsyncModule;
+
+    Response(
+        AsyncModule* owner,
+        Instance* instance,
+        runtime::Error error,
+        std::vector<runtime::EValue> outputs);
+
+    void release();
+
+    AsyncModule* owner_;
+    Instance* instance_;
+    runtime::Error error_;
+    std::vector<runtime::EValue> outputs_;
+  };
+
+  /**
+   * Invoked on a worker thread when a request completes. The outputs are only
+   * valid for the duration of the call.
+   */
+  using Callback = std::function<void(
+      runtime::Error error,
+      const std::vector<runtime::EValue>& outputs)>;
+
+  /**
+   * Constructs an instance that executes methods of `module`.
+   *
+   * @param[in] module The Module to load the program, external data and
+   *     planned memory pool from. Its event tracer is not used, since event
+   *     tracers are not thread-safe.
+   * @param[in] num_workers The number of threads executing requests.
+   * @param[in] instances_per_method The number of concurrently usable
+   *     instances of each method. Defaults to twice `num_workers`, which
+   *     leaves room for staging inputs while every worker is busy.
+   */
+  explicit AsyncModule(
+      std::unique_ptr<Module> module,
+      size_t num_workers = 2,
+      size_t instances_per_method = 0);
+
+  AsyncModule(const AsyncModule&) = delete;
+  AsyncModule& operator=(const AsyncModule&) = delete;
+  AsyncModule(AsyncModule&&) = delete;
+  AsyncModule& operator=(AsyncModule&&) = delete;
+
+  /**
+   * Finishes all queued requests, then stops the workers. All Responses must
+   * have been destroyed before this is called.
+   */
+  ~AsyncModule();
+
+  /**
+   * Loads all instances of a method ahead of the first request. Otherwise
+   * they are loaded by the first request for the method.
+   *
+   * @param[in] method_name The name of the method to load.
+   *
+   * @returns An Error to indicate success or failure.
+   */
+  ET_NODISCARD runtime::Error load_method(const std::string& method_name);
+
+  /**
+   * Queues a method for execution and reports the result through a callback.
+   *
+   * @param[in] method_name The name of the method to execute.
+   * @param[in] input_values The input values to pass to the method.
+   * @param[in] callback Invoked on a worker thread when the request completes,
+   *     including when it fails after being queued.
+   *
+   * @returns Error::Ok if the request was queued, in which case the callback
+   * will be invoked exactly once; otherwise an error, and the callback is not
+   * invoked.
+   */
+  ET_NODISCARD runtime::Error execute_async(
+      const std::string& method_name,
+      std::vector<runtime::EValue> input_values,
+      Callback callback);
+
+  /**
+   * Queues a method for execution and reports the result through a future.
+   *
+   * @param[in] method_name The name of the method to execute.
+   * @param[in] input_values The input values to pass to the method.
+   *
+   * @returns A future that becomes ready when the request completes.
+   */
+  std::future<Response> execute_async(
+      const std::string& method_name,
+      std::vector<runtime::EValue> input_values);
+
+  /// Returns the number of worker threads.
+  size_t num_workers() const {
+    return workers_.size();
+  }
+
+  /// Returns the number of instances created for each method.
+  size_t instances_per_method() const {
+    return instances_per_method_;
+  }
+
+ private:
+  struct Instance {
+    std::unique_ptr<runtime::MemoryAllocator> method_allocator;
+    std::unique_ptr<runtime::MemoryAllocator> temp_allocator;
+    std::vector<std::vector<uint8_t>> planned_buffers;
+    std::vector<PlannedMemoryPool::Buffer> pooled_buffers;
+    std::vector<runtime::Span<uint8_t>> planned_spans;
+    std::unique_ptr<runtime::HierarchicalAllocator> planned_memory;
+    std::unique_ptr<runtime::MemoryManager> memory_manager;
+    std::unique_ptr<Method> method;
+    std::string method_name;
+  };
+
+  struct MethodInstances {
+    std::vector<std::unique_ptr<Instance>> all;
+    std::vector<Instance*> idle;
+    // Queued requests that still need an instance. While non-zero, new
+    // requests are not staged at submission so that they can't overtake them.
+    size_t unstaged = 0;
+  };
+
+  struct Request {
+    std::string method_name;
+    std::vector<runtime::EValue> inputs;
+    // Set if the inputs are staged into an instance at submission.
+    Instance* instance = nullptr;
+    // True while the submitting thread stages the inputs. The request keeps
+    // its place in the queue, but workers don't take it until it is staged.
+    bool staging = false;
+    // Set if staging failed; the request is dropped from the queue without
+    // being run.
+    bool cancelled = false;
+    Callback callback;
+    std::shared_ptr<std::promise<Response>> promise;
+  };
+
+  runtime::Error load_method_locked(const std::string& method_name);
+  runtime::Result<std::unique_ptr<Instance>> create_instance(
+      const Method& prototype,
+      const std::string& method_name);
+  runtime::Error submit(Request request);
+  void worker_loop();
+  void complete(
+      Request& request,
+      runtime::Error error,
+      std::vector<runtime::EValue> outputs);
+  void release(Instance* instance);
+
+  std::unique_ptr<Module> module_;
+  const size_t instances_per_method_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable instance_available_;
+  // Requests in submission order. push_back() and pop_front() don't move the
+  // other elements, so a submitter can keep a reference to its request while
+  // it stages the inputs.
+  std::deque<Request> queue_;
+  std::unordered_map<std::string, MethodInstances> methods_;
+  bool stopping_ = false;
+
+  std::vector<std::thread> workers_;
+};
+
+} // namespace ET_MODULE_NAMESPACE
+} // namespace extension
+} // namespace executorch
+
+namespace executorch {
+namespace extension {
+using ::executorch::extension::ET_MODULE_NAMESPACE::AsyncModule;
+} // namespace extension
+} // namespace executorch
@@ -199,15 +199,29 @@ runtime::Error Module::load_method(
           ET_UNWRAP(program_->method_meta(method_name.c_str()));
       const auto planned_buffers_count =
           method_metadata.num_memory_planned_buffers();
-      method_holder.planned_buffers.reserve(planned_buffers_count);
       method_holder.planned_spans.reserve(planned_buffers_count);
+      if (planned_memory_pool_) {
+        method_holder.pooled_buffers.reserve(planned_buffers_count);
+      } else {
+        method_holder.planned_buffers.reserve(planned_buffers_count);
+      }
 
       for (auto index = 0; index < planned_buffers_count; ++index) {
         const auto buffer_size =
             method_metadata.memory_planned_buffer_size(index).get();
-        method_holder.planned_buffers.emplace_back(buffer_size);
-        method_holder.planned_spans.emplace_back(
-            method_holder.planned_buffers.back().data(), buffer_size);
+        if (planned_memory_pool_) {
+          auto buffer = planned_memory_pool_->acquire(buffer_size);
+          if (!buffer.ok()) {
+            return buffer.error();
+          }
+          method_holder.pooled_buffers.emplace_back(std::move(buffer.get()));
+          method_holder.planned_spans.emplace_back(
+              method_holder.pooled_buffers.back().data(), buffer_size);
+        } else {
+          method_holder.planned_buffers.emplace_back(buffer_size);
+          method_holder.planned_spans.emplace_back(
+              method_holder.planned_buffers.back().data(), buffer_size);
+        }
       }
       method_holder.planned_memory =
           std::make_unique<runtime::HierarchicalAllocator>(runtime::Span(
@@ -238,6 +252,22 @@ ET_NODISCARD runtime::Result<Method*> Module::method(
   return methods_[method_name].method.get();
 }
 
+runtime::Result<std::vector<runtime::Span<uint8_t>>> Module::planned_buffers(
+    const std::string& method_name) {
+  auto it = methods_.find(method_name);
+  ET_CHECK_OR_RETURN_ERROR(
+      it != methods_.end(),
+      InvalidArgument,
+      "method not loaded: %s",
+      method_name.c_str());
+  ET_CHECK_OR_RETURN_ERROR(
+      it->second.planned_memory != nullptr,
+      NotSupported,
+      "method %s uses caller-provided planned memory",
+      method_name.c_str());
+  return it->second.planned_spans;
+}
+
 runtime::Result<MethodMeta> Module::method_meta(
     const std::string& method_name) {
   ET_CHECK_OK_OR_RETURN_ERROR(load());
@@ -14,6 +14,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include <executorch/extension/memory_allocator/planned_memory_pool.h>
 #include <executorch/runtime/executor/program.h>
 
 #ifdef USE_ATEN_LIB
@@ -33,6 +34,9 @@ using ET_RUNTIME_NAMESPACE::Program;
 class ExecuTorchJni;
 
 namespace ET_MODULE_NAMESPACE {
+
+class AsyncModule;
+
 /**
  * A facade class for loading programs and executing methods within them.
  */
@@ -194,6 +198,42 @@ class Module {
     return load_method(method_name, nullptr, event_tracer);
   }
 
+  /**
+   * Unloads a specific method and releases its resources. If the method's
+   * planned buffers came from a planned memory pool, they are returned to the
+   * pool for reuse.
+   *
+   * @param[in] method_name The name of the method to unload.
+   *
+   * @returns true if the method was loaded and has been unloaded, false
+   * otherwise.
+   */
+  inline bool unload_method(const std::string& method_name) {
+    return methods_.erase(method_name) > 0;
+  }
+
+  /**
+   * Sets the pool that methods loaded after this call take their
+   * memory-planned buffers from, instead of allocating them with the default
+   * allocator. The pool may be shared between several Modules. Methods loaded
+   * with caller-provided planned memory are not affected.
+   *
+   * @param[in] pool The pool to use, or nullptr to go back to the default.
+   */
+  inline void set_planned_memory_pool(
+      std::shared_ptr<PlannedMemoryPool> pool) {
+    planned_memory_pool_ = std::move(pool);
+  }
+
+  /**
+   * Get the pool that memory-planned buffers are taken from.
+   *
+   * @returns Shared pointer to the pool, or nullptr if none was set.
+   */
+  inline std::shared_ptr<PlannedMemoryPool> planned_memory_pool() const {
+    return planned_memory_pool_;
+  }
+
   /**
    * Get a method by it's name. Not recommended to use this method directly as
    * an end user. It's exposed to allow for composability of module in apis that
@@ -206,6 +246,20 @@ class Module {
    */
   ET_NODISCARD runtime::Result<Method*> method(const std::string& method_name);
 
+  /**
+   * Get the memory-planned buffers of a loaded method, which hold its mutable
+   * state, such as KV caches, along with intermediate values. Copying their
+   * contents out and back in saves and restores that state.
+   *
+   * @param[in] method_name The name of the method.
+   *
+   * @returns The buffers, or Error::InvalidArgument if the method is not
+   * loaded, or Error::NotSupported if it was loaded with caller-provided
+   * planned memory.
+   */
+  ET_NODISCARD runtime::Result<std::vector<runtime::Span<uint8_t>>>
+  planned_buffers(const std::string& method_name);
+
   /**
    * Load the 'forward' method from the program and set up memory management if
    * needed. The loaded method is cached to reuse the next time it's executed.
@@ -498,6 +552,7 @@ class Module {
  private:
   struct MethodHolder {
     std::vector<std::vector<uint8_t>> planned_buffers;
+    std::vector<PlannedMemoryPool::Buffer> pooled_buffers;
     std::vector<runtime::Span<uint8_t>> planned_spans;
     std::unique_ptr<runtime::HierarchicalAllocator> planned_memory;
     std::unique_ptr<runtime::MemoryManager> memory_manager;
@@ -516,11 +571,14 @@ class Module {
   std::unique_ptr<runtime::DataLoader> data_map_loader_;
   std::unique_ptr<NamedDataMap> data_map_;
   std::vector<uint8_t> debug_buffer_;
+  // Must outlive methods_, whose pooled buffers are returned to it.
+  std::shared_ptr<PlannedMemoryPool> planned_memory_pool_;
 
  protected:
   std::unordered_map<std::string, MethodHolder> methods_;
 
   friend class executorch::extension::ExecuTorchJni;
+  friend class AsyncModule;
 };
 
 } // namespace ET_MODULE_NAMESPACE
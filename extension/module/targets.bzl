@@ -13,9 +13,11 @@ def define_common_targets():
         runtime.cxx_library(
             name = "module" + aten_suffix,
             srcs = [
+                "async_module.cpp",
                 "module.cpp",
             ],
             exported_headers = [
+                "async_module.h",
                 "module.h",
             ],
             visibility = [
@@ -28,6 +30,7 @@ def define_common_targets():
                 "//executorch/extension/flat_tensor:flat_tensor_data_map" + aten_suffix,
             ],
             exported_deps = [
+                "//executorch/extension/memory_allocator:planned_memory_pool",
                 "//executorch/runtime/executor:program_no_prim_ops" + aten_suffix,
             ],
         )
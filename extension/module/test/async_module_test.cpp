@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/module/async_module.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <gtest/gtest.h>
+
+#include <executorch/extension/tensor/tensor.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+
+using namespace ::executorch::extension;
+using namespace ::executorch::runtime;
+
+class AsyncModuleTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    model_path_ = std::getenv("ET_MODULE_ADD_PATH");
+  }
+
+  static inline std::string model_path_;
+};
+
+TEST_F(AsyncModuleTest, TestExecuteAsyncFuture) {
+  AsyncModule module(std::make_unique<Module>(model_path_), 2);
+  EXPECT_EQ(module.num_workers(), 2);
+  EXPECT_EQ(module.instances_per_method(), 4);
+
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  auto future = module.execute_async("forward", {tensor, tensor, 1.0});
+  auto response = future.get();
+  ASSERT_TRUE(response.ok());
+
+  const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+  EXPECT_TENSOR_CLOSE(response.outputs().at(0).toTensor(), *expected.get());
+}
+
+TEST_F(AsyncModuleTest, TestExecuteAsyncCallback) {
+  AsyncModule module(std::make_unique<Module>(model_path_), 1);
+  ASSERT_EQ(module.load_method("forward"), Error::Ok);
+
+  std::mutex mutex;
+  std::condition_variable done;
+  bool called = false;
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+
+  const auto error = module.execute_async(
+      "forward",
+      {tensor, tensor, 1.0},
+      [&](Error error, const std::vector<EValue>& outputs) {
+        EXPECT_EQ(error, Error::Ok);
+        EXPECT_TENSOR_CLOSE(outputs.at(0).toTensor(), *expected.get());
+        std::lock_guard<std::mutex> guard(mutex);
+        called = true;
+        done.notify_one();
+      });
+  ASSERT_EQ(error, Error::Ok);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [&]() { return called; });
+}
+
+TEST_F(AsyncModuleTest, TestManyConcurrentRequests) {
+  AsyncModule module(std::make_unique<Module>(model_path_), 4);
+
+  constexpr int kNumRequests = 64;
+  std::vector<TensorPtr> inputs;
+  std::vector<std::future<AsyncModule::Response>> futures;
+  for (int i = 0; i < kNumRequests; ++i) {
+    const float value = static_cast<float>(i);
+    inputs.push_back(make_tensor_ptr({2, 2}, {value, value, value, value}));
+    futures.push_back(
+        module.execute_async("forward", {inputs.back(), inputs.back(), 1.0}));
+  }
+  for (int i = 0; i < kNumRequests; ++i) {
+    auto response = futures[i].get();
+    ASSERT_TRUE(response.ok()) << "request " << i;
+    const float expected_value = 2.f * static_cast<float>(i);
+    const auto expected = make_tensor_ptr(
+        {2, 2}, {expected_value, expected_value, expected_value, expected_value});
+    EXPECT_TENSOR_CLOSE(response.outputs().at(0).toTensor(), *expected.get());
+  }
+}
+
+TEST_F(AsyncModuleTest, TestCallbacksFromManyThreads) {
+  AsyncModule module(std::make_unique<Module>(model_path_), 2);
+
+  std::atomic<int> completed{0};
+  std::atomic<int> failed{0};
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  std::vector<std::thread> submitters;
+  for (int t = 0; t < 4; ++t) {
+    submitters.emplace_back([&]() {
+      for (int i = 0; i < 16; ++i) {
+        const auto error = module.execute_async(
+            "forward",
+            {tensor, tensor, 1.0},
+            [&](Error error, const std::vector<EValue>&) {
+              if (error != Error::Ok) {
+                failed++;
+              }
+              completed++;
+            });
+        EXPECT_EQ(error, Error::Ok);
+      }
+    });
+  }
+  for (auto& submitter : submitters) {
+    submitter.join();
+  }
+  while (completed.load() < 64) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(failed.load(), 0);
+}
+
+TEST_F(AsyncModuleTest, TestConcurrentSubmitsWithOneInstance) {
+  // A request queued while another submitter stages into the only instance
+  // must not be run first, or the only worker would wait for that instance
+  // forever.
+  AsyncModule module(std::make_unique<Module>(model_path_), 1, 1);
+  ASSERT_EQ(module.load_method("forward"), Error::Ok);
+
+  constexpr int kNumThreads = 4;
+  constexpr int kRequestsPerThread = 32;
+  std::atomic<int> completed{0};
+  std::atomic<int> failed{0};
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  std::vector<std::thread> submitters;
+  for (int t = 0; t < kNumThreads; ++t) {
+    submitters.emplace_back([&]() {
+      for (int i = 0; i < kRequestsPerThread; ++i) {
+        const auto error = module.execute_async(
+            "forward",
+            {tensor, tensor, 1.0},
+            [&](Error error, const std::vector<EValue>&) {
+              if (error != Error::Ok) {
+                failed++;
+              }
+              completed++;
+            });
+        EXPECT_EQ(error, Error::Ok);
+      }
+    });
+  }
+  for (auto& submitter : submitters) {
+    submitter.join();
+  }
+  while (completed.load() < kNumThreads * kRequestsPerThread) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(failed.load(), 0);
+}
+
+TEST_F(AsyncModuleTest, TestNonExistentMethod) {
+  AsyncModule module(std::make_unique<Module>(model_path_));
+
+  auto response = module.execute_async("backward", {}).get();
+  EXPECT_NE(response.error(), Error::Ok);
+  EXPECT_TRUE(response.outputs().empty());
+  EXPECT_NE(
+      module.execute_async(
+          "backward", {}, [](Error, const std::vector<EValue>&) {}),
+      Error::Ok);
+}
+
+TEST_F(AsyncModuleTest, TestWrongNumberOfInputs) {
+  AsyncModule module(std::make_unique<Module>(model_path_));
+
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  auto response = module.execute_async("forward", {tensor}).get();
+  EXPECT_EQ(response.error(), Error::InvalidArgument);
+
+  // The instance is still usable afterwards.
+  response = module.execute_async("forward", {tensor, tensor, 1.0}).get();
+  EXPECT_TRUE(response.ok());
+}
@@ -466,3 +466,41 @@ TEST_F(ModuleTest, TestPTD) {
   auto tensor = make_tensor_ptr({2, 2}, {2.f, 3.f, 4.f, 2.f});
   ASSERT_EQ(module.forward(tensor).error(), Error::Ok);
 }
+
+TEST_F(ModuleTest, TestUnloadMethod) {
+  Module module(model_path_);
+
+  EXPECT_FALSE(module.unload_method("forward"));
+  ASSERT_EQ(module.load_method("forward"), Error::Ok);
+  EXPECT_TRUE(module.unload_method("forward"));
+  EXPECT_FALSE(module.is_method_loaded("forward"));
+
+  // The method is loaded again on demand.
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  const auto result = module.execute("forward", {tensor, tensor, 1.0});
+  EXPECT_EQ(result.error(), Error::Ok);
+}
+
+TEST_F(ModuleTest, TestPlannedMemoryPool) {
+  auto pool = std::make_shared<PlannedMemoryPool>();
+  Module module(model_path_);
+  module.set_planned_memory_pool(pool);
+  EXPECT_EQ(module.planned_memory_pool(), pool);
+
+  auto tensor = make_tensor_ptr({2, 2}, {1.f, 2.f, 3.f, 4.f});
+  const auto expected = make_tensor_ptr({2, 2}, {2.f, 4.f, 6.f, 8.f});
+  for (int i = 0; i < 3; ++i) {
+    const auto result = module.execute("forward", {tensor, tensor, 1.0});
+    ASSERT_EQ(result.error(), Error::Ok);
+    EXPECT_TENSOR_CLOSE(result->at(0).toTensor(), *expected.get());
+    EXPECT_GT(pool->stats().in_use_bytes, 0);
+    EXPECT_TRUE(module.unload_method("forward"));
+    EXPECT_EQ(pool->stats().in_use_bytes, 0);
+  }
+
+  // Every load after the first one is served from the pool's cache.
+  const auto stats = pool->stats();
+  EXPECT_GT(stats.acquisitions, 0);
+  EXPECT_EQ(stats.reuses * 3, stats.acquisitions * 2);
+  EXPECT_EQ(stats.resident_bytes, stats.peak_in_use_bytes);
+}
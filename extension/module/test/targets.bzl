@@ -27,6 +27,7 @@ def define_common_targets(is_fbcode=False):
             runtime.cxx_test(
                 name = "test" + aten_suffix,
                 srcs = [
+                    "async_module_test.cpp",
                     "module_test.cpp",
                 ],
                 deps = [
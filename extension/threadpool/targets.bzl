@@ -12,11 +12,13 @@ def define_common_targets():
         "thread_parallel.cpp",
         "threadpool.cpp",
         "threadpool_guard.cpp",
+        "work_stealing_pool.cpp",
     ] + (["fb/threadpool_use_n_threads.cpp"] if not runtime.is_oss else [])
 
     _THREADPOOL_HEADERS = [
         "threadpool.h",
         "threadpool_guard.h",
+        "work_stealing_pool.h",
     ] + (["fb/threadpool_use_n_threads.h"] if not runtime.is_oss else [])
 
     runtime.cxx_library(
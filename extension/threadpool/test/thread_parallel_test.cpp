@@ -9,8 +9,12 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <atomic>
 #include <mutex>
+#include <thread>
+#include <vector>
 
+#include <executorch/extension/threadpool/threadpool.h>
 #include <executorch/runtime/kernel/thread_parallel_interface.h>
 #include <executorch/runtime/platform/platform.h>
 
@@ -209,3 +213,99 @@ INSTANTIATE_TEST_SUITE_P(
     ParallelTestWithOrWithoutThreadpool,
     ParallelTest,
     ::testing::Values(true, false));
+
+TEST(WorkStealingParallelTest, TestUnevenWork) {
+  // Items at the start of the range are much more expensive than the rest,
+  // which a static split would hand to a single thread.
+  constexpr int64_t kSize = 1000;
+  std::vector<std::atomic<int>> visits(kSize);
+  std::atomic<int64_t> sink{0};
+  EXPECT_TRUE(executorch::extension::parallel_for(
+      0, kSize, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          const int64_t cost = i < kSize / 10 ? 10000 : 10;
+          int64_t acc = 0;
+          for (int64_t j = 0; j < cost; ++j) {
+            acc += j ^ i;
+          }
+          sink += acc;
+          visits[i]++;
+        }
+      }));
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(visits[i].load(), 1) << "index " << i;
+  }
+}
+
+TEST(WorkStealingParallelTest, TestThreadNumIsInRangeAndExclusive) {
+  const int64_t num_threads =
+      ::executorch::extension::threadpool::get_threadpool()->get_thread_count();
+  std::vector<std::atomic<int>> in_use(num_threads);
+  std::atomic<int> failures{0};
+  EXPECT_TRUE(executorch::extension::parallel_for(
+      0, 4096, 1, [&](int64_t /*begin*/, int64_t /*end*/) {
+        const int64_t thread_num = executorch::extension::get_thread_num();
+        if (thread_num < 0 || thread_num >= num_threads) {
+          failures++;
+          return;
+        }
+        // No other thread may be using the same thread number right now.
+        if (in_use[thread_num].fetch_add(1) != 0) {
+          failures++;
+        }
+        std::this_thread::yield();
+        in_use[thread_num].fetch_sub(1);
+      }));
+  EXPECT_EQ(failures.load(), 0);
+}
+
+TEST(WorkStealingParallelTest, TestNestedParallelFor) {
+  constexpr int64_t kOuter = 16;
+  constexpr int64_t kInner = 256;
+  std::vector<std::atomic<int>> visits(kOuter * kInner);
+  EXPECT_TRUE(executorch::extension::parallel_for(
+      0, kOuter, 1, [&](int64_t outer_begin, int64_t outer_end) {
+        for (int64_t i = outer_begin; i < outer_end; ++i) {
+          const int64_t outer_thread_num =
+              executorch::extension::get_thread_num();
+          EXPECT_TRUE(executorch::extension::parallel_for(
+              0, kInner, 1, [&](int64_t begin, int64_t end) {
+                for (int64_t j = begin; j < end; ++j) {
+                  visits[i * kInner + j]++;
+                }
+              }));
+          // The outer chunk still sees its own thread number.
+          EXPECT_EQ(executorch::extension::get_thread_num(), outer_thread_num);
+        }
+      }));
+  for (int64_t i = 0; i < kOuter * kInner; ++i) {
+    EXPECT_EQ(visits[i].load(), 1) << "index " << i;
+  }
+}
+
+TEST(WorkStealingParallelTest, TestConcurrentCallers) {
+  constexpr int kCallers = 4;
+  constexpr int64_t kSize = 10000;
+  std::vector<std::vector<int>> data(kCallers, std::vector<int>(kSize, 0));
+  std::vector<std::thread> callers;
+  for (int c = 0; c < kCallers; ++c) {
+    callers.emplace_back([&data, c]() {
+      for (int round = 0; round < 10; ++round) {
+        EXPECT_TRUE(executorch::extension::parallel_for(
+            0, kSize, 16, [&](int64_t begin, int64_t end) {
+              for (int64_t i = begin; i < end; ++i) {
+                data[c][i]++;
+              }
+            }));
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  for (int c = 0; c < kCallers; ++c) {
+    for (int64_t i = 0; i < kSize; ++i) {
+      ASSERT_EQ(data[c][i], 10) << "caller " << c << " index " << i;
+    }
+  }
+}
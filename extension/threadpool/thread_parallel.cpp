@@ -8,9 +8,10 @@
 
 #include <algorithm>
 #include <cinttypes>
-#include <tuple>
 
 #include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/extension/threadpool/threadpool_guard.h>
+#include <executorch/extension/threadpool/work_stealing_pool.h>
 #include <executorch/runtime/core/error.h>
 #include <executorch/runtime/kernel/thread_parallel_interface.h>
 #include <executorch/runtime/platform/assert.h>
@@ -20,7 +21,11 @@ namespace extension {
 
 namespace {
 thread_local int64_t thread_num_ = 0;
-}
+
+// Target number of chunks per thread; more chunks balance uneven work better
+// at the cost of more calls to the user function.
+constexpr int64_t kChunksPerThread = 4;
+} // namespace
 
 using namespace ::executorch::extension::threadpool;
 
@@ -36,20 +41,6 @@ void set_thread_num(int64_t thread_num) {
   thread_num_ = thread_num;
 }
 
-inline std::tuple<int64_t, int64_t>
-calc_num_tasks_and_chunk_size(int64_t begin, int64_t end, int64_t grain_size) {
-  if ((end - begin) < grain_size) {
-    return std::make_tuple(1, std::max((int64_t)0, end - begin));
-  }
-  // Choose number of tasks based on grain size and number of threads.
-  int64_t chunk_size =
-      divup((end - begin), get_threadpool()->get_thread_count());
-  // Make sure each task is at least grain_size size.
-  chunk_size = std::max(grain_size, chunk_size);
-  int64_t num_tasks = divup((end - begin), chunk_size);
-  return std::make_tuple(num_tasks, chunk_size);
-}
-
 bool parallel_for(
     const int64_t begin,
     const int64_t end,
@@ -61,22 +52,24 @@ bool parallel_for(
       begin,
       end);
   ET_CHECK_OR_RETURN_FALSE(grain_size > 0, "grain_size = %" PRId64, grain_size);
-  int64_t num_tasks = 0, chunk_size = 0;
-  std::tie(num_tasks, chunk_size) =
-      calc_num_tasks_and_chunk_size(begin, end, grain_size);
+  if (begin == end) {
+    return true;
+  }
+  // Run on same thread if NoThreadPoolGuard guard is enabled
+  if (NoThreadPoolGuard::is_enabled()) {
+    f(begin, end);
+    return true;
+  }
 
-  auto task = [&f, begin, end, chunk_size](size_t task_id) {
-    set_thread_num(task_id);
-    int64_t local_start = begin + static_cast<int64_t>(task_id) * chunk_size;
-    if (local_start < end) {
-      int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
-      f(local_start, local_end);
-    }
-  };
+  const int64_t num_threads = get_threadpool()->get_thread_count();
+  // Split the range into several chunks per thread so that threads that
+  // finish early can steal the remaining ones. Make sure each chunk is at
+  // least grain_size size.
+  const int64_t chunk_size = std::max(
+      grain_size, divup((end - begin), num_threads * kChunksPerThread));
 
-  // Per protocol from threadpool (pthreadpool), when this returns, all tasks
-  // are executed, so this is synchronous.
-  get_threadpool()->run(task, num_tasks);
+  // When this returns, all chunks are executed, so this is synchronous.
+  get_work_stealing_pool()->run(begin, end, chunk_size, num_threads, f);
   return true;
 }
 
@@ -35,13 +35,16 @@ void child_atfork() {
 #endif
 
 ThreadPool::ThreadPool(size_t thread_count)
-    : threadpool_(pthreadpool_create(thread_count), pthreadpool_destroy) {}
+    : threadpool_(pthreadpool_create(thread_count), pthreadpool_destroy),
+      thread_count_(
+          threadpool_ ? pthreadpool_get_threads_count(threadpool_.get()) : 0) {}
 
 size_t ThreadPool::get_thread_count() const {
-  std::lock_guard<std::mutex> lock{mutex_};
-
-  ET_CHECK_MSG(threadpool_.get(), "Invalid threadpool!");
-  return pthreadpool_get_threads_count(threadpool_.get());
+  // Called by every parallel_for, so this reads a cached count instead of
+  // taking mutex_.
+  const size_t thread_count = thread_count_.load(std::memory_order_relaxed);
+  ET_CHECK_MSG(thread_count > 0, "Invalid threadpool!");
+  return thread_count;
 }
 
 bool ThreadPool::_unsafe_reset_threadpool(uint32_t new_thread_count) {
@@ -53,6 +56,9 @@ bool ThreadPool::_unsafe_reset_threadpool(uint32_t new_thread_count) {
   std::lock_guard<std::mutex> lock{mutex_};
 
   threadpool_.reset(pthreadpool_create(new_thread_count));
+  thread_count_.store(
+      threadpool_ ? pthreadpool_get_threads_count(threadpool_.get()) : 0,
+      std::memory_order_relaxed);
   return true;
 }
 
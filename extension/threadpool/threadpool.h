@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -64,12 +65,12 @@ class ThreadPool final {
   friend pthreadpool_t get_pthreadpool();
 
  private:
-  // This mutex is used inside get_thread_count API but it is not really needed
-  // since data members of ThreadPool objects are not really mutable.
-  // TODO(kimishpatel): Figure out if we will allow set_num_threads API, in
-  // which case this mutex will be useful. Otherwise remove it.
+  // Serializes run() and _unsafe_reset_threadpool(). get_thread_count() reads
+  // thread_count_ instead so that parallel_for callers don't contend on it.
   mutable std::mutex mutex_;
   std::unique_ptr<pthreadpool, decltype(&pthreadpool_destroy)> threadpool_;
+  // Number of threads in threadpool_, or 0 if it failed to be created.
+  std::atomic<size_t> thread_count_;
 };
 
 /**
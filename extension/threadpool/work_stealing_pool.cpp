@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/extension/threadpool/work_stealing_pool.h>
+
+#include <algorithm>
+
+#include <executorch/extension/threadpool/threadpool.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
+#include <executorch/runtime/platform/assert.h>
+
+#include <cpuinfo.h>
+
+namespace executorch::extension::threadpool {
+
+namespace {
+// The pool that the current thread is a worker of, if any, and its index.
+thread_local WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+// How many times an idle worker checks for new tasks before going to sleep.
+constexpr int kSpinIterations = 64;
+
+#if !(defined(WIN32))
+// See the comment on the same flag in threadpool.cpp: the worker threads don't
+// survive a fork, so the pool is leaked and recreated in the child.
+bool leak_corrupted_pool = false;
+
+void child_atfork() {
+  leak_corrupted_pool = true;
+}
+#endif
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t thread_count) {
+  const size_t num_workers = std::max<size_t>(thread_count, 1) - 1;
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  threads_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    threads_.emplace_back([this, i]() { worker_loop(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> guard(sleep_mutex_);
+    stopping_.store(true);
+  }
+  wake_up_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::run(
+    int64_t begin,
+    int64_t end,
+    int64_t chunk_size,
+    size_t num_threads,
+    runtime::FunctionRef<void(int64_t, int64_t)> fn) {
+  if (begin >= end) {
+    return;
+  }
+  num_threads = std::min(std::max<size_t>(num_threads, 1), get_thread_count());
+  chunk_size = std::max<int64_t>(chunk_size, 1);
+
+  // Workers keep their own thread number for ranges they start. Thread number
+  // 0 never belongs to a worker, so it is free for any other caller: such a
+  // caller only executes chunks of the range it waits for.
+  const int64_t previous_thread_num = get_thread_num();
+  const size_t thread_num =
+      current_pool == this && current_worker + 1 < num_threads
+      ? current_worker + 1
+      : 0;
+  set_thread_num(thread_num);
+
+  if (num_threads == 1 || end - begin - chunk_size < chunk_size) {
+    // Too small to split.
+    fn(begin, end);
+  } else {
+    Job job(fn, chunk_size, num_threads, end - begin);
+    execute({&job, begin, end}, thread_num);
+    Task task;
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+      const uint64_t epoch = epoch_.load();
+      if (pop(&job, thread_num, task) || steal(&job, thread_num, task)) {
+        execute(task, thread_num);
+      } else {
+        wait(job, epoch);
+      }
+    }
+  }
+  set_thread_num(previous_thread_num);
+}
+
+void WorkStealingPool::worker_loop(size_t index) {
+  current_pool = this;
+  current_worker = index;
+  const size_t thread_num = index + 1;
+  while (!stopping_.load()) {
+    const uint64_t epoch = epoch_.load();
+    Task task;
+    if (pop(nullptr, thread_num, task) || steal(nullptr, thread_num, task)) {
+      execute(task, thread_num);
+      continue;
+    }
+    bool woken = false;
+    for (int i = 0; i < kSpinIterations && !woken; ++i) {
+      woken = epoch_.load() != epoch || stopping_.load();
+      if (!woken) {
+        std::this_thread::yield();
+      }
+    }
+    if (woken) {
+      continue;
+    }
+    sleepers_.fetch_add(1);
+    {
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_up_.wait(lock, [this, epoch]() {
+        return stopping_.load() || epoch_.load() != epoch;
+      });
+    }
+    sleepers_.fetch_sub(1);
+  }
+}
+
+void WorkStealingPool::execute(Task task, size_t thread_num) {
+  Job* const job = task.job;
+  // Keep the lower half and expose the upper half to thieves until the
+  // subrange is down to a single chunk.
+  while (task.end - task.begin - job->chunk_size >= job->chunk_size) {
+    const int64_t middle = task.begin + (task.end - task.begin) / 2;
+    push({job, middle, task.end});
+    task.end = middle;
+  }
+  set_thread_num(thread_num);
+  job->fn(task.begin, task.end);
+  // The job may be destroyed as soon as this reaches zero.
+  const int64_t items = task.end - task.begin;
+  if (job->remaining.fetch_sub(items) == items) {
+    wake_sleepers();
+  }
+}
+
+void WorkStealingPool::wait(const Job& job, uint64_t epoch) {
+  // Wake up for new tasks too: they may belong to the job, and only this
+  // thread may be left to execute them.
+  auto ready = [this, &job, epoch]() {
+    return job.remaining.load() == 0 || epoch_.load() != epoch;
+  };
+  for (int i = 0; i < kSpinIterations; ++i) {
+    if (ready()) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+  sleepers_.fetch_add(1);
+  {
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_up_.wait(lock, ready);
+  }
+  sleepers_.fetch_sub(1);
+}
+
+void WorkStealingPool::wake_sleepers() {
+  if (sleepers_.load() > 0) {
+    // Taking the lock orders the notification after a sleeper's last check
+    // of its wake-up condition.
+    { std::lock_guard<std::mutex> guard(sleep_mutex_); }
+    wake_up_.notify_all();
+  }
+}
+
+void WorkStealingPool::push(const Task& task) {
+  Worker* worker = nullptr;
+  if (current_pool == this) {
+    worker = workers_[current_worker].get();
+  } else {
+    // Only hand the task to workers that are allowed to execute it.
+    const size_t eligible = task.job->num_threads - 1;
+    worker = workers_[next_victim_.fetch_add(1) % eligible].get();
+  }
+  {
+    std::lock_guard<std::mutex> guard(worker->mutex);
+    worker->tasks.push_back(task);
+    worker->size.fetch_add(1);
+  }
+  epoch_.fetch_add(1);
+  wake_sleepers();
+}
+
+bool WorkStealingPool::pop(const Job* job, size_t thread_num, Task& task) {
+  if (current_pool != this) {
+    return false;
+  }
+  Worker& own = *workers_[current_worker];
+  return take(own, job, thread_num, /*oldest=*/false, task);
+}
+
+bool WorkStealingPool::steal(const Job* job, size_t thread_num, Task& task) {
+  const size_t num_workers = workers_.size();
+  // Start at a different victim on each thread to spread contention.
+  const size_t start = thread_num % num_workers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    Worker& victim = *workers_[(start + i) % num_workers];
+    if (take(victim, job, thread_num, /*oldest=*/true, task)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingPool::take(
+    Worker& worker,
+    const Job* job,
+    size_t thread_num,
+    bool oldest,
+    Task& task) {
+  if (worker.size.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(worker.mutex);
+  auto matches = [job, thread_num](const Task& candidate) {
+    return (job == nullptr || candidate.job == job) &&
+        thread_num < candidate.job->num_threads;
+  };
+  auto& tasks = worker.tasks;
+  if (oldest) {
+    auto it = std::find_if(tasks.begin(), tasks.end(), matches);
+    if (it == tasks.end()) {
+      return false;
+    }
+    task = *it;
+    tasks.erase(it);
+  } else {
+    auto it = std::find_if(tasks.rbegin(), tasks.rend(), matches);
+    if (it == tasks.rend()) {
+      return false;
+    }
+    task = *it;
+    tasks.erase(std::next(it).base());
+  }
+  worker.size.fetch_sub(1);
+  return true;
+}
+
+WorkStealingPool* get_work_stealing_pool() {
+  ThreadPool* const threadpool = get_threadpool();
+  ET_CHECK_MSG(threadpool, "Failed to acquire an instance of ThreadPool!");
+  // Size the pool for the largest thread count that get_threadpool() uses by
+  // default, so that shrinking the ThreadPool only limits how many workers
+  // take part in each range.
+  constexpr size_t tsan_thread_limit = 63;
+  static auto pool = std::make_unique<WorkStealingPool>(std::max(
+      std::min<size_t>(cpuinfo_get_processors_count(), tsan_thread_limit),
+      threadpool->get_thread_count()));
+
+#if !(defined(WIN32))
+  // @lint-ignore CLANGTIDY facebook-hte-std::once_flag
+  static std::once_flag flag;
+  // @lint-ignore CLANGTIDY facebook-hte-std::call_once
+  std::call_once(
+      flag, []() { pthread_atfork(nullptr, nullptr, child_atfork); });
+  if ET_UNLIKELY (leak_corrupted_pool) {
+    leak_corrupted_pool = false;
+    if (auto leaked = pool.release()) {
+      pool = std::make_unique<WorkStealingPool>(leaked->get_thread_count());
+    }
+  }
+#endif
+  return pool.get();
+}
+
+} // namespace executorch::extension::threadpool
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <executorch/runtime/core/function_ref.h>
+
+namespace executorch::extension::threadpool {
+
+/**
+ * A pool of worker threads that executes parallel_for() ranges with work
+ * stealing.
+ *
+ * Each worker owns a deque of pending subranges. A thread that executes a
+ * subrange splits it in half until it reaches the chunk size, pushing the
+ * upper halves onto its own deque; idle workers steal the oldest, and so
+ * largest, subranges from the other deques. This balances ranges whose items
+ * have very different costs without any up-front partitioning.
+ *
+ * There is no pool-wide lock on the dispatch path: every deque has its own
+ * mutex, and the shared sleep mutex is only taken when workers go idle or
+ * have to be woken up.
+ *
+ * parallel_for() may be called from inside a range being executed by the
+ * pool. While a thread waits for a range to finish it only helps with that
+ * range, so nested calls can't deadlock, and each thread only ever executes
+ * one chunk of a given range at a time. Once there is nothing left for it to
+ * help with, the waiting thread sleeps until the range completes.
+ */
+class WorkStealingPool final {
+ public:
+  /**
+   * Creates a pool that runs ranges on up to `thread_count` threads: the
+   * calling thread plus `thread_count - 1` workers.
+   */
+  explicit WorkStealingPool(size_t thread_count);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+  WorkStealingPool(WorkStealingPool&&) = delete;
+  WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+
+  /// Returns the maximum number of threads that execute a range, including
+  /// the calling thread.
+  size_t get_thread_count() const {
+    return workers_.size() + 1;
+  }
+
+  /**
+   * Calls `fn` on disjoint subranges covering [begin, end) and returns once
+   * all of them have completed. Subranges hold at least `chunk_size` items,
+   * except when the whole range is smaller than that.
+   *
+   * While `fn` runs, get_thread_num() returns a value in [0, num_threads)
+   * that no other thread executing the same range uses at the same time.
+   * The calling thread always participates; at most `num_threads` threads
+   * execute the range, which is clamped to [1, get_thread_count()].
+   */
+  void run(
+      int64_t begin,
+      int64_t end,
+      int64_t chunk_size,
+      size_t num_threads,
+      runtime::FunctionRef<void(int64_t, int64_t)> fn);
+
+ private:
+  struct Job {
+    Job(runtime::FunctionRef<void(int64_t, int64_t)> fn_,
+        int64_t chunk_size_,
+        size_t num_threads_,
+        int64_t items)
+        : fn(fn_),
+          chunk_size(chunk_size_),
+          num_threads(num_threads_),
+          remaining(items) {}
+
+    const runtime::FunctionRef<void(int64_t, int64_t)> fn;
+    const int64_t chunk_size;
+    // Only threads whose thread number is below this execute the job.
+    const size_t num_threads;
+    // Items that haven't been processed yet.
+    std::atomic<int64_t> remaining;
+  };
+
+  struct Task {
+    Job* job;
+    int64_t begin;
+    int64_t end;
+  };
+
+  // Padded so that workers don't share cache lines when touching their own
+  // deques.
+  struct alignas(64) Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    // Mirrors tasks.size() so that empty deques can be skipped without
+    // taking their lock.
+    std::atomic<size_t> size{0};
+  };
+
+  void worker_loop(size_t index);
+  void execute(Task task, size_t thread_num);
+  // Blocks until the job completes or a task is pushed after `epoch`.
+  void wait(const Job& job, uint64_t epoch);
+  void wake_sleepers();
+  void push(const Task& task);
+  bool pop(const Job* job, size_t thread_num, Task& task);
+  bool steal(const Job* job, size_t thread_num, Task& task);
+  static bool take(
+      Worker& worker,
+      const Job* job,
+      size_t thread_num,
+      bool oldest,
+      Task& task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // Incremented on every push, so that idle workers can tell whether new
+  // tasks showed up since they last looked.
+  std::atomic<uint64_t> epoch_{0};
+  // Round-robin cursor used when a non-worker thread pushes a task.
+  std::atomic<size_t> next_victim_{0};
+
+  std::mutex sleep_mutex_;
+  // Notified on every push and whenever a job completes. Idle workers and
+  // threads waiting for a job to complete sleep on it.
+  std::condition_variable wake_up_;
+  std::atomic<size_t> sleepers_{0};
+  std::atomic<bool> stopping_{false};
+};
+
+/**
+ * Returns the work-stealing pool that backs parallel_for(). It has as many
+ * threads as the default ThreadPool returned by get_threadpool().
+ */
+WorkStealingPool* get_work_stealing_pool();
+
+} // namespace executorch::extension::threadpool
@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/optimized/blas/BlockedGemm.h>
+
+#include <algorithm>
+
+#include <executorch/kernels/optimized/utils/unroll.h>
+#include <executorch/runtime/core/portable_type/bfloat16.h>
+#include <executorch/runtime/core/portable_type/half.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
+#include <executorch/runtime/platform/assert.h>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace executorch {
+namespace cpublas {
+
+using executorch::aten::BFloat16;
+using executorch::aten::Half;
+using executorch::extension::parallel_for;
+
+namespace {
+
+// The microkernel computes a kMR x kNR tile of C, held in 2 * kNR vector
+// registers, as a sum of outer products of a column of the A sliver and a row
+// of the B sliver.
+#if defined(__AVX512F__)
+struct FloatVec {
+  using type = __m512;
+  static constexpr int64_t size = 16;
+  static type zero() {
+    return _mm512_setzero_ps();
+  }
+  static type load(const float* p) {
+    return _mm512_loadu_ps(p);
+  }
+  static type broadcast(const float* p) {
+    return _mm512_set1_ps(*p);
+  }
+  static type fmadd(type a, type b, type c) {
+    return _mm512_fmadd_ps(a, b, c);
+  }
+  static void store(float* p, type v) {
+    _mm512_storeu_ps(p, v);
+  }
+};
+constexpr int64_t kNR = 8;
+#elif defined(__AVX2__) && defined(__FMA__)
+struct FloatVec {
+  using type = __m256;
+  static constexpr int64_t size = 8;
+  static type zero() {
+    return _mm256_setzero_ps();
+  }
+  static type load(const float* p) {
+    return _mm256_loadu_ps(p);
+  }
+  static type broadcast(const float* p) {
+    return _mm256_broadcast_ss(p);
+  }
+  static type fmadd(type a, type b, type c) {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static void store(float* p, type v) {
+    _mm256_storeu_ps(p, v);
+  }
+};
+constexpr int64_t kNR = 6;
+#elif defined(__aarch64__)
+struct FloatVec {
+  using type = float32x4_t;
+  static constexpr int64_t size = 4;
+  static type zero() {
+    return vdupq_n_f32(0.0f);
+  }
+  static type load(const float* p) {
+    return vld1q_f32(p);
+  }
+  static type broadcast(const float* p) {
+    return vld1q_dup_f32(p);
+  }
+  static type fmadd(type a, type b, type c) {
+    return vfmaq_f32(c, a, b);
+  }
+  static void store(float* p, type v) {
+    vst1q_f32(p, v);
+  }
+};
+constexpr int64_t kNR = 8;
+#else
+// Plain C++ that the compiler is free to vectorize.
+struct FloatVec {
+  static constexpr int64_t size = 4;
+  struct type {
+    float v[size];
+  };
+  static type zero() {
+    return type{};
+  }
+  static type load(const float* p) {
+    type r;
+    std::copy(p, p + size, r.v);
+    return r;
+  }
+  static type broadcast(const float* p) {
+    type r;
+    std::fill(r.v, r.v + size, *p);
+    return r;
+  }
+  static type fmadd(type a, type b, type c) {
+    for (int64_t i = 0; i < size; ++i) {
+      c.v[i] += a.v[i] * b.v[i];
+    }
+    return c;
+  }
+  static void store(float* p, type v) {
+    std::copy(v.v, v.v + size, p);
+  }
+};
+constexpr int64_t kNR = 4;
+#endif
+
+constexpr int64_t kMR = 2 * FloatVec::size;
+
+// Depth of the packed panels. A kKC x kNR sliver of B stays in L1 while the
+// microkernel sweeps over a block of A.
+constexpr int64_t kKC = 256;
+// Rows of the packed block of A, which stays in L2.
+constexpr int64_t kMC = 128;
+// Columns of C that one task computes against a block of A.
+constexpr int64_t kNB = 16 * kNR;
+// Columns of the packed panel of B, which stays in L3.
+constexpr int64_t kNC = 8 * kNB;
+
+static_assert(kMC % kMR == 0, "A blocks must hold whole slivers");
+static_assert(kNC % kNR == 0, "B panels must hold whole slivers");
+
+// Scratch space for packed operands, allocated on a thread's first GEMM at
+// the largest size any call needs and reused by all later calls.
+class PackingBuffer {
+ public:
+  explicit PackingBuffer(int64_t size) : size_(size) {}
+
+  float* get() {
+    if (!data_) {
+      data_.reset(new float[size_]);
+    }
+    return data_.get();
+  }
+
+ private:
+  const int64_t size_;
+  std::unique_ptr<float[]> data_;
+};
+
+// The panel of B is packed by the thread that calls blocked_gemm() and read
+// by all threads working on it; blocks of A are packed by each thread for
+// itself. A thread only ever works on one GEMM at a time, since the tasks of
+// a GEMM don't call into the GEMM again.
+thread_local PackingBuffer packed_b_buffer(kKC * kNC);
+thread_local PackingBuffer packed_a_buffer(kMC * kKC);
+
+int64_t round_up(int64_t x, int64_t multiple) {
+  return (x + multiple - 1) / multiple * multiple;
+}
+
+int64_t div_up(int64_t x, int64_t divisor) {
+  return (x + divisor - 1) / divisor;
+}
+
+// Computes the tile of packed_a * packed_b over `k` into `tile`, which is
+// column-major with kMR rows.
+ET_INLINE void microkernel(
+    int64_t k,
+    const float* packed_a,
+    const float* packed_b,
+    float* tile) {
+  using Vec = FloatVec;
+  Vec::type c0[kNR];
+  Vec::type c1[kNR];
+  utils::ForcedUnroll<kNR>{}([&](int j) {
+    c0[j] = Vec::zero();
+    c1[j] = Vec::zero();
+  });
+  for (int64_t p = 0; p < k; ++p) {
+    const auto a0 = Vec::load(packed_a);
+    const auto a1 = Vec::load(packed_a + Vec::size);
+    utils::ForcedUnroll<kNR>{}([&](int j) {
+      const auto b = Vec::broadcast(packed_b + j);
+      c0[j] = Vec::fmadd(a0, b, c0[j]);
+      c1[j] = Vec::fmadd(a1, b, c1[j]);
+    });
+    packed_a += kMR;
+    packed_b += kNR;
+  }
+  utils::ForcedUnroll<kNR>{}([&](int j) {
+    Vec::store(tile + j * kMR, c0[j]);
+    Vec::store(tile + j * kMR + Vec::size, c1[j]);
+  });
+}
+
+// Writes c = alpha * tile + beta * c for the `mr` x `nr` corner of the tile.
+// c isn't read when beta is 0, so it may hold NaNs.
+template <typename scalar_t>
+void store_tile(
+    const float* tile,
+    int64_t mr,
+    int64_t nr,
+    float alpha,
+    float beta,
+    scalar_t* c,
+    int64_t ldc) {
+  for (int64_t j = 0; j < nr; ++j) {
+    const float* t = tile + j * kMR;
+    scalar_t* c_j = c + j * ldc;
+    if (beta == 0.0f) {
+      for (int64_t i = 0; i < mr; ++i) {
+        c_j[i] = static_cast<scalar_t>(alpha * t[i]);
+      }
+    } else {
+      for (int64_t i = 0; i < mr; ++i) {
+        c_j[i] = static_cast<scalar_t>(
+            alpha * t[i] + beta * static_cast<float>(c_j[i]));
+      }
+    }
+  }
+}
+
+// Packs rows [i0, i0 + mr) and columns [p0, p0 + kc) of op(a) into a sliver
+// of kMR rows, stored column after column. Rows past `mr` are zero.
+template <typename scalar_t>
+void pack_a_sliver(
+    TransposeType transa,
+    const scalar_t* a,
+    int64_t lda,
+    int64_t i0,
+    int64_t mr,
+    int64_t p0,
+    int64_t kc,
+    float* dst) {
+  if (mr < kMR) {
+    std::fill(dst, dst + kc * kMR, 0.0f);
+  }
+  if (transa == TransposeType::NoTranspose) {
+    // op(a)(i, p) = a[i + p * lda]: columns are contiguous.
+    for (int64_t p = 0; p < kc; ++p) {
+      const scalar_t* src = a + (p0 + p) * lda + i0;
+      for (int64_t i = 0; i < mr; ++i) {
+        dst[p * kMR + i] = static_cast<float>(src[i]);
+      }
+    }
+  } else {
+    // op(a)(i, p) = a[p + i * lda]: rows are contiguous.
+    for (int64_t i = 0; i < mr; ++i) {
+      const scalar_t* src = a + (i0 + i) * lda + p0;
+      for (int64_t p = 0; p < kc; ++p) {
+        dst[p * kMR + i] = static_cast<float>(src[p]);
+      }
+    }
+  }
+}
+
+// Packs rows [p0, p0 + kc) and columns [j0, j0 + nr) of op(b) into a sliver
+// of kNR columns, stored row after row. Columns past `nr` are zero.
+template <typename scalar_t>
+void pack_b_sliver(
+    TransposeType transb,
+    const scalar_t* b,
+    int64_t ldb,
+    int64_t p0,
+    int64_t kc,
+    int64_t j0,
+    int64_t nr,
+    float* dst) {
+  if (nr < kNR) {
+    std::fill(dst, dst + kc * kNR, 0.0f);
+  }
+  if (transb == TransposeType::NoTranspose) {
+    // op(b)(p, j) = b[p + j * ldb]: columns are contiguous.
+    for (int64_t j = 0; j < nr; ++j) {
+      const scalar_t* src = b + (j0 + j) * ldb + p0;
+      for (int64_t p = 0; p < kc; ++p) {
+        dst[p * kNR + j] = static_cast<float>(src[p]);
+      }
+    }
+  } else {
+    // op(b)(p, j) = b[j + p * ldb]: rows are contiguous.
+    for (int64_t p = 0; p < kc; ++p) {
+      const scalar_t* src = b + (p0 + p) * ldb + j0;
+      for (int64_t j = 0; j < nr; ++j) {
+        dst[p * kNR + j] = static_cast<float>(src[j]);
+      }
+    }
+  }
+}
+
+template <typename scalar_t>
+void scale_c(int64_t m, int64_t n, float beta, scalar_t* c, int64_t ldc) {
+  for (int64_t j = 0; j < n; ++j) {
+    for (int64_t i = 0; i < m; ++i) {
+      c[j * ldc + i] = beta == 0.0f
+          ? scalar_t(0)
+          : static_cast<scalar_t>(beta * static_cast<float>(c[j * ldc + i]));
+    }
+  }
+}
+
+// The blocked loops shared by both entry points. op(a) is packed on the fly
+// from `a`, unless `packed_a` is given.
+template <typename scalar_t>
+void blocked_gemm_impl(
+    const PackedGemmA* packed_a,
+    TransposeType transa,
+    TransposeType transb,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float alpha,
+    const scalar_t* a,
+    int64_t lda,
+    const scalar_t* b,
+    int64_t ldb,
+    float beta,
+    scalar_t* c,
+    int64_t ldc) {
+  if (m == 0 || n == 0) {
+    return;
+  }
+  if (k == 0 || alpha == 0.0f) {
+    scale_c(m, n, beta, c, ldc);
+    return;
+  }
+
+  const int64_t m_padded = round_up(m, kMR);
+  const int64_t m_blocks = div_up(m, kMC);
+  float* const packed_b = packed_b_buffer.get();
+
+  for (int64_t jc = 0; jc < n; jc += kNC) {
+    const int64_t nc = std::min(kNC, n - jc);
+    const int64_t n_blocks = div_up(nc, kNB);
+    for (int64_t pc = 0; pc < k; pc += kKC) {
+      const int64_t kc = std::min(kKC, k - pc);
+      // Later panels accumulate onto the result of the first one.
+      const float beta_pc = pc == 0 ? beta : 1.0f;
+
+      parallel_for(0, div_up(nc, kNR), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t s = begin; s < end; ++s) {
+          pack_b_sliver(
+              transb,
+              b,
+              ldb,
+              pc,
+              kc,
+              jc + s * kNR,
+              std::min(kNR, nc - s * kNR),
+              packed_b + s * kNR * kc);
+        }
+      });
+
+      // Tasks are ordered so that consecutive ones share a block of A, which
+      // each chunk of tasks then packs only once.
+      parallel_for(0, m_blocks * n_blocks, 1, [&](int64_t begin, int64_t end) {
+        float* a_buffer = nullptr;
+        int64_t packed_ic = -1;
+        float tile[kMR * kNR];
+        for (int64_t task = begin; task < end; ++task) {
+          const int64_t ic = task / n_blocks * kMC;
+          const int64_t mc = std::min(kMC, m - ic);
+          const float* a_block;
+          if (packed_a != nullptr) {
+            a_block = packed_a->data() + pc * m_padded + ic * kc;
+          } else {
+            if (ic != packed_ic) {
+              if (a_buffer == nullptr) {
+                a_buffer = packed_a_buffer.get();
+              }
+              for (int64_t ir = 0; ir < mc; ir += kMR) {
+                pack_a_sliver(
+                    transa,
+                    a,
+                    lda,
+                    ic + ir,
+                    std::min(kMR, mc - ir),
+                    pc,
+                    kc,
+                    a_buffer + ir * kc);
+              }
+              packed_ic = ic;
+            }
+            a_block = a_buffer;
+          }
+
+          const int64_t jb = task % n_blocks * kNB;
+          const int64_t jb_end = std::min(jb + kNB, nc);
+          for (int64_t jr = jb; jr < jb_end; jr += kNR) {
+            const int64_t nr = std::min(kNR, nc - jr);
+            for (int64_t ir = 0; ir < mc; ir += kMR) {
+              microkernel(
+                  kc, a_block + ir * kc, packed_b + jr * kc, tile);
+              store_tile(
+                  tile,
+                  std::min(kMR, mc - ir),
+                  nr,
+                  alpha,
+                  beta_pc,
+                  c + (jc + jr) * ldc + ic + ir,
+                  ldc);
+            }
+          }
+        }
+      });
+    }
+  }
+}
+
+} // namespace
+
+template <typename scalar_t>
+void blocked_gemm(
+    TransposeType transa,
+    TransposeType transb,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float alpha,
+    const scalar_t* a,
+    int64_t lda,
+    const scalar_t* b,
+    int64_t ldb,
+    float beta,
+    scalar_t* c,
+    int64_t ldc) {
+  blocked_gemm_impl<scalar_t>(
+      nullptr,
+      transa,
+      transb,
+      m,
+      n,
+      k,
+      alpha,
+      a,
+      lda,
+      b,
+      ldb,
+      beta,
+      c,
+      ldc);
+}
+
+template <typename scalar_t>
+void blocked_gemm(
+    const PackedGemmA& packed_a,
+    TransposeType transb,
+    int64_t n,
+    float alpha,
+    const scalar_t* b,
+    int64_t ldb,
+    float beta,
+    scalar_t* c,
+    int64_t ldc) {
+  blocked_gemm_impl<scalar_t>(
+      &packed_a,
+      TransposeType::NoTranspose,
+      transb,
+      packed_a.m(),
+      n,
+      packed_a.k(),
+      alpha,
+      nullptr,
+      0,
+      b,
+      ldb,
+      beta,
+      c,
+      ldc);
+}
+
+// The packed operand holds the panels of kKC columns one after the other,
+// each made of the kMR-row slivers of all of op(a), i.e. the same layout as
+// the blocks that blocked_gemm_impl() packs on the fly.
+PackedGemmA::PackedGemmA(int64_t m, int64_t k)
+    : m_(m), k_(k), data_(new float[round_up(m, kMR) * k]) {}
+
+size_t PackedGemmA::nbytes() const {
+  return round_up(m_, kMR) * k_ * sizeof(float);
+}
+
+template <typename scalar_t>
+std::unique_ptr<PackedGemmA> PackedGemmA::pack(
+    TransposeType transa,
+    int64_t m,
+    int64_t k,
+    const scalar_t* a,
+    int64_t lda) {
+  std::unique_ptr<PackedGemmA> packed(new PackedGemmA(m, k));
+  const int64_t m_padded = round_up(m, kMR);
+  for (int64_t pc = 0; pc < k; pc += kKC) {
+    const int64_t kc = std::min(kKC, k - pc);
+    float* panel = packed->data_.get() + pc * m_padded;
+    parallel_for(0, m_padded / kMR, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t s = begin; s < end; ++s) {
+        pack_a_sliver(
+            transa,
+            a,
+            lda,
+            s * kMR,
+            std::min(kMR, m - s * kMR),
+            pc,
+            kc,
+            panel + s * kMR * kc);
+      }
+    });
+  }
+  return packed;
+}
+
+#define ET_INSTANTIATE_BLOCKED_GEMM(scalar_t)                             \
+  template void blocked_gemm<scalar_t>(                                   \
+      TransposeType,                                                      \
+      TransposeType,                                                      \
+      int64_t,                                                            \
+      int64_t,                                                            \
+      int64_t,                                                            \
+      float,                                                              \
+      const scalar_t*,                                                    \
+      int64_t,                                                            \
+      const scalar_t*,                                                    \
+      int64_t,                                                            \
+      float,                                                              \
+      scalar_t*,                                                          \
+      int64_t);                                                           \
+  template void blocked_gemm<scalar_t>(                                   \
+      const PackedGemmA&,                                                 \
+      TransposeType,                                                      \
+      int64_t,                                                            \
+      float,                                                              \
+      const scalar_t*,                                                    \
+      int64_t,                                                            \
+      float,                                                              \
+      scalar_t*,                                                          \
+      int64_t);                                                           \
+  template std::unique_ptr<PackedGemmA> PackedGemmA::pack<scalar_t>(      \
+      TransposeType, int64_t, int64_t, const scalar_t*, int64_t);
+
+ET_INSTANTIATE_BLOCKED_GEMM(float)
+ET_INSTANTIATE_BLOCKED_GEMM(Half)
+ET_INSTANTIATE_BLOCKED_GEMM(BFloat16)
+
+#undef ET_INSTANTIATE_BLOCKED_GEMM
+
+} // namespace cpublas
+} // namespace executorch
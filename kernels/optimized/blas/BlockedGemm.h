@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <executorch/kernels/optimized/blas/CPUBlas.h>
+
+namespace executorch {
+namespace cpublas {
+
+/*
+ * Cache-blocked GEMM for builds without an external BLAS.
+ *
+ * Follows the Goto/BLIS scheme: op(B) is packed into panels of kKC rows that
+ * stay in the L3 cache, op(A) into blocks of kMC x kKC that stay in L2, and a
+ * register-tiled microkernel multiplies slivers of both. Half and BFloat16
+ * operands are widened to float while they are packed, so all types share the
+ * float microkernels (AVX-512, AVX2+FMA or NEON, picked at compile time) and
+ * accumulate in float. The blocks of C are spread over the threadpool along
+ * both M and N.
+ *
+ * Like gemm(), matrices are column-major:
+ *   c = alpha * op(a) @ op(b) + beta * c
+ * where op(a) is m x k and op(b) is k x n.
+ */
+
+// Whether the blocked GEMM is expected to beat the simple loops of gemm_impl()
+// for a problem of this size. Thin problems such as matrix-vector products are
+// memory bound and don't amortize the packing.
+inline bool use_blocked_gemm(int64_t m, int64_t n, int64_t k) {
+  return m >= 8 && n >= 8 && k >= 8 && m * n * k >= 64 * 64 * 64;
+}
+
+template <typename scalar_t>
+void blocked_gemm(
+    TransposeType transa,
+    TransposeType transb,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float alpha,
+    const scalar_t* a,
+    int64_t lda,
+    const scalar_t* b,
+    int64_t ldb,
+    float beta,
+    scalar_t* c,
+    int64_t ldc);
+
+/**
+ * op(a) of a GEMM, packed ahead of time in the layout that the microkernels
+ * read. Packing a constant operand, such as the weights of a linear layer,
+ * once saves repacking it on every call.
+ */
+class PackedGemmA {
+ public:
+  int64_t m() const {
+    return m_;
+  }
+
+  int64_t k() const {
+    return k_;
+  }
+
+  size_t nbytes() const;
+
+  template <typename scalar_t>
+  static std::unique_ptr<PackedGemmA> pack(
+      TransposeType transa,
+      int64_t m,
+      int64_t k,
+      const scalar_t* a,
+      int64_t lda);
+
+  const float* data() const {
+    return data_.get();
+  }
+
+ private:
+  PackedGemmA(int64_t m, int64_t k);
+
+  int64_t m_;
+  int64_t k_;
+  std::unique_ptr<float[]> data_;
+};
+
+/**
+ * Same as blocked_gemm() with op(a) taken from `packed_a`.
+ */
+template <typename scalar_t>
+void blocked_gemm(
+    const PackedGemmA& packed_a,
+    TransposeType transb,
+    int64_t n,
+    float alpha,
+    const scalar_t* b,
+    int64_t ldb,
+    float beta,
+    scalar_t* c,
+    int64_t ldc);
+
+} // namespace cpublas
+} // namespace executorch
@@ -7,6 +7,7 @@
  */
 
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/kernels/optimized/blas/BlockedGemm.h>
 
 #include <limits.h>
 
@@ -142,6 +143,20 @@ void gemm(
 #endif // ET_BUILD_FOR_APPLE
 
 #else
+#ifdef ET_BUILD_WITH_BLOCKED_GEMM
+  if (use_blocked_gemm(m, n, k)) {
+    blocked_gemm(
+        transa, transb,
+        m, n, k,
+        alpha,
+        a, lda,
+        b, ldb,
+        beta,
+        c, ldc);
+    return;
+  }
+#endif // ET_BUILD_WITH_BLOCKED_GEMM
+
   using acc_type = utils::compute_dtype<float>;
   gemm_impl(
       transa, transb,
@@ -165,6 +180,20 @@ void gemm(
     Half *c, int64_t ldc) {
   normalize_last_dims(transa, transb, m, n, k, &lda, &ldb, &ldc);
 
+#ifdef ET_BUILD_WITH_BLOCKED_GEMM
+  if (use_blocked_gemm(m, n, k)) {
+    blocked_gemm(
+        transa, transb,
+        m, n, k,
+        static_cast<float>(alpha),
+        a, lda,
+        b, ldb,
+        static_cast<float>(beta),
+        c, ldc);
+    return;
+  }
+#endif // ET_BUILD_WITH_BLOCKED_GEMM
+
   using acc_type = utils::compute_dtype<Half>;
   gemm_impl(
       transa, transb,
@@ -188,6 +217,20 @@ void gemm(
     BFloat16 *c, int64_t ldc) {
   normalize_last_dims(transa, transb, m, n, k, &lda, &ldb, &ldc);
 
+#ifdef ET_BUILD_WITH_BLOCKED_GEMM
+  if (use_blocked_gemm(m, n, k)) {
+    blocked_gemm(
+        transa, transb,
+        m, n, k,
+        static_cast<float>(alpha),
+        a, lda,
+        b, ldb,
+        static_cast<float>(beta),
+        c, ldc);
+    return;
+  }
+#endif // ET_BUILD_WITH_BLOCKED_GEMM
+
   using acc_type = utils::compute_dtype<BFloat16>;
   gemm_impl(
       transa, transb,
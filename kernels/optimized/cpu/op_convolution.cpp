@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+
+#include <c10/util/irange.h>
+
+#include <executorch/kernels/optimized/blas/CPUBlas.h>
+#include <executorch/kernels/portable/cpu/util/dtype_util.h>
+#include <executorch/kernels/portable/cpu/util/kernel_ops_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
+
+namespace torch {
+namespace executor {
+namespace native {
+
+namespace {
+using ::executorch::aten::Tensor;
+using ::executorch::cpublas::gemm;
+using ::executorch::cpublas::TransposeType;
+
+// Size of the im2col buffer of each task. It lives on the stack of the thread
+// that runs the task, so that the kernel doesn't need a temp allocator.
+constexpr int64_t kColsBufferBytes = 16 * 1024;
+
+// Never split the output into tiles of fewer pixels than this to block the
+// reduction dimension, or the GEMMs get too thin.
+constexpr int64_t kMinTilePixels = 16;
+
+// Sizes and strides of a convolution operand as NCHW, whatever its dim order.
+// 1-D convolutions are viewed as 2-D convolutions of height 1.
+struct Operand2d {
+  int64_t size[4];
+  int64_t stride[4];
+};
+
+Operand2d make_operand_2d(const Tensor& t) {
+  executorch::aten::SizesType sizes[kTensorDimensionLimit];
+  executorch::aten::DimOrderType dim_order[kTensorDimensionLimit];
+  size_t ndim = t.dim();
+  if (t.dim() == 3) {
+    get_unsqueezed_sizes(t, 2, sizes, ndim);
+    get_unsqueezed_dim_order(t, 2, dim_order);
+  } else {
+    std::copy(t.sizes().begin(), t.sizes().end(), sizes);
+    std::copy(t.dim_order().begin(), t.dim_order().end(), dim_order);
+  }
+  executorch::aten::StridesType strides[kTensorDimensionLimit];
+  dim_order_to_stride_nocheck(sizes, dim_order, ndim, strides);
+
+  Operand2d operand;
+  for (const auto d : c10::irange(4)) {
+    operand.size[d] = sizes[d];
+    operand.stride[d] = strides[d];
+  }
+  return operand;
+}
+
+struct Conv2dParams {
+  Operand2d in;
+  Operand2d weight;
+  Operand2d out;
+  int64_t stride_y;
+  int64_t stride_x;
+  int64_t padding_y;
+  int64_t padding_x;
+  int64_t dilation_y;
+  int64_t dilation_x;
+  int64_t groups;
+  // Whether in and out are NHWC. Otherwise they are NCHW.
+  bool channels_last;
+};
+
+Conv2dParams make_conv2d_params(
+    const Tensor& in,
+    const Tensor& weight,
+    const Tensor& out,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int64_t groups) {
+  Conv2dParams params;
+  params.in = make_operand_2d(in);
+  params.weight = make_operand_2d(weight);
+  params.out = make_operand_2d(out);
+  if (in.dim() == 3) {
+    params.stride_y = 1;
+    params.stride_x = stride[0];
+    params.padding_y = 0;
+    params.padding_x = padding[0];
+    params.dilation_y = 1;
+    params.dilation_x = dilation.size() > 0 ? dilation[0] : 1;
+  } else {
+    params.stride_y = val_at(stride, 0);
+    params.stride_x = val_at(stride, 1);
+    params.padding_y = val_at(padding, 0, /*default_value=*/0);
+    params.padding_x = val_at(padding, 1, /*default_value=*/0);
+    params.dilation_y = val_at(dilation, 0);
+    params.dilation_x = val_at(dilation, 1);
+  }
+  params.groups = groups;
+  params.channels_last =
+      in.dim() == 4 && is_channels_last_dim_order(in.dim_order().data(), 4);
+  return params;
+}
+
+/**
+ * Returns the range [begin, end) of indices o in [0, out_size) for which
+ * o * stride + offset is in [0, in_size), so that the innermost loops need no
+ * bounds checks.
+ */
+std::pair<int64_t, int64_t> valid_range(
+    int64_t in_size,
+    int64_t out_size,
+    int64_t stride,
+    int64_t offset) {
+  const int64_t begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  const int64_t end = in_size - offset > 0
+      ? (in_size - offset + stride - 1) / stride
+      : 0;
+  const int64_t clamped_begin = std::min(begin, out_size);
+  return {clamped_begin, std::clamp(end, clamped_begin, out_size)};
+}
+
+template <typename CTYPE, typename LoadFn>
+void fill_with_bias(
+    CTYPE* out_plane,
+    int64_t channel_stride,
+    int64_t pixel_stride,
+    int64_t c_begin,
+    int64_t c_end,
+    int64_t num_pixels,
+    const std::optional<Tensor>& bias,
+    LoadFn load_bias) {
+  const char* const bias_ptr = bias.has_value()
+      ? reinterpret_cast<const char*>(bias.value().const_data_ptr())
+      : nullptr;
+  for (const auto c : c10::irange(c_begin, c_end)) {
+    const CTYPE value = bias_ptr != nullptr
+        ? load_bias(&bias_ptr[c * bias.value().element_size()])
+        : static_cast<CTYPE>(0);
+    CTYPE* const out_c = out_plane + c * channel_stride;
+    for (const auto p : c10::irange(num_pixels)) {
+      out_c[p * pixel_stride] = value;
+    }
+  }
+}
+
+/**
+ * Copies the input patches of output pixels [p_begin, p_end) into `cols`, for
+ * the rows [k_begin, k_end) of the weight matrix of `group`. Element (k, p)
+ * goes to cols[(k - k_begin) * k_stride + (p - p_begin) * p_stride], and is 0
+ * where the patch overlaps the padding.
+ *
+ * Row k of the weight matrix is the weight element at offset k within an
+ * output channel, so the rows follow the dim order of the weight.
+ */
+template <typename CTYPE>
+void im2col(
+    const Conv2dParams& params,
+    const CTYPE* in_n,
+    int64_t group,
+    int64_t p_begin,
+    int64_t p_end,
+    int64_t k_begin,
+    int64_t k_end,
+    CTYPE* cols,
+    int64_t k_stride,
+    int64_t p_stride) {
+  const Operand2d& in = params.in;
+  const Operand2d& w = params.weight;
+  const int64_t out_W = params.out.size[3];
+  const int64_t in_c_start = group * w.size[1];
+
+  // Dims 1, 2 and 3 of the weight from outermost to innermost.
+  int64_t w_dims[3] = {1, 2, 3};
+  std::sort(w_dims, w_dims + 3, [&](int64_t a, int64_t b) {
+    return w.stride[a] > w.stride[b];
+  });
+
+  for (const auto k : c10::irange(k_begin, k_end)) {
+    int64_t coord[4];
+    int64_t rem = k;
+    for (const auto d : w_dims) {
+      // Dims of size 1 may share their stride with another dim.
+      if (w.size[d] == 1) {
+        coord[d] = 0;
+        continue;
+      }
+      coord[d] = rem / w.stride[d];
+      rem %= w.stride[d];
+    }
+    const CTYPE* const in_c = in_n + (in_c_start + coord[1]) * in.stride[1];
+    const int64_t offset_y = coord[2] * params.dilation_y - params.padding_y;
+    const int64_t offset_x = coord[3] * params.dilation_x - params.padding_x;
+
+    CTYPE* const col = cols + (k - k_begin) * k_stride;
+    int64_t out_y = p_begin / out_W;
+    int64_t out_x = p_begin % out_W;
+    for (const auto p : c10::irange(p_end - p_begin)) {
+      const int64_t in_y = out_y * params.stride_y + offset_y;
+      const int64_t in_x = out_x * params.stride_x + offset_x;
+      col[p * p_stride] =
+          (in_y >= 0 && in_y < in.size[2] && in_x >= 0 && in_x < in.size[3])
+          ? in_c[in_y * in.stride[2] + in_x * in.stride[3]]
+          : static_cast<CTYPE>(0);
+      if (++out_x == out_W) {
+        out_x = 0;
+        ++out_y;
+      }
+    }
+  }
+}
+
+/**
+ * Convolution as one GEMM per batch, group and tile of output pixels,
+ * between the weight matrix of the group and the patches of the input that
+ * the pixels see. The patches are gathered by im2col a block of weight rows
+ * at a time into a small buffer, except for 1x1 convolutions with unit
+ * strides whose input already is the patch matrix.
+ */
+template <typename CTYPE, typename LoadFn>
+void conv2d_gemm(
+    const Conv2dParams& params,
+    const CTYPE* in_ptr,
+    const CTYPE* w_ptr,
+    const std::optional<Tensor>& bias,
+    LoadFn load_bias,
+    CTYPE* out_ptr) {
+  const Operand2d& in = params.in;
+  const Operand2d& w = params.weight;
+  const Operand2d& out = params.out;
+
+  const int64_t out_C_per_group = out.size[1] / params.groups;
+  const int64_t num_pixels = out.size[2] * out.size[3];
+  // Rows of the weight matrix of a group, i.e. the size of a patch.
+  const int64_t K = w.stride[0];
+  const bool pointwise = w.size[2] == 1 && w.size[3] == 1 &&
+      params.stride_y == 1 && params.stride_x == 1 && params.padding_y == 0 &&
+      params.padding_x == 0;
+
+  constexpr int64_t cols_capacity = kColsBufferBytes / sizeof(CTYPE);
+  const int64_t k_block =
+      std::min(K, std::max<int64_t>(cols_capacity / kMinTilePixels, 1));
+  const int64_t tile_pixels =
+      std::min(num_pixels, std::max<int64_t>(cols_capacity / k_block, 1));
+  const int64_t num_tiles = (num_pixels + tile_pixels - 1) / tile_pixels;
+
+  // The pixels of in and out are contiguous in NCHW, and C apart in NHWC.
+  const int64_t in_pixel_stride = in.stride[3];
+  const int64_t out_pixel_stride = out.stride[3];
+
+  const int64_t num_tasks = out.size[0] * params.groups * num_tiles;
+  ::executorch::extension::parallel_for(
+      0, num_tasks, 1, [&](const auto begin, const auto end) {
+        alignas(64) char cols_buffer[kColsBufferBytes];
+        CTYPE* const cols = reinterpret_cast<CTYPE*>(cols_buffer);
+
+        for (const auto task : c10::irange(begin, end)) {
+          const int64_t tile = task % num_tiles;
+          const int64_t group = (task / num_tiles) % params.groups;
+          const int64_t n = task / num_tiles / params.groups;
+
+          const int64_t p_begin = tile * tile_pixels;
+          const int64_t p_end = std::min(p_begin + tile_pixels, num_pixels);
+          const int64_t tile_size = p_end - p_begin;
+          const int64_t out_c_start = group * out_C_per_group;
+
+          const CTYPE* const in_n = in_ptr + n * in.stride[0];
+          const CTYPE* const w_g = w_ptr + out_c_start * w.stride[0];
+          CTYPE* const out_tile = out_ptr + n * out.stride[0] +
+              out_c_start * out.stride[1] + p_begin * out_pixel_stride;
+
+          if (bias.has_value()) {
+            fill_with_bias(
+                out_tile - out_c_start * out.stride[1],
+                out.stride[1],
+                out_pixel_stride,
+                out_c_start,
+                out_c_start + out_C_per_group,
+                tile_size,
+                bias,
+                load_bias);
+          }
+
+          const int64_t k_step = pointwise ? K : k_block;
+          for (int64_t k_begin = 0; k_begin < K; k_begin += k_step) {
+            const int64_t k_size = std::min(k_step, K - k_begin);
+            const CTYPE beta = (bias.has_value() || k_begin > 0)
+                ? static_cast<CTYPE>(1)
+                : static_cast<CTYPE>(0);
+
+            // The patches of the tile, as a column-major matrix of size
+            // tile_size x k_size for NCHW and k_size x tile_size for NHWC.
+            const CTYPE* patches = cols;
+            int64_t ld_patches = 0;
+            if (pointwise) {
+              patches = in_n + group * w.size[1] * in.stride[1] +
+                  p_begin * in_pixel_stride;
+              ld_patches = params.channels_last ? in.stride[3] : in.stride[1];
+            } else if (params.channels_last) {
+              im2col(
+                  params,
+                  in_n,
+                  group,
+                  p_begin,
+                  p_end,
+                  k_begin,
+                  k_begin + k_size,
+                  cols,
+                  /*k_stride=*/1,
+                  /*p_stride=*/k_size);
+              ld_patches = k_size;
+            } else {
+              im2col(
+                  params,
+                  in_n,
+                  group,
+                  p_begin,
+                  p_end,
+                  k_begin,
+                  k_begin + k_size,
+                  cols,
+                  /*k_stride=*/tile_size,
+                  /*p_stride=*/1);
+              ld_patches = tile_size;
+            }
+
+            if (params.channels_last) {
+              // out^T (out_C_per_group x tile_size) += W^T * patches
+              gemm(
+                  TransposeType::Transpose,
+                  TransposeType::NoTranspose,
+                  out_C_per_group,
+                  tile_size,
+                  k_size,
+                  static_cast<CTYPE>(1),
+                  w_g + k_begin,
+                  K,
+                  patches,
+                  ld_patches,
+                  beta,
+                  out_tile,
+                  out_pixel_stride);
+            } else {
+              // out (tile_size x out_C_per_group) += patches * W
+              gemm(
+                  TransposeType::NoTranspose,
+                  TransposeType::NoTranspose,
+                  tile_size,
+                  out_C_per_group,
+                  k_size,
+                  static_cast<CTYPE>(1),
+                  patches,
+                  ld_patches,
+                  w_g + k_begin,
+                  K,
+                  beta,
+                  out_tile,
+                  out.stride[1]);
+            }
+          }
+        }
+      });
+}
+
+/**
+ * Depthwise convolution: each output channel only sees one input channel, so
+ * there is no reduction to hand to a GEMM. Each task computes whole output
+ * channels by accumulating shifted rows of the input, which vectorizes along
+ * the width for NCHW inputs.
+ */
+template <typename CTYPE, typename LoadFn>
+void conv2d_depthwise(
+    const Conv2dParams& params,
+    const CTYPE* in_ptr,
+    const CTYPE* w_ptr,
+    const std::optional<Tensor>& bias,
+    LoadFn load_bias,
+    CTYPE* out_ptr) {
+  const Operand2d& in = params.in;
+  const Operand2d& w = params.weight;
+  const Operand2d& out = params.out;
+  const int64_t out_C = out.size[1];
+  const int64_t out_C_per_group = out_C / params.groups;
+
+  ::executorch::extension::parallel_for(
+      0, out.size[0] * out_C, 1, [&](const auto begin, const auto end) {
+        for (const auto task : c10::irange(begin, end)) {
+          const int64_t n = task / out_C;
+          const int64_t out_c = task % out_C;
+          const int64_t in_c = out_c / out_C_per_group;
+
+          const CTYPE* const in_c_ptr =
+              in_ptr + n * in.stride[0] + in_c * in.stride[1];
+          const CTYPE* const w_c = w_ptr + out_c * w.stride[0];
+          CTYPE* const out_n = out_ptr + n * out.stride[0];
+          CTYPE* const out_c_ptr = out_n + out_c * out.stride[1];
+
+          for (const auto out_y : c10::irange(out.size[2])) {
+            fill_with_bias(
+                out_n + out_y * out.stride[2],
+                out.stride[1],
+                out.stride[3],
+                out_c,
+                out_c + 1,
+                out.size[3],
+                bias,
+                load_bias);
+          }
+
+          for (const auto w_y : c10::irange(w.size[2])) {
+            const auto [y_begin, y_end] = valid_range(
+                in.size[2],
+                out.size[2],
+                params.stride_y,
+                w_y * params.dilation_y - params.padding_y);
+            for (const auto w_x : c10::irange(w.size[3])) {
+              const int64_t offset_x =
+                  w_x * params.dilation_x - params.padding_x;
+              const auto [x_begin, x_end] = valid_range(
+                  in.size[3], out.size[3], params.stride_x, offset_x);
+              const CTYPE w_val = w_c[w_y * w.stride[2] + w_x * w.stride[3]];
+
+              for (const auto out_y : c10::irange(y_begin, y_end)) {
+                const int64_t in_y = out_y * params.stride_y +
+                    w_y * params.dilation_y - params.padding_y;
+                const CTYPE* const in_row = in_c_ptr + in_y * in.stride[2];
+                CTYPE* const out_row = out_c_ptr + out_y * out.stride[2];
+                for (const auto out_x : c10::irange(x_begin, x_end)) {
+                  out_row[out_x * out.stride[3]] += w_val *
+                      in_row[(out_x * params.stride_x + offset_x) *
+                             in.stride[3]];
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+/**
+ * Transposed convolution: each input pixel scatters into a window of the
+ * output. Each task owns whole output channels so that the scatters of
+ * different threads never overlap.
+ */
+template <typename CTYPE, typename LoadFn>
+void conv2d_transposed(
+    const Conv2dParams& params,
+    const CTYPE* in_ptr,
+    const CTYPE* w_ptr,
+    const std::optional<Tensor>& bias,
+    LoadFn load_bias,
+    CTYPE* out_ptr) {
+  const Operand2d& in = params.in;
+  const Operand2d& w = params.weight;
+  const Operand2d& out = params.out;
+  const int64_t out_C = out.size[1];
+  const int64_t out_C_per_group = w.size[1];
+  const int64_t in_C_per_group = in.size[1] / params.groups;
+
+  ::executorch::extension::parallel_for(
+      0, out.size[0] * out_C, 1, [&](const auto begin, const auto end) {
+        for (const auto task : c10::irange(begin, end)) {
+          const int64_t n = task / out_C;
+          const int64_t out_c = task % out_C;
+          const int64_t group = out_c / out_C_per_group;
+
+          CTYPE* const out_n = out_ptr + n * out.stride[0];
+          CTYPE* const out_c_ptr = out_n + out_c * out.stride[1];
+          for (const auto out_y : c10::irange(out.size[2])) {
+            fill_with_bias(
+                out_n + out_y * out.stride[2],
+                out.stride[1],
+                out.stride[3],
+                out_c,
+                out_c + 1,
+                out.size[3],
+                bias,
+                load_bias);
+          }
+
+          for (const auto in_c : c10::irange(
+                   group * in_C_per_group, (group + 1) * in_C_per_group)) {
+            const CTYPE* const in_c_ptr =
+                in_ptr + n * in.stride[0] + in_c * in.stride[1];
+            const CTYPE* const w_c = w_ptr + in_c * w.stride[0] +
+                (out_c - group * out_C_per_group) * w.stride[1];
+
+            for (const auto w_y : c10::irange(w.size[2])) {
+              const int64_t offset_y =
+                  w_y * params.dilation_y - params.padding_y;
+              const auto [y_begin, y_end] = valid_range(
+                  out.size[2], in.size[2], params.stride_y, offset_y);
+              for (const auto w_x : c10::irange(w.size[3])) {
+                const int64_t offset_x =
+                    w_x * params.dilation_x - params.padding_x;
+                const auto [x_begin, x_end] = valid_range(
+                    out.size[3], in.size[3], params.stride_x, offset_x);
+                const CTYPE w_val =
+                    w_c[w_y * w.stride[2] + w_x * w.stride[3]];
+
+                for (const auto in_y : c10::irange(y_begin, y_end)) {
+                  const CTYPE* const in_row = in_c_ptr + in_y * in.stride[2];
+                  CTYPE* const out_row = out_c_ptr +
+                      (in_y * params.stride_y + offset_y) * out.stride[2];
+                  for (const auto in_x : c10::irange(x_begin, x_end)) {
+                    const int64_t out_x = in_x * params.stride_x + offset_x;
+                    out_row[out_x * out.stride[3]] +=
+                        w_val * in_row[in_x * in.stride[3]];
+                  }
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+} // namespace
+
+Tensor& opt_convolution_out(
+    KernelRuntimeContext& ctx,
+    const Tensor& in,
+    const Tensor& weight,
+    const std::optional<Tensor>& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    bool transposed,
+    IntArrayRef output_padding,
+    int64_t groups,
+    Tensor& out) {
+  ET_KERNEL_CHECK(
+      ctx,
+      check_convolution_args(
+          in,
+          weight,
+          bias,
+          stride,
+          padding,
+          dilation,
+          transposed,
+          output_padding,
+          groups,
+          out),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx, tensors_have_same_dim_order(in, out), InvalidArgument, out);
+
+  size_t output_ndim = 0;
+  executorch::aten::SizesType output_sizes[kTensorDimensionLimit];
+  get_convolution_out_target_size(
+      in,
+      weight,
+      stride,
+      padding,
+      dilation,
+      transposed,
+      output_padding,
+      groups,
+      output_sizes,
+      &output_ndim);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      output_size_is_valid({output_sizes, output_ndim}, in.dim() - 2),
+      InvalidArgument,
+      out);
+
+  ET_KERNEL_CHECK(
+      ctx,
+      resize_tensor(out, {output_sizes, output_ndim}) == Error::Ok,
+      InvalidArgument,
+      out);
+
+  if (out.numel() == 0) {
+    return out;
+  }
+
+  const Conv2dParams params =
+      make_conv2d_params(in, weight, out, stride, padding, dilation, groups);
+  const bool depthwise = !transposed && groups > 1 && weight.size(1) == 1;
+
+  // @lint-ignore CLANGTIDY facebook-hte-CArray
+  static constexpr const char name[] = "convolution.out";
+
+  ET_SWITCH_REALH_TYPES(in.scalar_type(), ctx, name, CTYPE, [&]() {
+    const auto load_bias = bias.has_value()
+        ? utils::internal::get_load_to_compute_fn<CTYPE, name>(
+              bias.value(), utils::SupportedTensorDtypes::REALHBF16)
+        : nullptr;
+    const CTYPE* const in_ptr = in.const_data_ptr<CTYPE>();
+    const CTYPE* const w_ptr = weight.const_data_ptr<CTYPE>();
+    CTYPE* const out_ptr = out.mutable_data_ptr<CTYPE>();
+    if (transposed) {
+      conv2d_transposed(params, in_ptr, w_ptr, bias, load_bias, out_ptr);
+    } else if (depthwise) {
+      conv2d_depthwise(params, in_ptr, w_ptr, bias, load_bias, out_ptr);
+    } else {
+      conv2d_gemm(params, in_ptr, w_ptr, bias, load_bias, out_ptr);
+    }
+  });
+
+  return out;
+}
+
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -8,9 +8,13 @@
 
 #include <gtest/gtest.h>
 
+#include <executorch/kernels/optimized/blas/BlockedGemm.h>
 #include <executorch/kernels/optimized/blas/CPUBlas.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 
+#include <cmath>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #define TEST_FORALL_SUPPORTED_CTYPES(_, N)   \
@@ -80,3 +84,189 @@ void test_matmul_ones() {
 TEST(BlasTest, MatmulOnes) {
   TEST_FORALL_SUPPORTED_CTYPES(test_matmul_ones, 25);
 }
+
+namespace {
+
+using executorch::cpublas::TransposeType;
+
+// A column-major matrix with padding between its columns.
+template <typename CTYPE>
+struct Matrix {
+  Matrix(int64_t rows, int64_t cols) : rows(rows), ld(rows + 3) {
+    data.resize(ld * cols);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<CTYPE>(static_cast<float>(i * 7 % 17) / 8 - 1);
+    }
+  }
+
+  int64_t rows;
+  int64_t ld;
+  std::vector<CTYPE> data;
+};
+
+// op(x)(i, j) of a column-major matrix.
+template <typename CTYPE>
+double
+element(const Matrix<CTYPE>& x, TransposeType trans, int64_t i, int64_t j) {
+  return trans == TransposeType::NoTranspose
+      ? static_cast<float>(x.data[i + j * x.ld])
+      : static_cast<float>(x.data[j + i * x.ld]);
+}
+
+template <typename CTYPE>
+void test_blocked_gemm(
+    TransposeType transa,
+    TransposeType transb,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float alpha,
+    float beta,
+    bool use_packed_a = false) {
+  const bool ta = transa != TransposeType::NoTranspose;
+  const bool tb = transb != TransposeType::NoTranspose;
+  Matrix<CTYPE> a(ta ? k : m, ta ? m : k);
+  Matrix<CTYPE> b(tb ? n : k, tb ? k : n);
+  Matrix<CTYPE> c(m, n);
+  const std::vector<CTYPE> c_in = c.data;
+
+  if (use_packed_a) {
+    auto packed_a = executorch::cpublas::PackedGemmA::pack(
+        transa, m, k, a.data.data(), a.ld);
+    executorch::cpublas::blocked_gemm(
+        *packed_a,
+        transb,
+        n,
+        alpha,
+        b.data.data(),
+        b.ld,
+        beta,
+        c.data.data(),
+        c.ld);
+  } else {
+    // clang-format off
+    executorch::cpublas::blocked_gemm(
+        transa, transb,
+        m, n, k,
+        alpha,
+        a.data.data(), a.ld,
+        b.data.data(), b.ld,
+        beta,
+        c.data.data(), c.ld);
+    // clang-format on
+  }
+
+  // Values are multiples of 1/8 that Half and BFloat16 hold exactly, so the
+  // only error is the float accumulation and the rounding of the result.
+  const double tolerance = std::is_same<CTYPE, float>::value ? 1e-5 : 1e-2;
+  for (int64_t j = 0; j < n; ++j) {
+    for (int64_t i = 0; i < m; ++i) {
+      double expected = 0;
+      for (int64_t p = 0; p < k; ++p) {
+        expected += element(a, transa, i, p) * element(b, transb, p, j);
+      }
+      expected *= alpha;
+      if (beta != 0) {
+        expected += beta * static_cast<float>(c_in[i + j * c.ld]);
+      }
+      const double actual = static_cast<float>(c.data[i + j * c.ld]);
+      ASSERT_NEAR(actual, expected, tolerance * (1 + std::abs(expected)))
+          << "at (" << i << ", " << j << ") of " << m << "x" << n << "x" << k;
+    }
+  }
+  // The padding between the columns of c is untouched.
+  for (int64_t j = 0; j < n; ++j) {
+    for (int64_t i = m; i < c.ld; ++i) {
+      ASSERT_EQ(c.data[i + j * c.ld], c_in[i + j * c.ld]);
+    }
+  }
+}
+
+constexpr TransposeType kTransposeTypes[] = {
+    TransposeType::NoTranspose, TransposeType::Transpose};
+
+} // namespace
+
+TEST(BlasTest, BlockedGemmMatchesReference) {
+  // Sizes below, at and past the register tile, the blocks of A and the
+  // panels of B.
+  const int64_t sizes[][3] = {
+      {1, 1, 1},
+      {7, 5, 3},
+      {33, 17, 9},
+      {130, 70, 300},
+      {9, 1100, 5},
+  };
+  for (const auto transa : kTransposeTypes) {
+    for (const auto transb : kTransposeTypes) {
+      for (const auto& size : sizes) {
+        test_blocked_gemm<float>(
+            transa, transb, size[0], size[1], size[2], 1.0f, 0.0f);
+      }
+    }
+  }
+}
+
+TEST(BlasTest, BlockedGemmAlphaBeta) {
+  test_blocked_gemm<float>(
+      TransposeType::NoTranspose,
+      TransposeType::Transpose,
+      40,
+      30,
+      20,
+      2.0f,
+      0.5f);
+  test_blocked_gemm<float>(
+      TransposeType::Transpose,
+      TransposeType::NoTranspose,
+      40,
+      30,
+      300,
+      -1.0f,
+      1.0f);
+  // alpha == 0 only scales c.
+  test_blocked_gemm<float>(
+      TransposeType::NoTranspose,
+      TransposeType::NoTranspose,
+      40,
+      30,
+      20,
+      0.0f,
+      0.5f);
+}
+
+TEST(BlasTest, BlockedGemmIgnoresOutputWhenBetaIsZero) {
+  const int64_t m = 20, n = 10, k = 5;
+  std::vector<float> a(m * k, 1.0f);
+  std::vector<float> b(k * n, 1.0f);
+  std::vector<float> c(m * n, std::numeric_limits<float>::quiet_NaN());
+  // clang-format off
+  executorch::cpublas::blocked_gemm(
+      TransposeType::NoTranspose, TransposeType::NoTranspose,
+      m, n, k,
+      1.0f,
+      a.data(), m,
+      b.data(), k,
+      0.0f,
+      c.data(), m);
+  // clang-format on
+  EXPECT_TRUE(check_all_equal_to(c, static_cast<float>(k)));
+}
+
+TEST(BlasTest, BlockedGemmReducedPrecision) {
+  for (const auto transa : kTransposeTypes) {
+    test_blocked_gemm<executorch::aten::Half>(
+        transa, TransposeType::NoTranspose, 70, 20, 40, 1.0f, 0.0f);
+    test_blocked_gemm<executorch::aten::BFloat16>(
+        transa, TransposeType::Transpose, 70, 20, 40, 1.0f, 1.0f);
+  }
+}
+
+TEST(BlasTest, BlockedGemmPackedA) {
+  for (const auto transa : kTransposeTypes) {
+    test_blocked_gemm<float>(
+        transa, TransposeType::NoTranspose, 130, 20, 300, 1.0f, 0.0f, true);
+    test_blocked_gemm<executorch::aten::Half>(
+        transa, TransposeType::Transpose, 33, 17, 9, 1.0f, 0.5f, true);
+  }
+}
@@ -76,6 +76,7 @@ class BroadcastIndexesIterator {
       effective_input_broadcast_strides_ = {
           effective_input_broadcast_stride(output, args)...};
     }
+    compute_inner_run(output);
   }
 
   struct make_end_t {
@@ -184,10 +185,89 @@ class BroadcastIndexesIterator {
     return difference_type(output_index() - rhs.output_index());
   }
 
+  /**
+   * Number of elements, starting at the current one, that belong to the
+   * same inner run. Within a run, every index advances by a fixed stride
+   * (see inner_run_strides()), so callers can process the whole run with
+   * a plain loop instead of incrementing the iterator per element.
+   */
+  ssize_t inner_run_remaining() const {
+    return inner_run_size_ - output_index() % inner_run_size_;
+  }
+
+  /**
+   * The step each index takes between consecutive elements of a run. The
+   * 0th entry is for the output and is always 1; a 0 entry means the
+   * input is broadcast across the run.
+   */
+  const value_type& inner_run_strides() const {
+    return inner_run_strides_;
+  }
+
+  /**
+   * Advances by n elements, which must not exceed inner_run_remaining().
+   * Finishing a run is as cheap as a single increment.
+   */
+  BroadcastIndexesIterator& advance_inner_run(difference_type n) {
+    if (output_dim_or_zero_if_no_broadcasting_ == 0 ||
+        n != inner_run_remaining()) {
+      return *this += n;
+    }
+    // Jump to the last element of the run, then let operator++ carry
+    // into the outer dimensions.
+    output_index() += n - 1;
+    for (const auto ii : c10::irange(1, kNumInputs + 1)) {
+      current_indexes_[ii] += (n - 1) * inner_run_strides_[ii];
+    }
+    for (auto ii = output_dim_or_zero_if_no_broadcasting_ - inner_run_dims_;
+         ii < output_dim_or_zero_if_no_broadcasting_;
+         ++ii) {
+      delinearized_output_index_[ii] = output_shape_[ii] - 1;
+    }
+    return ++*this;
+  }
+
  private:
   using ShapeType =
       std::array<std::size_t, executorch::runtime::kTensorDimensionLimit>;
 
+  // Finds the longest run of trailing output dimensions that every
+  // tensor walks through with a single stride, so that [N, C, H, W] +
+  // [C, 1, 1] yields runs of H * W elements rather than W.
+  void compute_inner_run(const Tensor& output) {
+    inner_run_strides_.fill(1);
+    if (output_dim_or_zero_if_no_broadcasting_ == 0) {
+      inner_run_size_ = std::max<ssize_t>(output.numel(), 1);
+      return;
+    }
+    bool found_inner_dim = false;
+    for (auto ii = output_dim_or_zero_if_no_broadcasting_ - 1; ii >= 0; --ii) {
+      const auto size = output_shape_[ii];
+      if (size != 1) {
+        if (!found_inner_dim) {
+          for (const auto jj : c10::irange(1, kNumInputs + 1)) {
+            inner_run_strides_[jj] =
+                effective_input_broadcast_strides_[jj - 1][ii];
+          }
+          found_inner_dim = true;
+        } else {
+          bool mergeable = true;
+          for (const auto jj : c10::irange(1, kNumInputs + 1)) {
+            mergeable = mergeable &&
+                static_cast<ssize_t>(
+                    effective_input_broadcast_strides_[jj - 1][ii]) ==
+                    inner_run_strides_[jj] * inner_run_size_;
+          }
+          if (!mergeable) {
+            break;
+          }
+        }
+        inner_run_size_ *= size;
+      }
+      inner_run_dims_++;
+    }
+  }
+
   ssize_t output_index() const {
     return current_indexes_[0];
   }
@@ -235,6 +315,12 @@ class BroadcastIndexesIterator {
   // adjusted stride array that contains 0s where the padded input
   // shape would contain 1s.
   std::array<ShapeType, kNumInputs> effective_input_broadcast_strides_;
+  // The innermost inner_run_dims_ output dimensions, holding
+  // inner_run_size_ elements, form runs that every tensor walks with the
+  // stride in inner_run_strides_.
+  value_type inner_run_strides_ = {0};
+  ssize_t inner_run_size_ = 1;
+  ssize_t inner_run_dims_ = 0;
 };
 
 // When there is only 1 input and no noncontiguous tensor support
@@ -251,8 +337,9 @@ class BroadcastIndexesIterator<1, false> {
   BroadcastIndexesIterator() = default;
 
   explicit BroadcastIndexesIterator(
-      [[maybe_unused]] const Tensor& output,
-      [[maybe_unused]] const Tensor& input) {}
+      const Tensor& output,
+      [[maybe_unused]] const Tensor& input)
+      : numel_(output.numel()) {}
 
   struct make_end_t {
     explicit constexpr make_end_t() = default;
@@ -306,6 +393,20 @@ class BroadcastIndexesIterator<1, false> {
     return difference_type(current_index() - rhs.current_index());
   }
 
+  ssize_t inner_run_remaining() const {
+    return numel_ - current_index();
+  }
+
+  const value_type& inner_run_strides() const {
+    static constexpr value_type kStrides = {{1, 1}};
+    return kStrides;
+  }
+
+  BroadcastIndexesIterator& advance_inner_run(difference_type n) {
+    add_to_current_index(n);
+    return *this;
+  }
+
  private:
   ssize_t current_index() const {
     return current_indexes_[0];
@@ -316,6 +417,7 @@ class BroadcastIndexesIterator<1, false> {
     current_indexes_[1] = current_indexes_[0];
   }
   value_type current_indexes_ = {{0, 0}};
+  ssize_t numel_ = 0;
 };
 } // namespace internal
 
@@ -337,6 +439,17 @@ class BroadcastIndexesIterator<1, false> {
  * linearize_access_indexes(), BroadcastIndexesRange avoids expensive
  * division and modulo operations on each iteration.
  *
+ * Hot loops can go further and consume whole inner runs at a time, in
+ * which each index moves by a fixed stride (0 for broadcast inputs):
+ *
+ * auto it = range.begin();
+ * const auto& strides = it.inner_run_strides();
+ * while ((*it)[0] < end_index) {
+ *   const auto n = std::min(it.inner_run_remaining(), end_index - (*it)[0]);
+ *   // Element k of the run is at (*it)[i] + k * strides[i] for tensor i.
+ *   it.advance_inner_run(n);
+ * }
+ *
  * The support_noncontiguous_input_tensors argument disables an
  * optimization that causes the iterators not to respect strides in
  * some cases for input tensors. This optimization is normally safe
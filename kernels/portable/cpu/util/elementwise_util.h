@@ -22,6 +22,7 @@
 #include <ATen/cpu/vec/vec.h>
 #endif // ET_USE_PYTORCH_HEADERS
 
+#include <algorithm>
 #include <array>
 #include <utility>
 
@@ -167,6 +168,9 @@ inline void dtype_specialized_elementwise_fn_impl(
   }
 #endif // ET_USE_PYTORCH_HEADERS
 
+  // Broadcasting (or strided inputs): walk the inner runs of the
+  // output, in which every input is either contiguous or a single
+  // repeated element, so the inner loop can still be vectorized.
   ::executorch::extension::parallel_for(
       0,
       out.numel(),
@@ -182,13 +186,54 @@ inline void dtype_specialized_elementwise_fn_impl(
                 out, (*inputs.first)...);
         auto begin_it = range.begin();
         begin_it += begin;
-        for (; (*begin_it)[0] < end; ++begin_it) {
+        const auto strides = begin_it.inner_run_strides();
+#if defined(ET_USE_PYTORCH_HEADERS) && ET_USE_PYTORCH_HEADERS
+        bool strides_allow_vectorization = true;
+        for (const auto idx : c10::irange(kNumInputs)) {
+          strides_allow_vectorization = strides_allow_vectorization &&
+              (strides[idx + 1] == 0 || strides[idx + 1] == 1);
+        }
+#endif // ET_USE_PYTORCH_HEADERS
+        while ((*begin_it)[0] < end) {
           const auto& indexes = *begin_it;
-          std::array<CTYPE_COMPUTE, kNumInputs> loaded_inputs;
+          const ssize_t run_length = std::min<ssize_t>(
+              begin_it.inner_run_remaining(), end - indexes[0]);
+          std::array<const CTYPE_COMPUTE*, kNumInputs> run_inputs;
           for (const auto idx : c10::irange(kNumInputs)) {
-            loaded_inputs[idx] = inputs_data_ptrs[idx][indexes[idx + 1]];
+            run_inputs[idx] = &inputs_data_ptrs[idx][indexes[idx + 1]];
+          }
+          CTYPE_OUT* const run_out = &data_out[indexes[0]];
+          ssize_t k = 0;
+#if defined(ET_USE_PYTORCH_HEADERS) && ET_USE_PYTORCH_HEADERS
+          if constexpr (can_use_vectorized<CTYPE_COMPUTE, Op, Args...>()) {
+            using Vec = at::vec::Vectorized<CTYPE_COMPUTE>;
+            if (strides_allow_vectorization && run_length >= Vec::size()) {
+              std::array<Vec, kNumInputs> loaded_vec_inputs;
+              for (const auto idx : c10::irange(kNumInputs)) {
+                if (strides[idx + 1] == 0) {
+                  loaded_vec_inputs[idx] = Vec(run_inputs[idx][0]);
+                }
+              }
+              for (; k + Vec::size() <= run_length; k += Vec::size()) {
+                for (const auto idx : c10::irange(kNumInputs)) {
+                  if (strides[idx + 1] != 0) {
+                    loaded_vec_inputs[idx] = Vec::loadu(&run_inputs[idx][k]);
+                  }
+                }
+                auto result_vec = std::apply(compute_fun, loaded_vec_inputs);
+                result_vec.store(&run_out[k]);
+              }
+            }
           }
-          data_out[indexes[0]] = std::apply(compute_fun, loaded_inputs);
+#endif // ET_USE_PYTORCH_HEADERS
+          for (; k < run_length; ++k) {
+            std::array<CTYPE_COMPUTE, kNumInputs> loaded_inputs;
+            for (const auto idx : c10::irange(kNumInputs)) {
+              loaded_inputs[idx] = run_inputs[idx][k * strides[idx + 1]];
+            }
+            run_out[k] = std::apply(compute_fun, loaded_inputs);
+          }
+          begin_it.advance_inner_run(run_length);
         }
       });
 }
@@ -259,18 +304,25 @@ inline void apply_elementwise_fn_generic_impl(
                 out, (*inputs.first)...);
         auto begin_it = range.begin();
         begin_it += begin;
-        for (; (*begin_it)[0] < end; ++begin_it) {
+        const auto strides = begin_it.inner_run_strides();
+        while ((*begin_it)[0] < end) {
           const auto& indexes = *begin_it;
-          std::array<CTYPE_COMPUTE, kNumInputs> loaded_inputs;
-          for (const auto idx : c10::irange(kNumInputs)) {
-            const auto& input_info = inputs_info[idx];
-            loaded_inputs[idx] = input_info.load_to_compute(
-                &input_info
-                     .data_ptr[indexes[idx + 1] * input_info.element_size]);
+          const ssize_t run_length = std::min<ssize_t>(
+              begin_it.inner_run_remaining(), end - indexes[0]);
+          for (const auto k : c10::irange(run_length)) {
+            std::array<CTYPE_COMPUTE, kNumInputs> loaded_inputs;
+            for (const auto idx : c10::irange(kNumInputs)) {
+              const auto& input_info = inputs_info[idx];
+              loaded_inputs[idx] = input_info.load_to_compute(
+                  &input_info.data_ptr
+                       [(indexes[idx + 1] + k * strides[idx + 1]) *
+                        input_info.element_size]);
+            }
+            auto result = std::apply(compute_fun, loaded_inputs);
+            store_compute_to_out(
+                result, &data_out[(indexes[0] + k) * out_element_size]);
           }
-          auto result = std::apply(compute_fun, loaded_inputs);
-          store_compute_to_out(
-              result, &data_out[indexes[0] * out_element_size]);
+          begin_it.advance_inner_run(run_length);
         }
       });
 }
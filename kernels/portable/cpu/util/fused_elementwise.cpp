@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/portable/cpu/util/fused_elementwise.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <executorch/kernels/portable/cpu/util/elementwise_util.h>
+#include <executorch/runtime/core/exec_aten/util/dim_order_util.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
+
+namespace torch {
+namespace executor {
+namespace native {
+namespace utils {
+
+using executorch::runtime::FusedElementwiseStep;
+using executorch::runtime::FusibleElementwiseOp;
+
+namespace {
+
+// Elements computed at a time. The intermediate results of a chunk stay in
+// L1 while every step of the chain is applied to it.
+constexpr int64_t kChunkSize = 256;
+
+// The largest number of inputs that a chain can have: two per step for the
+// longest chains that Method fuses.
+constexpr size_t kMaxInputs = 32;
+
+bool is_supported_tensor(const Tensor& t, const Tensor& reference) {
+  return t.scalar_type() == ScalarType::Float &&
+      t.sizes().equals(reference.sizes()) &&
+      executorch::runtime::is_contiguous_dim_order(
+             t.dim_order().data(), t.dim());
+}
+
+// Whether the memory of `a` and `b` overlaps without being the same.
+bool overlaps_partially(const Tensor& a, const Tensor& b) {
+  const auto* a_begin = static_cast<const char*>(a.const_data_ptr());
+  const auto* b_begin = static_cast<const char*>(b.const_data_ptr());
+  if (a_begin == b_begin) {
+    return false;
+  }
+  return a_begin < b_begin + b.nbytes() && b_begin < a_begin + a.nbytes();
+}
+
+// Applies `compute_fun` to `len` elements of the operands. Like
+// apply_*_elementwise_fn(), this uses at::vec::Vectorized when `compute_fun`
+// accepts it; see [NOTE: Generic lambdas] in elementwise_util.h. The chunks
+// start at multiples of kChunkSize, so the vectorized and scalar parts of the
+// output are the same as when the portable kernel computes it.
+template <typename Op, typename... Operands>
+void apply_compute_fun(
+    const Op& compute_fun,
+    float* dst,
+    int64_t len,
+    const Operands*... operands) {
+  int64_t i = 0;
+#if defined(ET_USE_PYTORCH_HEADERS) && ET_USE_PYTORCH_HEADERS
+  if constexpr (internal::can_use_vectorized<float, Op, Operands...>()) {
+    using Vec = at::vec::Vectorized<float>;
+    for (; i + Vec::size() <= len; i += Vec::size()) {
+      compute_fun(Vec::loadu(operands + i)...).store(dst + i);
+    }
+  }
+#endif // ET_USE_PYTORCH_HEADERS
+  for (; i < len; ++i) {
+    dst[i] = compute_fun(operands[i]...);
+  }
+}
+
+// Applies one step to `len` elements, with the same function that the
+// portable kernel of the operator passes to elementwise_util.h or
+// apply_unary_map_fn() for float tensors. `dst` never aliases the operands.
+void apply_step(
+    FusibleElementwiseOp op,
+    float alpha,
+    const float* a,
+    const float* b,
+    float* dst,
+    int64_t len) {
+  switch (op) {
+    case FusibleElementwiseOp::Add:
+      apply_compute_fun(
+          [alpha](const auto val_a, const auto val_b) {
+            return val_a + alpha * val_b;
+          },
+          dst,
+          len,
+          a,
+          b);
+      break;
+    case FusibleElementwiseOp::Sub:
+      apply_compute_fun(
+          [alpha](const auto val_a, const auto val_b) {
+            return val_a - (decltype(val_b))(alpha)*val_b;
+          },
+          dst,
+          len,
+          a,
+          b);
+      break;
+    case FusibleElementwiseOp::Mul:
+      apply_compute_fun(
+          [](const auto val_a, const auto val_b) { return val_a * val_b; },
+          dst,
+          len,
+          a,
+          b);
+      break;
+    case FusibleElementwiseOp::Div:
+      apply_compute_fun(
+          [](const auto val_a, const auto val_b) { return val_a / val_b; },
+          dst,
+          len,
+          a,
+          b);
+      break;
+    case FusibleElementwiseOp::Neg:
+      apply_compute_fun(
+          [](const auto val_in) { return -val_in; }, dst, len, a);
+      break;
+    case FusibleElementwiseOp::Relu:
+      apply_compute_fun(
+          [](const float val_in) {
+            return (std::isnan(val_in) || val_in >= 0.0f) ? val_in : 0.0f;
+          },
+          dst,
+          len,
+          a);
+      break;
+    case FusibleElementwiseOp::Sigmoid:
+      apply_compute_fun(
+          [](const auto val_in) {
+            const auto one = static_cast<decltype(val_in)>(1.0);
+            return one / (one + executorch::math::exp(-val_in));
+          },
+          dst,
+          len,
+          a);
+      break;
+    case FusibleElementwiseOp::Tanh:
+      apply_compute_fun(
+          [](const float val_in) { return std::tanh(val_in); }, dst, len, a);
+      break;
+    case FusibleElementwiseOp::Exp:
+      apply_compute_fun(
+          [](const float val_in) { return std::exp(val_in); }, dst, len, a);
+      break;
+  }
+}
+
+// Applies the steps to elements [begin, begin + len) of the inputs and
+// returns the result. The steps alternate between the two buffers of
+// `scratch`, so that none reads the buffer it writes.
+const float* compute_chunk(
+    Span<const FusedElementwiseStep> steps,
+    const float* const* inputs,
+    int64_t begin,
+    int64_t len,
+    float (*scratch)[kChunkSize]) {
+  const float* previous = nullptr;
+  for (size_t i = 0; i < steps.size(); ++i) {
+    const FusedElementwiseStep& step = steps[i];
+    const float* a = step.lhs == FusedElementwiseStep::kPrevious
+        ? previous
+        : inputs[step.lhs] + begin;
+    const float* b = step.rhs == FusedElementwiseStep::kPrevious
+        ? previous
+        : inputs[step.rhs] + begin;
+    float* dst = scratch[i % 2];
+    const float alpha = static_cast<float>(step.alpha);
+    apply_step(step.op, alpha, a, b, dst, len);
+    previous = dst;
+  }
+  return previous;
+}
+
+} // namespace
+
+bool fused_elementwise(
+    KernelRuntimeContext& ctx,
+    Span<const FusedElementwiseStep> steps,
+    Span<EValue*> inputs,
+    EValue& out_value) {
+  if (steps.empty() || inputs.empty() || inputs.size() > kMaxInputs ||
+      !out_value.isTensor()) {
+    return false;
+  }
+  const float* input_data[kMaxInputs];
+  const Tensor& first = inputs[0]->toTensor();
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (!inputs[i]->isTensor()) {
+      return false;
+    }
+    const Tensor& input = inputs[i]->toTensor();
+    if (!is_supported_tensor(input, first)) {
+      return false;
+    }
+    input_data[i] = input.const_data_ptr<float>();
+  }
+  const auto n_inputs = static_cast<int16_t>(inputs.size());
+  for (size_t i = 0; i < steps.size(); ++i) {
+    // The first step has no previous result to read.
+    const int16_t min_operand = i == 0 ? 0 : FusedElementwiseStep::kPrevious;
+    const FusedElementwiseStep& step = steps[i];
+    if (step.lhs < min_operand || step.lhs >= n_inputs ||
+        (executorch::runtime::is_binary_elementwise_op(step.op) &&
+         (step.rhs < min_operand || step.rhs >= n_inputs))) {
+      return false;
+    }
+  }
+
+  Tensor& out = out_value.toTensor();
+  if (out.scalar_type() != ScalarType::Float ||
+      !executorch::runtime::is_contiguous_dim_order(
+          out.dim_order().data(), out.dim()) ||
+      resize_tensor(out, first.sizes()) != Error::Ok) {
+    return false;
+  }
+  // An output that shares memory with an input at an offset would overwrite
+  // elements of that input before they are read.
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (overlaps_partially(out, inputs[i]->toTensor())) {
+      return false;
+    }
+  }
+
+  float* out_data = out.mutable_data_ptr<float>();
+  const int64_t numel = out.numel();
+  const int64_t n_chunks = (numel + kChunkSize - 1) / kChunkSize;
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      ::executorch::extension::internal::GRAIN_SIZE /
+          (kChunkSize * static_cast<int64_t>(steps.size())));
+  const bool success = ::executorch::extension::parallel_for(
+      0, n_chunks, grain_size, [&](int64_t begin, int64_t end) {
+        float scratch[2][kChunkSize];
+        for (int64_t chunk = begin; chunk < end; ++chunk) {
+          const int64_t offset = chunk * kChunkSize;
+          const int64_t len = std::min(kChunkSize, numel - offset);
+          const float* result =
+              compute_chunk(steps, input_data, offset, len, scratch);
+          // The output may be one of the inputs, so it is only written once
+          // all the steps have read the chunk.
+          std::memcpy(out_data + offset, result, len * sizeof(float));
+        }
+      });
+  ET_KERNEL_CHECK_MSG(
+      ctx, success, Internal, true, "parallel_for failed in fused kernel");
+  return true;
+}
+
+} // namespace utils
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <executorch/runtime/kernel/elementwise_fusion.h>
+#include <executorch/runtime/kernel/kernel_includes.h>
+
+namespace torch {
+namespace executor {
+namespace native {
+namespace utils {
+
+/**
+ * Portable implementation of executorch::runtime::FusedElementwiseFunction.
+ * Linking it doesn't enable fusion; to do so, before loading methods, call
+ *
+ *   executorch::runtime::register_fused_elementwise_function(
+ *       torch::executor::native::utils::fused_elementwise);
+ *
+ * Handles chains over float tensors that all have the same shape and a
+ * contiguous dim order, with an output that either doesn't overlap the inputs
+ * or is one of them. The chain is computed one cache-sized chunk at a time,
+ * so the inputs are read and the output is written only once, and the chunks
+ * are spread over the threadpool. Each operator computes exactly what its
+ * portable kernel does for float tensors, even if the method resolved it to
+ * another kernel.
+ */
+bool fused_elementwise(
+    KernelRuntimeContext& ctx,
+    Span<const executorch::runtime::FusedElementwiseStep> steps,
+    Span<EValue*> inputs,
+    EValue& out);
+
+} // namespace utils
+} // namespace native
+} // namespace executor
+} // namespace torch
@@ -35,10 +35,26 @@ def define_common_targets():
             "//executorch/kernels/portable/cpu/util:elementwise_util",
             "//executorch/kernels/portable/cpu/util:upsample_util",
             "//executorch/kernels/portable/cpu/util:vectorized_math",
+            "//executorch/kernels/portable/cpu/util:fused_elementwise",
         ],
         visibility = ["//executorch/...", "@EXECUTORCH_CLIENTS"],
     )
 
+    runtime.cxx_library(
+        name = "fused_elementwise",
+        srcs = ["fused_elementwise.cpp"],
+        exported_headers = ["fused_elementwise.h"],
+        exported_deps = [
+            "//executorch/runtime/kernel:operator_registry",
+        ],
+        deps = [
+            ":elementwise_util",
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/runtime/kernel:kernel_includes",
+        ],
+        visibility = ["//executorch/kernels/portable/cpu/...", "@EXECUTORCH_CLIENTS"],
+    )
+
     runtime.cxx_library(
         name = "activation_ops_util",
         srcs = ["activation_ops_util.cpp"],
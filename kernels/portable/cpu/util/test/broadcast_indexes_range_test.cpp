@@ -61,6 +61,34 @@ void test_operator_plus(const Range& range) {
   }
 }
 
+// Walking the range one inner run at a time, from any starting point,
+// must visit the same indexes as incrementing element by element.
+template <typename Range>
+void test_inner_runs(const Range& range) {
+  const auto expected = range_to_vec(range);
+  for (const auto start : c10::irange(expected.size())) {
+    auto it = range.begin() + start;
+    const auto strides = it.inner_run_strides();
+    EXPECT_EQ(strides[0], 1);
+    size_t pos = start;
+    while (it != range.end()) {
+      const auto run_length = it.inner_run_remaining();
+      ASSERT_GT(run_length, 0);
+      ASSERT_LE(pos + run_length, expected.size());
+      for (const auto k : c10::irange(run_length)) {
+        for (const auto ii : c10::irange(strides.size())) {
+          EXPECT_EQ((*it)[ii] + k * strides[ii], expected[pos + k][ii]);
+        }
+      }
+      // Also exercise stopping partway through a run.
+      const auto step = (pos % 2 == 1 && run_length > 1) ? 1 : run_length;
+      it.advance_inner_run(step);
+      pos += step;
+    }
+    EXPECT_EQ(pos, expected.size());
+  }
+}
+
 // [1] -> [H, W]
 // [W] -> [H, W]
 // [1, 1] -> [H, W]
@@ -106,6 +134,8 @@ TEST(BroadcastIndexesRangeTest, OneAndTwoDExhaustive) {
   EXPECT_EQ(expected, actual);
 
   test_operator_plus(range);
+
+  test_inner_runs(range);
 }
 
 // Make sure nothing is thrown off by a size-1 dim in the output:
@@ -158,6 +188,8 @@ TEST(BroadcastIndexesRangeTest, OneAndTwoDWith1InOutputShapeExhaustive) {
 
   test_operator_plus(range_row);
 
+  test_inner_runs(range_row);
+
   idx = 0;
   const auto range_col = BroadcastIndexesRange<4>(
       out_col, in_0d_scalar, in_1d_scalar, in_2d_scalar, in_col);
@@ -171,6 +203,8 @@ TEST(BroadcastIndexesRangeTest, OneAndTwoDWith1InOutputShapeExhaustive) {
   }
 
   test_operator_plus(range_col);
+
+  test_inner_runs(range_col);
 }
 
 // [1, 1, 1] -> [C, H, W]
@@ -222,6 +256,7 @@ TEST(BroadcastIndexesRangeTest, ThreeDBroadcasting) {
     }
   }
   test_operator_plus(range);
+  test_inner_runs(range);
 }
 
 // 4-D should generalize, but we will go ahead and test:
@@ -254,6 +289,8 @@ void four_d_broadcasting_test() {
   }
 
   test_operator_plus(range);
+
+  test_inner_runs(range);
 }
 
 TEST(BroadcastIndexesRangeTest, FourDBroadcasting) {
@@ -264,3 +301,43 @@ TEST(BroadcastIndexesRangeTest, FourDBroadcastingWithOneDimsInOutput) {
   four_d_broadcasting_test<2, 3, 1, 5>();
   four_d_broadcasting_test<2, 1, 3, 1>();
 }
+
+// [C, 1, 1] -> [N, C, H, W] walks H * W elements per run, and [N, C, H, W]
+// -> [N, C, H, W] walks the whole tensor in one run.
+TEST(BroadcastIndexesRangeTest, InnerRunsMergeDimensions) {
+  TensorFactory<ScalarType::Int> tf;
+  Tensor out = tf.zeros({2, 3, 4, 5});
+  Tensor bias = tf.zeros({3, 1, 1});
+  Tensor row = tf.zeros({1, 5});
+
+  const auto bias_range = BroadcastIndexesRange<2>(out, bias, out);
+  auto it = bias_range.begin();
+  EXPECT_EQ(it.inner_run_remaining(), 4 * 5);
+  EXPECT_EQ(it.inner_run_strides()[1], 0);
+  EXPECT_EQ(it.inner_run_strides()[2], 1);
+  it.advance_inner_run(3);
+  EXPECT_EQ(it.inner_run_remaining(), 4 * 5 - 3);
+  test_inner_runs(bias_range);
+
+  const auto row_range = BroadcastIndexesRange<2>(out, row, out);
+  EXPECT_EQ(row_range.begin().inner_run_remaining(), 5);
+  test_inner_runs(row_range);
+
+  const auto same_range = BroadcastIndexesRange<1>(out, out);
+  EXPECT_EQ(same_range.begin().inner_run_remaining(), out.numel());
+  test_inner_runs(same_range);
+}
+
+// A transposed input walks each run with its own stride.
+TEST(BroadcastIndexesRangeTest, InnerRunsNoncontiguousInput) {
+  TensorFactory<ScalarType::Int> tf;
+  Tensor out = tf.zeros({3, 4});
+  Tensor transposed = tf.make({3, 4}, std::vector<int>(12, 0), {1, 3});
+
+  const auto range =
+      BroadcastIndexesRange<1, /*support_noncontiguous_input_tensors=*/true>(
+          out, transposed);
+  EXPECT_EQ(range.begin().inner_run_remaining(), 4);
+  EXPECT_EQ(range.begin().inner_run_strides()[1], 3);
+  test_inner_runs(range);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/kernels/portable/cpu/util/fused_elementwise.h>
+
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_factory.h>
+#include <executorch/runtime/core/exec_aten/testing_util/tensor_util.h>
+#include <executorch/runtime/platform/runtime.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace ::testing;
+using executorch::aten::ScalarType;
+using executorch::aten::Tensor;
+using executorch::aten::TensorImpl;
+using executorch::runtime::EValue;
+using executorch::runtime::FusedElementwiseStep;
+using executorch::runtime::FusibleElementwiseOp;
+using executorch::runtime::KernelRuntimeContext;
+using executorch::runtime::Span;
+using executorch::runtime::testing::TensorFactory;
+using torch::executor::native::utils::fused_elementwise;
+
+namespace {
+
+constexpr int16_t kPrevious = FusedElementwiseStep::kPrevious;
+
+std::vector<float> iota(size_t size, float start, float step) {
+  std::vector<float> values(size);
+  for (size_t i = 0; i < size; ++i) {
+    values[i] = start + step * i;
+  }
+  return values;
+}
+
+class FusedElementwiseTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executorch::runtime::runtime_init();
+  }
+
+  bool run(
+      std::vector<FusedElementwiseStep> steps,
+      std::vector<Tensor> inputs,
+      Tensor& out) {
+    std::vector<EValue> input_values(inputs.begin(), inputs.end());
+    std::vector<EValue*> input_ptrs;
+    for (auto& value : input_values) {
+      input_ptrs.push_back(&value);
+    }
+    EValue out_value(out);
+    return fused_elementwise(
+        context_,
+        {steps.data(), steps.size()},
+        {input_ptrs.data(), input_ptrs.size()},
+        out_value);
+  }
+
+  KernelRuntimeContext context_;
+  TensorFactory<ScalarType::Float> tf_;
+};
+
+} // namespace
+
+TEST_F(FusedElementwiseTest, IsNotRegisteredByLinking) {
+  // Fusion is opt-in.
+  EXPECT_EQ(executorch::runtime::get_fused_elementwise_function(), nullptr);
+}
+
+TEST_F(FusedElementwiseTest, MatchesUnfusedOperators) {
+  // Spans several chunks, the last of them partial.
+  const std::vector<int32_t> sizes = {3, 345};
+  const size_t numel = 3 * 345;
+  const auto x_data = iota(numel, -4.0f, 0.01f);
+  const auto y_data = iota(numel, 0.5f, 0.003f);
+  const auto z_data = iota(numel, 2.0f, -0.007f);
+  Tensor x = tf_.make(sizes, x_data);
+  Tensor y = tf_.make(sizes, y_data);
+  Tensor z = tf_.make(sizes, z_data);
+  Tensor out = tf_.zeros(sizes);
+
+  // sigmoid(x * y - 0.5 * z) / x, then relu.
+  const bool fused = run(
+      {
+          {FusibleElementwiseOp::Mul, 0, 1, 1.0},
+          {FusibleElementwiseOp::Sub, kPrevious, 2, 0.5},
+          {FusibleElementwiseOp::Sigmoid, kPrevious, kPrevious, 1.0},
+          {FusibleElementwiseOp::Div, kPrevious, 0, 1.0},
+          {FusibleElementwiseOp::Relu, kPrevious, kPrevious, 1.0},
+      },
+      {x, y, z},
+      out);
+  ASSERT_TRUE(fused);
+  EXPECT_EQ(context_.failure_state(), executorch::runtime::Error::Ok);
+
+  std::vector<float> expected(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    float value = x_data[i] * y_data[i];
+    value = value - 0.5f * z_data[i];
+    value = 1.0f / (1.0f + std::exp(-value));
+    value = value / x_data[i];
+    expected[i] = value >= 0.0f ? value : 0.0f;
+  }
+  EXPECT_TENSOR_CLOSE(out, tf_.make(sizes, expected));
+}
+
+TEST_F(FusedElementwiseTest, OutputCanBeAnInput) {
+  Tensor x = tf_.make({4}, {1.0, 2.0, 3.0, 4.0});
+  Tensor y = tf_.make({4}, {0.5, 0.5, 2.0, 2.0});
+
+  ASSERT_TRUE(run(
+      {
+          {FusibleElementwiseOp::Add, 0, 1, 2.0},
+          {FusibleElementwiseOp::Mul, kPrevious, 0, 1.0},
+          {FusibleElementwiseOp::Neg, kPrevious, kPrevious, 1.0},
+      },
+      {x, y},
+      x));
+  EXPECT_TENSOR_EQ(x, tf_.make({4}, {-2.0, -6.0, -21.0, -32.0}));
+}
+
+TEST_F(FusedElementwiseTest, ResizesOutput) {
+  Tensor x = tf_.make({2, 2}, {0.0, 1.0, -1.0, 2.0});
+  Tensor out = tf_.zeros(
+      {4, 4}, executorch::aten::TensorShapeDynamism::DYNAMIC_BOUND);
+
+  ASSERT_TRUE(run(
+      {
+          {FusibleElementwiseOp::Exp, 0, kPrevious, 1.0},
+          {FusibleElementwiseOp::Tanh, kPrevious, kPrevious, 1.0},
+      },
+      {x},
+      out));
+  EXPECT_TENSOR_CLOSE(
+      out,
+      tf_.make(
+          {2, 2},
+          {std::tanh(std::exp(0.0f)),
+           std::tanh(std::exp(1.0f)),
+           std::tanh(std::exp(-1.0f)),
+           std::tanh(std::exp(2.0f))}));
+}
+
+TEST_F(FusedElementwiseTest, RejectsUnsupportedCalls) {
+  Tensor x = tf_.make({2, 2}, {1.0, 2.0, 3.0, 4.0});
+  Tensor out = tf_.zeros({2, 2});
+  const std::vector<FusedElementwiseStep> add = {
+      {FusibleElementwiseOp::Add, 0, 1, 1.0},
+      {FusibleElementwiseOp::Neg, kPrevious, kPrevious, 1.0},
+  };
+
+  // Inputs that need broadcasting.
+  EXPECT_FALSE(run(add, {x, tf_.make({2, 1}, {1.0, 2.0})}, out));
+  // Inputs of other dtypes.
+  TensorFactory<ScalarType::Int> tf_int;
+  EXPECT_FALSE(run(add, {x, tf_int.make({2, 2}, {1, 2, 3, 4})}, out));
+  // The first step reading a previous result.
+  EXPECT_FALSE(run(
+      {{FusibleElementwiseOp::Neg, kPrevious, kPrevious, 1.0}}, {x}, out));
+  // An operand out of range.
+  EXPECT_FALSE(run({{FusibleElementwiseOp::Mul, 0, 2, 1.0}}, {x, x}, out));
+  EXPECT_TENSOR_EQ(out, tf_.zeros({2, 2}));
+}
+
+TEST_F(FusedElementwiseTest, RejectsPartiallyOverlappingOutput) {
+  std::vector<float> buffer = {1.0, 2.0, 3.0, 4.0, 5.0};
+  TensorImpl::SizesType sizes[] = {4};
+  TensorImpl::DimOrderType dim_order[] = {0};
+  TensorImpl::StridesType strides[] = {1};
+  TensorImpl input_impl(
+      ScalarType::Float, 1, sizes, buffer.data(), dim_order, strides);
+  TensorImpl out_impl(
+      ScalarType::Float, 1, sizes, buffer.data() + 1, dim_order, strides);
+  Tensor input(&input_impl);
+  Tensor out(&out_impl);
+
+  EXPECT_FALSE(run(
+      {
+          {FusibleElementwiseOp::Neg, 0, kPrevious, 1.0},
+          {FusibleElementwiseOp::Exp, kPrevious, kPrevious, 1.0},
+      },
+      {input},
+      out));
+  EXPECT_EQ(buffer, std::vector<float>({1.0, 2.0, 3.0, 4.0, 5.0}));
+}
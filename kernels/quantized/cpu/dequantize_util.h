@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// SIMD helpers for the kernels that dequantize low-bit weights.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace torch {
+namespace executor {
+namespace native {
+namespace internal {
+
+/**
+ * The float vector of the widest instruction set the build targets, with the
+ * few operations that dequantization and dot products need.
+ */
+#if defined(__AVX2__) && defined(__FMA__)
+struct FloatVec {
+  using type = __m256;
+  static constexpr int64_t size = 8;
+  static type zero() {
+    return _mm256_setzero_ps();
+  }
+  static type set1(float value) {
+    return _mm256_set1_ps(value);
+  }
+  static type load(const float* p) {
+    return _mm256_loadu_ps(p);
+  }
+  static type load_int8(const int8_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+  }
+  static void store(float* p, type v) {
+    _mm256_storeu_ps(p, v);
+  }
+  static type mul(type a, type b) {
+    return _mm256_mul_ps(a, b);
+  }
+  static type sub(type a, type b) {
+    return _mm256_sub_ps(a, b);
+  }
+  static type fmadd(type a, type b, type c) {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static float reduce_add(type v) {
+    __m128 sum =
+        _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_hadd_ps(sum, sum);
+    sum = _mm_hadd_ps(sum, sum);
+    return _mm_cvtss_f32(sum);
+  }
+};
+#elif defined(__aarch64__)
+struct FloatVec {
+  using type = float32x4_t;
+  static constexpr int64_t size = 4;
+  static type zero() {
+    return vdupq_n_f32(0.0f);
+  }
+  static type set1(float value) {
+    return vdupq_n_f32(value);
+  }
+  static type load(const float* p) {
+    return vld1q_f32(p);
+  }
+  static type load_int8(const int8_t* p) {
+    int32_t bits;
+    std::memcpy(&bits, p, sizeof(bits));
+    const int16x8_t wide = vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(bits)));
+    return vcvtq_f32_s32(vmovl_s16(vget_low_s16(wide)));
+  }
+  static void store(float* p, type v) {
+    vst1q_f32(p, v);
+  }
+  static type mul(type a, type b) {
+    return vmulq_f32(a, b);
+  }
+  static type sub(type a, type b) {
+    return vsubq_f32(a, b);
+  }
+  static type fmadd(type a, type b, type c) {
+    return vfmaq_f32(c, a, b);
+  }
+  static float reduce_add(type v) {
+    return vaddvq_f32(v);
+  }
+};
+#elif defined(__SSE2__)
+// x86-64 builds without AVX2 still have SSE2.
+struct FloatVec {
+  using type = __m128;
+  static constexpr int64_t size = 4;
+  static type zero() {
+    return _mm_setzero_ps();
+  }
+  static type set1(float value) {
+    return _mm_set1_ps(value);
+  }
+  static type load(const float* p) {
+    return _mm_loadu_ps(p);
+  }
+  static type load_int8(const int8_t* p) {
+    int32_t bits;
+    std::memcpy(&bits, p, sizeof(bits));
+    // Move each byte to the top of a 32-bit lane, then sign-extend it.
+    __m128i v = _mm_cvtsi32_si128(bits);
+    v = _mm_unpacklo_epi8(v, v);
+    v = _mm_unpacklo_epi16(v, v);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(v, 24));
+  }
+  static void store(float* p, type v) {
+    _mm_storeu_ps(p, v);
+  }
+  static type mul(type a, type b) {
+    return _mm_mul_ps(a, b);
+  }
+  static type sub(type a, type b) {
+    return _mm_sub_ps(a, b);
+  }
+  static type fmadd(type a, type b, type c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static float reduce_add(type v) {
+    const __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    const __m128 second = _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, second));
+  }
+};
+#else
+// Scalar fallback. The independent sums of the dot products still overlap.
+struct FloatVec {
+  using type = float;
+  static constexpr int64_t size = 1;
+  static type zero() {
+    return 0.0f;
+  }
+  static type set1(float value) {
+    return value;
+  }
+  static type load(const float* p) {
+    return *p;
+  }
+  static type load_int8(const int8_t* p) {
+    return static_cast<float>(*p);
+  }
+  static void store(float* p, type v) {
+    *p = v;
+  }
+  static type mul(type a, type b) {
+    return a * b;
+  }
+  static type sub(type a, type b) {
+    return a - b;
+  }
+  static type fmadd(type a, type b, type c) {
+    return a * b + c;
+  }
+  static float reduce_add(type v) {
+    return v;
+  }
+};
+#endif
+
+/**
+ * Unpacks `len` int4 values, two per byte with the first one in the high
+ * nibble, offset by 8. `len` must be even.
+ */
+inline void unpack_int4(const uint8_t* src, int64_t len, int8_t* dst) {
+  int64_t k = 0;
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  const __m128i offset = _mm_set1_epi8(8);
+  for (; k + 32 <= len; k += 32) {
+    const __m128i packed =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k / 2));
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+    const __m128i lo = _mm_and_si128(packed, mask);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + k),
+        _mm_sub_epi8(_mm_unpacklo_epi8(hi, lo), offset));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + k + 16),
+        _mm_sub_epi8(_mm_unpackhi_epi8(hi, lo), offset));
+  }
+#elif defined(__aarch64__)
+  const int8x16_t offset = vdupq_n_s8(8);
+  for (; k + 32 <= len; k += 32) {
+    const uint8x16_t packed = vld1q_u8(src + k / 2);
+    const uint8x16x2_t values =
+        vzipq_u8(vshrq_n_u8(packed, 4), vandq_u8(packed, vdupq_n_u8(0x0F)));
+    vst1q_s8(dst + k, vsubq_s8(vreinterpretq_s8_u8(values.val[0]), offset));
+    vst1q_s8(
+        dst + k + 16, vsubq_s8(vreinterpretq_s8_u8(values.val[1]), offset));
+  }
+#endif
+  for (; k < len; k += 2) {
+    const uint8_t packed = src[k / 2];
+    dst[k] = static_cast<int8_t>((packed >> 4) - 8);
+    dst[k + 1] = static_cast<int8_t>((packed & 0x0F) - 8);
+  }
+}
+
+/**
+ * Unpacks `len` int2 values, four per byte with the first one in the lowest
+ * two bits, offset by 2. `len` must be a multiple of 4.
+ */
+inline void unpack_int2(const uint8_t* src, int64_t len, int8_t* dst) {
+  int64_t k = 0;
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi8(0x03);
+  const __m128i offset = _mm_set1_epi8(2);
+  for (; k + 64 <= len; k += 64) {
+    const __m128i packed =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k / 4));
+    const __m128i v0 = _mm_sub_epi8(_mm_and_si128(packed, mask), offset);
+    const __m128i v1 = _mm_sub_epi8(
+        _mm_and_si128(_mm_srli_epi16(packed, 2), mask), offset);
+    const __m128i v2 = _mm_sub_epi8(
+        _mm_and_si128(_mm_srli_epi16(packed, 4), mask), offset);
+    const __m128i v3 = _mm_sub_epi8(
+        _mm_and_si128(_mm_srli_epi16(packed, 6), mask), offset);
+    // Interleave the four values of each byte.
+    const __m128i v01_lo = _mm_unpacklo_epi8(v0, v1);
+    const __m128i v01_hi = _mm_unpackhi_epi8(v0, v1);
+    const __m128i v23_lo = _mm_unpacklo_epi8(v2, v3);
+    const __m128i v23_hi = _mm_unpackhi_epi8(v2, v3);
+    __m128i* out = reinterpret_cast<__m128i*>(dst + k);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(v01_lo, v23_lo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(v01_lo, v23_lo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(v01_hi, v23_hi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(v01_hi, v23_hi));
+  }
+#elif defined(__aarch64__)
+  const uint8x16_t mask = vdupq_n_u8(0x03);
+  const int8x16_t offset = vdupq_n_s8(2);
+  for (; k + 64 <= len; k += 64) {
+    const uint8x16_t packed = vld1q_u8(src + k / 4);
+    int8x16x4_t values;
+    values.val[0] =
+        vsubq_s8(vreinterpretq_s8_u8(vandq_u8(packed, mask)), offset);
+    values.val[1] = vsubq_s8(
+        vreinterpretq_s8_u8(vandq_u8(vshrq_n_u8(packed, 2), mask)), offset);
+    values.val[2] = vsubq_s8(
+        vreinterpretq_s8_u8(vandq_u8(vshrq_n_u8(packed, 4), mask)), offset);
+    values.val[3] =
+        vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(packed, 6)), offset);
+    // Stores the four values of each byte next to each other.
+    vst4q_s8(dst + k, values);
+  }
+#endif
+  for (; k < len; k += 4) {
+    const uint8_t packed = src[k / 4];
+    dst[k] = static_cast<int8_t>((packed & 0x03) - 2);
+    dst[k + 1] = static_cast<int8_t>(((packed >> 2) & 0x03) - 2);
+    dst[k + 2] = static_cast<int8_t>(((packed >> 4) & 0x03) - 2);
+    dst[k + 3] = static_cast<int8_t>((packed >> 6) - 2);
+  }
+}
+
+} // namespace internal
+} // namespace native
+} // namespace executor
+} // namespace torch
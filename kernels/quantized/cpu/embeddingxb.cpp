@@ -6,12 +6,15 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <executorch/kernels/quantized/cpu/dequantize_util.h>
 #include <executorch/kernels/quantized/cpu/embeddingxb.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
 #include <algorithm>
 #include <cassert>
 #include <cinttypes>
 #include <cmath>
+#include <type_traits>
 
 namespace torch {
 namespace executor {
@@ -23,33 +26,10 @@ using ScalarType = executorch::aten::ScalarType;
 
 namespace {
 
-static inline int32_t
-weight_value(const unsigned char* w_data, int32_t index, int32_t weight_nbit) {
-  if (weight_nbit == 2) {
-    int32_t subbyte = index % 4;
-    index >>= 2;
-    switch (subbyte) {
-      case 0:
-        return (int32_t)(w_data[index] & 3) - 2;
-      case 1:
-        return (int32_t)((w_data[index] & 12) >> 2) - 2;
-      case 2:
-        return (int32_t)((w_data[index] & 48) >> 4) - 2;
-      case 3:
-        return (int32_t)((w_data[index] & 192) >> 6) - 2;
-    }
-  } else if (weight_nbit == 4) {
-    int32_t odd = index & 1;
-    index >>= 1;
-    if (odd) {
-      return (int32_t)(w_data[index] & 0x0F) - 8;
-    } else {
-      return (int32_t)((w_data[index] >> 4) & 0x0F) - 8;
-    }
-  }
+using internal::FloatVec;
 
-  ET_CHECK_MSG(false, "invalid weight_nbit");
-}
+// Values of an embedding that are unpacked and dequantized at a time.
+constexpr int64_t kChunk = 256;
 
 static inline int32_t get_embedding_dim(
     int32_t packed_dim,
@@ -107,13 +87,15 @@ void check_embedding_xbit_args(
 
   ET_CHECK_MSG(
       out.scalar_type() == ScalarType::Float ||
-          out.scalar_type() == ScalarType::Half,
+          out.scalar_type() == ScalarType::Half ||
+          out.scalar_type() == ScalarType::BFloat16,
       "out.scalar_type() %" PRId8 " is not supported:",
       static_cast<int8_t>(out.scalar_type()));
 
   ET_CHECK_MSG(
       weight_scales.scalar_type() == ScalarType::Float ||
-          weight_scales.scalar_type() == ScalarType::Half,
+          weight_scales.scalar_type() == ScalarType::Half ||
+          weight_scales.scalar_type() == ScalarType::BFloat16,
       "weight_scales.scalar_type() %" PRId8 " is not supported:",
       static_cast<int8_t>(weight_scales.scalar_type()));
 
@@ -162,9 +144,37 @@ void check_embedding_xbit_args(
   }
 }
 
+/**
+ * Writes (q[k] - zero_point) * scale to dst[k] for the `len` values of one
+ * quantization group.
+ */
+void dequantize_group(
+    const int8_t* q,
+    int64_t len,
+    float scale,
+    float zero_point,
+    float* dst) {
+  const FloatVec::type vscale = FloatVec::set1(scale);
+  const FloatVec::type vzero_point = FloatVec::set1(zero_point);
+  int64_t k = 0;
+  for (; k + FloatVec::size <= len; k += FloatVec::size) {
+    FloatVec::store(
+        dst + k,
+        FloatVec::mul(
+            FloatVec::sub(FloatVec::load_int8(q + k), vzero_point), vscale));
+  }
+  for (; k < len; ++k) {
+    dst[k] = (static_cast<float>(q[k]) - zero_point) * scale;
+  }
+}
+
 /**
  * Retrieves the embeddings specified by indices, dequantizes them, and stores
- * them in out. Weight will always be uint8
+ * them in out. Weight will always be uint8.
+ *
+ * Each embedding is unpacked and dequantized kChunk values at a time, straight
+ * into the output row for float outputs and through a buffer that stays in L1
+ * for reduced precision ones. The indices are spread over the threadpool.
  */
 template <typename CTYPE_PARAMS, typename CTYPE_OUT>
 void embedding_xbit_per_channel(
@@ -174,16 +184,22 @@ void embedding_xbit_per_channel(
     const Tensor& indices,
     Tensor& out,
     int weight_nbit) {
-  auto embedding_dim = get_embedding_dim(weight.size(1), weight_nbit);
+  ET_CHECK_MSG(
+      weight_nbit == 2 || weight_nbit == 4,
+      "invalid weight_nbit %d",
+      weight_nbit);
+  const int64_t packed_dim = weight.size(1);
+  const int64_t embedding_dim = get_embedding_dim(packed_dim, weight_nbit);
 
-  int32_t num_groups_per_channel = 1;
+  int64_t num_groups_per_channel = 1;
   if (weight_scales.dim() == 2) {
     num_groups_per_channel = weight_scales.size(1);
   }
-  int32_t group_size = embedding_dim / num_groups_per_channel;
+  const int64_t group_size = embedding_dim / num_groups_per_channel;
 
   CTYPE_OUT* out_data = out.mutable_data_ptr<CTYPE_OUT>();
   const int64_t* indices_ptr = indices.const_data_ptr<int64_t>();
+  const uint8_t* weight_data = weight.const_data_ptr<uint8_t>();
 
   const CTYPE_PARAMS* scales = weight_scales.const_data_ptr<CTYPE_PARAMS>();
   const CTYPE_PARAMS* zero_points = nullptr;
@@ -191,33 +207,54 @@ void embedding_xbit_per_channel(
     zero_points = opt_weight_zero_points.value().const_data_ptr<CTYPE_PARAMS>();
   }
 
-  for (int i = 0; i < indices.numel(); i++) {
-    int64_t index = indices_ptr[i];
-    // If using groupwise embedding
-    int32_t qparams_index = index * num_groups_per_channel;
-    CTYPE_PARAMS zp = 0.0;
-    const CTYPE_PARAMS* scale_ptr = scales + qparams_index;
-    const CTYPE_PARAMS* zero_points_ptr = nullptr;
-    if (opt_weight_zero_points.has_value()) {
-      zero_points_ptr = zero_points + qparams_index;
-    }
-
-    const uint8_t* w_data =
-        weight.const_data_ptr<uint8_t>() + weight.size(1) * index;
-
-    for (int j = 0; j < embedding_dim; ++j) {
-      int32_t group_id = j / group_size;
-      const CTYPE_PARAMS scale = scale_ptr[group_id];
-      if (opt_weight_zero_points.has_value()) {
-        zp = zero_points_ptr[group_id];
-      }
-      out_data[j] = static_cast<CTYPE_OUT>(
-          (static_cast<float>(weight_value(w_data, j, weight_nbit)) -
-           static_cast<float>(zp)) *
-          static_cast<float>(scale));
-    }
-    out_data += embedding_dim;
-  }
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      ::executorch::extension::internal::GRAIN_SIZE /
+          std::max<int64_t>(1, embedding_dim));
+  ::executorch::extension::parallel_for(
+      0, indices.numel(), grain_size, [&](int64_t begin, int64_t end) {
+        int8_t unpacked[kChunk];
+        float dequantized[kChunk];
+        for (int64_t i = begin; i < end; ++i) {
+          const int64_t index = indices_ptr[i];
+          const uint8_t* w_data = weight_data + packed_dim * index;
+          // If using groupwise embedding
+          const int64_t qparams_index = index * num_groups_per_channel;
+          CTYPE_OUT* out_row = out_data + i * embedding_dim;
+
+          for (int64_t j0 = 0; j0 < embedding_dim; j0 += kChunk) {
+            // embedding_dim and kChunk are multiples of the values per byte.
+            const int64_t len = std::min(kChunk, embedding_dim - j0);
+            if (weight_nbit == 4) {
+              internal::unpack_int4(w_data + j0 / 2, len, unpacked);
+            } else {
+              internal::unpack_int2(w_data + j0 / 4, len, unpacked);
+            }
+
+            float* dst = dequantized;
+            if constexpr (std::is_same_v<CTYPE_OUT, float>) {
+              dst = out_row + j0;
+            }
+            for (int64_t j = 0; j < len;) {
+              const int64_t group_id = (j0 + j) / group_size;
+              const int64_t group_end =
+                  std::min(len, (group_id + 1) * group_size - j0);
+              const float scale =
+                  static_cast<float>(scales[qparams_index + group_id]);
+              const float zp = zero_points == nullptr
+                  ? 0.0f
+                  : static_cast<float>(zero_points[qparams_index + group_id]);
+              dequantize_group(unpacked + j, group_end - j, scale, zp, dst + j);
+              j = group_end;
+            }
+            if constexpr (!std::is_same_v<CTYPE_OUT, float>) {
+              for (int64_t k = 0; k < len; ++k) {
+                out_row[j0 + k] = static_cast<CTYPE_OUT>(dequantized[k]);
+              }
+            }
+          }
+        }
+      });
 }
 
 void resize_out_tensor(
@@ -282,15 +319,16 @@ Tensor& quantized_embedding_xbit_out(
       weight_nbit);
 
   constexpr auto name = "quantized_decomposed::embedding_xbit.out";
-  ET_SWITCH_TWO_TYPES(Float, Half, out_type, ctx, name, CTYPE_OUT, [&]() {
-    embedding_xbit_per_channel<CTYPE_OUT, CTYPE_OUT>(
-        weight,
-        weight_scales,
-        opt_weight_zero_points,
-        indices,
-        out,
-        weight_nbit);
-  });
+  ET_SWITCH_THREE_TYPES(
+      Float, Half, BFloat16, out_type, ctx, name, CTYPE_OUT, [&]() {
+        embedding_xbit_per_channel<CTYPE_OUT, CTYPE_OUT>(
+            weight,
+            weight_scales,
+            opt_weight_zero_points,
+            indices,
+            out,
+            weight_nbit);
+      });
 
   return out;
 }
@@ -349,17 +387,19 @@ Tensor& quantized_embedding_xbit_dtype_out(
   ScalarType out_type = out.scalar_type();
 
   constexpr auto name = "quantized_decomposed::embedding_xbit.dtype_out";
-  ET_SWITCH_TWO_TYPES(Float, Half, params_type, ctx, name, CTYPE_P, [&]() {
-    ET_SWITCH_TWO_TYPES(Float, Half, out_type, ctx, name, CTYPE_OUT, [&]() {
-      embedding_xbit_per_channel<CTYPE_P, CTYPE_OUT>(
-          weight,
-          weight_scales,
-          opt_weight_zero_points,
-          indices,
-          out,
-          weight_nbit);
-    });
-  });
+  ET_SWITCH_THREE_TYPES(
+      Float, Half, BFloat16, params_type, ctx, name, CTYPE_P, [&]() {
+        ET_SWITCH_THREE_TYPES(
+            Float, Half, BFloat16, out_type, ctx, name, CTYPE_OUT, [&]() {
+              embedding_xbit_per_channel<CTYPE_P, CTYPE_OUT>(
+                  weight,
+                  weight_scales,
+                  opt_weight_zero_points,
+                  indices,
+                  out,
+                  weight_nbit);
+            });
+      });
 
   return out;
 }
@@ -6,8 +6,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
-#include <executorch/kernels/portable/cpu/vec_ops.h>
+#include <executorch/kernels/quantized/cpu/dequantize_util.h>
 #include <executorch/runtime/kernel/kernel_includes.h>
+#include <executorch/runtime/kernel/thread_parallel_interface.h>
+
+#include <algorithm>
+#include <type_traits>
 
 namespace torch {
 namespace executor {
@@ -15,6 +19,233 @@ namespace native {
 
 using Tensor = executorch::aten::Tensor;
 
+namespace {
+
+using internal::FloatVec;
+using internal::unpack_int4;
+
+// Columns of the input and the weights that are processed at a time.
+constexpr int64_t kKC = 256;
+// Output channels per task. Their dequantized chunks stay in L1.
+constexpr int64_t kNC = 4;
+// Input rows per task. The dequantized weights are reused for all of them.
+constexpr int64_t kMC = 64;
+
+/**
+ * Adds the dot products of one input row with the kNC dequantized weight rows
+ * of a chunk, all `len` long, to acc[0..kNC). Used for decode, where each
+ * weight is used once.
+ */
+void dot_1x4(const float* x, const float* w, int64_t len, float* acc) {
+  static_assert(kNC == 4, "one sum per output channel");
+  using Vec = FloatVec;
+  auto sum0 = Vec::zero();
+  auto sum1 = Vec::zero();
+  auto sum2 = Vec::zero();
+  auto sum3 = Vec::zero();
+  int64_t k = 0;
+  for (; k + Vec::size <= len; k += Vec::size) {
+    const auto xv = Vec::load(x + k);
+    sum0 = Vec::fmadd(xv, Vec::load(w + k), sum0);
+    sum1 = Vec::fmadd(xv, Vec::load(w + kKC + k), sum1);
+    sum2 = Vec::fmadd(xv, Vec::load(w + 2 * kKC + k), sum2);
+    sum3 = Vec::fmadd(xv, Vec::load(w + 3 * kKC + k), sum3);
+  }
+  acc[0] += Vec::reduce_add(sum0);
+  acc[1] += Vec::reduce_add(sum1);
+  acc[2] += Vec::reduce_add(sum2);
+  acc[3] += Vec::reduce_add(sum3);
+  for (; k < len; ++k) {
+    for (int64_t c = 0; c < kNC; ++c) {
+      acc[c] += x[k] * w[c * kKC + k];
+    }
+  }
+}
+
+/**
+ * Adds the dot products of four input rows with two dequantized weight rows
+ * to acc[r * kNC + c]. Used for prefill: the 4 x 2 register tile reuses each
+ * loaded input vector twice and each weight vector four times.
+ */
+void dot_4x2(const float* const* x, const float* w, int64_t len, float* acc) {
+  using Vec = FloatVec;
+  auto sum00 = Vec::zero();
+  auto sum01 = Vec::zero();
+  auto sum10 = Vec::zero();
+  auto sum11 = Vec::zero();
+  auto sum20 = Vec::zero();
+  auto sum21 = Vec::zero();
+  auto sum30 = Vec::zero();
+  auto sum31 = Vec::zero();
+  int64_t k = 0;
+  for (; k + Vec::size <= len; k += Vec::size) {
+    const auto w0 = Vec::load(w + k);
+    const auto w1 = Vec::load(w + kKC + k);
+    const auto x0 = Vec::load(x[0] + k);
+    sum00 = Vec::fmadd(x0, w0, sum00);
+    sum01 = Vec::fmadd(x0, w1, sum01);
+    const auto x1 = Vec::load(x[1] + k);
+    sum10 = Vec::fmadd(x1, w0, sum10);
+    sum11 = Vec::fmadd(x1, w1, sum11);
+    const auto x2 = Vec::load(x[2] + k);
+    sum20 = Vec::fmadd(x2, w0, sum20);
+    sum21 = Vec::fmadd(x2, w1, sum21);
+    const auto x3 = Vec::load(x[3] + k);
+    sum30 = Vec::fmadd(x3, w0, sum30);
+    sum31 = Vec::fmadd(x3, w1, sum31);
+  }
+  acc[0] += Vec::reduce_add(sum00);
+  acc[1] += Vec::reduce_add(sum01);
+  acc[kNC] += Vec::reduce_add(sum10);
+  acc[kNC + 1] += Vec::reduce_add(sum11);
+  acc[2 * kNC] += Vec::reduce_add(sum20);
+  acc[2 * kNC + 1] += Vec::reduce_add(sum21);
+  acc[3 * kNC] += Vec::reduce_add(sum30);
+  acc[3 * kNC + 1] += Vec::reduce_add(sum31);
+  for (; k < len; ++k) {
+    for (int64_t r = 0; r < 4; ++r) {
+      acc[r * kNC] += x[r][k] * w[k];
+      acc[r * kNC + 1] += x[r][k] * w[kKC + k];
+    }
+  }
+}
+
+/**
+ * Group-wise quantized weights of shape [p, n]: one int8 per value, or two
+ * int4 per byte as unpacked by unpack_int4().
+ */
+template <typename CTYPE>
+struct QuantizedWeights {
+  const uint8_t* data;
+  int64_t nbit;
+  int64_t n;
+  const CTYPE* scales;
+  int64_t scales_stride;
+  int64_t group_size;
+
+  /**
+   * Writes the dequantized columns [k0, k0 + len) of row j to dst. For int4,
+   * k0 and len must be even, and `unpacked` must hold `len` values.
+   */
+  void dequantize(
+      int64_t j,
+      int64_t k0,
+      int64_t len,
+      int8_t* unpacked,
+      float* dst) const {
+    using Vec = FloatVec;
+    const int8_t* src;
+    if (nbit == 8) {
+      src = reinterpret_cast<const int8_t*>(data) + j * n + k0;
+    } else {
+      unpack_int4(data + (j * n + k0) / 2, len, unpacked);
+      src = unpacked;
+    }
+    const CTYPE* row_scales = scales + j * scales_stride;
+    for (int64_t k = 0; k < len;) {
+      // Columns up to the end of the group share a scale.
+      const int64_t group = (k0 + k) / group_size;
+      const int64_t end = std::min(len, (group + 1) * group_size - k0);
+      const float scale = static_cast<float>(row_scales[group]);
+      const auto scale_vec = Vec::set1(scale);
+      for (; k + Vec::size <= end; k += Vec::size) {
+        Vec::store(dst + k, Vec::mul(Vec::load_int8(src + k), scale_vec));
+      }
+      for (; k < end; ++k) {
+        dst[k] = static_cast<float>(src[k]) * scale;
+      }
+    }
+  }
+};
+
+/**
+ * out[i][j] = sum_k in[i][k] * dequantized_weight[j][k], for in of shape
+ * [m, n] and out of shape [m, p].
+ *
+ * Each task dequantizes a chunk of kNC weight rows at a time and multiplies
+ * it with up to kMC input rows, so that prefill dequantizes each weight once
+ * per kMC rows. Decode streams the weights once through dot_1x4(). Tasks are
+ * spread over the threadpool along both the output channels and the rows.
+ */
+template <typename CTYPE, typename CTYPE_OUT>
+void quantized_linear(
+    const CTYPE* in,
+    const QuantizedWeights<CTYPE>& weights,
+    CTYPE_OUT* out,
+    int64_t m,
+    int64_t n,
+    int64_t p) {
+  constexpr int64_t kTileRows = 4;
+  const int64_t row_blocks = (m + kMC - 1) / kMC;
+  const int64_t channel_blocks = (p + kNC - 1) / kNC;
+  const int64_t task_size = kNC * n * std::min(m, kMC);
+  const int64_t grain_size = std::max<int64_t>(
+      1, ::executorch::extension::internal::GRAIN_SIZE / task_size);
+
+  ::executorch::extension::parallel_for(
+      0,
+      row_blocks * channel_blocks,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        int8_t unpacked[kKC];
+        float w_chunk[kNC * kKC];
+        float x_chunk[kTileRows * kKC];
+        float acc[kMC * kNC];
+        for (int64_t task = begin; task < end; ++task) {
+          const int64_t i0 = task % row_blocks * kMC;
+          const int64_t mc = std::min(kMC, m - i0);
+          const int64_t j0 = task / row_blocks * kNC;
+          const int64_t nc = std::min(kNC, p - j0);
+          std::fill(acc, acc + mc * kNC, 0.0f);
+
+          for (int64_t k0 = 0; k0 < n; k0 += kKC) {
+            const int64_t len = std::min(kKC, n - k0);
+            for (int64_t c = 0; c < nc; ++c) {
+              weights.dequantize(j0 + c, k0, len, unpacked, w_chunk + c * kKC);
+            }
+            for (int64_t c = nc; c < kNC; ++c) {
+              std::fill(w_chunk + c * kKC, w_chunk + c * kKC + len, 0.0f);
+            }
+
+            for (int64_t i = 0; i < mc; i += kTileRows) {
+              const int64_t rows = std::min(kTileRows, mc - i);
+              const float* x[kTileRows];
+              for (int64_t r = 0; r < rows; ++r) {
+                const CTYPE* row = in + (i0 + i + r) * n + k0;
+                if constexpr (std::is_same<CTYPE, float>::value) {
+                  x[r] = row;
+                } else {
+                  float* converted = x_chunk + r * kKC;
+                  for (int64_t k = 0; k < len; ++k) {
+                    converted[k] = static_cast<float>(row[k]);
+                  }
+                  x[r] = converted;
+                }
+              }
+              float* acc_rows = acc + i * kNC;
+              if (rows == kTileRows) {
+                dot_4x2(x, w_chunk, len, acc_rows);
+                dot_4x2(x, w_chunk + 2 * kKC, len, acc_rows + 2);
+              } else {
+                for (int64_t r = 0; r < rows; ++r) {
+                  dot_1x4(x[r], w_chunk, len, acc_rows + r * kNC);
+                }
+              }
+            }
+          }
+
+          for (int64_t i = 0; i < mc; ++i) {
+            for (int64_t c = 0; c < nc; ++c) {
+              out[(i0 + i) * p + j0 + c] =
+                  static_cast<CTYPE_OUT>(acc[i * kNC + c]);
+            }
+          }
+        }
+      });
+}
+
+} // namespace
+
 bool check_quantized_mixed_linear_args(
     const Tensor& in,
     const Tensor& weight,
@@ -28,10 +259,8 @@ bool check_quantized_mixed_linear_args(
       tensor_is_rank(weight_scales, 1) || tensor_is_rank(weight_scales, 2));
   ET_LOG_AND_RETURN_IF_FALSE(tensor_is_rank(out, 2));
 
-  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_size_at_dims(in, 1, weight, 1));
   ET_LOG_AND_RETURN_IF_FALSE(
       tensors_have_same_size_at_dims(weight_scales, 0, weight, 0));
-  ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_size_at_dims(in, 1, weight, 1));
 
   ET_LOG_AND_RETURN_IF_FALSE(tensors_have_same_dtype(in, weight_scales));
   if (dtype.has_value()) {
@@ -40,8 +269,20 @@ bool check_quantized_mixed_linear_args(
         dtype.value() == ScalarType::Float || dtype.value() == ScalarType::Half,
         "dtype must be Float or Half");
   }
-  ET_CHECK_OR_RETURN_FALSE(
-      weight.scalar_type() == ScalarType::Char, "weight dtype must be int8");
+  // Byte weights hold two int4 values per element.
+  if (weight.scalar_type() == ScalarType::Char) {
+    ET_LOG_AND_RETURN_IF_FALSE(
+        tensors_have_same_size_at_dims(in, 1, weight, 1));
+  } else {
+    ET_CHECK_OR_RETURN_FALSE(
+        weight.scalar_type() == ScalarType::Byte,
+        "weight dtype must be int8, or uint8 for packed int4");
+    ET_CHECK_OR_RETURN_FALSE(
+        in.size(1) == 2 * weight.size(1),
+        "packed int4 weight.size(1) %zd must be half of input.size(1) %zd",
+        ssize_t(weight.size(1)),
+        ssize_t(in.size(1)));
+  }
   ET_CHECK_OR_RETURN_FALSE(
       in.scalar_type() == ScalarType::Float ||
           in.scalar_type() == ScalarType::Half,
@@ -85,27 +326,31 @@ Tensor& quantized_mixed_linear_out(
 
   ET_SWITCH_TWO_TYPES(Float, Half, in.scalar_type(), ctx, name, CTYPE, [&]() {
     ET_SWITCH_FLOAT_TYPES_AND(Half, out_dtype, ctx, name, CTYPE_OUT, [&]() {
-      size_t m = in.size(0);
-      size_t n = in.size(1);
-      size_t p = weight.size(0);
-      size_t g = n;
+      int64_t m = in.size(0);
+      int64_t n = in.size(1);
+      int64_t p = weight.size(0);
+      int64_t g = n;
+      int64_t scales_stride = 1;
 
       if (weight_scales.dim() == 2) {
         g = (n + weight_scales.size(1) - 1) / weight_scales.size(1);
+        scales_stride = weight_scales.size(1);
       };
 
-      // FIXME: this currently ignores dtype
-      vec_quantized_matmul_transb_int8<
-          CTYPE_OUT, // T *z
-          CTYPE>( // U *x, U *s
-          out.mutable_data_ptr<CTYPE_OUT>(),
-          in.const_data_ptr<CTYPE>(),
-          weight.const_data_ptr<int8_t>(),
+      const QuantizedWeights<CTYPE> weights{
+          static_cast<const uint8_t*>(weight.const_data_ptr()),
+          weight.scalar_type() == ScalarType::Char ? 8 : 4,
+          n,
           weight_scales.const_data_ptr<CTYPE>(),
+          scales_stride,
+          g};
+      quantized_linear(
+          in.const_data_ptr<CTYPE>(),
+          weights,
+          out.mutable_data_ptr<CTYPE_OUT>(),
           m,
           n,
-          p,
-          g);
+          p);
     });
   });
 
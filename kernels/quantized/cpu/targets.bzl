@@ -46,7 +46,8 @@ _QUANT_OPS = (
     op_target(
         name = "op_mixed_linear",
         deps = [
-            "//executorch/kernels/portable/cpu:vec_ops",
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/kernels/quantized/cpu:dequantize_util",
         ],
     ),
     op_target(
@@ -70,6 +71,14 @@ def define_common_targets():
         exported_deps = quant_op_targets,
     )
 
+    runtime.cxx_library(
+        name = "dequantize_util",
+        exported_headers = ["dequantize_util.h"],
+        visibility = [
+            "//executorch/kernels/quantized/...",
+        ],
+    )
+
     runtime.cxx_library(
         name = "embeddingxb",
         srcs = ["embeddingxb.cpp"],
@@ -77,7 +86,11 @@ def define_common_targets():
         visibility = [
             "//executorch/kernels/quantized/...",
         ],
-        deps = ["//executorch/runtime/kernel:kernel_includes"],
+        deps = [
+            ":dequantize_util",
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/runtime/kernel:kernel_includes",
+        ],
     )
 
     runtime.cxx_library(
@@ -87,7 +100,11 @@ def define_common_targets():
         visibility = [
             "//executorch/kernels/quantized/...",
         ],
-        deps = ["//executorch/runtime/kernel:kernel_includes_aten"],
+        deps = [
+            ":dequantize_util",
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/runtime/kernel:kernel_includes_aten",
+        ],
     )
 
     runtime.cxx_library(
@@ -15,6 +15,7 @@
 
 #include <gtest/gtest.h>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
@@ -104,6 +105,57 @@ TEST(OpQuantizedEmbedding2bTest, TestGroupWiseQuantizedEmbedding) {
   EXPECT_TENSOR_EQ(out, expected);
 }
 
+TEST(OpQuantizedEmbedding2bTest, TestLargeGroupWiseQuantizedEmbedding) {
+  et_pal_init();
+  TensorFactory<ScalarType::Byte> tfb;
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tfl;
+
+  // 600 values per embedding in groups of 200, so that groups straddle the
+  // chunks the kernel dequantizes at a time.
+  constexpr int32_t num_embeddings = 4;
+  constexpr int32_t packed_dim = 150;
+  constexpr int32_t embedding_dim = 4 * packed_dim;
+  constexpr int32_t num_groups = 3;
+  constexpr int32_t group_size = embedding_dim / num_groups;
+
+  std::vector<uint8_t> weight_data(num_embeddings * packed_dim);
+  for (size_t i = 0; i < weight_data.size(); ++i) {
+    weight_data[i] = static_cast<uint8_t>((i * 53 + 7) % 256);
+  }
+  std::vector<float> scales(num_embeddings * num_groups);
+  std::vector<float> zero_points(num_embeddings * num_groups);
+  for (size_t i = 0; i < scales.size(); ++i) {
+    scales[i] = 0.5f * (i % 3 + 1);
+    zero_points[i] = static_cast<float>(i % 4) - 2.0f;
+  }
+  const std::vector<int64_t> indices_data = {3, 1, 1, 0, 2};
+
+  std::vector<float> expected_data;
+  for (int64_t index : indices_data) {
+    for (int32_t j = 0; j < embedding_dim; ++j) {
+      const uint8_t packed = weight_data[index * packed_dim + j / 4];
+      const int32_t q = ((packed >> (2 * (j % 4))) & 3) - 2;
+      const int32_t g = index * num_groups + j / group_size;
+      expected_data.push_back(
+          (static_cast<float>(q) - zero_points[g]) * scales[g]);
+    }
+  }
+
+  Tensor qweight = tfb.make({num_embeddings, packed_dim}, weight_data);
+  Tensor weight_scales = tf.make({num_embeddings, num_groups}, scales);
+  Tensor weight_zero_points =
+      tf.make({num_embeddings, num_groups}, zero_points);
+  const int32_t num_indices = indices_data.size();
+  Tensor indices = tfl.make({num_indices}, indices_data);
+
+  Tensor out = tf.zeros({num_indices, embedding_dim});
+  quantized_embedding_2bit_out(
+      qweight, weight_scales, weight_zero_points, -2, 1, indices, out);
+
+  EXPECT_TENSOR_EQ(out, tf.make({num_indices, embedding_dim}, expected_data));
+}
+
 TEST(OpQuantizedEmbedding2bTest, TestGroupWiseQuantizedEmbeddingDeath1) {
   et_pal_init();
   TensorFactory<ScalarType::Byte> tfb;
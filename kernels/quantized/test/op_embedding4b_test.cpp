@@ -15,6 +15,7 @@
 
 #include <gtest/gtest.h>
 #include <limits>
+#include <vector>
 
 using namespace ::testing;
 using executorch::aten::ArrayRef;
@@ -22,6 +23,7 @@ using executorch::aten::ScalarType;
 using executorch::aten::Tensor;
 using executorch::ET_RUNTIME_NAMESPACE::KernelRuntimeContext;
 using std::optional;
+using torch::executor::native::quantized_embedding_4bit_dtype_out;
 using torch::executor::native::quantized_embedding_4bit_out;
 
 using torch::executor::testing::TensorFactory;
@@ -101,6 +103,89 @@ TEST(OpQuantizedEmbedding4bTest, TestGroupWiseQuantizedEmbedding) {
   EXPECT_TENSOR_EQ(out, expected);
 }
 
+TEST(OpQuantizedEmbedding4bTest, TestLargeGroupWiseQuantizedEmbedding) {
+  et_pal_init();
+  TensorFactory<ScalarType::Byte> tfb;
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Long> tfl;
+
+  // 600 values per embedding in groups of 150, so that groups straddle the
+  // chunks the kernel dequantizes at a time.
+  constexpr int32_t num_embeddings = 5;
+  constexpr int32_t packed_dim = 300;
+  constexpr int32_t embedding_dim = 2 * packed_dim;
+  constexpr int32_t num_groups = 4;
+  constexpr int32_t group_size = embedding_dim / num_groups;
+
+  std::vector<uint8_t> weight_data(num_embeddings * packed_dim);
+  for (size_t i = 0; i < weight_data.size(); ++i) {
+    weight_data[i] = static_cast<uint8_t>((i * 37 + 11) % 256);
+  }
+  std::vector<float> scales(num_embeddings * num_groups);
+  std::vector<float> zero_points(num_embeddings * num_groups);
+  for (size_t i = 0; i < scales.size(); ++i) {
+    scales[i] = 0.25f * (i % 5 + 1);
+    zero_points[i] = static_cast<float>(i % 7) - 3.0f;
+  }
+  const std::vector<int64_t> indices_data = {4, 0, 2, 2, 1, 3, 0};
+
+  std::vector<float> expected_data;
+  for (int64_t index : indices_data) {
+    for (int32_t j = 0; j < embedding_dim; ++j) {
+      const uint8_t packed = weight_data[index * packed_dim + j / 2];
+      const int32_t q = (j % 2 == 0 ? packed >> 4 : packed & 0x0F) - 8;
+      const int32_t g = index * num_groups + j / group_size;
+      expected_data.push_back(
+          (static_cast<float>(q) - zero_points[g]) * scales[g]);
+    }
+  }
+
+  Tensor qweight = tfb.make({num_embeddings, packed_dim}, weight_data);
+  Tensor weight_scales = tf.make({num_embeddings, num_groups}, scales);
+  Tensor weight_zero_points =
+      tf.make({num_embeddings, num_groups}, zero_points);
+  const int32_t num_indices = indices_data.size();
+  Tensor indices = tfl.make({num_indices}, indices_data);
+
+  Tensor out = tf.zeros({num_indices, embedding_dim});
+  quantized_embedding_4bit_out(
+      qweight, weight_scales, weight_zero_points, -8, 7, indices, out);
+
+  EXPECT_TENSOR_EQ(out, tf.make({num_indices, embedding_dim}, expected_data));
+}
+
+TEST(OpQuantizedEmbedding4bTest, TestBFloat16Output) {
+  et_pal_init();
+  TensorFactory<ScalarType::Byte> tfb;
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::BFloat16> tfbf;
+  TensorFactory<ScalarType::Long> tfl;
+
+  // -3,  1,  6, 7,
+  //  2, -5, -4, 0,
+  // -8,  3, -1, 6,
+  Tensor qweight = tfb.make({3, 2}, {89, 239, 163, 72, 11, 126});
+  Tensor weight_scales = tf.make({3, 2}, {0.5, 1.0, 1.5, 2.0, 2.5, 3.0});
+  Tensor indices = tfl.make({3}, {0, 2, 1});
+
+  Tensor out = tfbf.zeros({3, 4});
+  Tensor expected = tfbf.make(
+      {3, 4},
+      {-1.5, 0.5, 6.0, 7.0, -20.0, 7.5, -3.0, 18.0, 3.0, -7.5, -8.0, 0.0});
+
+  quantized_embedding_4bit_dtype_out(
+      qweight,
+      weight_scales,
+      std::nullopt,
+      -8,
+      7,
+      indices,
+      ScalarType::BFloat16,
+      out);
+
+  EXPECT_TENSOR_EQ(out, expected);
+}
+
 TEST(OpQuantizedEmbedding4bTest, TestGroupWiseQuantizedEmbeddingDeath1) {
   et_pal_init();
   TensorFactory<ScalarType::Byte> tfb;
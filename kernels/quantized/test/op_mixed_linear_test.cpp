@@ -140,3 +140,121 @@ TEST_F(OpQuantizedMixedDtypeLinearTest, HalfInputHalfOutput_Partials) {
   test_dtype_partials<ScalarType::Half, ScalarType::Half>();
 }
 #endif
+
+TEST_F(OpQuantizedMixedDtypeLinearTest, PackedInt4Weights) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  Tensor input = tf.make(
+      /*sizes=*/{1, 4},
+      /*data=*/{1.0, 1.5, 2.0, 0.5});
+  // Two int4 values per byte, the first one in the high nibble, offset by 8:
+  // {{5, -3, 1, 7}, {-8, 2, 0, -1}}.
+  Tensor weight = tf_byte.make(
+      /*sizes=*/{2, 2},
+      /*data=*/{0xD5, 0x9F, 0x0A, 0x87});
+  Tensor weight_scales = tf.make(
+      /*sizes=*/{2, 2},
+      /*data=*/{0.2, 1, 0.4, 0.5});
+  const optional<Tensor> opt_weight_zp{};
+  const optional<ScalarType> opt_dtype_out{};
+
+  Tensor out = tf.zeros({1, 2});
+
+  Tensor expected = tf.make(
+      /*sizes=*/{1, 2},
+      /*data=*/
+      {(1.0 * 5 - 1.5 * 3) * 0.2 + (2.0 * 1 + 0.5 * 7) * 1,
+       (-1.0 * 8 + 1.5 * 2) * 0.4 + (2.0 * 0 - 0.5 * 1) * 0.5});
+
+  KernelRuntimeContext ctx{};
+
+  quantized_mixed_linear_out(
+      ctx, input, weight, weight_scales, opt_weight_zp, opt_dtype_out, out);
+
+  EXPECT_TENSOR_CLOSE(out, expected);
+}
+
+namespace {
+
+// Compares against a reference on shapes that exercise the tails of the
+// vectorized loops, the chunks of columns and the blocks of rows and output
+// channels.
+void test_against_reference(
+    int32_t m,
+    int32_t n,
+    int32_t p,
+    int32_t num_groups,
+    int nbit) {
+  TensorFactory<ScalarType::Float> tf;
+  TensorFactory<ScalarType::Char> tf_char;
+  TensorFactory<ScalarType::Byte> tf_byte;
+
+  std::vector<float> input_data(m * n);
+  for (size_t i = 0; i < input_data.size(); ++i) {
+    input_data[i] = static_cast<float>(i * 37 % 23) / 11 - 1;
+  }
+  const int32_t qmin = nbit == 8 ? -128 : -8;
+  const int32_t qrange = nbit == 8 ? 256 : 16;
+  std::vector<int32_t> weight_values(p * n);
+  for (size_t i = 0; i < weight_values.size(); ++i) {
+    weight_values[i] = qmin + static_cast<int32_t>(i * 53 % qrange);
+  }
+  std::vector<float> scales_data(p * num_groups);
+  for (size_t i = 0; i < scales_data.size(); ++i) {
+    scales_data[i] = 0.01f * (1 + i % 7);
+  }
+  const int32_t group_size = (n + num_groups - 1) / num_groups;
+
+  std::vector<float> expected_data(m * p);
+  for (int32_t i = 0; i < m; ++i) {
+    for (int32_t j = 0; j < p; ++j) {
+      double sum = 0;
+      for (int32_t k = 0; k < n; ++k) {
+        sum += input_data[i * n + k] * weight_values[j * n + k] *
+            scales_data[j * num_groups + k / group_size];
+      }
+      expected_data[i * p + j] = sum;
+    }
+  }
+
+  std::vector<int8_t> int8_data(weight_values.begin(), weight_values.end());
+  std::vector<uint8_t> int4_data(p * n / 2);
+  for (size_t i = 0; i < int4_data.size(); ++i) {
+    int4_data[i] =
+        (weight_values[2 * i] + 8) << 4 | (weight_values[2 * i + 1] + 8);
+  }
+  Tensor weight = nbit == 8 ? tf_char.make({p, n}, int8_data)
+                            : tf_byte.make({p, n / 2}, int4_data);
+  Tensor input = tf.make({m, n}, input_data);
+  Tensor weight_scales = tf.make({p, num_groups}, scales_data);
+  Tensor out = tf.zeros({m, p});
+
+  KernelRuntimeContext ctx{};
+  quantized_mixed_linear_out(ctx, input, weight, weight_scales, {}, {}, out);
+
+  EXPECT_TENSOR_CLOSE_WITH_TOL(out, tf.make({m, p}, expected_data), 1e-4, 1e-4);
+}
+
+} // namespace
+
+TEST_F(OpQuantizedMixedDtypeLinearTest, Int8Decode) {
+  test_against_reference(
+      /*m=*/1, /*n=*/600, /*p=*/37, /*num_groups=*/3, /*nbit=*/8);
+}
+
+TEST_F(OpQuantizedMixedDtypeLinearTest, Int8Prefill) {
+  test_against_reference(
+      /*m=*/70, /*n=*/300, /*p=*/9, /*num_groups=*/4, /*nbit=*/8);
+}
+
+TEST_F(OpQuantizedMixedDtypeLinearTest, Int4Decode) {
+  test_against_reference(
+      /*m=*/1, /*n=*/600, /*p=*/37, /*num_groups=*/8, /*nbit=*/4);
+}
+
+TEST_F(OpQuantizedMixedDtypeLinearTest, Int4Prefill) {
+  // Groups of 75 columns start on odd columns, in the middle of a byte.
+  test_against_reference(
+      /*m=*/70, /*n=*/300, /*p=*/9, /*num_groups=*/4, /*nbit=*/4);
+}
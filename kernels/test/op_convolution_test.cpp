@@ -137,6 +137,128 @@ class OpConvOutTest : public OperatorTest {
         out);
     EXPECT_TENSOR_CLOSE(out, expected);
   }
+
+  // Compares a 2D convolution against a direct computation of its
+  // definition, on shapes large enough to exercise the blocked paths of
+  // optimized kernels.
+  void test_against_reference(
+      int32_t in_channels,
+      int32_t out_channels,
+      int32_t size,
+      int32_t kernel_size,
+      int64_t stride,
+      int64_t padding,
+      int64_t dilation,
+      int64_t groups,
+      bool channels_last) {
+    TensorFactory<ScalarType::Float> tf;
+    const int32_t batch = 2;
+    const int32_t in_per_group = in_channels / groups;
+    const int32_t out_per_group = out_channels / groups;
+    const int32_t out_size =
+        (size + 2 * padding - dilation * (kernel_size - 1) - 1) / stride + 1;
+
+    std::vector<float> in_data(batch * in_channels * size * size);
+    for (size_t i = 0; i < in_data.size(); ++i) {
+      in_data[i] = static_cast<float>(i % 13) / 8 - 0.75f;
+    }
+    std::vector<float> weight_data(
+        out_channels * in_per_group * kernel_size * kernel_size);
+    for (size_t i = 0; i < weight_data.size(); ++i) {
+      weight_data[i] = static_cast<float>(i % 7) / 4 - 0.75f;
+    }
+    std::vector<float> bias_data(out_channels);
+    for (size_t i = 0; i < bias_data.size(); ++i) {
+      bias_data[i] = static_cast<float>(i % 5) - 2;
+    }
+
+    std::vector<float> expected_data(
+        batch * out_channels * out_size * out_size);
+    for (int32_t n = 0; n < batch; ++n) {
+      for (int32_t oc = 0; oc < out_channels; ++oc) {
+        const int32_t g = oc / out_per_group;
+        for (int32_t oy = 0; oy < out_size; ++oy) {
+          for (int32_t ox = 0; ox < out_size; ++ox) {
+            float acc = bias_data[oc];
+            for (int32_t ic = 0; ic < in_per_group; ++ic) {
+              for (int32_t ky = 0; ky < kernel_size; ++ky) {
+                for (int32_t kx = 0; kx < kernel_size; ++kx) {
+                  const int64_t iy = oy * stride - padding + ky * dilation;
+                  const int64_t ix = ox * stride - padding + kx * dilation;
+                  if (iy < 0 || iy >= size || ix < 0 || ix >= size) {
+                    continue;
+                  }
+                  acc += in_data
+                             [((n * in_channels + g * in_per_group + ic) *
+                                   size +
+                               iy) *
+                                  size +
+                              ix] *
+                      weight_data
+                          [((oc * in_per_group + ic) * kernel_size + ky) *
+                               kernel_size +
+                           kx];
+                }
+              }
+            }
+            expected_data[((n * out_channels + oc) * out_size + oy) *
+                              out_size +
+                          ox] = acc;
+          }
+        }
+      }
+    }
+
+    const std::vector<int32_t> in_sizes = {batch, in_channels, size, size};
+    const std::vector<int32_t> weight_sizes = {
+        out_channels, in_per_group, kernel_size, kernel_size};
+    const std::vector<int32_t> out_sizes = {
+        batch, out_channels, out_size, out_size};
+    Tensor input = tf.make(in_sizes, in_data);
+    Tensor weight = tf.make(weight_sizes, weight_data);
+    Tensor expected = tf.make(out_sizes, expected_data);
+    Tensor out = tf.zeros(out_sizes);
+    if (channels_last) {
+      // Convert the contiguous tensors to channels last.
+      Tensor input_cl = tf.zeros_channels_last(in_sizes);
+      Tensor expected_cl = tf.zeros_channels_last(out_sizes);
+      const auto to_channels_last = [](const Tensor& from, Tensor& to) {
+        const int64_t C = from.size(1);
+        const int64_t HW = from.size(2) * from.size(3);
+        for (int64_t n = 0; n < from.size(0); ++n) {
+          for (int64_t c = 0; c < C; ++c) {
+            for (int64_t p = 0; p < HW; ++p) {
+              to.mutable_data_ptr<float>()[(n * HW + p) * C + c] =
+                  from.const_data_ptr<float>()[(n * C + c) * HW + p];
+            }
+          }
+        }
+      };
+      to_channels_last(input, input_cl);
+      to_channels_last(expected, expected_cl);
+      input = input_cl;
+      expected = expected_cl;
+      out = tf.zeros_channels_last(out_sizes);
+    }
+
+    int64_t stride_arr[] = {stride, stride};
+    int64_t padding_arr[] = {padding, padding};
+    int64_t dilation_arr[] = {dilation, dilation};
+    int64_t output_padding[] = {0, 0};
+
+    op_convolution_out(
+        input,
+        weight,
+        optional<Tensor>(tf.make({out_channels}, bias_data)),
+        stride_arr,
+        padding_arr,
+        dilation_arr,
+        false,
+        output_padding,
+        groups,
+        out);
+    EXPECT_TENSOR_CLOSE_WITH_TOL(out, expected, 1e-4, 1e-4);
+  }
 };
 
 class OpConvCorrectnessTest : public OpConvOutTest {};
@@ -728,3 +850,94 @@ TEST_F(OpConvCorrectnessTest, InvalidOutputPadding) {
           groups,
           out));
 }
+
+TEST_F(OpConvCorrectnessTest, LargeReduction) {
+  test_against_reference(
+      /*in_channels=*/64,
+      /*out_channels=*/24,
+      /*size=*/12,
+      /*kernel_size=*/3,
+      /*stride=*/1,
+      /*padding=*/1,
+      /*dilation=*/1,
+      /*groups=*/1,
+      /*channels_last=*/false);
+}
+
+TEST_F(OpConvCorrectnessTest, LargeReductionChannelsLast) {
+  test_against_reference(
+      /*in_channels=*/64,
+      /*out_channels=*/24,
+      /*size=*/12,
+      /*kernel_size=*/3,
+      /*stride=*/2,
+      /*padding=*/1,
+      /*dilation=*/2,
+      /*groups=*/1,
+      /*channels_last=*/true);
+}
+
+TEST_F(OpConvCorrectnessTest, Pointwise) {
+  test_against_reference(
+      /*in_channels=*/32,
+      /*out_channels=*/16,
+      /*size=*/9,
+      /*kernel_size=*/1,
+      /*stride=*/1,
+      /*padding=*/0,
+      /*dilation=*/1,
+      /*groups=*/1,
+      /*channels_last=*/false);
+}
+
+TEST_F(OpConvCorrectnessTest, PointwiseChannelsLast) {
+  test_against_reference(
+      /*in_channels=*/32,
+      /*out_channels=*/16,
+      /*size=*/9,
+      /*kernel_size=*/1,
+      /*stride=*/1,
+      /*padding=*/0,
+      /*dilation=*/1,
+      /*groups=*/1,
+      /*channels_last=*/true);
+}
+
+TEST_F(OpConvCorrectnessTest, Depthwise) {
+  test_against_reference(
+      /*in_channels=*/8,
+      /*out_channels=*/16,
+      /*size=*/10,
+      /*kernel_size=*/3,
+      /*stride=*/2,
+      /*padding=*/1,
+      /*dilation=*/1,
+      /*groups=*/8,
+      /*channels_last=*/false);
+}
+
+TEST_F(OpConvCorrectnessTest, DepthwiseChannelsLast) {
+  test_against_reference(
+      /*in_channels=*/8,
+      /*out_channels=*/8,
+      /*size=*/10,
+      /*kernel_size=*/5,
+      /*stride=*/1,
+      /*padding=*/2,
+      /*dilation=*/1,
+      /*groups=*/8,
+      /*channels_last=*/true);
+}
+
+TEST_F(OpConvCorrectnessTest, Grouped) {
+  test_against_reference(
+      /*in_channels=*/12,
+      /*out_channels=*/6,
+      /*size=*/7,
+      /*kernel_size=*/3,
+      /*stride=*/1,
+      /*padding=*/1,
+      /*dilation=*/1,
+      /*groups=*/3,
+      /*channels_last=*/false);
+}
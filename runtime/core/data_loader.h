@@ -123,6 +123,34 @@ class DataLoader {
     return Error::NotImplemented;
   }
 
+  /**
+   * Hints that a region of the data source will be loaded soon, so that the
+   * loader can start reading it in the background. A later load() of the same
+   * region may then return without waiting for the data.
+   *
+   * NOTE: This must be thread-safe. If this call modifies common state, the
+   * implementation must do its own locking.
+   *
+   * @param offset The byte offset in the data source of the region.
+   * @param size The size of the region in bytes.
+   * @param segment_info Information about the segment that will be loaded.
+   *
+   * @retval Error::Ok The loader started reading the region.
+   * @retval Error::NotImplemented The loader doesn't prefetch.
+   * @returns Other errors if the region can't be prefetched. Callers may
+   *     ignore them, since load() reports them again.
+   */
+  ET_NODISCARD virtual Error prefetch(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const {
+    // Like load_into(), a stub implementation keeps existing loaders working.
+    (void)offset;
+    (void)size;
+    (void)segment_info;
+    return Error::NotImplemented;
+  }
+
   /**
    * Returns the length of the underlying data source, typically the file size.
    */
@@ -9,10 +9,12 @@
 #include <executorch/runtime/executor/method.h>
 
 #include <c10/util/irange.h>
+#include <algorithm>
 #include <array>
 #include <cinttypes> // @donotremove
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 
 #include <executorch/runtime/backend/interface.h>
 #include <executorch/runtime/core/event_tracer_hooks.h>
@@ -24,6 +26,7 @@
 #include <executorch/runtime/executor/platform_memory_allocator.h>
 #include <executorch/runtime/executor/program.h>
 #include <executorch/runtime/executor/tensor_parser.h>
+#include <executorch/runtime/kernel/elementwise_fusion.h>
 #include <executorch/runtime/kernel/kernel_runtime_context.h>
 #include <executorch/runtime/kernel/operator_registry.h>
 #include <executorch/runtime/platform/assert.h>
@@ -212,6 +215,18 @@ class BackendDelegate final {
   DelegateHandle* handle_;
 };
 
+/**
+ * A run of elementwise kernel calls that executes as a single fused call.
+ */
+struct FusedElementwiseGroup {
+  FusedElementwiseFunction function;
+  Span<const FusedElementwiseStep> steps;
+  Span<EValue*> inputs;
+  EValue* out;
+  /// The index of the instruction that follows the run.
+  size_t end;
+};
+
 /**
  * Runtime state for a chain of instructions.
  */
@@ -223,6 +238,23 @@ struct Chain {
   Span<InstructionArgs> argument_lists_;
   /// Each instruction will have one kernel (not for delegate).
   OpFunction* kernels_;
+  /// Null if no instruction of the chain was fused. Otherwise, one entry per
+  /// instruction, set for the first instruction of each fused run.
+  FusedElementwiseGroup** fused_groups_;
+};
+
+/**
+ * Order in which the instructions of a chain run in parallel execution mode.
+ */
+struct ParallelSchedule {
+  /// False if the chain must run sequentially; the other fields are unset.
+  bool parallel;
+  /// Instruction indices grouped by level. Instructions of a level only depend
+  /// on instructions of earlier levels.
+  uint32_t* order;
+  /// The end offset in `order` of each level.
+  uint32_t* level_ends;
+  size_t n_levels;
 };
 
 namespace {
@@ -338,8 +370,9 @@ Error Method::parse_external_constants(const NamedDataMap* external_data_map) {
   size_t n_value = flatbuffer_values->size();
 
   // n_external_constants_ counts the number of successfully-initialized
-  // external constants for ~Method() to clean up, and is incremented at the
-  // bottom of the loop. This makes it safe for errors to return without
+  // external constants, and is incremented at the bottom of the loop. A slot
+  // only gets its key once its buffer is constructed, so ~Method() can tell
+  // which slots to clean up. This makes it safe for errors to return without
   // updating any state.
   n_external_constants_ = 0;
   for (size_t i = 0; i < n_value; ++i) {
@@ -369,9 +402,16 @@ Error Method::parse_external_constants(const NamedDataMap* external_data_map) {
         s_tensor->extra_tensor_info()->fully_qualified_name()->c_str();
 
     // Check if this tensor has already been resolved.
-    if (get_data_by_key(
-            key, Span<NamedData>(external_constants_, n_external_constants_)) !=
-        nullptr) {
+    NamedData* slot = deserialization::find_named_data_slot(
+        key,
+        {Span<NamedData>(external_constants_, external_constants_size_)});
+    ET_CHECK_OR_RETURN_ERROR(
+        slot != nullptr,
+        Internal,
+        "No room for external constant %s at index %zu",
+        key,
+        i);
+    if (slot->key != nullptr) {
       continue;
     }
     Result<const TensorLayout> tensor_layout =
@@ -386,23 +426,36 @@ Error Method::parse_external_constants(const NamedDataMap* external_data_map) {
     if (err != Error::Ok) {
       return err;
     }
-    // Save the key.
-    external_constants_[n_external_constants_].key = key;
-
-    // Save the buffer.
+    // Save the buffer, then the key.
     Result<FreeableBuffer> buffer = external_data_map->get_data(key);
     ET_CHECK_OR_RETURN_ERROR(
         buffer.ok(),
         InvalidExternalData,
         "Buffer retrieved from get_data is not valid");
-    new (&external_constants_[n_external_constants_].buffer)
-        FreeableBuffer(std::move(buffer.get()));
+    new (&slot->buffer) FreeableBuffer(std::move(buffer.get()));
+    slot->key = key;
 
     n_external_constants_ += 1;
   }
   return Error::Ok;
 }
 
+Span<NamedData> Method::get_external_constant(
+    const executorch_flatbuffer::Tensor* s_tensor) {
+  if (external_constants_size_ == 0 ||
+      s_tensor->extra_tensor_info() == nullptr ||
+      s_tensor->extra_tensor_info()->fully_qualified_name() == nullptr) {
+    return {};
+  }
+  NamedData* slot = deserialization::find_named_data_slot(
+      s_tensor->extra_tensor_info()->fully_qualified_name()->c_str(),
+      {Span<NamedData>(external_constants_, external_constants_size_)});
+  if (slot == nullptr || slot->key == nullptr) {
+    return {};
+  }
+  return {slot, 1};
+}
+
 Error Method::parse_values(const NamedDataMap* external_data_map) {
   auto flatbuffer_values = serialization_plan_->values();
   ET_CHECK_OR_RETURN_ERROR(
@@ -424,13 +477,20 @@ Error Method::parse_values(const NamedDataMap* external_data_map) {
     return max_external_constants.error();
   }
   if (max_external_constants.get() > 0) {
-    // Allocate space for external tensors.
+    // Allocate the external constants table; looking constants up by fqn
+    // while parsing the values below is then constant time instead of a scan.
+    const size_t table_size = deserialization::get_named_data_table_size(
+        max_external_constants.get());
     external_constants_ =
         memory_manager_->method_allocator()->allocateList<NamedData>(
-            max_external_constants.get());
+            table_size);
     if (external_constants_ == nullptr) {
       return Error::MemoryAllocationFailed;
     }
+    for (const auto i : c10::irange(table_size)) {
+      external_constants_[i].key = nullptr;
+    }
+    external_constants_size_ = table_size;
     Error err = parse_external_constants(external_data_map);
     if (err != Error::Ok) {
       return err;
@@ -540,12 +600,14 @@ Error Method::parse_values(const NamedDataMap* external_data_map) {
         new (&values_[i]) EValue(fb_str->c_str(), fb_str->size());
       } break;
       case executorch_flatbuffer::KernelTypes::Tensor: {
+        const auto s_tensor =
+            static_cast<const executorch_flatbuffer::Tensor*>(val);
         auto t = deserialization::parseTensor(
             program_,
             memory_manager_,
-            static_cast<const executorch_flatbuffer::Tensor*>(val),
+            s_tensor,
             external_data_map,
-            Span<NamedData>(external_constants_, n_external_constants_));
+            get_external_constant(s_tensor));
         if (!t.ok()) {
           ET_LOG(
               Error,
@@ -744,7 +806,8 @@ Result<Method> Method::load(
     const Program* program,
     MemoryManager* memory_manager,
     EventTracer* event_tracer,
-    const NamedDataMap* external_data_map) {
+    const NamedDataMap* external_data_map,
+    const Method* prototype) {
   MemoryAllocator* temp_allocator = memory_manager->temp_allocator();
   if (temp_allocator == nullptr) {
     PlatformMemoryAllocator* platform_allocator =
@@ -758,7 +821,7 @@ Result<Method> Method::load(
   }
   Method method(program, memory_manager, event_tracer, temp_allocator);
   ET_LOG(Debug, "Loading method: %s.", s_plan->name()->c_str());
-  Error err = method.init(s_plan, external_data_map);
+  Error err = method.init(s_plan, external_data_map, prototype);
   if (err != Error::Ok) {
     return err;
   } else {
@@ -769,7 +832,8 @@ Result<Method> Method::load(
 
 Error Method::init(
     executorch_flatbuffer::ExecutionPlan* s_plan,
-    const NamedDataMap* external_data_map) {
+    const NamedDataMap* external_data_map,
+    const Method* prototype) {
   EXECUTORCH_SCOPE_PROF("Method::init");
   internal::EventTracerProfileMethodScope event_tracer_profile_scope =
       internal::EventTracerProfileMethodScope(event_tracer_, "Method::init");
@@ -779,6 +843,12 @@ Error Method::init(
       init_state_ == InitializationState::Uninitialized,
       InvalidState,
       "Method already initialized, or previously failed to initialize.");
+  ET_CHECK_OR_RETURN_ERROR(
+      prototype == nullptr ||
+          (prototype->initialized() &&
+           prototype->serialization_plan_ == s_plan),
+      InvalidArgument,
+      "Prototype method is not initialized or was loaded from another plan.");
   init_state_ =
       InitializationState::InitializationFailed; // Until proven otherwise
   serialization_plan_ = s_plan;
@@ -833,6 +903,22 @@ Error Method::init(
       named_data_map = pte_data_map.get();
     }
 
+    // Start reading the segments of all the delegates, so that loaders that
+    // can prefetch overlap each read with the initialization of the delegates
+    // before it. Failures are reported when the segment is loaded.
+    for (size_t i = 0; i < n_delegate; ++i) {
+      const auto& delegate = *delegates->Get(i);
+      const auto* processed = delegate.processed();
+      if (delegate.id() != nullptr && processed != nullptr &&
+          processed->location() ==
+              executorch_flatbuffer::DataLocation::SEGMENT) {
+        (void)program_->prefetch_segment(DataLoader::SegmentInfo(
+            DataLoader::SegmentInfo::Type::Backend,
+            processed->index(),
+            delegate.id()->c_str()));
+      }
+    }
+
     // n_delegate_ counts the number of successfully-initialized delegates for
     // ~Method() to clean up, and is incremented at the bottom of the loop. This
     // makes it safe for errors to return without updating any state.
@@ -923,6 +1009,14 @@ Error Method::init(
               return res.error();
             }
             chain_instruction_arg_lists[instr_idx] = res.get();
+            if (prototype != nullptr) {
+              // The prototype was initialized from the same plan, so its
+              // kernel for this instruction was resolved against identical
+              // tensor metadata. Reuse it rather than searching the registry.
+              chain_instruction_kernels[instr_idx] =
+                  prototype->chains_[i].kernels_[instr_idx];
+              break;
+            }
             auto err = resolve_operator(
                 instr_args_as_KernelCall->op_index(),
                 chain_instruction_kernels,
@@ -981,6 +1075,7 @@ Error Method::init(
           s_chain,
           Span<InstructionArgs>(chain_instruction_arg_lists, num_instructions),
           chain_instruction_kernels,
+          /*fused_groups_=*/nullptr,
       };
     }
     ET_CHECK_OR_RETURN_ERROR(
@@ -994,6 +1089,13 @@ Error Method::init(
     }
   }
 
+  {
+    Error err = fuse_elementwise_instructions();
+    if (err != Error::Ok) {
+      return err;
+    }
+  }
+
   step_state_ = StepState{0, 0};
 
   init_state_ = InitializationState::Initialized;
@@ -1319,7 +1421,21 @@ Error Method::execute_instruction() {
       // TODO(T147221312): Also expose tensor resizer via the context.
       KernelRuntimeContext context(event_tracer_, temp_allocator_);
       auto args = chain.argument_lists_[step_state_.instr_idx];
-      chain.kernels_[step_state_.instr_idx](context, args.data());
+      const FusedElementwiseGroup* fused_group = chain.fused_groups_ != nullptr
+          ? chain.fused_groups_[step_state_.instr_idx]
+          : nullptr;
+      if (fused_group != nullptr &&
+          fused_group->function(
+              context,
+              fused_group->steps,
+              fused_group->inputs,
+              *fused_group->out)) {
+        next_instr_idx = fused_group->end;
+      } else {
+        // Not fused, or the fused call doesn't support the current inputs:
+        // run the operators one by one.
+        chain.kernels_[step_state_.instr_idx](context, args.data());
+      }
       // We reset the temp_allocator after the switch statement
       err = context.failure_state();
       if (err != Error::Ok) {
@@ -1449,6 +1565,772 @@ Error Method::execute_instruction() {
   return err;
 }
 
+namespace {
+
+// The longest run of instructions that is fused into one call.
+constexpr size_t kMaxFusedSteps = 16;
+
+// An operator that a fused elementwise call can compute.
+struct FusibleOperator {
+  const char* name;
+  FusibleElementwiseOp op;
+  // The number of arguments before `out`.
+  size_t n_inputs;
+};
+
+constexpr FusibleOperator kFusibleOperators[] = {
+    {"aten::add", FusibleElementwiseOp::Add, 3},
+    {"aten::sub", FusibleElementwiseOp::Sub, 3},
+    {"aten::mul", FusibleElementwiseOp::Mul, 2},
+    {"aten::div", FusibleElementwiseOp::Div, 2},
+    {"aten::neg", FusibleElementwiseOp::Neg, 1},
+    {"aten::relu", FusibleElementwiseOp::Relu, 1},
+    {"aten::sigmoid", FusibleElementwiseOp::Sigmoid, 1},
+    {"aten::tanh", FusibleElementwiseOp::Tanh, 1},
+    {"aten::exp", FusibleElementwiseOp::Exp, 1},
+};
+
+// The operands of a kernel call to a fusible operator.
+struct FusibleCall {
+  FusibleElementwiseOp op;
+  EValue* lhs;
+  // Null for unary operators.
+  EValue* rhs;
+  double alpha;
+  EValue* out;
+};
+
+bool is_float_tensor(const EValue* value) {
+  return value->isTensor() &&
+      value->toTensor().scalar_type() == executorch::aten::ScalarType::Float;
+}
+
+// Returns true if `instruction` calls the out variant of a fusible operator on
+// float tensors, and fills `call` with its operands.
+bool parse_fusible_call(
+    const executorch_flatbuffer::ExecutionPlan* plan,
+    const executorch_flatbuffer::Instruction* instruction,
+    InstructionArgs args,
+    FusibleCall* call) {
+  if (instruction->instr_args_type() !=
+      executorch_flatbuffer::InstructionArguments::KernelCall) {
+    return false;
+  }
+  const auto op_index = instruction->instr_args_as_KernelCall()->op_index();
+  const auto* ops = plan->operators();
+  if (ops == nullptr || op_index < 0 ||
+      static_cast<flatbuffers::uoffset_t>(op_index) >= ops->size()) {
+    return false;
+  }
+  const auto* op = ops->Get(op_index);
+  if (op->name() == nullptr || op->overload() == nullptr ||
+      strcmp(op->overload()->c_str(), "out") != 0) {
+    return false;
+  }
+  for (const FusibleOperator& fusible : kFusibleOperators) {
+    if (strcmp(op->name()->c_str(), fusible.name) != 0) {
+      continue;
+    }
+    const size_t n = fusible.n_inputs;
+    // `out` may also be listed again as the return value.
+    if (args.size() != n + 1 &&
+        !(args.size() == n + 2 && args[n + 1] == args[n])) {
+      return false;
+    }
+    call->op = fusible.op;
+    call->lhs = args[0];
+    call->rhs = is_binary_elementwise_op(fusible.op) ? args[1] : nullptr;
+    call->alpha = 1.0;
+    call->out = args[n];
+    if (n == 3) {
+      const EValue* alpha = args[2];
+      if (alpha->isInt()) {
+        call->alpha = static_cast<double>(alpha->toInt());
+      } else if (alpha->isDouble()) {
+        call->alpha = alpha->toDouble();
+      } else {
+        return false;
+      }
+    }
+    return is_float_tensor(call->lhs) &&
+        (call->rhs == nullptr || is_float_tensor(call->rhs)) &&
+        is_float_tensor(call->out);
+  }
+  return false;
+}
+
+// Returns how many arguments of `args` are `value`.
+uint32_t count_args(InstructionArgs args, const EValue* value) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < args.size(); ++i) {
+    count += args[i] == value ? 1 : 0;
+  }
+  return count;
+}
+
+} // namespace
+
+Error Method::fuse_elementwise_instructions() {
+  const FusedElementwiseFunction function = get_fused_elementwise_function();
+  // Fusing would hide the intermediate results and the individual operators
+  // from the event tracer.
+  if (function == nullptr || event_tracer_ != nullptr ||
+      temp_allocator_ == nullptr) {
+    return Error::Ok;
+  }
+  // Fusion is an optimization: when memory runs short, the method runs
+  // unfused.
+  MemoryAllocator* scratch = temp_allocator_;
+  auto* uses = scratch->allocateList<uint32_t>(n_value_ > 0 ? n_value_ : 1);
+  if (uses == nullptr) {
+    ET_LOG(Debug, "Not enough temp memory to fuse elementwise operators");
+    return Error::Ok;
+  }
+
+  // Count the kernel and delegate call arguments that refer to each value. A
+  // value that anything else refers to is pinned and never skipped.
+  constexpr uint32_t kPinned = UINT32_MAX / 2;
+  std::fill(uses, uses + n_value_, 0);
+  auto pin = [&](int64_t index) {
+    if (index >= 0 && static_cast<size_t>(index) < n_value_) {
+      uses[index] = kPinned;
+    }
+  };
+  for (size_t i = 0; i < inputs_size(); ++i) {
+    pin(static_cast<int64_t>(get_input_index(i)));
+  }
+  for (size_t i = 0; i < outputs_size(); ++i) {
+    pin(static_cast<int64_t>(get_output_index(i)));
+  }
+  const auto* s_values = serialization_plan_->values();
+  for (size_t i = 0; i < n_value_; ++i) {
+    const auto* s_value = s_values->Get(i);
+    const flatbuffers::Vector<int32_t>* items = nullptr;
+    if (s_value->val_type() == executorch_flatbuffer::KernelTypes::TensorList) {
+      items = s_value->val_as_TensorList()->items();
+    } else if (
+        s_value->val_type() ==
+        executorch_flatbuffer::KernelTypes::OptionalTensorList) {
+      items = s_value->val_as_OptionalTensorList()->items();
+    }
+    if (items != nullptr) {
+      for (const int32_t item : *items) {
+        pin(item);
+      }
+    }
+  }
+  for (size_t chain_idx = 0; chain_idx < n_chains_; ++chain_idx) {
+    const Chain& chain = chains_[chain_idx];
+    const auto* instructions = chain.s_chain_->instructions();
+    for (size_t instr_idx = 0; instr_idx < instructions->size(); ++instr_idx) {
+      const auto* instruction = instructions->Get(instr_idx);
+      switch (instruction->instr_args_type()) {
+        case executorch_flatbuffer::InstructionArguments::KernelCall:
+        case executorch_flatbuffer::InstructionArguments::DelegateCall: {
+          const InstructionArgs args = chain.argument_lists_[instr_idx];
+          for (size_t i = 0; i < args.size(); ++i) {
+            uses[args[i] - values_] += 1;
+          }
+        } break;
+        case executorch_flatbuffer::InstructionArguments::JumpFalseCall:
+          pin(instruction->instr_args_as_JumpFalseCall()->cond_value_index());
+          break;
+        case executorch_flatbuffer::InstructionArguments::MoveCall:
+          pin(instruction->instr_args_as_MoveCall()->move_from());
+          pin(instruction->instr_args_as_MoveCall()->move_to());
+          break;
+        case executorch_flatbuffer::InstructionArguments::FreeCall:
+          pin(instruction->instr_args_as_FreeCall()->value_index());
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  auto* method_allocator = memory_manager_->method_allocator();
+  size_t n_fused = 0;
+  for (size_t chain_idx = 0; chain_idx < n_chains_; ++chain_idx) {
+    Chain& chain = chains_[chain_idx];
+    const auto* instructions = chain.s_chain_->instructions();
+    const size_t n_instructions = instructions->size();
+    if (n_instructions < 2) {
+      continue;
+    }
+    // A run can't be entered in the middle, so it can't contain jump
+    // destinations other than its first instruction.
+    auto* is_destination = scratch->allocateList<bool>(n_instructions);
+    if (is_destination == nullptr) {
+      break;
+    }
+    std::fill(is_destination, is_destination + n_instructions, false);
+    for (size_t instr_idx = 0; instr_idx < n_instructions; ++instr_idx) {
+      const auto* instruction = instructions->Get(instr_idx);
+      if (instruction->instr_args_type() ==
+          executorch_flatbuffer::InstructionArguments::JumpFalseCall) {
+        const auto destination = instruction->instr_args_as_JumpFalseCall()
+                                     ->destination_instruction();
+        if (destination >= 0 &&
+            static_cast<size_t>(destination) < n_instructions) {
+          is_destination[destination] = true;
+        }
+      }
+    }
+
+    size_t begin = 0;
+    while (begin < n_instructions) {
+      // Grow a run in which every call consumes the result of the previous
+      // one, and nothing else uses that result.
+      FusibleCall calls[kMaxFusedSteps];
+      size_t n_calls = 0;
+      while (n_calls < kMaxFusedSteps && begin + n_calls < n_instructions &&
+             (n_calls == 0 || !is_destination[begin + n_calls])) {
+        const size_t instr_idx = begin + n_calls;
+        FusibleCall call;
+        if (!parse_fusible_call(
+                serialization_plan_,
+                instructions->Get(instr_idx),
+                chain.argument_lists_[instr_idx],
+                &call)) {
+          break;
+        }
+        if (n_calls > 0) {
+          EValue* previous = calls[n_calls - 1].out;
+          const uint32_t local_uses =
+              count_args(chain.argument_lists_[instr_idx - 1], previous) +
+              count_args(chain.argument_lists_[instr_idx], previous);
+          if ((call.lhs != previous && call.rhs != previous) ||
+              call.out == previous || uses[previous - values_] != local_uses) {
+            break;
+          }
+        }
+        calls[n_calls++] = call;
+      }
+      if (n_calls < 2) {
+        begin += 1;
+        continue;
+      }
+
+      if (chain.fused_groups_ == nullptr) {
+        chain.fused_groups_ =
+            method_allocator->allocateList<FusedElementwiseGroup*>(
+                n_instructions);
+        if (chain.fused_groups_ == nullptr) {
+          break;
+        }
+        std::fill(
+            chain.fused_groups_, chain.fused_groups_ + n_instructions, nullptr);
+      }
+      auto* group = method_allocator->allocateInstance<FusedElementwiseGroup>();
+      auto* steps =
+          method_allocator->allocateList<FusedElementwiseStep>(n_calls);
+      auto* inputs = method_allocator->allocateList<EValue*>(2 * n_calls);
+      if (group == nullptr || steps == nullptr || inputs == nullptr) {
+        break;
+      }
+      size_t n_inputs = 0;
+      auto operand = [&](size_t step, EValue* value) -> int16_t {
+        if (step > 0 && value == calls[step - 1].out) {
+          return FusedElementwiseStep::kPrevious;
+        }
+        for (size_t i = 0; i < n_inputs; ++i) {
+          if (inputs[i] == value) {
+            return static_cast<int16_t>(i);
+          }
+        }
+        inputs[n_inputs] = value;
+        return static_cast<int16_t>(n_inputs++);
+      };
+      for (size_t step = 0; step < n_calls; ++step) {
+        const FusibleCall& call = calls[step];
+        steps[step].op = call.op;
+        steps[step].lhs = operand(step, call.lhs);
+        steps[step].rhs = call.rhs != nullptr
+            ? operand(step, call.rhs)
+            : FusedElementwiseStep::kPrevious;
+        steps[step].alpha = call.alpha;
+      }
+      *group = FusedElementwiseGroup{
+          function,
+          Span<const FusedElementwiseStep>(steps, n_calls),
+          Span<EValue*>(inputs, n_inputs),
+          calls[n_calls - 1].out,
+          begin + n_calls,
+      };
+      chain.fused_groups_[begin] = group;
+      ET_LOG(
+          Debug,
+          "Fused instructions %" ET_PRIsize_t " to %" ET_PRIsize_t
+          " of chain %" ET_PRIsize_t,
+          begin,
+          begin + n_calls - 1,
+          chain_idx);
+      n_fused += n_calls;
+      begin += n_calls;
+    }
+  }
+  scratch->reset();
+  ET_LOG(
+      Debug,
+      "Fused %" ET_PRIsize_t " elementwise instructions of method %s",
+      n_fused,
+      serialization_plan_->name()->c_str());
+  return Error::Ok;
+}
+
+namespace {
+
+// Flags describing how accesses to a value are tracked while building
+// parallel schedules.
+constexpr uint8_t kValuePlanned = 1 << 0; // Memory-planned tensor.
+constexpr uint8_t kValueUnknown = 1 << 1; // Tensor with unknown storage.
+constexpr uint8_t kValueInput = 1 << 2; // Method input.
+
+// Returns true if `args[index]` also appears before `index`.
+bool aliases_earlier_arg(InstructionArgs args, size_t index) {
+  for (size_t i = 0; i < index; ++i) {
+    if (args[i] == args[index]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+Error Method::build_parallel_schedules(MemoryAllocator* scratch) {
+  auto* schedules =
+      memory_manager_->method_allocator()->allocateList<ParallelSchedule>(
+          n_chains_ > 0 ? n_chains_ : 1);
+  ET_CHECK_OR_RETURN_ERROR(
+      schedules != nullptr,
+      MemoryAllocationFailed,
+      "Failed to allocate parallel schedules");
+
+  const size_t n_value = n_value_ > 0 ? n_value_ : 1;
+  auto* flags = scratch->allocateList<uint8_t>(n_value);
+  auto* region_begin = scratch->allocateList<uintptr_t>(n_value);
+  auto* region_end = scratch->allocateList<uintptr_t>(n_value);
+  auto* read_level = scratch->allocateList<int32_t>(n_value);
+  auto* write_level = scratch->allocateList<int32_t>(n_value);
+  auto* planned = scratch->allocateList<uint32_t>(n_value);
+  auto* delegate_level =
+      scratch->allocateList<int32_t>(n_delegate_ > 0 ? n_delegate_ : 1);
+  ET_CHECK_OR_RETURN_ERROR(
+      flags != nullptr && region_begin != nullptr && region_end != nullptr &&
+          read_level != nullptr && write_level != nullptr &&
+          planned != nullptr && delegate_level != nullptr,
+      MemoryAllocationFailed,
+      "Failed to allocate scratch memory for %" ET_PRIsize_t " values",
+      n_value_);
+
+  // Find where every tensor lives. Planned tensors are tracked by address
+  // range, since memory planning reuses buffers across values whose
+  // lifetimes don't overlap in the original instruction order.
+  const auto* s_values = serialization_plan_->values();
+  size_t n_planned = 0;
+  uintptr_t max_region_size = 0;
+  for (size_t i = 0; i < n_value_; ++i) {
+    flags[i] = 0;
+    region_begin[i] = 0;
+    region_end[i] = 0;
+    const auto* s_value = s_values->Get(i);
+    if (s_value->val_type() != executorch_flatbuffer::KernelTypes::Tensor) {
+      continue;
+    }
+    const auto* s_tensor = s_value->val_as_Tensor();
+    if (s_tensor->allocation_info() != nullptr) {
+      size_t nbytes = elementSize(
+          static_cast<executorch::aten::ScalarType>(s_tensor->scalar_type()));
+      if (s_tensor->sizes() != nullptr) {
+        for (const auto size : *s_tensor->sizes()) {
+          nbytes *= static_cast<size_t>(size);
+        }
+      }
+      flags[i] = kValuePlanned;
+      region_begin[i] =
+          reinterpret_cast<uintptr_t>(values_[i].toTensor().const_data_ptr());
+      region_end[i] = region_begin[i] + nbytes;
+      max_region_size = std::max<uintptr_t>(max_region_size, nbytes);
+      planned[n_planned++] = static_cast<uint32_t>(i);
+    } else if (
+        s_tensor->data_buffer_idx() == 0 &&
+        (s_tensor->extra_tensor_info() == nullptr ||
+         s_tensor->extra_tensor_info()->location() !=
+             executorch_flatbuffer::TensorDataLocation::EXTERNAL)) {
+      // Neither planned nor constant: a view, an unbounded dynamic tensor, or
+      // an input or output whose memory is provided by the caller.
+      flags[i] = kValueUnknown;
+    }
+  }
+  // The caller owns the memory of unplanned inputs and outputs.
+  for (size_t i = 0; i < inputs_size(); ++i) {
+    const size_t index = get_input_index(i);
+    flags[index] = (flags[index] & ~kValueUnknown) | kValueInput;
+  }
+  for (size_t i = 0; i < outputs_size(); ++i) {
+    flags[get_output_index(i)] &= ~kValueUnknown;
+  }
+  std::sort(planned, planned + n_planned, [&](uint32_t a, uint32_t b) {
+    return region_begin[a] < region_begin[b];
+  });
+
+  for (size_t chain_idx = 0; chain_idx < n_chains_; ++chain_idx) {
+    ParallelSchedule& schedule = schedules[chain_idx];
+    schedule = ParallelSchedule{false, nullptr, nullptr, 0};
+    const Chain& chain = chains_[chain_idx];
+    const auto* instructions = chain.s_chain_->instructions();
+    const size_t n_instructions =
+        instructions == nullptr ? 0 : instructions->size();
+    if (n_instructions < 2) {
+      continue;
+    }
+    auto* levels = scratch->allocateList<int32_t>(n_instructions);
+    ET_CHECK_OR_RETURN_ERROR(
+        levels != nullptr,
+        MemoryAllocationFailed,
+        "Failed to allocate levels for chain %" ET_PRIsize_t,
+        chain_idx);
+    std::fill(read_level, read_level + n_value_, -1);
+    std::fill(write_level, write_level + n_value_, -1);
+    std::fill(delegate_level, delegate_level + n_delegate_, -1);
+
+    bool parallel = true;
+    int32_t n_levels = 0;
+    for (size_t instr_idx = 0; parallel && instr_idx < n_instructions;
+         ++instr_idx) {
+      const auto* instruction = instructions->Get(instr_idx);
+      const auto type = instruction->instr_args_type();
+      if (type != executorch_flatbuffer::InstructionArguments::KernelCall &&
+          type != executorch_flatbuffer::InstructionArguments::DelegateCall) {
+        // Control flow, moves and frees depend on the sequential order.
+        parallel = false;
+        break;
+      }
+      const bool is_delegate =
+          type == executorch_flatbuffer::InstructionArguments::DelegateCall;
+      const InstructionArgs args = chain.argument_lists_[instr_idx];
+      const size_t n_args = args.size();
+
+      // Kernel calls end with the values they return. For out variants and
+      // in-place ops these alias earlier arguments, otherwise the last
+      // argument is the single return value.
+      size_t first_written = n_args;
+      if (n_args > 0) {
+        first_written = n_args - 1;
+        while (first_written > 0 &&
+               aliases_earlier_arg(args, first_written)) {
+          --first_written;
+        }
+        if (first_written < n_args - 1) {
+          first_written += 1;
+        }
+      }
+      auto is_written = [&](size_t value_index) {
+        if (is_delegate) {
+          // Delegate arguments don't say which ones are outputs.
+          return true;
+        }
+        for (size_t i = first_written; i < n_args; ++i) {
+          if (args[i] == &values_[value_index]) {
+            return true;
+          }
+        }
+        // A planned intermediate is produced by the first instruction that
+        // touches it, even if it isn't a return value.
+        return (flags[value_index] & kValuePlanned) != 0 &&
+            (flags[value_index] & kValueInput) == 0 &&
+            read_level[value_index] < 0 && write_level[value_index] < 0;
+      };
+
+      // Calls fn(value_index, write) for every value an argument touches,
+      // including the elements of lists.
+      auto for_each_access = [&](auto&& fn) {
+        for (size_t i = 0; i < n_args; ++i) {
+          const size_t value_index = static_cast<size_t>(args[i] - values_);
+          const bool write = is_written(value_index);
+          const auto* s_value = s_values->Get(value_index);
+          const flatbuffers::Vector<int32_t>* tensor_items = nullptr;
+          const flatbuffers::Vector<int64_t>* int_items = nullptr;
+          switch (s_value->val_type()) {
+            case executorch_flatbuffer::KernelTypes::TensorList:
+              tensor_items = s_value->val_as_TensorList()->items();
+              break;
+            case executorch_flatbuffer::KernelTypes::OptionalTensorList:
+              tensor_items = s_value->val_as_OptionalTensorList()->items();
+              break;
+            case executorch_flatbuffer::KernelTypes::IntList:
+              int_items = s_value->val_as_IntList()->items();
+              break;
+            default:
+              fn(value_index, write);
+              continue;
+          }
+          // Boxed lists rewrite their unboxed cache on every access.
+          fn(value_index, /*write=*/true);
+          const size_t n_items = tensor_items != nullptr
+              ? tensor_items->size()
+              : (int_items != nullptr ? int_items->size() : 0);
+          for (size_t j = 0; j < n_items; ++j) {
+            const int64_t item = tensor_items != nullptr
+                ? static_cast<int64_t>(tensor_items->Get(j))
+                : int_items->Get(j);
+            if (item >= 0 && static_cast<size_t>(item) < n_value_) {
+              fn(static_cast<size_t>(item), write);
+            }
+          }
+        }
+      };
+
+      // The level is one past the latest conflicting access.
+      int32_t level = 0;
+      auto constrain = [&](size_t other, bool write) {
+        level = std::max(level, write_level[other] + 1);
+        if (write) {
+          level = std::max(level, read_level[other] + 1);
+        }
+      };
+      for_each_access([&](size_t value_index, bool write) {
+        if (flags[value_index] & kValueUnknown) {
+          parallel = false;
+          return;
+        }
+        constrain(value_index, write);
+        const uintptr_t begin = region_begin[value_index];
+        const uintptr_t end = region_end[value_index];
+        if ((flags[value_index] & kValuePlanned) == 0 || begin == end) {
+          return;
+        }
+        // Visit every planned value whose buffer overlaps this one.
+        size_t i = std::lower_bound(
+                       planned,
+                       planned + n_planned,
+                       end,
+                       [&](uint32_t other, uintptr_t address) {
+                         return region_begin[other] < address;
+                       }) -
+            planned;
+        while (i > 0 &&
+               region_begin[planned[i - 1]] + max_region_size > begin) {
+          const uint32_t other = planned[--i];
+          if (region_end[other] > begin) {
+            constrain(other, write);
+          }
+        }
+      });
+      if (!parallel) {
+        break;
+      }
+      if (is_delegate) {
+        const auto delegate_idx =
+            instruction->instr_args_as_DelegateCall()->delegate_index();
+        ET_CHECK_OR_RETURN_ERROR(
+            static_cast<size_t>(delegate_idx) < n_delegate_,
+            InvalidProgram,
+            "DELEGATE_CALL index %" PRIu32 " >= num delegates %" ET_PRIsize_t,
+            delegate_idx,
+            n_delegate_);
+        // A delegate handle can't run two calls at once.
+        level = std::max(level, delegate_level[delegate_idx] + 1);
+        delegate_level[delegate_idx] = level;
+      }
+      for_each_access([&](size_t value_index, bool write) {
+        int32_t& last =
+            write ? write_level[value_index] : read_level[value_index];
+        last = std::max(last, level);
+      });
+      levels[instr_idx] = level;
+      n_levels = std::max(n_levels, level + 1);
+    }
+    if (!parallel || static_cast<size_t>(n_levels) == n_instructions) {
+      // Fully sequential anyway.
+      continue;
+    }
+
+    // Counting sort of the instructions by level, keeping their original
+    // order within a level.
+    auto* method_allocator = memory_manager_->method_allocator();
+    schedule.order = method_allocator->allocateList<uint32_t>(n_instructions);
+    schedule.level_ends = method_allocator->allocateList<uint32_t>(n_levels);
+    ET_CHECK_OR_RETURN_ERROR(
+        schedule.order != nullptr && schedule.level_ends != nullptr,
+        MemoryAllocationFailed,
+        "Failed to allocate the schedule of chain %" ET_PRIsize_t,
+        chain_idx);
+    std::fill(schedule.level_ends, schedule.level_ends + n_levels, 0);
+    for (size_t i = 0; i < n_instructions; ++i) {
+      schedule.level_ends[levels[i]] += 1;
+    }
+    uint32_t offset = 0;
+    for (int32_t level = 0; level < n_levels; ++level) {
+      const uint32_t count = schedule.level_ends[level];
+      // Temporarily holds the start of the level.
+      schedule.level_ends[level] = offset;
+      offset += count;
+    }
+    for (size_t i = 0; i < n_instructions; ++i) {
+      schedule.order[schedule.level_ends[levels[i]]++] =
+          static_cast<uint32_t>(i);
+    }
+    schedule.n_levels = static_cast<size_t>(n_levels);
+    schedule.parallel = true;
+  }
+  parallel_schedules_ = schedules;
+  return Error::Ok;
+}
+
+Error Method::set_parallel_execution(
+    ParallelForFunction parallel_for,
+    Span<MemoryAllocator*> temp_allocators) {
+  ET_CHECK_OR_RETURN_ERROR(
+      initialized(),
+      InvalidState,
+      "Parallel execution requires an initialized method");
+  if (parallel_for == nullptr) {
+    parallel_for_ = nullptr;
+    parallel_temp_allocators_ = {};
+    return Error::Ok;
+  }
+  ET_CHECK_OR_RETURN_ERROR(
+      temp_allocators.size() > 0,
+      InvalidArgument,
+      "Parallel execution needs at least one temp allocator");
+  for (size_t i = 0; i < temp_allocators.size(); ++i) {
+    ET_CHECK_OR_RETURN_ERROR(
+        temp_allocators[i] != nullptr,
+        InvalidArgument,
+        "Temp allocator %" ET_PRIsize_t " is null",
+        i);
+  }
+  if (temp_allocators.size() > n_parallel_errors_) {
+    parallel_errors_ =
+        memory_manager_->method_allocator()->allocateList<Error>(
+            temp_allocators.size());
+    ET_CHECK_OR_RETURN_ERROR(
+        parallel_errors_ != nullptr,
+        MemoryAllocationFailed,
+        "Failed to allocate %" ET_PRIsize_t " parallel error slots",
+        temp_allocators.size());
+    n_parallel_errors_ = temp_allocators.size();
+  }
+  if (parallel_schedules_ == nullptr) {
+    MemoryAllocator* scratch = temp_allocators[0];
+    const Error err = build_parallel_schedules(scratch);
+    scratch->reset();
+    ET_CHECK_OK_OR_RETURN_ERROR(err);
+  }
+  parallel_for_ = parallel_for;
+  parallel_temp_allocators_ = temp_allocators;
+  return Error::Ok;
+}
+
+size_t Method::num_parallel_chains() const {
+  if (parallel_for_ == nullptr || parallel_schedules_ == nullptr) {
+    return 0;
+  }
+  size_t count = 0;
+  for (size_t i = 0; i < n_chains_; ++i) {
+    count += parallel_schedules_[i].parallel ? 1 : 0;
+  }
+  return count;
+}
+
+Error Method::execute_parallel_instruction(
+    size_t chain_idx,
+    size_t instr_idx,
+    MemoryAllocator* temp_allocator) {
+  auto& chain = chains_[chain_idx];
+  auto instruction = chain.s_chain_->instructions()->Get(instr_idx);
+  auto args = chain.argument_lists_[instr_idx];
+  Error err = Error::Ok;
+  switch (instruction->instr_args_type()) {
+    case executorch_flatbuffer::InstructionArguments::KernelCall: {
+      KernelRuntimeContext context(/*event_tracer=*/nullptr, temp_allocator);
+      chain.kernels_[instr_idx](context, args.data());
+      err = context.failure_state();
+      if (err != Error::Ok) {
+        auto op_index = instruction->instr_args_as_KernelCall()->op_index();
+        ET_UNUSED auto op = serialization_plan_->operators()->Get(op_index);
+        ET_LOG(
+            Error,
+            "KernelCall failed at instruction %" ET_PRIsize_t ":%" ET_PRIsize_t
+            " in operator %s.%s: 0x%x",
+            chain_idx,
+            instr_idx,
+            op->name()->c_str(),
+            op->overload()->c_str(),
+            (unsigned int)err);
+      }
+    } break;
+    case executorch_flatbuffer::InstructionArguments::DelegateCall: {
+      // The index was checked when the schedule was built.
+      auto delegate_idx =
+          instruction->instr_args_as_DelegateCall()->delegate_index();
+      BackendExecutionContext backend_execution_context(
+          /*event_tracer=*/nullptr,
+          /*temp_allocator=*/temp_allocator,
+          /*method_name=*/serialization_plan_->name()->c_str());
+      err = delegates_[delegate_idx].Execute(
+          backend_execution_context, args.data());
+      if (err != Error::Ok) {
+        ET_LOG(
+            Error,
+            "CALL_DELEGATE execute failed at instruction %" ET_PRIsize_t
+            ":%" ET_PRIsize_t ": 0x%" PRIx32,
+            chain_idx,
+            instr_idx,
+            static_cast<uint32_t>(err));
+      }
+    } break;
+    default:
+      // Chains with other instructions never get a parallel schedule.
+      err = Error::Internal;
+  }
+  temp_allocator->reset();
+  return err;
+}
+
+Error Method::execute_chain_in_parallel(size_t chain_idx) {
+  const ParallelSchedule& schedule = parallel_schedules_[chain_idx];
+  const size_t n_lanes = parallel_temp_allocators_.size();
+  size_t level_begin = 0;
+  for (size_t level = 0; level < schedule.n_levels; ++level) {
+    const size_t level_end = schedule.level_ends[level];
+    // Run the level in batches of at most one instruction per temp
+    // allocator.
+    for (size_t batch_begin = level_begin; batch_begin < level_end;
+         batch_begin += n_lanes) {
+      const size_t batch_size = std::min(n_lanes, level_end - batch_begin);
+      const uint32_t* batch = schedule.order + batch_begin;
+      if (batch_size == 1) {
+        ET_CHECK_OK_OR_RETURN_ERROR(execute_parallel_instruction(
+            chain_idx, batch[0], parallel_temp_allocators_[0]));
+        continue;
+      }
+      const bool ok = parallel_for_(
+          0,
+          static_cast<int64_t>(batch_size),
+          1,
+          [this, chain_idx, batch](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              parallel_errors_[i] = execute_parallel_instruction(
+                  chain_idx, batch[i], parallel_temp_allocators_[i]);
+            }
+          });
+      ET_CHECK_OR_RETURN_ERROR(
+          ok,
+          Internal,
+          "parallel_for failed in chain %" ET_PRIsize_t,
+          chain_idx);
+      for (size_t i = 0; i < batch_size; ++i) {
+        ET_CHECK_OK_OR_RETURN_ERROR(parallel_errors_[i]);
+      }
+    }
+    level_begin = level_end;
+  }
+  return Error::Ok;
+}
+
 Error Method::reset_execution() {
   ET_CHECK_OR_RETURN_ERROR(
       step_state_.chain_idx == n_chains_,
@@ -1552,6 +2434,17 @@ Error Method::execute() {
         "chain %" ET_PRIsize_t " has no instructions field",
         step_state_.chain_idx);
 
+    // Event tracers aren't thread-safe, so tracing keeps the sequential
+    // order.
+    if (parallel_for_ != nullptr && event_tracer_ == nullptr &&
+        parallel_schedules_[step_state_.chain_idx].parallel) {
+      auto status = execute_chain_in_parallel(step_state_.chain_idx);
+      if (status != Error::Ok) {
+        return status;
+      }
+      continue;
+    }
+
     // Loop over instructions
     step_state_.instr_idx = 0;
     while (step_state_.instr_idx < chain.s_chain_->instructions()->size()) {
@@ -1693,8 +2586,10 @@ Method::~Method() {
     }
   }
   // Free resources associated with external constants.
-  for (const auto i : c10::irange(n_external_constants_)) {
-    external_constants_[i].buffer.~FreeableBuffer();
+  for (const auto i : c10::irange(external_constants_size_)) {
+    if (external_constants_[i].key != nullptr) {
+      external_constants_[i].buffer.~FreeableBuffer();
+    }
   }
   // Free the MergedDataMap.
   if (merged_data_map_ != nullptr) {
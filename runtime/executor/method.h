@@ -17,6 +17,7 @@
 #include <executorch/runtime/core/evalue.h>
 #include <executorch/runtime/core/event_tracer.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/function_ref.h>
 #include <executorch/runtime/core/named_data_map.h>
 #include <executorch/runtime/core/span.h>
 #include <executorch/runtime/executor/memory_manager.h>
@@ -30,6 +31,7 @@ namespace executorch_flatbuffer {
 struct Chain;
 struct ExecutionPlan;
 struct EValue;
+struct Tensor;
 } // namespace executorch_flatbuffer
 
 namespace executorch {
@@ -47,6 +49,7 @@ class Program;
 // Forward declare internal types.
 class BackendDelegate;
 struct Chain;
+struct ParallelSchedule;
 class KernelRuntimeContext;
 using OpFunction = void (*)(KernelRuntimeContext&, EValue**);
 /// A list of pointers into the master values table that together compose the
@@ -54,6 +57,17 @@ using OpFunction = void (*)(KernelRuntimeContext&, EValue**);
 using InstructionArgs = Span<EValue*>;
 using deserialization::NamedData;
 
+/**
+ * Runs `f` on disjoint subranges that together cover [begin, end), possibly
+ * concurrently, and returns once all of them have completed. Returns false on
+ * failure. `executorch::extension::parallel_for()` has this signature.
+ */
+using ParallelForFunction = bool (*)(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    FunctionRef<void(int64_t, int64_t)> f);
+
 /**
  * An executable method of an executorch program. Maps to a python method like
  * `forward()` on the original nn.Module.
@@ -77,9 +91,15 @@ class Method final {
         delegates_(rhs.delegates_),
         n_chains_(rhs.n_chains_),
         chains_(rhs.chains_),
+        parallel_for_(rhs.parallel_for_),
+        parallel_temp_allocators_(rhs.parallel_temp_allocators_),
+        parallel_errors_(rhs.parallel_errors_),
+        n_parallel_errors_(rhs.n_parallel_errors_),
+        parallel_schedules_(rhs.parallel_schedules_),
         merged_data_map_(std::move(rhs.merged_data_map_)),
         external_constants_(rhs.external_constants_),
         n_external_constants_(rhs.n_external_constants_),
+        external_constants_size_(rhs.external_constants_size_),
         init_state_(rhs.init_state_) {
     // Required: clear out fields that the dtor looks at, so that we don't free
     // anything twice.
@@ -90,6 +110,7 @@ class Method final {
 
     rhs.merged_data_map_ = nullptr;
     rhs.n_external_constants_ = 0;
+    rhs.external_constants_size_ = 0;
     rhs.external_constants_ = nullptr;
 
     // Helpful: Try to ensure that any other interactions with the old object
@@ -102,6 +123,11 @@ class Method final {
     rhs.event_tracer_ = nullptr;
     rhs.n_chains_ = 0;
     rhs.chains_ = nullptr;
+    rhs.parallel_for_ = nullptr;
+    rhs.parallel_temp_allocators_ = {};
+    rhs.parallel_errors_ = nullptr;
+    rhs.n_parallel_errors_ = 0;
+    rhs.parallel_schedules_ = nullptr;
   }
 
   /**
@@ -219,7 +245,9 @@ class Method final {
   ET_NODISCARD Error execute();
 
   /**
-   * EXPERIMENTAL: Advances/executes a single instruction in the method.
+   * EXPERIMENTAL: Advances/executes a single instruction in the method. If
+   * elementwise fusion was enabled with register_fused_elementwise_function()
+   * when the method was loaded, a fused run of operators is a single step.
    *
    * @retval Error::Ok step succeeded
    * @retval non-Ok step failed
@@ -230,6 +258,49 @@ class Method final {
   /// DEPRECATED: Use `step()` instead.
   ET_DEPRECATED ET_NODISCARD Error experimental_step();
 
+  /**
+   * EXPERIMENTAL: Lets execute() run independent instructions of the method
+   * concurrently.
+   *
+   * The first call derives, for every chain, the dependencies between
+   * instructions from the values they read and write, including values whose
+   * memory-planned buffers overlap, and groups the instructions into levels
+   * that only depend on earlier levels. execute() then runs each level with
+   * `parallel_for`. Chains containing control flow, moves or frees, or
+   * tensors whose storage can't be determined up front (for example views or
+   * unbounded dynamic tensors) keep running sequentially, as does everything
+   * while an EventTracer is attached. step() is not affected.
+   *
+   * Written values are identified by the emitter convention that kernel calls
+   * list the values they return, including mutated arguments, at the end of
+   * their arguments; all arguments of delegate calls are treated as written.
+   * Kernels that run concurrently must not share global state.
+   *
+   * @param[in] parallel_for The function used to run the instructions of a
+   *     level, or nullptr to go back to sequential execution.
+   * @param[in] temp_allocators The temp allocators for concurrently running
+   *     instructions: instruction `i` of a batch uses `temp_allocators[i]`, so
+   *     this also bounds how many instructions run at the same time. The
+   *     first one is also used as scratch memory while deriving the
+   *     dependencies. The array and the allocators must outlive the Method or
+   *     the next call to this function.
+   *
+   * @retval Error::Ok on success.
+   * @retval Error::InvalidArgument if `parallel_for` is set and
+   *     `temp_allocators` is empty.
+   * @retval Error::MemoryAllocationFailed if the method or scratch allocator
+   *     is too small.
+   */
+  ET_EXPERIMENTAL ET_NODISCARD Error set_parallel_execution(
+      ParallelForFunction parallel_for,
+      Span<MemoryAllocator*> temp_allocators);
+
+  /**
+   * EXPERIMENTAL: Returns the number of chains that execute() runs in
+   * parallel, which is 0 unless set_parallel_execution() enabled it.
+   */
+  ET_EXPERIMENTAL size_t num_parallel_chains() const;
+
   /**
    * EXPERIMENTAL: Resets execution state to the start of the Method. For use
    * with the `step()` API.
@@ -318,9 +389,15 @@ class Method final {
         delegates_(nullptr),
         n_chains_(0),
         chains_(nullptr),
+        parallel_for_(nullptr),
+        parallel_temp_allocators_(),
+        parallel_errors_(nullptr),
+        n_parallel_errors_(0),
+        parallel_schedules_(nullptr),
         merged_data_map_(nullptr),
         external_constants_(nullptr),
         n_external_constants_(0),
+        external_constants_size_(0),
         init_state_(InitializationState::Uninitialized) {}
 
   /// Static factory used by Program.
@@ -329,16 +406,24 @@ class Method final {
       const Program* program,
       MemoryManager* memory_manager,
       EventTracer* event_tracer,
-      const NamedDataMap* named_data_map);
+      const NamedDataMap* named_data_map,
+      const Method* prototype = nullptr);
 
   /**
    * Initialize the method from its serialized representation.
    *
+   * @param[in] s_plan The serialized execution plan to initialize from.
+   * @param[in] named_data_map Map used to resolve external data, if any.
+   * @param[in] prototype An optional, initialized Method loaded from the same
+   *     `s_plan`. If provided, its resolved kernels are copied instead of
+   *     being looked up in the operator registry again.
+   *
    * @returns Error::Ok on success, non-Ok on failure.
    */
   ET_NODISCARD Error init(
       executorch_flatbuffer::ExecutionPlan* s_plan,
-      const NamedDataMap* named_data_map);
+      const NamedDataMap* named_data_map,
+      const Method* prototype = nullptr);
 
   /// Returns true if the Method was successfully initialized.
   inline bool initialized() const {
@@ -353,6 +438,25 @@ class Method final {
   // Executes a single instruction using the state in step_state_
   ET_NODISCARD Error execute_instruction();
 
+  // Executes the instructions of a chain level by level, using the schedule
+  // built by set_parallel_execution().
+  ET_NODISCARD Error execute_chain_in_parallel(size_t chain_idx);
+
+  // Executes a kernel or delegate call of a parallel chain with the given temp
+  // allocator. Does not touch step_state_ or the event tracer.
+  ET_NODISCARD Error execute_parallel_instruction(
+      size_t chain_idx,
+      size_t instr_idx,
+      MemoryAllocator* temp_allocator);
+
+  // Builds the level schedule of every chain for parallel execution.
+  ET_NODISCARD Error build_parallel_schedules(MemoryAllocator* scratch);
+
+  // Replaces runs of elementwise kernel calls whose intermediate results are
+  // used by nothing else with calls to the registered fused elementwise
+  // function, if any.
+  ET_NODISCARD Error fuse_elementwise_instructions();
+
   StepState step_state_;
   const Program* program_;
   MemoryManager* memory_manager_;
@@ -369,9 +473,19 @@ class Method final {
   size_t n_chains_;
   Chain* chains_;
 
+  ParallelForFunction parallel_for_;
+  Span<MemoryAllocator*> parallel_temp_allocators_;
+  Error* parallel_errors_;
+  size_t n_parallel_errors_;
+  // One entry per chain, built on the first call to set_parallel_execution().
+  ParallelSchedule* parallel_schedules_;
+
   internal::MergedDataMap* merged_data_map_;
+  // Hash table of external constants keyed by fqn; slots with a null key are
+  // unused. See deserialization::find_named_data_slot().
   NamedData* external_constants_;
   size_t n_external_constants_ = 0;
+  size_t external_constants_size_ = 0;
 
   InitializationState init_state_;
 
@@ -383,9 +497,9 @@ class Method final {
 
   /**
    * Parses the flatbuffer for constant tensors tagged as EXTERNAL.
-   * Retrieves the external constants using the named_data_map and places them
-   * into `external_constants_`. Updates `n_external_constants_` to count the
-   * number of successfully-initialized external constants.
+   * Retrieves the external constants using the named_data_map and inserts them
+   * into the `external_constants_` table. Updates `n_external_constants_` to
+   * count the number of successfully-initialized external constants.
    * FreeableBuffers returned by the named_data_map are owned by the
    * method and are freed on method destruction.
    *
@@ -395,6 +509,14 @@ class Method final {
   ET_NODISCARD Error
   parse_external_constants(const NamedDataMap* named_data_map);
 
+  /**
+   * Returns the entry of `external_constants_` that holds the data of
+   * `s_tensor`, as a span for deserialization::parseTensor(). The span is
+   * empty if `s_tensor` is not an external constant that has been resolved.
+   */
+  Span<NamedData> get_external_constant(
+      const executorch_flatbuffer::Tensor* s_tensor);
+
   /**
    * Parses the elements of the values_ array. On error, n_value_ will be set to
    * the number of successfully-initialized entries so that ~Method doesn't try
@@ -289,6 +289,33 @@ Result<Method> Program::load_method(
       plan.get(), this, memory_manager, event_tracer, named_data_map);
 }
 
+Result<Method> Program::load_method_instance(
+    const Method& method,
+    MemoryManager* memory_manager,
+    EventTracer* event_tracer,
+    const NamedDataMap* named_data_map) const {
+  EXECUTORCH_SCOPE_PROF("Program::load_method_instance");
+  internal::event_tracer_create_event_block(event_tracer, "Default");
+  internal::EventTracerProfileMethodScope event_tracer_scope =
+      internal::EventTracerProfileMethodScope(
+          event_tracer, "Program::load_method_instance");
+  ET_CHECK_OR_RETURN_ERROR(
+      method.initialized(),
+      InvalidArgument,
+      "Cannot create an instance of an uninitialized method");
+  ET_CHECK_OR_RETURN_ERROR(
+      method.program_ == this,
+      InvalidArgument,
+      "Method was not loaded from this program");
+  return Method::load(
+      method.serialization_plan_,
+      this,
+      memory_manager,
+      event_tracer,
+      named_data_map,
+      /*prototype=*/&method);
+}
+
 Result<MethodMeta> Program::method_meta(const char* method_name) const {
   auto plan = get_execution_plan(internal_program_, method_name);
   if (!plan.ok()) {
@@ -459,6 +486,20 @@ Result<FreeableBuffer> Program::LoadSegment(
       segment_base_offset_ + segment->offset(), segment->size(), segment_info);
 }
 
+Error Program::prefetch_segment(
+    const DataLoader::SegmentInfo& segment_info) const {
+  size_t index = segment_info.segment_index;
+  // LoadSegment() logs these errors when the segment is loaded.
+  if (loader_ == nullptr || segment_base_offset_ == 0 ||
+      index >= internal_program_->segments()->size()) {
+    return Error::NotFound;
+  }
+  const executorch_flatbuffer::DataSegment* segment =
+      internal_program_->segments()->Get(index);
+  return loader_->prefetch(
+      segment_base_offset_ + segment->offset(), segment->size(), segment_info);
+}
+
 Error Program::load_mutable_subsegment_into(
     size_t mutable_data_segments_index,
     size_t offset_index,
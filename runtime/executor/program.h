@@ -150,6 +150,34 @@ class Program final {
       EventTracer* event_tracer = nullptr,
       const NamedDataMap* named_data_map = nullptr) const;
 
+  /**
+   * Loads another instance of an already-loaded method.
+   *
+   * The new instance has its own values and uses `memory_manager` for its
+   * planned and runtime memory, so it can execute concurrently with `method`
+   * and with any other instance. Constant tensors point into the same
+   * Program-owned data as every other instance, and the operator kernels that
+   * `method` resolved are reused instead of being looked up in the registry
+   * again. Backend delegates are initialized per instance.
+   *
+   * @param[in] method A successfully-loaded method of this Program. It only
+   *     needs to be valid for the duration of this call.
+   * @param[in] memory_manager The allocators to use during initialization and
+   *     execution of the new instance. Must not share planned memory with
+   *     `method` or any other instance that may execute concurrently.
+   * @param[in] event_tracer The event tracer to use for this method run.
+   * @param[in] named_data_map An optional map of {name, blob} used to resolve
+   *     data that is external to the PTE, if any. Should be the same map that
+   *     `method` was loaded with.
+   *
+   * @returns The loaded method on success, or an error on failure.
+   */
+  Result<Method> load_method_instance(
+      const Method& method,
+      MemoryManager* memory_manager,
+      EventTracer* event_tracer = nullptr,
+      const NamedDataMap* named_data_map = nullptr) const;
+
   /**
    * Gathers metadata for the named method.
    *
@@ -246,6 +274,22 @@ class Program final {
   ET_NODISCARD Result<FreeableBuffer> LoadSegment(
       const DataLoader::SegmentInfo& segment_info) const;
 
+  /**
+   * Asks the DataLoader to start reading a segment that will be loaded with
+   * LoadSegment() soon.
+   *
+   * @param[in] segment_info The segment, as it will be passed to
+   * LoadSegment().
+   *
+   * @retval Error::Ok The loader started reading the segment.
+   * @retval Error::NotFound The program does not contain any segments or the
+   *     index is out of range.
+   * @retval Error::NotImplemented The DataLoader doesn't prefetch.
+   * @returns Other errors depending on the implementation of DataLoader.
+   */
+  ET_NODISCARD Error
+  prefetch_segment(const DataLoader::SegmentInfo& segment_info) const;
+
   /**
    * Loads a portion of a mutable segment into the provided buffer.
    *
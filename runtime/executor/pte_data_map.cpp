@@ -9,10 +9,48 @@
 #include <executorch/runtime/executor/pte_data_map.h>
 #include <executorch/schema/program_generated.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace executorch {
 namespace ET_RUNTIME_NAMESPACE {
 namespace internal {
 
+namespace {
+
+/// Orders keys bytewise, shorter keys first on a common prefix, which is how
+/// the serializer sorts named_data.
+int compare_keys(
+    const flatbuffers::String* lhs,
+    executorch::aten::string_view rhs) {
+  const size_t common = std::min<size_t>(lhs->size(), rhs.size());
+  const int cmp = common == 0 ? 0 : memcmp(lhs->data(), rhs.data(), common);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return lhs->size() < rhs.size() ? -1 : (lhs->size() > rhs.size() ? 1 : 0);
+}
+
+bool are_keys_sorted(const flatbuffers::FlatbufferNamedData* named_data) {
+  const flatbuffers::String* prev = nullptr;
+  for (uint32_t i = 0; i < named_data->size(); i++) {
+    const auto* item = named_data->Get(i);
+    if (item == nullptr || item->key() == nullptr) {
+      // Let the linear search report the malformed entry.
+      return false;
+    }
+    const flatbuffers::String* key = item->key();
+    if (prev != nullptr &&
+        compare_keys(prev, {key->data(), key->size()}) >= 0) {
+      return false;
+    }
+    prev = key;
+  }
+  return true;
+}
+
+} // namespace
+
 /* static */ Result<PteDataMap> PteDataMap::create(
     DataLoader* loader,
     size_t segment_base_offset,
@@ -22,45 +60,74 @@ namespace internal {
       loader != nullptr && named_data != nullptr && segments != nullptr,
       InvalidArgument,
       "PteDataMap loader, named_data or segments is null; most likely the program does not have any named_data segments");
-  return PteDataMap(loader, segment_base_offset, named_data, segments);
+  return PteDataMap(
+      loader,
+      segment_base_offset,
+      named_data,
+      segments,
+      are_keys_sorted(named_data));
 }
 
 ET_NODISCARD
 Result<FreeableBuffer> PteDataMap::get_data(
     executorch::aten::string_view key) const {
-  for (uint32_t i = 0; i < named_data_->size(); i++) {
-    const auto* named_data_item = named_data_->Get(i);
-    ET_CHECK_OR_RETURN_ERROR(
-        named_data_item != nullptr && named_data_item->key() != nullptr,
-        InvalidArgument,
-        "Searching for key %.*s: NamedData at index %d is null",
-        static_cast<int>(key.size()),
-        key.data(),
-        i);
-    const auto* named_data_key = named_data_item->key();
-    if (named_data_key->size() == key.size() &&
-        memcmp(named_data_key->data(), key.data(), key.size()) == 0) {
-      // Get the segment index.
-      size_t segment_index = named_data_item->segment_index();
-
-      // Get the segment offset and size.
+  const executorch_flatbuffer::NamedData* named_data_item = nullptr;
+  if (keys_sorted_) {
+    // Binary search; create() checked that all entries are non-null.
+    uint32_t low = 0;
+    uint32_t high = named_data_->size();
+    while (low < high) {
+      const uint32_t mid = low + (high - low) / 2;
+      const auto* item = named_data_->Get(mid);
+      const int cmp = compare_keys(item->key(), key);
+      if (cmp == 0) {
+        named_data_item = item;
+        break;
+      }
+      if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+  } else {
+    for (uint32_t i = 0; i < named_data_->size(); i++) {
+      const auto* item = named_data_->Get(i);
       ET_CHECK_OR_RETURN_ERROR(
-          segment_index < segments_->size(),
+          item != nullptr && item->key() != nullptr,
           InvalidArgument,
-          "Segment index %zu for key %.*s is out of range for segments size %u",
-          segment_index,
+          "Searching for key %.*s: NamedData at index %d is null",
           static_cast<int>(key.size()),
           key.data(),
-          segments_->size());
-      size_t segment_offset = segments_->Get(segment_index)->offset();
-      size_t segment_size = segments_->Get(segment_index)->size();
-      return loader_->load(
-          /*offset=*/segment_base_offset_ + segment_offset,
-          segment_size,
-          DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::External));
+          i);
+      if (compare_keys(item->key(), key) == 0) {
+        named_data_item = item;
+        break;
+      }
     }
   }
-  return Error::NotFound;
+  if (named_data_item == nullptr) {
+    return Error::NotFound;
+  }
+
+  // Get the segment index.
+  size_t segment_index = named_data_item->segment_index();
+
+  // Get the segment offset and size.
+  ET_CHECK_OR_RETURN_ERROR(
+      segment_index < segments_->size(),
+      InvalidArgument,
+      "Segment index %zu for key %.*s is out of range for segments size %u",
+      segment_index,
+      static_cast<int>(key.size()),
+      key.data(),
+      segments_->size());
+  size_t segment_offset = segments_->Get(segment_index)->offset();
+  size_t segment_size = segments_->Get(segment_index)->size();
+  return loader_->load(
+      /*offset=*/segment_base_offset_ + segment_offset,
+      segment_size,
+      DataLoader::SegmentInfo(DataLoader::SegmentInfo::Type::External));
 }
 
 ET_NODISCARD Result<uint32_t> PteDataMap::get_num_keys() const {
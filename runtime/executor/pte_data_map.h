@@ -123,11 +123,13 @@ class PteDataMap final : public NamedDataMap {
       DataLoader* loader,
       size_t segment_base_offset,
       const flatbuffers::FlatbufferNamedData* named_data,
-      const flatbuffers::FlatbufferDataSegment* segments)
+      const flatbuffers::FlatbufferDataSegment* segments,
+      bool keys_sorted)
       : loader_(loader),
         segment_base_offset_(segment_base_offset),
         named_data_(named_data),
-        segments_(segments) {}
+        segments_(segments),
+        keys_sorted_(keys_sorted) {}
 
   // Not copyable or assignable.
   PteDataMap(const PteDataMap& rhs) = delete;
@@ -145,6 +147,10 @@ class PteDataMap final : public NamedDataMap {
 
   // Segments, to retrieve offset and size for the loader.
   const flatbuffers::FlatbufferDataSegment* segments_;
+
+  // Whether named_data is sorted by key, as written by the serializer, so that
+  // keys can be binary searched. Older files fall back to a linear search.
+  bool keys_sorted_;
 };
 
 } // namespace internal
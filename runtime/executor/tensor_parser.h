@@ -31,6 +31,30 @@ struct NamedData {
   FreeableBuffer buffer;
 };
 
+/**
+ * An open-addressing hash table of NamedData keyed by NamedData::key. The
+ * number of slots comes from get_named_data_table_size(), and unused slots
+ * have a null key.
+ */
+struct NamedDataTable {
+  Span<NamedData> slots;
+};
+
+/**
+ * Returns the number of slots to allocate for a NamedDataTable that holds up
+ * to `max_entries` entries. Always a power of two, and at least twice
+ * `max_entries` so that probe sequences stay short.
+ */
+size_t get_named_data_table_size(size_t max_entries);
+
+/**
+ * Finds `key` in `table`.
+ *
+ * @returns The slot holding `key` if present, otherwise the empty slot where
+ *     it should be inserted. nullptr if the table has no slot for it.
+ */
+NamedData* find_named_data_slot(const char* key, NamedDataTable table);
+
 NamedData* get_data_by_key(const char* key, Span<NamedData> entries);
 
 ET_NODISCARD Result<executorch::aten::Tensor> parseTensor(
@@ -148,6 +148,33 @@ ET_NODISCARD Error validateTensorLayout(
   return Error::Ok;
 }
 
+size_t get_named_data_table_size(size_t max_entries) {
+  size_t size = 1;
+  while (size < 2 * max_entries) {
+    size <<= 1;
+  }
+  return size;
+}
+
+NamedData* find_named_data_slot(const char* key, NamedDataTable table) {
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char* c = key; *c != '\0'; ++c) {
+    hash ^= static_cast<uint8_t>(*c);
+    hash *= 1099511628211ULL;
+  }
+  // Visit each slot at most once, so that a full table ends the probe too.
+  const size_t mask = table.slots.size() - 1;
+  for (size_t n = 0, i = hash & mask; n < table.slots.size();
+       ++n, i = (i + 1) & mask) {
+    NamedData& slot = table.slots[i];
+    if (slot.key == nullptr || strcmp(key, slot.key) == 0) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
 // Check if key exists in entries. If it does, return a pointer to the entry
 // otherwise return a nullptr.
 NamedData* get_data_by_key(const char* key, Span<NamedData> entries) {
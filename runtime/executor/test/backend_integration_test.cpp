@@ -6,6 +6,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
@@ -168,12 +169,12 @@ class DataLoaderSpy final : public DataLoader {
  public:
   /// A record of an operation performed on this DataLoader.
   struct Operation {
-    enum { Load, Free } op;
-    size_t offset; // Set for Load; zero for Free.
-    void* data; // Set for Free; nullptr for Load.
-    size_t size; // Set for Load and Free.
+    enum { Load, Free, Prefetch } op;
+    size_t offset; // Set for Load and Prefetch; zero for Free.
+    void* data; // Set for Free; nullptr for Load and Prefetch.
+    size_t size; // Set for Load, Free and Prefetch.
     std::unique_ptr<const DataLoader::SegmentInfo>
-        segment_info; // Set for Load; nullptr for Free.
+        segment_info; // Set for Load and Prefetch; nullptr for Free.
   };
 
   explicit DataLoaderSpy(DataLoader* delegate) : delegate_(delegate) {}
@@ -201,6 +202,20 @@ class DataLoaderSpy final : public DataLoader {
         context->buffer.data(), context->buffer.size(), FreeBuffer, context);
   }
 
+  Error prefetch(
+      size_t offset,
+      size_t size,
+      const SegmentInfo& segment_info) const override {
+    operations_.push_back(
+        {Operation::Prefetch,
+         offset,
+         /*data=*/nullptr,
+         size,
+         /*segment_info=*/
+         std::make_unique<const DataLoader::SegmentInfo>(segment_info)});
+    return delegate_->prefetch(offset, size, segment_info);
+  }
+
   Result<size_t> size() const override {
     return delegate_->size();
   }
@@ -565,6 +580,56 @@ TEST_P(BackendIntegrationTest, SegmentInfoIsPassedIntoDataLoader) {
   EXPECT_EQ(backend_load_was_called, using_segments());
 }
 
+/**
+ * Tests that Method asks the DataLoader to prefetch every backend segment
+ * before it loads the first one.
+ */
+TEST_P(BackendIntegrationTest, BackendSegmentsArePrefetchedBeforeLoad) {
+  Result<FileDataLoader> loader = FileDataLoader::from(program_path());
+  ASSERT_EQ(loader.error(), Error::Ok);
+  DataLoaderSpy spy_loader(&loader.get());
+
+  Result<Program> program = Program::load(&spy_loader);
+  ASSERT_EQ(program.error(), Error::Ok);
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method_res = program->load_method("forward", &mmm.get());
+  EXPECT_EQ(method_res.error(), Error::Ok);
+
+  const auto& operations = spy_loader.operations();
+  auto is_backend = [](const DataLoaderSpy::Operation& op) {
+    return op.op != DataLoaderSpy::Operation::Free &&
+        op.segment_info->segment_type ==
+        DataLoader::SegmentInfo::Type::Backend;
+  };
+  auto first_load = std::find_if(
+      operations.begin(), operations.end(), [&](const auto& op) {
+        return is_backend(op) && op.op == DataLoaderSpy::Operation::Load;
+      });
+  size_t num_prefetches = 0;
+  size_t num_loads = 0;
+  for (auto it = operations.begin(); it != operations.end(); ++it) {
+    if (!is_backend(*it)) {
+      continue;
+    }
+    if (it->op == DataLoaderSpy::Operation::Prefetch) {
+      // Every prefetch is issued before the first segment is consumed.
+      EXPECT_LT(it - operations.begin(), first_load - operations.begin());
+      EXPECT_STREQ(it->segment_info->descriptor, "StubBackend");
+      num_prefetches += 1;
+      continue;
+    }
+    // Every load reads a region that was prefetched.
+    EXPECT_TRUE(std::any_of(operations.begin(), it, [&](const auto& op) {
+      return op.op == DataLoaderSpy::Operation::Prefetch &&
+          op.offset == it->offset && op.size == it->size;
+    }));
+    num_loads += 1;
+  }
+  EXPECT_EQ(num_prefetches, num_loads);
+  // Only segments are prefetched; inline data needs no loading.
+  EXPECT_EQ(num_prefetches > 0, using_segments());
+}
+
 TEST_P(BackendIntegrationTest, GetMethodNameDuringInitSuccess) {
   Result<FileDataLoader> loader = FileDataLoader::from(program_path());
   ASSERT_EQ(loader.error(), Error::Ok);
@@ -8,14 +8,18 @@
 
 #include <cstdlib>
 #include <filesystem>
+#include <thread>
+#include <vector>
 
 #include <executorch/extension/data_loader/file_data_loader.h>
 #include <executorch/extension/flat_tensor/flat_tensor_data_map.h>
 #include <executorch/extension/runner_util/inputs.h>
+#include <executorch/kernels/portable/cpu/util/fused_elementwise.h>
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
 #include <executorch/runtime/executor/method.h>
 #include <executorch/runtime/executor/program.h>
 #include <executorch/runtime/executor/test/managed_memory_manager.h>
+#include <executorch/runtime/kernel/elementwise_fusion.h>
 #include <executorch/runtime/platform/runtime.h>
 #include <executorch/test/utils/DeathTest.h>
 #include <gtest/gtest.h>
@@ -26,9 +30,15 @@ using executorch::extension::FlatTensorDataMap;
 using executorch::extension::prepare_input_tensors;
 using executorch::runtime::Error;
 using executorch::runtime::EValue;
+using executorch::runtime::FunctionRef;
+using executorch::runtime::FusedElementwiseFunction;
+using executorch::runtime::FusedElementwiseStep;
+using executorch::runtime::FusibleElementwiseOp;
+using executorch::runtime::MemoryAllocator;
 using executorch::runtime::Method;
 using executorch::runtime::Program;
 using executorch::runtime::Result;
+using executorch::runtime::Span;
 using executorch::runtime::testing::ManagedMemoryManager;
 using torch::executor::util::FileDataLoader;
 
@@ -317,6 +327,246 @@ TEST_F(MethodTest, ConstantSegmentTest) {
   ASSERT_EQ(err, Error::Ok);
 }
 
+TEST_F(MethodTest, LoadMethodInstanceTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["add_mul"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  // Create a second instance with its own memory.
+  ManagedMemoryManager instance_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> instance =
+      programs_["add_mul"]->load_method_instance(*method, &instance_mmm.get());
+  ASSERT_EQ(instance.error(), Error::Ok);
+  ASSERT_EQ(instance->inputs_size(), method->inputs_size());
+  ASSERT_EQ(instance->outputs_size(), method->outputs_size());
+
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  auto instance_input_cleanup = prepare_input_tensors(*instance);
+  ASSERT_EQ(instance_input_cleanup.error(), Error::Ok);
+
+  ASSERT_EQ(method->execute(), Error::Ok);
+  ASSERT_EQ(instance->execute(), Error::Ok);
+
+  // Both instances compute the same result into different planned buffers.
+  const auto& expected = method->get_output(0).toTensor();
+  const auto& actual = instance->get_output(0).toTensor();
+  ASSERT_EQ(expected.numel(), actual.numel());
+  EXPECT_NE(expected.const_data_ptr(), actual.const_data_ptr());
+  for (size_t i = 0; i < expected.numel(); ++i) {
+    EXPECT_FLOAT_EQ(
+        expected.const_data_ptr<float>()[i], actual.const_data_ptr<float>()[i]);
+  }
+
+  // The instance does not depend on the prototype after it is loaded.
+  Method moved(std::move(method.get()));
+  ASSERT_EQ(instance->execute(), Error::Ok);
+}
+
+TEST_F(MethodTest, LoadMethodInstanceFromOtherProgramFails) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method = programs_["add"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  ManagedMemoryManager instance_mmm(
+      kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> instance =
+      programs_["add_mul"]->load_method_instance(*method, &instance_mmm.get());
+  EXPECT_EQ(instance.error(), Error::InvalidArgument);
+}
+
+namespace {
+// Runs every index of the range on its own thread.
+bool thread_per_index_parallel_for(
+    int64_t begin,
+    int64_t end,
+    int64_t /*grain_size*/,
+    FunctionRef<void(int64_t, int64_t)> f) {
+  std::vector<std::thread> threads;
+  for (int64_t i = begin; i < end; ++i) {
+    threads.emplace_back([f, i]() { f(i, i + 1); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return true;
+}
+
+// A parallel_for that always fails.
+bool failing_parallel_for(
+    int64_t,
+    int64_t,
+    int64_t,
+    FunctionRef<void(int64_t, int64_t)>) {
+  return false;
+}
+
+// Temp allocators for the lanes of a parallel method.
+class LaneAllocators {
+ public:
+  explicit LaneAllocators(size_t num_lanes, size_t bytes_per_lane = 4096)
+      : buffers_(num_lanes, std::vector<uint8_t>(bytes_per_lane)) {
+    allocators_.reserve(num_lanes);
+    for (auto& buffer : buffers_) {
+      allocators_.emplace_back(buffer.size(), buffer.data());
+    }
+    for (auto& allocator : allocators_) {
+      pointers_.push_back(&allocator);
+    }
+  }
+
+  Span<MemoryAllocator*> get() {
+    return {pointers_.data(), pointers_.size()};
+  }
+
+ private:
+  std::vector<std::vector<uint8_t>> buffers_;
+  std::vector<MemoryAllocator> allocators_;
+  std::vector<MemoryAllocator*> pointers_;
+};
+} // namespace
+
+TEST_F(MethodTest, ParallelExecutionMatchesSequential) {
+  for (const char* name : {"add", "add_mul"}) {
+    ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+    Result<Method> method = programs_[name]->load_method("forward", &mmm.get());
+    ASSERT_EQ(method.error(), Error::Ok);
+    ManagedMemoryManager parallel_mmm(
+        kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+    Result<Method> parallel_method =
+        programs_[name]->load_method("forward", &parallel_mmm.get());
+    ASSERT_EQ(parallel_method.error(), Error::Ok);
+
+    LaneAllocators lanes(4);
+    ASSERT_EQ(
+        parallel_method->set_parallel_execution(
+            thread_per_index_parallel_for, lanes.get()),
+        Error::Ok);
+    EXPECT_LE(parallel_method->num_parallel_chains(), 1);
+
+    auto input_cleanup = prepare_input_tensors(*method);
+    ASSERT_EQ(input_cleanup.error(), Error::Ok);
+    auto parallel_input_cleanup = prepare_input_tensors(*parallel_method);
+    ASSERT_EQ(parallel_input_cleanup.error(), Error::Ok);
+
+    // Run twice to make sure the schedule can be reused.
+    for (int run = 0; run < 2; ++run) {
+      ASSERT_EQ(method->execute(), Error::Ok) << name;
+      ASSERT_EQ(parallel_method->execute(), Error::Ok) << name;
+      const auto& expected = method->get_output(0).toTensor();
+      const auto& actual = parallel_method->get_output(0).toTensor();
+      ASSERT_EQ(expected.numel(), actual.numel()) << name;
+      for (size_t i = 0; i < expected.numel(); ++i) {
+        EXPECT_FLOAT_EQ(
+            expected.const_data_ptr<float>()[i],
+            actual.const_data_ptr<float>()[i])
+            << name;
+      }
+    }
+  }
+}
+
+TEST_F(MethodTest, SetParallelExecutionArgumentsTest) {
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["add_mul"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+
+  // At least one temp allocator is required.
+  EXPECT_EQ(
+      method->set_parallel_execution(thread_per_index_parallel_for, {}),
+      Error::InvalidArgument);
+  MemoryAllocator* null_allocators[] = {nullptr};
+  EXPECT_EQ(
+      method->set_parallel_execution(
+          thread_per_index_parallel_for, {null_allocators, 1}),
+      Error::InvalidArgument);
+  EXPECT_EQ(method->num_parallel_chains(), 0);
+
+  LaneAllocators lanes(2);
+  ASSERT_EQ(
+      method->set_parallel_execution(failing_parallel_for, lanes.get()),
+      Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+  if (method->num_parallel_chains() > 0) {
+    // The failure of parallel_for is reported.
+    EXPECT_EQ(method->execute(), Error::Internal);
+  }
+
+  // Disabling parallel execution restores the sequential path.
+  ASSERT_EQ(method->set_parallel_execution(nullptr, {}), Error::Ok);
+  EXPECT_EQ(method->num_parallel_chains(), 0);
+  EXPECT_EQ(method->execute(), Error::Ok);
+}
+
+namespace {
+// Records the chains that Method fuses, and computes them with the portable
+// fused elementwise function.
+struct FusionRecorder {
+  static bool run(
+      executorch::runtime::KernelRuntimeContext& context,
+      Span<const FusedElementwiseStep> steps,
+      Span<EValue*> inputs,
+      EValue& out) {
+    calls += 1;
+    ops.clear();
+    for (const auto& step : steps) {
+      ops.push_back(step.op);
+    }
+    num_inputs = inputs.size();
+    return torch::executor::native::utils::fused_elementwise(
+        context, steps, inputs, out);
+  }
+
+  static FusedElementwiseFunction previous;
+  static int calls;
+  static std::vector<FusibleElementwiseOp> ops;
+  static size_t num_inputs;
+};
+
+FusedElementwiseFunction FusionRecorder::previous = nullptr;
+int FusionRecorder::calls = 0;
+std::vector<FusibleElementwiseOp> FusionRecorder::ops;
+size_t FusionRecorder::num_inputs = 0;
+} // namespace
+
+TEST_F(MethodTest, ElementwiseFusionTest) {
+  FusionRecorder::previous =
+      executorch::runtime::get_fused_elementwise_function();
+  executorch::runtime::register_fused_elementwise_function(
+      FusionRecorder::run);
+
+  ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
+  Result<Method> method =
+      programs_["add_mul"]->load_method("forward", &mmm.get());
+  ASSERT_EQ(method.error(), Error::Ok);
+  auto input_cleanup = prepare_input_tensors(*method);
+  ASSERT_EQ(input_cleanup.error(), Error::Ok);
+
+  // mul(a, x) -> add(_, b) runs as a single fused call, or falls back to
+  // the original operators if the call isn't supported.
+  FusionRecorder::calls = 0;
+  ASSERT_EQ(method->execute(), Error::Ok);
+  EXPECT_EQ(FusionRecorder::calls, 1);
+  EXPECT_EQ(
+      FusionRecorder::ops,
+      std::vector<FusibleElementwiseOp>(
+          {FusibleElementwiseOp::Mul, FusibleElementwiseOp::Add}));
+  EXPECT_EQ(FusionRecorder::num_inputs, 3);
+
+  // 3 * x + 2 with x = 1.
+  const auto& output = method->get_output(0).toTensor();
+  for (size_t i = 0; i < output.numel(); ++i) {
+    EXPECT_FLOAT_EQ(output.const_data_ptr<float>()[i], 5.0f);
+  }
+
+  executorch::runtime::register_fused_elementwise_function(
+      FusionRecorder::previous);
+}
+
 TEST_F(MethodTest, ConstantBufferTest) {
   // Execute model with constants stored in the program flatbuffer.
   ManagedMemoryManager mmm(kDefaultNonConstMemBytes, kDefaultRuntimeMemBytes);
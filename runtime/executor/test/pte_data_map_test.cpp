@@ -275,3 +275,58 @@ TEST_F(PteDataMapTest, ReloadAndFree) {
   // Free data_reload0.
   data0_reload->Free();
 }
+
+TEST_F(PteDataMapTest, GetDataWithUnsortedKeys) {
+  // Older PTE files do not sort named_data by key; lookups still have to find
+  // every key.
+  flatbuffers::FlatBufferBuilder builder;
+  std::array<const flatbuffers::Offset<executorch_flatbuffer::NamedData>, 3>
+      named_data_arr = {
+          executorch_flatbuffer::CreateNamedDataDirect(
+              builder, "key1", /*segment_index=*/1),
+          executorch_flatbuffer::CreateNamedDataDirect(
+              builder, "key", /*segment_index=*/0),
+          executorch_flatbuffer::CreateNamedDataDirect(
+              builder, "key0", /*segment_index=*/0),
+      };
+  const auto named_data =
+      builder.CreateVector(named_data_arr.data(), named_data_arr.size());
+  std::array<const flatbuffers::Offset<executorch_flatbuffer::DataSegment>, 2>
+      segment_arr = {// @lint-ignore CLANGTIDY facebook-hte-BadArgumentComment
+                     executorch_flatbuffer::CreateDataSegment(
+                         builder, /*offset=*/0, /*size=*/kSegmentSizes[0]),
+                     // @lint-ignore CLANGTIDY facebook-hte-BadArgumentComment
+                     executorch_flatbuffer::CreateDataSegment(
+                         builder,
+                         /*offset=*/kSegmentAlignment * 2,
+                         /*size=*/kSegmentSizes[1])};
+  const auto segments =
+      builder.CreateVector(segment_arr.data(), segment_arr.size());
+  builder.Finish(executorch_flatbuffer::CreateProgram(
+      builder, 0, 0, 0, 0, segments, 0, 0, named_data));
+  const auto* program =
+      executorch_flatbuffer::GetProgram(builder.GetBufferPointer());
+
+  Result<PteDataMap> data_map = PteDataMap::create(
+      data_map_loader_.get(), 0, program->named_data(), program->segments());
+  ASSERT_TRUE(data_map.ok());
+
+  for (const char* key : {"key1", "key", "key0"}) {
+    Result<FreeableBuffer> data = data_map->get_data(key);
+    EXPECT_EQ(data.error(), Error::Ok) << key;
+  }
+  EXPECT_EQ(data_map->get_data("ke").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_data("key2").error(), Error::NotFound);
+}
+
+TEST_F(PteDataMapTest, GetDataMatchesWholeKey) {
+  Result<PteDataMap> data_map = PteDataMap::create(
+      data_map_loader_.get(), 0, program_->named_data(), program_->segments());
+  ASSERT_TRUE(data_map.ok());
+
+  // Prefixes and extensions of existing keys are not found.
+  EXPECT_EQ(data_map->get_data("key").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_data("key00").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_data("").error(), Error::NotFound);
+  EXPECT_EQ(data_map->get_data("key_a").error(), Error::NotFound);
+}
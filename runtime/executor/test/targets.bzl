@@ -169,6 +169,7 @@ def define_common_targets(is_fbcode = False):
                 "//executorch/extension/flat_tensor:flat_tensor_data_map",
                 "//executorch/extension/runner_util:inputs",
                 "//executorch/kernels/portable:generated_lib",
+                "//executorch/kernels/portable/cpu/util:fused_elementwise",
             ],
             env = modules_env,
         )
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <executorch/runtime/kernel/elementwise_fusion.h>
+
+namespace executorch {
+namespace ET_RUNTIME_NAMESPACE {
+
+namespace {
+
+// Registration is expected to happen before any method that should use it is
+// loaded, and not concurrently with loading methods.
+FusedElementwiseFunction fused_elementwise_function = nullptr;
+
+} // namespace
+
+void register_fused_elementwise_function(FusedElementwiseFunction function) {
+  fused_elementwise_function = function;
+}
+
+FusedElementwiseFunction get_fused_elementwise_function() {
+  return fused_elementwise_function;
+}
+
+} // namespace ET_RUNTIME_NAMESPACE
+} // namespace executorch
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <executorch/runtime/core/evalue.h>
+#include <executorch/runtime/core/exec_aten/exec_aten.h>
+#include <executorch/runtime/core/span.h>
+#include <executorch/runtime/platform/compiler.h>
+
+namespace executorch {
+namespace ET_RUNTIME_NAMESPACE {
+
+class KernelRuntimeContext; // Forward declaration
+
+/**
+ * The elementwise operators that Method can fuse into a single pass over
+ * memory.
+ */
+enum class FusibleElementwiseOp : uint8_t {
+  Add, ///< aten::add.out
+  Sub, ///< aten::sub.out
+  Mul, ///< aten::mul.out
+  Div, ///< aten::div.out
+  Neg, ///< aten::neg.out
+  Relu, ///< aten::relu.out
+  Sigmoid, ///< aten::sigmoid.out
+  Tanh, ///< aten::tanh.out
+  Exp, ///< aten::exp.out
+};
+
+/// Whether `op` takes two tensor operands.
+inline bool is_binary_elementwise_op(FusibleElementwiseOp op) {
+  return op == FusibleElementwiseOp::Add || op == FusibleElementwiseOp::Sub ||
+      op == FusibleElementwiseOp::Mul || op == FusibleElementwiseOp::Div;
+}
+
+/**
+ * One operator of a fused elementwise chain.
+ */
+struct FusedElementwiseStep {
+  /// Operand index that refers to the result of the previous step.
+  static constexpr int16_t kPrevious = -1;
+
+  FusibleElementwiseOp op;
+  /// Index in the inputs of the chain of the first operand, or kPrevious.
+  int16_t lhs;
+  /// Same for the second operand of binary operators, unused otherwise.
+  int16_t rhs;
+  /// The alpha argument of add and sub.
+  double alpha;
+};
+
+/**
+ * Computes a chain of elementwise operators in a single pass, writing only
+ * the result of the last step, to `out`. The results of the other steps are
+ * never materialized.
+ *
+ * Returns false without touching `out` if the call isn't supported, for
+ * example because the inputs need broadcasting, in which case the caller runs
+ * the original operators one by one. Once it returns true, failures are
+ * reported through the failure state of `context` like for any kernel.
+ */
+using FusedElementwiseFunction = bool (*)(
+    KernelRuntimeContext& context,
+    Span<const FusedElementwiseStep> steps,
+    Span<EValue*> inputs,
+    EValue& out);
+
+/**
+ * Registers the function that Method uses to run chains of elementwise
+ * operators whose intermediate results are used by nothing else. Fusion is
+ * off until a function is registered, and only affects methods loaded
+ * afterwards.
+ *
+ * Fusing is opt-in because it changes what runs: a fused chain is computed by
+ * `function` whichever kernels the operators resolved to, including optimized
+ * or custom ones, and it executes as a single step of Method::step().
+ *
+ * @param[in] function The function to use, replacing any earlier one, or
+ *     nullptr to stop fusing.
+ */
+void register_fused_elementwise_function(FusedElementwiseFunction function);
+
+/**
+ * Returns the registered fused elementwise function, or nullptr if there is
+ * none.
+ */
+FusedElementwiseFunction get_fused_elementwise_function();
+
+} // namespace ET_RUNTIME_NAMESPACE
+} // namespace executorch
@@ -14,6 +14,15 @@
 #include <executorch/runtime/platform/platform.h>
 #include <executorch/runtime/platform/system.h>
 
+/**
+ * Whether to keep a hash index over the registered kernels. It makes
+ * registration and lookup independent of the number of registered kernels, at
+ * the cost of static memory proportional to the maximum number of kernels.
+ */
+#ifndef ET_ENABLE_KERNEL_INDEX
+#define ET_ENABLE_KERNEL_INDEX 1
+#endif
+
 namespace executorch {
 namespace ET_RUNTIME_NAMESPACE {
 
@@ -48,6 +57,105 @@ Kernel* registered_kernels = reinterpret_cast<Kernel*>(registered_kernels_data);
 /// The number of kernels registered in the table.
 size_t num_registered_kernels = 0;
 
+#if ET_ENABLE_KERNEL_INDEX
+
+constexpr uint32_t next_power_of_two(uint32_t n) {
+  uint32_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+// Hash index over registered_kernels, keyed by operator name and kernel key,
+// so that neither registration nor lookup has to scan the whole table. It uses
+// open addressing with linear probing and is at most half full. It takes up to
+// 32 bytes per kernel in kMaxRegisteredKernels, 32 KiB by default; builds that
+// can't spare them lower MAX_KERNEL_NUM or set ET_ENABLE_KERNEL_INDEX=0.
+constexpr uint32_t kKernelIndexSize =
+    next_power_of_two(2 * kMaxRegisteredKernels);
+constexpr uint32_t kKernelIndexMask = kKernelIndexSize - 1;
+
+struct KernelIndexEntry {
+  uint32_t hash;
+  // Index in registered_kernels plus one; zero marks an empty entry.
+  uint32_t kernel_index_plus_one;
+};
+
+// @lint-ignore CLANGTIDY facebook-hte-CArray
+KernelIndexEntry kernel_index[kKernelIndexSize];
+
+/// FNV-1a hash of an operator name and kernel key.
+uint32_t hash_kernel(const char* name, const KernelKey& key) {
+  uint32_t hash = 2166136261u;
+  const auto add_byte = [&hash](uint8_t byte) {
+    hash ^= byte;
+    hash *= 16777619u;
+  };
+  for (const char* p = name; *p != '\0'; p++) {
+    add_byte(static_cast<uint8_t>(*p));
+  }
+  // Separate the name from the key, distinguishing fallback kernels from
+  // kernels with an empty key.
+  add_byte(key.is_fallback() ? 0xff : 0);
+  if (!key.is_fallback()) {
+    for (const char* p = key.data(); *p != '\0'; p++) {
+      add_byte(static_cast<uint8_t>(*p));
+    }
+  }
+  return hash;
+}
+
+/// Returns the registered kernel with exactly this name and key, or nullptr.
+const Kernel* find_kernel(const char* name, const KernelKey& key) {
+  const uint32_t hash = hash_kernel(name, key);
+  for (uint32_t i = hash & kKernelIndexMask;; i = (i + 1) & kKernelIndexMask) {
+    const KernelIndexEntry& entry = kernel_index[i];
+    if (entry.kernel_index_plus_one == 0) {
+      return nullptr;
+    }
+    if (entry.hash == hash) {
+      const Kernel& kernel =
+          registered_kernels[entry.kernel_index_plus_one - 1];
+      if (strcmp(kernel.name_, name) == 0 && kernel.kernel_key_ == key) {
+        return &kernel;
+      }
+    }
+  }
+}
+
+/// Appends a kernel, which must not be registered yet, to the table and the
+/// index.
+void add_kernel(const Kernel& kernel) {
+  const uint32_t hash = hash_kernel(kernel.name_, kernel.kernel_key_);
+  uint32_t i = hash & kKernelIndexMask;
+  while (kernel_index[i].kernel_index_plus_one != 0) {
+    i = (i + 1) & kKernelIndexMask;
+  }
+  registered_kernels[num_registered_kernels++] = kernel;
+  kernel_index[i] = {hash, static_cast<uint32_t>(num_registered_kernels)};
+}
+
+#else // ET_ENABLE_KERNEL_INDEX
+
+/// Returns the registered kernel with exactly this name and key, or nullptr.
+const Kernel* find_kernel(const char* name, const KernelKey& key) {
+  for (size_t i = 0; i < num_registered_kernels; i++) {
+    const Kernel& kernel = registered_kernels[i];
+    if (strcmp(kernel.name_, name) == 0 && kernel.kernel_key_ == key) {
+      return &kernel;
+    }
+  }
+  return nullptr;
+}
+
+/// Appends a kernel, which must not be registered yet, to the table.
+void add_kernel(const Kernel& kernel) {
+  registered_kernels[num_registered_kernels++] = kernel;
+}
+
+#endif // ET_ENABLE_KERNEL_INDEX
+
 // Registers the kernels, but may return an error.
 Error register_kernels_internal(const Span<const Kernel> kernels) {
   // Operator registration happens in static initialization time before or after
@@ -81,17 +189,13 @@ Error register_kernels_internal(const Span<const Kernel> kernels) {
       et_pal_get_shared_library_name(kernels.data());
 
   for (const auto& kernel : kernels) {
-    // Linear search. This is fine if the number of kernels is small.
-    for (size_t i = 0; i < num_registered_kernels; i++) {
-      Kernel k = registered_kernels[i];
-      if (strcmp(kernel.name_, k.name_) == 0 &&
-          kernel.kernel_key_ == k.kernel_key_) {
-        ET_LOG(Error, "Re-registering %s, from %s", k.name_, lib_name);
-        ET_LOG_KERNEL_KEY(k.kernel_key_);
-        return Error::RegistrationAlreadyRegistered;
-      }
+    const Kernel* k = find_kernel(kernel.name_, kernel.kernel_key_);
+    if (k != nullptr) {
+      ET_LOG(Error, "Re-registering %s, from %s", k->name_, lib_name);
+      ET_LOG_KERNEL_KEY(k->kernel_key_);
+      return Error::RegistrationAlreadyRegistered;
     }
-    registered_kernels[num_registered_kernels++] = kernel;
+    add_kernel(kernel);
   }
   ET_LOG(
       Debug,
@@ -239,19 +343,13 @@ Result<OpFunction> get_op_function_from_registry(
   }
   KernelKey kernel_key = KernelKey(key_string.data());
 
-  int32_t fallback_idx = -1;
-  for (size_t idx = 0; idx < num_registered_kernels; idx++) {
-    if (strcmp(registered_kernels[idx].name_, name) == 0) {
-      if (registered_kernels[idx].kernel_key_ == kernel_key) {
-        return registered_kernels[idx].op_;
-      }
-      if (registered_kernels[idx].kernel_key_.is_fallback()) {
-        fallback_idx = idx;
-      }
-    }
+  const Kernel* kernel = find_kernel(name, kernel_key);
+  if (kernel == nullptr) {
+    // Fall back to the kernel registered without a key, if any.
+    kernel = find_kernel(name, KernelKey());
   }
-  if (fallback_idx != -1) {
-    return registered_kernels[fallback_idx].op_;
+  if (kernel != nullptr) {
+    return kernel->op_;
   }
   ET_LOG(Error, "kernel '%s' not found.", name);
   ET_LOG_TENSOR_META(meta_list);
@@ -1,6 +1,12 @@
 load("@fbsource//xplat/executorch/build:runtime_wrapper.bzl", "get_aten_mode_options", "runtime")
 
 def _operator_registry_preprocessor_flags():
+    flags = []
+    if native.read_config("executorch", "enable_kernel_index", "true") == "false":
+        flags.append("-DET_ENABLE_KERNEL_INDEX=0")
+    return flags + _max_kernel_num_preprocessor_flags()
+
+def _max_kernel_num_preprocessor_flags():
     max_kernel_num = native.read_config("executorch", "max_kernel_num", None)
     if max_kernel_num != None:
         return ["-DMAX_KERNEL_NUM=" + max_kernel_num]
@@ -55,8 +61,14 @@ def define_common_targets():
 
         runtime.cxx_library(
             name = "operator_registry" + aten_suffix,
-            srcs = ["operator_registry.cpp"],
-            exported_headers = ["operator_registry.h"],
+            srcs = [
+                "elementwise_fusion.cpp",
+                "operator_registry.cpp",
+            ],
+            exported_headers = [
+                "elementwise_fusion.h",
+                "operator_registry.h",
+            ],
             visibility = [
                 "//executorch/...",
                 "@EXECUTORCH_CLIENTS",
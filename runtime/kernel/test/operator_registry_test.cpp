@@ -7,6 +7,8 @@
  */
 
 #include <gtest/gtest.h>
+#include <array>
+#include <string>
 #include <vector>
 
 #include <executorch/runtime/core/exec_aten/exec_aten.h>
@@ -508,3 +510,57 @@ TEST_F(OperatorRegistryTest, ExecutorUsesFallbackKernel) {
   auto val = values[0].toScalar().to<int64_t>();
   ASSERT_EQ(val, 100);
 }
+
+TEST_F(OperatorRegistryTest, RegisterAndLookUpManyKernels) {
+  constexpr size_t kNumOps = 100;
+  // Kernels keep pointers to their names and keys.
+  static std::vector<std::string> names;
+  static std::array<char, kKernelKeyBufSize> float_key;
+  static std::array<char, kKernelKeyBufSize> long_key;
+  ASSERT_EQ(
+      make_kernel_key(
+          {{ScalarType::Float, {0, 1}}}, float_key.data(), float_key.size()),
+      Error::Ok);
+  ASSERT_EQ(
+      make_kernel_key(
+          {{ScalarType::Long, {0, 1}}}, long_key.data(), long_key.size()),
+      Error::Ok);
+
+  OpFunction fallback_op = [](KernelRuntimeContext&, EValue** stack) {
+    *(stack[0]) = Scalar(0);
+  };
+  OpFunction float_op = [](KernelRuntimeContext&, EValue** stack) {
+    *(stack[0]) = Scalar(1);
+  };
+  OpFunction long_op = [](KernelRuntimeContext&, EValue** stack) {
+    *(stack[0]) = Scalar(2);
+  };
+  for (size_t i = 0; i < kNumOps; i++) {
+    names.push_back("test::many_" + std::to_string(i));
+  }
+  std::vector<Kernel> kernels;
+  for (const std::string& name : names) {
+    kernels.emplace_back(name.c_str(), KernelKey(float_key.data()), float_op);
+    kernels.emplace_back(name.c_str(), fallback_op);
+    kernels.emplace_back(name.c_str(), KernelKey(long_key.data()), long_op);
+  }
+  ASSERT_EQ(register_kernels({kernels.data(), kernels.size()}), Error::Ok);
+
+  Tensor::DimOrderType dims[] = {0, 1};
+  Span<Tensor::DimOrderType> dim_order(dims, 2);
+  TensorMeta float_meta[] = {TensorMeta(ScalarType::Float, dim_order)};
+  TensorMeta long_meta[] = {TensorMeta(ScalarType::Long, dim_order)};
+  TensorMeta int_meta[] = {TensorMeta(ScalarType::Int, dim_order)};
+  for (const std::string& name : names) {
+    EXPECT_EQ(
+        get_op_function_from_registry(name.c_str(), float_meta).get(),
+        float_op);
+    EXPECT_EQ(
+        get_op_function_from_registry(name.c_str(), long_meta).get(), long_op);
+    // Keys without a kernel of their own use the fallback.
+    EXPECT_EQ(
+        get_op_function_from_registry(name.c_str(), int_meta).get(),
+        fallback_op);
+  }
+  EXPECT_FALSE(registry_has_op_function("test::many_", float_meta));
+}
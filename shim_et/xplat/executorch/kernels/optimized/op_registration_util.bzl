@@ -163,6 +163,15 @@ OPTIMIZED_ATEN_OPS = (
             "//executorch/kernels/portable/cpu/util:matmul_ops_util",
         ],
     ),
+    op_target(
+        name = "op_convolution",
+        deps = [
+            "//executorch/extension/threadpool:threadpool",
+            "//executorch/kernels/optimized:libblas",
+            "//executorch/kernels/portable/cpu/util:dtype_util",
+            "//executorch/kernels/portable/cpu/util:kernel_ops_util",
+        ],
+    ),
     op_target(
         name = "op_div",
         deps = [
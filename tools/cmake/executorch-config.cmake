@@ -60,6 +60,7 @@ target_link_libraries(executorch INTERFACE executorch_core)
 set(lib_list
     flatccrt
     etdump
+    metrics_event_tracer
     bundled_program
     extension_data_loader
     extension_flat_tensor
@@ -153,6 +154,12 @@ if(TARGET etdump)
   set_target_properties(etdump PROPERTIES INTERFACE_LINK_LIBRARIES "flatccrt;executorch")
 endif()
 
+if(TARGET metrics_event_tracer)
+  set_target_properties(
+    metrics_event_tracer PROPERTIES INTERFACE_LINK_LIBRARIES "executorch"
+  )
+endif()
+
 if(TARGET optimized_native_cpu_ops_lib)
   if(TARGET optimized_portable_kernels)
     set(_maybe_optimized_portable_kernels_lib optimized_portable_kernels)
@@ -54,6 +54,11 @@ define_overridable_option(
   "Build with ET_EVENT_TRACER_ENABLED"
   BOOL OFF
 )
+define_overridable_option(
+  EXECUTORCH_ENABLE_KERNEL_INDEX
+  "Build with ET_ENABLE_KERNEL_INDEX, a hash index over registered kernels"
+  BOOL ON
+)
 define_overridable_option(
   EXECUTORCH_OPTIMIZE_SIZE
   "Build executorch runtime optimizing for binary size"
@@ -154,6 +159,11 @@ define_overridable_option(
   "Build the optimized kernels"
   BOOL OFF
 )
+define_overridable_option(
+  EXECUTORCH_OPTIMIZED_BLAS
+  "GEMM backend of the optimized kernels. Choices: eigen, blocked"
+  STRING "eigen"
+)
 define_overridable_option(
   EXECUTORCH_BUILD_KERNELS_QUANTIZED
   "Build the quantized kernels"
@@ -252,7 +262,8 @@ define_overridable_option(
 )
 
 # NB: Enabling this will serialize execution of delegate instances Keeping this
-# OFF by default to maintain existing behavior, to be revisited.
+# OFF by default to maintain existing behavior, to be revisited. This only picks
+# the default; the "workspace_sharing_mode" backend option overrides it.
 define_overridable_option(
   EXECUTORCH_XNNPACK_SHARED_WORKSPACE
   "Enable workspace sharing across different delegate instances"